@@ -0,0 +1,378 @@
+#include "camera-simulator.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sdk/core/packed12.h>
+#include <sdk/tof/playback-src.h>
+#include <spdlog/sinks/stdout_color_sinks.h>
+#include <spdlog/spdlog.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <deque>
+#include <list>
+#include <thread>
+
+using namespace spdlog;
+
+static logger* logger_ = stdout_color_mt("CameraSimulator").get();
+
+// frame format of the camera, see ToFCameraSrc
+#define SIM_PLANES 4
+#define SIM_HEIGHT 480
+#define SIM_WIDTH 640
+// synthetic frames are precomputed and looped, 1s at 30fps
+#define SIM_SYNTHETIC_FRAMES 30
+// granularity of the bandwidth limit
+#define SIM_SEND_SLICE (64 << 10)
+
+using Clock = std::chrono::steady_clock;
+
+struct CameraSimulator::Client {
+  int fd;
+  // arrival time of the getFrame requests not answered yet
+  std::deque<Clock::time_point> requests;
+  std::string pending;
+  // when the next frame is due at the configured frame rate
+  Clock::time_point deadline;
+  bool resync;
+  // when the simulated link is free to send again
+  Clock::time_point linkFree;
+  uint64_t frames;
+};
+
+CameraSimulator::CameraSimulator(const SimulatorConfig& config)
+    : config_(config),
+      listenFd_(-1),
+      running_(false),
+      fmodMHz_(0),
+      next_frame_(0),
+      frames_sent_(0),
+      bytes_sent_(0) {}
+
+CameraSimulator::~CameraSimulator() {
+  if (listenFd_ >= 0) close(listenFd_);
+}
+
+void CameraSimulator::Stop() { running_ = false; }
+
+void CameraSimulator::GenerateSyntheticFrames(int fmodMHz) {
+  fmodMHz_ = fmodMHz;
+  synthetic_.assign(SIM_SYNTHETIC_FRAMES,
+                    std::vector<int16_t>(SIM_PLANES * SIM_HEIGHT * SIM_WIDTH));
+  const size_t plane = SIM_HEIGHT * SIM_WIDTH;
+  const float phaseScale = 4 * M_PI * fmodMHz * 1e6 / 3e8;
+  uint32_t seed = 1;
+
+  // a slanted wall with a wave running over it, so that depth moves. The
+  // phases are laid out as DepthCalc reads them: i = p1 - p0, q = p3 - p2.
+  for (int f = 0; f < SIM_SYNTHETIC_FRAMES; f++) {
+    int16_t* p = synthetic_[f].data();
+    float t = 2 * M_PI * f / SIM_SYNTHETIC_FRAMES;
+    for (int y = 0; y < SIM_HEIGHT; y++) {
+      for (int x = 0; x < SIM_WIDTH; x++) {
+        float depth = 1.5f + 1.0f * x / SIM_WIDTH +
+                      0.3f * sinf(t + M_PI * y / SIM_HEIGHT);
+        float phase = phaseScale * depth;
+        // falls off with distance, stays within 12 bits
+        float amplitude = 800.0f / (depth * depth);
+        float c = amplitude * cosf(phase);
+        float s = amplitude * sinf(phase);
+        int16_t samples[4] = {(int16_t)c, (int16_t)-c, (int16_t)s,
+                              (int16_t)-s};
+        size_t i = y * SIM_WIDTH + x;
+        for (int k = 0; k < SIM_PLANES; k++) {
+          seed = seed * 1664525 + 1013904223;
+          // a few LSB of noise
+          p[k * plane + i] = samples[k] + (int16_t)((seed >> 28) - 8);
+        }
+      }
+    }
+  }
+  logger_->info("Generated {} synthetic frames at {}MHz", SIM_SYNTHETIC_FRAMES,
+                fmodMHz);
+}
+
+void CameraSimulator::NextFrame(std::vector<int16_t>& frame) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  frame.resize(SIM_PLANES * SIM_HEIGHT * SIM_WIDTH);
+  if (!playback_) {
+    const auto& source = synthetic_[next_frame_++ % synthetic_.size()];
+    std::copy(source.begin(), source.end(), frame.begin());
+    return;
+  }
+
+  Mat m = playback_->GenerateFrame();
+  if (m.empty()) {
+    std::fill(frame.begin(), frame.end(), 0);
+    return;
+  }
+  // planes may not be continuous in the mapped recording
+  const size_t plane = SIM_HEIGHT * SIM_WIDTH;
+  for (int p = 0; p < SIM_PLANES; p++) {
+    int16_t* dst = frame.data() + p * plane;
+    for (int r = 0; r < SIM_HEIGHT; r++) {
+      if (m.type() == CV_12SP) {
+        Packed12::Unpack(m.ptr<uint8_t>(p, r), dst + r * SIM_WIDTH, SIM_WIDTH);
+      } else {
+        memcpy(dst + r * SIM_WIDTH, m.ptr<int16_t>(p, r),
+               SIM_WIDTH * sizeof(int16_t));
+      }
+    }
+  }
+  next_frame_++;
+}
+
+int16_t CameraSimulator::HandleCommand(const std::string& command) {
+  char name[32] = {0};
+  char reg[32] = {0};
+  char value[32] = {0};
+  int fields = sscanf(command.c_str(), "%31s %31s %31s", name, reg, value);
+  std::string cmd(name);
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (cmd == "w" && fields == 3) {
+    registers_[reg] = value;
+    logger_->info("Register {} = {}", reg, value);
+    return 0;
+  } else if (cmd == "setMode" || cmd == "changeOutputMode") {
+    logger_->info("{} {}", cmd, reg);
+    return 0;
+  } else if (cmd == "changeModFreq" && fields >= 2) {
+    int fmodMHz = atoi(reg);
+    if (fmodMHz <= 0) return -1;
+    if (!playback_ && fmodMHz != fmodMHz_) {
+      GenerateSyntheticFrames(fmodMHz);
+    }
+    return 0;
+  }
+  logger_->warn("Unknown command \"{}\"", command);
+  return -1;
+}
+
+bool CameraSimulator::SendPaced(Client& client, const uint8_t* data,
+                                size_t size) {
+  while (size > 0) {
+    size_t slice = size;
+    if (config_.bandwidthMbps > 0) {
+      slice = std::min(size, (size_t)SIM_SEND_SLICE);
+      // the slice goes on the wire once the previous one is through
+      auto start = std::max(Clock::now(), client.linkFree);
+      std::this_thread::sleep_until(start);
+      auto duration = std::chrono::duration<double>(
+          slice * 8 / (config_.bandwidthMbps * 1e6));
+      client.linkFree =
+          start + std::chrono::duration_cast<Clock::duration>(duration);
+    }
+    ssize_t n = send(client.fd, data, slice, MSG_NOSIGNAL);
+    if (n < 0 && errno == EINTR) continue;
+    if (n <= 0) return false;
+    data += n;
+    size -= n;
+    bytes_sent_ += n;
+  }
+  return true;
+}
+
+void CameraSimulator::Serve(int fd) {
+  Client client;
+  client.fd = fd;
+  client.resync = true;
+  client.linkFree = Clock::now();
+  client.frames = 0;
+  auto frameDuration = std::chrono::duration_cast<Clock::duration>(
+      std::chrono::duration<double>(config_.fps > 0 ? 1.0 / config_.fps : 0));
+  std::vector<int16_t> frame;
+  char buffer[4096];
+
+  while (running_) {
+    // don't wait for more requests while some are pending
+    struct pollfd pfd = {fd, POLLIN, 0};
+    int ready = poll(&pfd, 1, client.requests.empty() ? 100 : 0);
+    if (ready > 0) {
+      ssize_t n = recv(fd, buffer, sizeof(buffer), 0);
+      if (n <= 0) break;
+      client.pending.append(buffer, n);
+      auto now = Clock::now();
+
+      // getFrame may come back to back, other commands one at a time
+      while (!client.pending.empty()) {
+        std::string& pending = client.pending;
+        if (pending.compare(0, 8, "getFrame") == 0) {
+          size_t end = 8;
+          while (end < pending.size() &&
+                 (pending[end] == '\0' || pending[end] == '\n')) {
+            end++;
+          }
+          pending.erase(0, end);
+          client.requests.push_back(now);
+          continue;
+        }
+        if (std::string("getFrame").compare(0, pending.size(), pending) ==
+            0) {
+          // the rest of the request is still on its way
+          break;
+        }
+        // setup commands are not terminated, but only sent one at a time
+        size_t end = pending.find_first_of(std::string("\0\n", 2));
+        std::string command = pending.substr(0, end);
+        pending.erase(0, end == std::string::npos ? end : end + 1);
+        if (command.empty()) continue;
+        int16_t ack = HandleCommand(command);
+        if (!SendPaced(client, (uint8_t*)&ack, sizeof(ack))) {
+          logger_->info("Client disconnected");
+          close(fd);
+          return;
+        }
+      }
+    } else if (ready < 0 && errno != EINTR) {
+      break;
+    }
+
+    if (client.requests.empty()) continue;
+
+    // answer the oldest request, not before the link latency and the frame
+    // rate allow
+    auto due = client.requests.front() +
+               std::chrono::milliseconds(config_.latencyMs);
+    if (config_.fps > 0) {
+      auto now = Clock::now();
+      if (client.resync || now - client.deadline > frameDuration) {
+        client.deadline = now;
+        client.resync = false;
+      } else {
+        client.deadline += frameDuration;
+      }
+      due = std::max(due, client.deadline);
+    }
+    std::this_thread::sleep_until(due);
+    client.requests.pop_front();
+
+    if (config_.stallEvery > 0 && config_.stallMs > 0 &&
+        ++client.frames % config_.stallEvery == 0) {
+      logger_->info("Stalling the link for {}ms", config_.stallMs);
+      std::this_thread::sleep_for(std::chrono::milliseconds(config_.stallMs));
+      client.resync = true;
+    }
+
+    NextFrame(frame);
+    if (!SendPaced(client, (uint8_t*)frame.data(),
+                   frame.size() * sizeof(int16_t))) {
+      break;
+    }
+    frames_sent_++;
+  }
+
+  logger_->info("Client disconnected");
+  close(fd);
+}
+
+void CameraSimulator::PrintStats() {
+  static uint64_t lastFrames = 0;
+  static uint64_t lastBytes = 0;
+  uint64_t frames = frames_sent_;
+  uint64_t bytes = bytes_sent_;
+  if (frames != lastFrames) {
+    logger_->info("{} fps, {:.1f} MB/s", frames - lastFrames,
+                  (bytes - lastBytes) / 1e6);
+  }
+  lastFrames = frames;
+  lastBytes = bytes;
+}
+
+bool CameraSimulator::Run() {
+  if (!config_.recording.empty()) {
+    playback_.reset(new PlaybackSource("simulator", false, true));
+    playback_->SetFilename(config_.recording);
+    playback_->SetPacing(kPlaybackPacingUnthrottled);
+    playback_->SetFormat({SIM_PLANES, SIM_HEIGHT, SIM_WIDTH}, CV_16SC1);
+    if (!playback_->InitializeSource()) {
+      logger_->error("Failed to open {}", config_.recording);
+      return false;
+    }
+    MatShape shape;
+    int type;
+    playback_->GetSourcePad()->GetFrameFormat(shape, type);
+    bool packed = Packed12::IsPacked(shape, type);
+    if (packed) shape = Packed12::GetUnpackedShape(shape);
+    if (shape.dims() != 3 || shape[0] != SIM_PLANES ||
+        shape[1] != SIM_HEIGHT || shape[2] != SIM_WIDTH ||
+        (type != CV_16SC1 && !packed)) {
+      logger_->error("{} is not a {}x{}x{} phase recording", config_.recording,
+                     SIM_PLANES, SIM_HEIGHT, SIM_WIDTH);
+      return false;
+    }
+    logger_->info("Serving {} frames of {}", playback_->GetFrameCount(),
+                  config_.recording);
+  } else {
+    GenerateSyntheticFrames(config_.fmodMHz);
+  }
+
+  listenFd_ = socket(AF_INET, SOCK_STREAM, 0);
+  int reuse = 1;
+  setsockopt(listenFd_, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+  struct sockaddr_in addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(config_.port);
+  addr.sin_addr.s_addr = htonl(INADDR_ANY);
+  if (bind(listenFd_, (struct sockaddr*)&addr, sizeof(addr)) < 0 ||
+      listen(listenFd_, 16) < 0) {
+    logger_->error("Failed to listen on port {}: {}", config_.port,
+                   strerror(errno));
+    return false;
+  }
+  logger_->info("Listening on port {}, {} fps, {} Mbit/s, {}ms latency",
+                config_.port, config_.fps, config_.bandwidthMbps,
+                config_.latencyMs);
+
+  running_ = true;
+  // clients reconnect often (e.g. on every timeout), finished threads are
+  // joined as we go instead of piling up until Stop()
+  struct Client {
+    std::thread thread;
+    std::shared_ptr<std::atomic<bool>> done;
+  };
+  std::list<Client> clients;
+  auto lastStats = Clock::now();
+  while (running_) {
+    struct pollfd pfd = {listenFd_, POLLIN, 0};
+    if (poll(&pfd, 1, 100) > 0) {
+      int fd = accept(listenFd_, nullptr, nullptr);
+      if (fd >= 0) {
+        int nodelay = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &nodelay, sizeof(nodelay));
+        logger_->info("Client connected");
+        auto done = std::make_shared<std::atomic<bool>>(false);
+        std::thread thread([this, fd, done]() {
+          Serve(fd);
+          *done = true;
+        });
+        clients.push_back({std::move(thread), done});
+      }
+    }
+    for (auto it = clients.begin(); it != clients.end();) {
+      if (*it->done) {
+        it->thread.join();
+        it = clients.erase(it);
+      } else {
+        it++;
+      }
+    }
+    if (Clock::now() - lastStats >= std::chrono::seconds(1)) {
+      PrintStats();
+      lastStats = Clock::now();
+    }
+  }
+
+  for (auto& client : clients) {
+    client.thread.join();
+  }
+  if (playback_) playback_->CleanupSource();
+  return true;
+}
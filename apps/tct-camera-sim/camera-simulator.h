@@ -0,0 +1,89 @@
+#pragma once
+#include <sdk/core/pad.h>
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+class PlaybackSource;
+
+struct SimulatorConfig {
+  int port = 50660;
+  // recording to serve, synthetic frames if empty
+  std::string recording;
+  // frames per second, 0 for as fast as requested
+  float fps = 30;
+  // link bandwidth in Mbit/s, 0 for unlimited
+  float bandwidthMbps = 0;
+  // delay between a request and its answer
+  int latencyMs = 0;
+  // every stallEvery frames, stall the link for stallMs
+  int stallEvery = 0;
+  int stallMs = 0;
+  // modulation frequency of the synthetic frames, changeModFreq overrides it
+  int fmodMHz = 20;
+};
+
+/**
+ * @brief Serves the ToF camera command protocol used by ToFCameraSrc on a TCP
+ * port: "w <reg> <value>", "setMode", "changeOutputMode" and "changeModFreq"
+ * are acknowledged with an int16 0, "getFrame" is answered with a raw
+ * 4x480x640 CV_16SC1 frame. Commands may be NUL or newline terminated, so
+ * requests sent back to back can be told apart.
+ *
+ */
+class CameraSimulator {
+ public:
+  CameraSimulator(const SimulatorConfig& config);
+  ~CameraSimulator();
+
+  /**
+   * @brief Accept and serve clients until Stop(), one thread per client.
+   *
+   * @return false if the port cannot be listened on or the recording opened
+   */
+  bool Run();
+  void Stop();
+
+ private:
+  struct Client;
+
+  void Serve(int fd);
+  /**
+   * @brief Handle one command that is not getFrame.
+   *
+   * @return int16_t ack, 0 if ok
+   */
+  int16_t HandleCommand(const std::string& command);
+  /**
+   * @brief Copy the next frame to serve.
+   *
+   * @param frame 4x480x640 int16 samples
+   */
+  void NextFrame(std::vector<int16_t>& frame);
+  void GenerateSyntheticFrames(int fmodMHz);
+  /**
+   * @brief Send as the link allows, with the configured bandwidth and stalls.
+   *
+   * @return false if the client is gone
+   */
+  bool SendPaced(Client& client, const uint8_t* data, size_t size);
+  void PrintStats();
+
+  SimulatorConfig config_;
+  int listenFd_;
+  std::atomic<bool> running_;
+  std::mutex mutex_;
+  // loop of synthetic frames, or the recording
+  std::vector<std::vector<int16_t>> synthetic_;
+  int fmodMHz_;
+  std::unique_ptr<PlaybackSource> playback_;
+  uint64_t next_frame_;
+  std::map<std::string, std::string> registers_;
+  std::atomic<uint64_t> frames_sent_;
+  std::atomic<uint64_t> bytes_sent_;
+};
@@ -0,0 +1,81 @@
+#include <getopt.h>
+#include <signal.h>
+
+#include <cstdio>
+#include <cstdlib>
+
+#include "camera-simulator.h"
+
+static CameraSimulator* simulator = nullptr;
+
+static void OnSignal(int) {
+  if (simulator != nullptr) simulator->Stop();
+}
+
+static void Usage(const char* name) {
+  fprintf(stderr,
+          "Usage: %s [options]\n"
+          "Simulate a ToF camera on the network, for ToFCameraSrc.\n"
+          "\n"
+          "  -p <port>       TCP port (default 50660)\n"
+          "  -r <file>       serve a 4x480x640 phase recording, looped\n"
+          "                  (default synthetic frames)\n"
+          "  -m <MHz>        modulation frequency of synthetic frames\n"
+          "                  (default 20)\n"
+          "  -f <fps>        frame rate, 0 for as fast as requested\n"
+          "                  (default 30)\n"
+          "  -b <Mbit/s>     link bandwidth, 0 for unlimited (default 0)\n"
+          "  -l <ms>         latency of the answers (default 0)\n"
+          "  -s <n>:<ms>     stall the link for <ms> every <n> frames\n",
+          name);
+}
+
+int main(int argc, char** argv) {
+  SimulatorConfig config;
+
+  int opt;
+  while ((opt = getopt(argc, argv, "p:r:m:f:b:l:s:h")) != -1) {
+    switch (opt) {
+      case 'p':
+        config.port = atoi(optarg);
+        break;
+      case 'r':
+        config.recording = optarg;
+        break;
+      case 'm':
+        config.fmodMHz = atoi(optarg);
+        break;
+      case 'f':
+        config.fps = atof(optarg);
+        break;
+      case 'b':
+        config.bandwidthMbps = atof(optarg);
+        break;
+      case 'l':
+        config.latencyMs = atoi(optarg);
+        break;
+      case 's':
+        if (sscanf(optarg, "%d:%d", &config.stallEvery, &config.stallMs) !=
+            2) {
+          Usage(argv[0]);
+          return 1;
+        }
+        break;
+      default:
+        Usage(argv[0]);
+        return 1;
+    }
+  }
+  if (optind != argc || config.fmodMHz <= 0) {
+    Usage(argv[0]);
+    return 1;
+  }
+
+  CameraSimulator sim(config);
+  simulator = &sim;
+  signal(SIGINT, OnSignal);
+  signal(SIGTERM, OnSignal);
+  signal(SIGPIPE, SIG_IGN);
+
+  return sim.Run() ? 0 : 1;
+}
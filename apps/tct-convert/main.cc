@@ -0,0 +1,81 @@
+#include <getopt.h>
+#include <sdk/tof/batch-converter.h>
+#include <sdk/tof/depth-calc.h>
+#include <sdk/tof/moving-average.h>
+
+#include <cstdio>
+#include <cstdlib>
+
+static void Usage(const char* name) {
+  fprintf(stderr,
+          "Usage: %s [options] <recording> <result>\n"
+          "Convert a phase recording to depth and amplitude on all cores.\n"
+          "\n"
+          "  -f <MHz>     modulation frequency (default 37)\n"
+          "  -o <m>       depth offset (default 0)\n"
+          "  -a <frames>  moving average window, 1 to disable (default 1)\n"
+          "  -j <count>   worker threads (default one per core)\n"
+          "  -c <frames>  frames per chunk (default one chunk per worker)\n",
+          name);
+}
+
+int main(int argc, char** argv) {
+  float fmodMHz = 37;
+  float offset = 0;
+  int window = 1;
+  int workers = 0;
+  int chunkSize = 0;
+
+  int opt;
+  while ((opt = getopt(argc, argv, "f:o:a:j:c:h")) != -1) {
+    switch (opt) {
+      case 'f':
+        fmodMHz = atof(optarg);
+        break;
+      case 'o':
+        offset = atof(optarg);
+        break;
+      case 'a':
+        window = atoi(optarg);
+        break;
+      case 'j':
+        workers = atoi(optarg);
+        break;
+      case 'c':
+        chunkSize = atoi(optarg);
+        break;
+      default:
+        Usage(argv[0]);
+        return 1;
+    }
+  }
+  if (argc - optind != 2 || fmodMHz <= 0 || window < 1) {
+    Usage(argv[0]);
+    return 1;
+  }
+
+  BatchConverter converter;
+  converter.SetInput(argv[optind]);
+  converter.SetOutput(argv[optind + 1]);
+  converter.SetWorkers(workers);
+  converter.SetChunkSize(chunkSize);
+  // the average of a chunk first frame needs the window - 1 frames before
+  converter.SetOverlap(window - 1);
+  converter.SetPipeline(
+      [=](Pad* src, vector<shared_ptr<Element>>& elements) -> Pad* {
+        auto depth = make_shared<DepthCalc>("depth");
+        depth->SetConfig(fmodMHz * 1e6, offset);
+        src->Link(depth->GetSinkPad());
+        elements.push_back(depth);
+        if (window <= 1) {
+          return depth->GetSourcePad();
+        }
+        auto average = make_shared<MovingAverage>("average");
+        average->SetWindowSize(window);
+        depth->GetSourcePad()->Link(average->GetSinkPad());
+        elements.push_back(average);
+        return average->GetSourcePad();
+      });
+
+  return converter.Run() ? 0 : 1;
+}
@@ -3,7 +3,11 @@
 #include <ImGuiFileDialog.h>
 #include <sdk/tof/depth-calc.h>
 #include <sdk/tof/moving-average.h>
+#include <sdk/tof/packer.h>
 #include <sdk/tof/playback-src.h>
+#include <sdk/tof/recorder-sink.h>
+#include <sdk/tof/rvl-sink.h>
+#include <sdk/tof/rvl-src.h>
 #include <sdk/tof/unprojection.h>
 
 #include <nlohmann/json.hpp>
@@ -125,6 +129,8 @@ PlayBackNode::PlayBackNode(const std::string& name, ImColor color)
   typeId_ = CV_16SC1;
   fps_ = 30;
   loop_ = true;
+  prefetchDepth_ = 0;
+  pacing_ = kPlaybackPacingDeadline;
   changed = false;
 };
 
@@ -250,6 +256,26 @@ void PlayBackNode::DrawBody() {
   if (ImGui::Checkbox("Loop", &loop_)) {
     playback->SetLoop(loop_);
   }
+  static const char* pacings[] = {"Unthrottled", "Deadline", "Recorded"};
+  ImGui::PushItemWidth(100);
+  if (ImGui::Combo("Pacing", &pacing_, pacings, IM_ARRAYSIZE(pacings))) {
+    playback->SetPacing((PlaybackPacing)pacing_);
+  }
+  ImGui::PopItemWidth();
+  if (ImGui::DragInt("Prefetch", &prefetchDepth_, 1, 0, 32)) {
+    playback->SetPrefetchDepth(prefetchDepth_);
+  }
+  ToFFrameMeta meta;
+  if (playback->GetFrameMeta(meta) && !meta.subframes.empty()) {
+    ImGui::Text("#%d fmod %.2f MHz temp %u", meta.frame_index,
+                meta.subframes[0].modulation_frequency / 1e6f,
+                meta.subframes[0].sensor_temperature);
+  }
+  if (prefetchDepth_ > 0) {
+    ImGui::SameLine();
+    ImGui::Text("hit %lu miss %lu", (unsigned long)playback->GetPrefetchHits(),
+                (unsigned long)playback->GetPrefetchMisses());
+  }
 
   ImGui::PopItemWidth();
   ImGui::EndGroup();
@@ -282,11 +308,32 @@ void PlayBackNode::DrawBody() {
       nodeEditor_->flowing_ = false;
     }
     ImGui::SameLine();
+    if (ImGui::Button(ICON_FA_STEP_BACKWARD "Back")) {
+      playback->StepBackward();
+      nodeEditor_->flowing_ = false;
+    }
+    ImGui::SameLine();
     if (ImGui::Button(ICON_FA_STEP_FORWARD "Step")) {
       playback->Step();
       nodeEditor_->flowing_ = false;
     }
   }
+
+  if (state == StreamState::kStreamStateStopped) {
+    ImGui::SameLine();
+    if (ImGui::Button(ICON_FA_LIST "Index")) {
+      playback->BuildIndex();
+    }
+  } else if (playback->GetFrameCount() > 0) {
+    int position = playback->GetPosition();
+    ImGui::PushItemWidth(200);
+    if (ImGui::SliderInt("Frame", &position, 0,
+                         playback->GetFrameCount() - 1)) {
+      playback->Seek(position);
+      if (state == StreamState::kStreamStatePaused) playback->Step();
+    }
+    ImGui::PopItemWidth();
+  }
   ImGui::PopID();
 
   ImGui::EndGroup();
@@ -304,6 +351,8 @@ void PlayBackNode::SaveState() {
   nodeSettings["type"] = typeId_;
   nodeSettings["fps"] = fps_;
   nodeSettings["loop"] = loop_;
+  nodeSettings["prefetchDepth"] = prefetchDepth_;
+  nodeSettings["pacing"] = pacing_;
 
   nodeSettings_ = nodeSettings.dump();
 };
@@ -322,11 +371,15 @@ void PlayBackNode::LoadState(std::string& savedData) {
   typeId_ = nodeSettings["type"].get<int>();
   fps_ = nodeSettings["fps"].get<float>();
   loop_ = nodeSettings["loop"].get<bool>();
+  prefetchDepth_ = nodeSettings.value("prefetchDepth", 0);
+  pacing_ = nodeSettings.value("pacing", (int)kPlaybackPacingDeadline);
 
   playback->SetFilename(fn_);
   playback->SetFormat(shape_, typeId_);
   playback->SetFrameRate(fps_);
   playback->SetLoop(loop_);
+  playback->SetPrefetchDepth(prefetchDepth_);
+  playback->SetPacing((PlaybackPacing)pacing_);
 };
 
 RawToDepthNode::RawToDepthNode(const std::string& name, ImColor color)
@@ -408,6 +461,264 @@ void MovingAverageNode::LoadState(std::string& savedData) {
   movingAverage->SetWindowSize(width);
 };
 
+PackerNode::PackerNode(const std::string& name, ImColor color)
+    : ElementWrapper() {
+  auto packer = std::make_shared<Packer>(name);
+  element_ = packer;
+  BuildNode();
+  mode_ = kPackerPack;
+};
+
+void PackerNode::DrawBody() {
+  auto packer = dynamic_cast<Packer*>(element_.get());
+  const char* modes[] = {"Pack", "Unpack"};
+  ImGui::BeginGroup();
+  ImGui::PushItemWidth(80);
+  ImGui::PushID(element_->GetName().c_str());
+  if (ImGui::Combo("Mode", &mode_, modes, IM_ARRAYSIZE(modes))) {
+    packer->SetMode((PackerMode)mode_);
+  }
+  ImGui::PopID();
+  ImGui::PopItemWidth();
+  ImGui::EndGroup();
+};
+
+void PackerNode::SaveState() {
+  nlohmann::json nodeSettings;
+
+  nodeSettings["mode"] = mode_;
+
+  nodeSettings_ = nodeSettings.dump();
+};
+
+void PackerNode::LoadState(std::string& savedData) {
+  nlohmann::json nodeSettings = nlohmann::json::parse(savedData);
+
+  auto packer = dynamic_cast<Packer*>(element_.get());
+  mode_ = nodeSettings.value("mode", (int)kPackerPack);
+  packer->SetMode((PackerMode)mode_);
+};
+
+RecorderNode::RecorderNode(const std::string& name, ImColor color)
+    : ElementWrapper() {
+  auto recorder = std::make_shared<RecorderSink>(name);
+  element_ = recorder;
+  BuildNode();
+  strcpy(fn_, "recording.bin");
+  segmentSizeMB_ = 0;
+  directIO_ = false;
+  compress_ = false;
+  fps_ = 30;
+  recorder->SetFilename(fn_);
+};
+
+void RecorderNode::DrawBody() {
+  auto recorder = dynamic_cast<RecorderSink*>(element_.get());
+  bool recording = recorder->IsRecording();
+  ImGui::BeginGroup();
+  ImGui::PushItemWidth(100);
+  ImGui::PushID(element_->GetName().c_str());
+  // settings take effect on next recording, hide them meanwhile
+  if (!recording) {
+    if (ImGui::InputText("File", fn_, sizeof(fn_))) {
+      recorder->SetFilename(fn_);
+    }
+    if (ImGui::DragInt("Segment (MB)", &segmentSizeMB_, 1, 0, 65536)) {
+      recorder->SetSegmentSize((size_t)segmentSizeMB_ << 20);
+    }
+    if (ImGui::Checkbox("O_DIRECT", &directIO_)) {
+      recorder->SetDirectIO(directIO_);
+    }
+    if (ImGui::Checkbox("Compress", &compress_)) {
+      recorder->SetCodec(compress_ ? kToFCodecPhase : kToFCodecNone);
+    }
+    if (ImGui::DragFloat("FPS", &fps_, 1, 1, 60, "%.2f")) {
+      recorder->SetFrameRate(fps_);
+    }
+  } else {
+    ImGui::TextWrapped("%s", fn_);
+  }
+
+  if (!recording) {
+    if (ImGui::Button(ICON_FA_CIRCLE "Record")) {
+      recorder->StartRecording();
+    }
+  } else if (ImGui::Button(ICON_FA_STOP "Stop")) {
+    recorder->StopRecording();
+  }
+  ImGui::SameLine();
+  ImGui::Text("%lu frames, %lu dropped, %.1f MB",
+              (unsigned long)recorder->GetFramesWritten(),
+              (unsigned long)recorder->GetFramesDropped(),
+              recorder->GetBytesWritten() / 1e6);
+  ImGui::PopID();
+  ImGui::PopItemWidth();
+  ImGui::EndGroup();
+};
+
+void RecorderNode::SaveState() {
+  nlohmann::json nodeSettings;
+
+  nodeSettings["filename"] = std::string(fn_);
+  nodeSettings["segmentSizeMB"] = segmentSizeMB_;
+  nodeSettings["directIO"] = directIO_;
+  nodeSettings["compress"] = compress_;
+  nodeSettings["fps"] = fps_;
+
+  nodeSettings_ = nodeSettings.dump();
+};
+
+void RecorderNode::LoadState(std::string& savedData) {
+  auto recorder = dynamic_cast<RecorderSink*>(element_.get());
+  nlohmann::json nodeSettings = nlohmann::json::parse(savedData);
+
+  std::string filename = nodeSettings.value("filename", std::string(fn_));
+  strncpy(fn_, filename.c_str(), sizeof(fn_) - 1);
+  segmentSizeMB_ = nodeSettings.value("segmentSizeMB", segmentSizeMB_);
+  directIO_ = nodeSettings.value("directIO", directIO_);
+  compress_ = nodeSettings.value("compress", compress_);
+  fps_ = nodeSettings.value("fps", fps_);
+  recorder->SetFilename(fn_);
+  recorder->SetSegmentSize((size_t)segmentSizeMB_ << 20);
+  recorder->SetDirectIO(directIO_);
+  recorder->SetCodec(compress_ ? kToFCodecPhase : kToFCodecNone);
+  recorder->SetFrameRate(fps_);
+};
+
+RvlRecorderNode::RvlRecorderNode(const std::string& name, ImColor color)
+    : ElementWrapper() {
+  auto recorder = std::make_shared<RvlSink>(name);
+  element_ = recorder;
+  BuildNode();
+  strcpy(fn_, "depth.rvl");
+  depthScaleMM_ = DEFAULT_RVL_DEPTH_SCALE * 1000;
+  amplitude_ = true;
+  recorder->SetFilename(fn_);
+};
+
+void RvlRecorderNode::DrawBody() {
+  auto recorder = dynamic_cast<RvlSink*>(element_.get());
+  bool recording = recorder->IsRecording();
+  ImGui::BeginGroup();
+  ImGui::PushItemWidth(100);
+  ImGui::PushID(element_->GetName().c_str());
+  if (!recording) {
+    if (ImGui::InputText("File", fn_, sizeof(fn_))) {
+      recorder->SetFilename(fn_);
+    }
+    if (ImGui::DragFloat("Depth step (mm)", &depthScaleMM_, 0.1, 0.1, 10,
+                         "%.1f")) {
+      recorder->SetScale(depthScaleMM_ / 1000, DEFAULT_RVL_AMPLITUDE_SCALE);
+    }
+    if (ImGui::Checkbox("Amplitude", &amplitude_)) {
+      recorder->SetAmplitude(amplitude_);
+    }
+    if (ImGui::Button(ICON_FA_CIRCLE "Record")) {
+      recorder->StartRecording();
+    }
+  } else {
+    ImGui::TextWrapped("%s", fn_);
+    if (ImGui::Button(ICON_FA_STOP "Stop")) {
+      recorder->StopRecording();
+    }
+  }
+  ImGui::SameLine();
+  ImGui::Text("%lu frames, %.1f MB",
+              (unsigned long)recorder->GetFramesWritten(),
+              recorder->GetBytesWritten() / 1e6);
+  ImGui::PopID();
+  ImGui::PopItemWidth();
+  ImGui::EndGroup();
+};
+
+void RvlRecorderNode::SaveState() {
+  nlohmann::json nodeSettings;
+
+  nodeSettings["filename"] = std::string(fn_);
+  nodeSettings["depthScaleMM"] = depthScaleMM_;
+  nodeSettings["amplitude"] = amplitude_;
+
+  nodeSettings_ = nodeSettings.dump();
+};
+
+void RvlRecorderNode::LoadState(std::string& savedData) {
+  auto recorder = dynamic_cast<RvlSink*>(element_.get());
+  nlohmann::json nodeSettings = nlohmann::json::parse(savedData);
+
+  std::string filename = nodeSettings.value("filename", std::string(fn_));
+  strncpy(fn_, filename.c_str(), sizeof(fn_) - 1);
+  depthScaleMM_ = nodeSettings.value("depthScaleMM", depthScaleMM_);
+  amplitude_ = nodeSettings.value("amplitude", amplitude_);
+  recorder->SetFilename(fn_);
+  recorder->SetScale(depthScaleMM_ / 1000, DEFAULT_RVL_AMPLITUDE_SCALE);
+  recorder->SetAmplitude(amplitude_);
+};
+
+RvlPlayBackNode::RvlPlayBackNode(const std::string& name, ImColor color)
+    : ElementWrapper() {
+  auto playback = std::make_shared<RvlSource>(name, false, true);
+  element_ = playback;
+  auto& app = Application::GetInstance();
+  nodeEditor_ = app.nodeEditor;
+  BuildNode();
+  strcpy(fn_, "depth.rvl");
+  fps_ = 30;
+  loop_ = true;
+  playback->SetFilename(fn_);
+};
+
+void RvlPlayBackNode::DrawBody() {
+  auto playback = dynamic_cast<RvlSource*>(element_.get());
+  ImGui::BeginGroup();
+  ImGui::PushItemWidth(100);
+  ImGui::PushID(element_->GetName().c_str());
+  if (ImGui::InputText("File", fn_, sizeof(fn_))) {
+    playback->SetFilename(fn_);
+  }
+  if (ImGui::DragFloat("FPS", &fps_, 1, 1, 60, "%.2f")) {
+    playback->SetFrameRate(fps_);
+  }
+  if (ImGui::Checkbox("Loop", &loop_)) {
+    playback->SetLoop(loop_);
+  }
+
+  if (playback->GetState() == StreamState::kStreamStateStopped) {
+    if (ImGui::Button(ICON_FA_PLAY "Play")) {
+      playback->Start();
+      nodeEditor_->flowing_ = true;
+    }
+  } else if (ImGui::Button(ICON_FA_STOP "Stop")) {
+    playback->Stop();
+    nodeEditor_->flowing_ = false;
+  }
+  ImGui::PopID();
+  ImGui::PopItemWidth();
+  ImGui::EndGroup();
+};
+
+void RvlPlayBackNode::SaveState() {
+  nlohmann::json nodeSettings;
+
+  nodeSettings["filename"] = std::string(fn_);
+  nodeSettings["fps"] = fps_;
+  nodeSettings["loop"] = loop_;
+
+  nodeSettings_ = nodeSettings.dump();
+};
+
+void RvlPlayBackNode::LoadState(std::string& savedData) {
+  auto playback = dynamic_cast<RvlSource*>(element_.get());
+  nlohmann::json nodeSettings = nlohmann::json::parse(savedData);
+
+  std::string filename = nodeSettings.value("filename", std::string(fn_));
+  strncpy(fn_, filename.c_str(), sizeof(fn_) - 1);
+  fps_ = nodeSettings.value("fps", fps_);
+  loop_ = nodeSettings.value("loop", loop_);
+  playback->SetFilename(fn_);
+  playback->SetFrameRate(fps_);
+  playback->SetLoop(loop_);
+};
+
 UnprojectionNode::UnprojectionNode(const std::string& name, ImColor color)
     : ElementWrapper() {
   auto unprojection = std::make_shared<Unprojection>(name);
@@ -416,6 +727,11 @@ UnprojectionNode::UnprojectionNode(const std::string& name, ImColor color)
   usePreset_ = true;
   presetNames_ = PinholeParams::GetPresetNames();
   presetIdx_ = 0;
+  compact_ = unprojection->IsCompactMode();
+  minDepth_ = 0.0f;
+  maxDepth_ = 10.0f;
+  minAmplitude_ = unprojection->GetMinAmplitude();
+  unprojection->SetDepthRange(minDepth_, maxDepth_);
   BuildNode();
 };
 
@@ -462,6 +778,22 @@ void UnprojectionNode::DrawBody() {
     }
   }
 
+  if (ImGui::Checkbox("Compact", &compact_)) {
+    unprojection->SetCompactMode(compact_);
+  }
+  if (compact_) {
+    if (ImGui::DragFloat("Min depth (m)", &minDepth_, 0.01, 0.0, 100.0,
+                         "%.2f") ||
+        ImGui::DragFloat("Max depth (m)", &maxDepth_, 0.01, 0.0, 100.0,
+                         "%.2f")) {
+      unprojection->SetDepthRange(minDepth_, maxDepth_);
+    }
+    if (ImGui::DragFloat("Min amplitude", &minAmplitude_, 1, 0.0, 1000.0,
+                         "%.0f")) {
+      unprojection->SetMinAmplitude(minAmplitude_);
+    }
+  }
+
   ImGui::PopID();
   ImGui::PopItemWidth();
   ImGui::EndGroup();
@@ -485,6 +817,15 @@ void UnprojectionNode::LoadState(std::string& savedData) {
     params_ = PinholeParams(fx, fy, cx, cy, dx, dy);
   }
   unprojection->SetParams(params_);
+
+  // compact settings are optional, for files saved before they existed
+  compact_ = nodeSettings.value("compact", false);
+  minDepth_ = nodeSettings.value("minDepth", minDepth_);
+  maxDepth_ = nodeSettings.value("maxDepth", maxDepth_);
+  minAmplitude_ = nodeSettings.value("minAmplitude", minAmplitude_);
+  unprojection->SetDepthRange(minDepth_, maxDepth_);
+  unprojection->SetMinAmplitude(minAmplitude_);
+  unprojection->SetCompactMode(compact_);
 }
 
 void UnprojectionNode::SaveState() {
@@ -498,6 +839,10 @@ void UnprojectionNode::SaveState() {
   nodeSettings["cy"] = params_.cy_;
   nodeSettings["dx"] = params_.dx_;
   nodeSettings["dy"] = params_.dy_;
+  nodeSettings["compact"] = compact_;
+  nodeSettings["minDepth"] = minDepth_;
+  nodeSettings["maxDepth"] = maxDepth_;
+  nodeSettings["minAmplitude"] = minAmplitude_;
 
   nodeSettings_ = nodeSettings.dump();
 }
@@ -620,6 +965,22 @@ std::map<std::string, NodeConstructor>& GetNodeConstructors() {
        [](const std::string& name) {
          return std::make_shared<MovingAverageNode>(name);
        }},
+      {"Packer",
+       [](const std::string& name) {
+         return std::make_shared<PackerNode>(name);
+       }},
+      {"Recorder",
+       [](const std::string& name) {
+         return std::make_shared<RecorderNode>(name);
+       }},
+      {"RvlRecorder",
+       [](const std::string& name) {
+         return std::make_shared<RvlRecorderNode>(name);
+       }},
+      {"RvlPlayBack",
+       [](const std::string& name) {
+         return std::make_shared<RvlPlayBackNode>(name);
+       }},
       {"Unprojection",
        [](const std::string& name) {
          return std::make_shared<UnprojectionNode>(name);
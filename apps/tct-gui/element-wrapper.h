@@ -73,6 +73,8 @@ struct PlayBackNode : public ElementWrapper {
   int typeId_;
   float fps_;
   bool loop_;
+  int prefetchDepth_;
+  int pacing_;
   bool changed;
 };
 
@@ -95,6 +97,50 @@ struct MovingAverageNode : public ElementWrapper {
   int width;
 };
 
+struct PackerNode : public ElementWrapper {
+  PackerNode(const std::string& name, ImColor color = ImColor(255, 255, 255));
+  void DrawBody() override;
+  void SaveState() override;
+  void LoadState(std::string& savedData) override;
+  int mode_;
+};
+
+struct RecorderNode : public ElementWrapper {
+  RecorderNode(const std::string& name,
+               ImColor color = ImColor(255, 255, 255));
+  void DrawBody() override;
+  void SaveState() override;
+  void LoadState(std::string& savedData) override;
+  char fn_[256];
+  int segmentSizeMB_;
+  bool directIO_;
+  bool compress_;
+  float fps_;
+};
+
+struct RvlRecorderNode : public ElementWrapper {
+  RvlRecorderNode(const std::string& name,
+                  ImColor color = ImColor(255, 255, 255));
+  void DrawBody() override;
+  void SaveState() override;
+  void LoadState(std::string& savedData) override;
+  char fn_[256];
+  float depthScaleMM_;
+  bool amplitude_;
+};
+
+struct RvlPlayBackNode : public ElementWrapper {
+  RvlPlayBackNode(const std::string& name,
+                  ImColor color = ImColor(255, 255, 255));
+  void DrawBody() override;
+  void SaveState() override;
+  void LoadState(std::string& savedData) override;
+  NodeEditor* nodeEditor_;
+  char fn_[256];
+  float fps_;
+  bool loop_;
+};
+
 struct UnprojectionNode : public ElementWrapper {
   UnprojectionNode(const std::string& name,
                    ImColor color = ImColor(255, 255, 255));
@@ -106,6 +152,10 @@ struct UnprojectionNode : public ElementWrapper {
   int presetIdx_;
   bool showPresetPopup_;
   std::vector<std::string> presetNames_;
+  bool compact_;
+  float minDepth_;
+  float maxDepth_;
+  float minAmplitude_;
 };
 
 struct VideoOutputNode : public ElementWrapper {
@@ -119,6 +119,12 @@ GraphicImageItem::GraphicImageItem(std::string name) : GraphicsItem(name) {
   geometries_.push_back(ImVec2(0, 0));
   uv0 = ImVec2(0.0f, 0.0f);
   uv1 = ImVec2(1.0f, 1.0f);
+  imageTextureId_ = 0;
+  isFloat_ = false;
+  cmapType_ = -1;
+  colormap_.lutTextureId = 0;
+  colormap_.min = 0.0f;
+  colormap_.max = 1.0f;
 }
 
 GraphicImageItem::GraphicImageItem(cv::Mat& image, std::string name)
@@ -130,20 +136,49 @@ void GraphicImageItem::setImage(cv::Mat& image) {
   if (image.empty()) {
     throw std::runtime_error("empty image");
   }
-  UploadCvMatToGpuTexture(image, (GLuint*)&imageTextureId_, &imageSize_);
+  bool isFloat = (image.type() == CV_32FC1);
+  if (isFloat != isFloat_ && imageTextureId_ != 0) {
+    // another texture format
+    glDeleteTextures(1, (GLuint*)&imageTextureId_);
+    imageTextureId_ = 0;
+  }
+  isFloat_ = isFloat;
+  if (isFloat_) {
+    UploadFloatToGpuTexture(image, (GLuint*)&imageTextureId_, &imageSize_);
+    if (colormap_.lutTextureId == 0) {
+      UploadColormapLut(cmapType_, &colormap_.lutTextureId);
+    }
+  } else {
+    UploadCvMatToGpuTexture(image, (GLuint*)&imageTextureId_, &imageSize_);
+  }
   if (imageSize_ != geometries_[1]) {
     geometries_[1] = imageSize_;
     update();
   }
 }
 
+void GraphicImageItem::setColormap(int cmapType, float min, float max) {
+  if (cmapType != cmapType_ || colormap_.lutTextureId == 0) {
+    cmapType_ = cmapType;
+    UploadColormapLut(cmapType_, &colormap_.lutTextureId);
+  }
+  colormap_.min = min;
+  colormap_.max = max;
+}
+
 void GraphicImageItem::paintSelf() {
   if (imageTextureId_ == 0) {
     return;
   }
   ImVec2 pmin = sceneGeometries_[0];
   ImVec2 pmax = sceneGeometries_[1];
-  ImGui::GetWindowDrawList()->AddImage(imageTextureId_, pmin, pmax, uv0, uv1);
+  if (isFloat_) {
+    AddColormappedImage(ImGui::GetWindowDrawList(), imageTextureId_,
+                        &colormap_, pmin, pmax, uv0, uv1);
+  } else {
+    ImGui::GetWindowDrawList()->AddImage(imageTextureId_, pmin, pmax, uv0,
+                                         uv1);
+  }
 }
 
 void GraphicImageItem::clipSelf(ImRect r) {
@@ -2,6 +2,7 @@
 #include <opencv2/core.hpp>
 
 #include "graphics-item.h"
+#include "utility.h"
 
 struct GraphicLineItem : public GraphicsItem {
   GraphicLineItem(ImVec2 p1, ImVec2 p2, std::string name = "");
@@ -30,7 +31,17 @@ struct GraphicPolygonItem : public GraphicsItem {
 struct GraphicImageItem : public GraphicsItem {
   GraphicImageItem(std::string name = "");
   GraphicImageItem(cv::Mat& image, std::string name = "");
+  // CV_32FC1 images are uploaded as is and colormapped by a shader, see
+  // setColormap(), other images are converted to RGBA
   void setImage(cv::Mat& image);
+  /**
+   * @brief Set the colormap of float images.
+   *
+   * @param cmapType cv::ColormapTypes, or -1 for grayscale
+   * @param min value at the start of the colormap, lower values are clamped
+   * @param max value at the end of the colormap, higher values are clamped
+   */
+  void setColormap(int cmapType, float min, float max);
   void paintSelf() override;
   void clipSelf(ImRect r) override;
   bool hitTest(ImVec2 p) override;
@@ -39,6 +50,9 @@ struct GraphicImageItem : public GraphicsItem {
   std::vector<ImVec2> beforeClippedGeometries_;
   ImTextureID imageTextureId_;
   ImVec2 uv0, uv1;
+  bool isFloat_;
+  int cmapType_;
+  ColormapDrawData colormap_;
 };
 
 struct GraphicTextItem : public GraphicsItem {
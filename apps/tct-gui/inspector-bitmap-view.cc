@@ -9,6 +9,14 @@
 #include "inspector-plot-view.h"
 #include "utility.h"
 
+struct ColormapConfig {
+  bool clamp = false;
+  float min = 0.0f;
+  float max = 10.0f;
+  bool cmap = true;
+  cv::ColormapTypes cmapType = cv::COLORMAP_JET;
+};
+
 InspectorBitmapView::InspectorBitmapView(const std::string& name)
     : InspectorBitmap(name) {
   scene_ = std::make_shared<GraphicsScene>();
@@ -23,6 +31,10 @@ InspectorBitmapView::InspectorBitmapView(const std::string& name)
   markersDecorated = false;
 
   frameRendered_ = false;
+  for (int i = 0; i < 2; i++) {
+    currentRanges_[i][0] = 0.0f;
+    currentRanges_[i][1] = 1.0f;
+  }
 
   plotContext_ = ImPlot::CreateContext();
 }
@@ -54,6 +66,17 @@ void InspectorBitmapView::ImGuiDraw() {
         }
         frameRendered_ = true;
       }
+      // only the depth has a colormap
+      for (int i = 0; i < 2; i++) {
+        auto& config = cmapConfigs_[i];
+        int cmapType = (i == 0 && config.cmap) ? config.cmapType : -1;
+        if (config.clamp) {
+          view_->setColormap(i, cmapType, config.min, config.max);
+        } else {
+          view_->setColormap(i, cmapType, currentRanges_[i][0],
+                             currentRanges_[i][1]);
+        }
+      }
     }
 
     if (needRelayout) {
@@ -192,14 +215,6 @@ void InspectorBitmapView::DrawMenu() {
   ShowToolsSettingsPopup();
 }
 
-struct ColormapConfig {
-  bool clamp = false;
-  float min = 0.0f;
-  float max = 10.0f;
-  bool cmap = true;
-  cv::ColormapTypes cmapType = cv::COLORMAP_JET;
-};
-
 void InspectorBitmapView::ShowColormapSettingsPopup() {
   auto center = contentRect.GetCenter() + ImGui::GetWindowPos();
   ImGui::SetNextWindowPos(center, ImGuiCond_Appearing, ImVec2(0.5f, 0.5f));
@@ -334,26 +349,30 @@ void InspectorBitmapView::HandleMouse() {
 
 void InspectorBitmapView::Render(cv::Mat& frame) {
   static bool firstImage = true;
-  auto images = splitChannels(frame_);
-
-  for (int i = 0; i < 2; i++) {
-    auto& image = images[i];
-    auto& config = cmapConfigs_[i];
-    if (config.clamp) {
-      cv::Mat minMask, maxMask;
-      minMask = image < config.min;
-      maxMask = image > config.max;
-      image.setTo(config.min, minMask);
-      image.setTo(config.max, maxMask);
+  auto images = splitChannels(frame);
+  int count = std::min((int)images.size(), 2);
+
+  // the clamp, normalization and colormap are done by the GPU, only the
+  // range is needed when not clamped
+  float ranges[2][2] = {{0.0f, 1.0f}, {0.0f, 1.0f}};
+  for (int i = 0; i < count; i++) {
+    if (!cmapConfigs_[i].clamp) {
+      double min, max;
+      cv::minMaxIdx(images[i], &min, &max);
+      ranges[i][0] = min;
+      ranges[i][1] = max;
     }
-
-    cv::normalize(image, image, 0, 255, cv::NORM_MINMAX, CV_8UC1);
-    if (i == 0 && config.cmap) cv::applyColorMap(image, image, config.cmapType);
   }
 
   {
     std::lock_guard<std::mutex> lock(renderMutex_);
-    currentImages_ = images;
+    // the frame may be reused by the pipeline while the GUI uploads it
+    currentImages_.resize(count);
+    for (int i = 0; i < count; i++) {
+      images[i].copyTo(currentImages_[i]);
+      currentRanges_[i][0] = ranges[i][0];
+      currentRanges_[i][1] = ranges[i][1];
+    }
     if (firstImage) {
       imageSizeChanged = true;
       firstImage = false;
@@ -42,7 +42,9 @@ struct InspectorBitmapView : public ImGuiWidget, public InspectorBitmap {
   bool imageSizeChanged;
   bool windowChanged;
   bool markersDecorated;
+  // copies of the planes of the last frame, and their min/max
   std::vector<cv::Mat> currentImages_;
+  float currentRanges_[2][2];
 
   std::vector<ColormapConfig> cmapConfigs_;
 
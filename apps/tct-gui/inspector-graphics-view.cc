@@ -157,6 +157,11 @@ void InspectorGraphicsView::setImages(std::vector<cv::Mat> images) {
   }
 }
 
+void InspectorGraphicsView::setColormap(int index, int cmapType, float min,
+                                        float max) {
+  imageItems_[index]->setColormap(cmapType, min, max);
+}
+
 void InspectorGraphicsView::onMouseMove(ImVec2 mousePos) {
   bool hit0 = imageItems_[0]->hitTest(mousePos);
   bool hit1 = imageItems_[1]->hitTest(mousePos);
@@ -17,6 +17,8 @@ struct InspectorGraphicsView : public GraphicsView {
   void enableRulers(bool enable);
   void setImageFitMode(ViewMode mode);
   void setImages(std::vector<cv::Mat> images);
+  // colormap of the float images of one side, see GraphicImageItem
+  void setColormap(int index, int cmapType, float min, float max);
 
   void buildScene();
   virtual void ImGuiLayout() override;
@@ -125,29 +125,40 @@ void HistogramPlotWidget::ImGuiDraw() {
     ImGui::SameLine();
     HelpMarker(plotHelpText);
 
-    // TODO: move the histogram calculation down to the sdk
-    auto hc = dynamic_pointer_cast<HistogramPlotConfigWidget>(configWidget);
-    int numBins = hc->bins;
-    float rangeMin = hc->ranges[0];
-    float rangeMax = hc->ranges[1];
-    bool isAutoRange = hc->isAutoRange;
-
     if (ImPlot::BeginPlot(name_.c_str(), ImVec2(-1, -1))) {
       ImPlot::SetupAxes(nullptr, nullptr, ImPlotAxisFlags_AutoFit,
                         ImPlotAxisFlags_AutoFit);
       ImPlot::SetNextFillStyle(IMPLOT_AUTO_COL, 0.5f);
-      ImPlot::PlotHistogram(
-          "Normalized Density", (float *)histogram_.data, histogram_.total(),
-          numBins, 1.0,
-          (!isAutoRange) ? ImPlotRange(rangeMin, rangeMax) : ImPlotRange(),
-          ImPlotHistogramFlags_Density);
+      std::lock_guard<std::mutex> lock(renderMutex_);
+      if (!density.empty()) {
+        ImPlot::PlotBars("Normalized Density", binCenters.data(),
+                         density.data(), density.size(), binWidth);
+      }
       ImPlot::EndPlot();
     }
   }
   ImGui::End();
 }
 
-void HistogramPlotWidget::RenderHistogram(const Mat &histogram) {}
+void HistogramPlotWidget::RenderHistogram(const Mat &histogram) {
+  // the bins are counted by the sdk, only a few values are kept for drawing
+  float min, max;
+  GetHistogramRanges(min, max);
+  int numBins = histogram.total();
+  float total = 0;
+  for (int i = 0; i < numBins; i++) {
+    total += histogram.at<float>(i);
+  }
+
+  std::lock_guard<std::mutex> lock(renderMutex_);
+  binWidth = (numBins > 0 && max > min) ? (max - min) / numBins : 1.0f;
+  binCenters.resize(numBins);
+  density.resize(numBins);
+  for (int i = 0; i < numBins; i++) {
+    binCenters[i] = min + (i + 0.5f) * binWidth;
+    density[i] = (total > 0) ? histogram.at<float>(i) / (total * binWidth) : 0;
+  }
+}
 
 void HistogramPlotWidget::OnFrameFormatChanged(const MatShape &shape,
                                                int type) {}
@@ -202,7 +213,7 @@ void HistogramPlotConfigWidget::ImGuiDraw() {
 }
 
 PointTrackerPlotWidget::PointTrackerPlotWidget(const std::string &name)
-    : PlotWidget(name), buffer(300) {}
+    : PlotWidget(name), samples(0) {}
 
 void PointTrackerPlotWidget::ImGuiDraw() {
   if (!isOpened) {
@@ -214,14 +225,29 @@ void PointTrackerPlotWidget::ImGuiDraw() {
     configWidget->ImGuiDraw();
 
     if (ImPlot::BeginPlot(name_.c_str(), ImVec2(-1, -1))) {
-      ImPlot::SetupAxes("sample", nullptr);
-      ImPlot::SetupAxisLimits(ImAxis_X1, buffer.Total - buffer.MaxSize,
-                              buffer.Total, ImGuiCond_Always);
-      ImPlot::SetupAxisLimits(ImAxis_Y1, 0, 10);
-      if (!buffer.IsEmpty()) {
-        ImPlot::PlotLine(name_.c_str(), &buffer.Data[0].x, &buffer.Data[0].y,
-                         buffer.Data.size(), 0, buffer.Offset,
-                         2 * sizeof(float));
+      ImPlot::SetupAxes("sample", nullptr, ImPlotAxisFlags_AutoFit,
+                        ImPlotAxisFlags_AutoFit);
+      {
+        // the whole history, decimated to about a point per pixel
+        std::lock_guard<std::mutex> lock(renderMutex_);
+        history.Query(0, samples, ImPlot::GetPlotSize().x, points);
+      }
+      int count = points.size();
+      plotData.resize(4 * count);
+      double *xs = plotData.data();
+      double *means = xs + count;
+      double *mins = means + count;
+      double *maxs = mins + count;
+      for (int i = 0; i < count; i++) {
+        xs[i] = points[i].t;
+        means[i] = points[i].mean;
+        mins[i] = points[i].min;
+        maxs[i] = points[i].max;
+      }
+      if (count > 0) {
+        ImPlot::SetNextFillStyle(IMPLOT_AUTO_COL, 0.25f);
+        ImPlot::PlotShaded("min/max", xs, mins, maxs, count);
+        ImPlot::PlotLine(name_.c_str(), xs, means, count);
       }
       ImPlot::EndPlot();
     }
@@ -230,8 +256,8 @@ void PointTrackerPlotWidget::ImGuiDraw() {
 }
 
 void PointTrackerPlotWidget::RenderPoint(float value) {
-  auto t = buffer.Total;
-  buffer.AddPoint(t++, value);
+  std::lock_guard<std::mutex> lock(renderMutex_);
+  history.Add(samples++, value);
 }
 
 void PointTrackerPlotWidget::OnFrameFormatChanged(const MatShape &shape,
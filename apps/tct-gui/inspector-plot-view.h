@@ -2,6 +2,7 @@
 
 #include <implot.h>
 #include <sdk/inspector/inspector-histogram.h>
+#include <sdk/inspector/inspector-multi-tracker.h>
 #include <sdk/inspector/inspector-scanner.h>
 #include <sdk/inspector/inspector-tracker.h>
 
@@ -53,6 +54,10 @@ struct HistogramPlotWidget : public PlotWidget, public InspectorHistogram {
   void RenderHistogram(const Mat& image) override;
   void OnFrameFormatChanged(const MatShape& shape, int type) override;
   bool firstRun = true;
+  // normalized density of the last histogram, guarded by renderMutex_
+  std::vector<float> binCenters;
+  std::vector<float> density;
+  float binWidth = 1.0f;
 };
 
 struct HistogramPlotConfigWidget : public PlotConfigWidget {
@@ -69,7 +74,11 @@ struct PointTrackerPlotWidget : public PlotWidget, public InspectorTracker {
   void ImGuiDraw() override;
   void RenderPoint(float value) override;
   void OnFrameFormatChanged(const MatShape& shape, int type) override;
-  ScrollingBuffer buffer;
+  // bounded, so that long runs can be plotted, guarded by renderMutex_
+  TimeSeries history;
+  uint64_t samples;
+  std::vector<TimeSeriesPoint> points;
+  std::vector<double> plotData;
 };
 
 struct PointTrackerPlotConfigWidget : public PlotConfigWidget {
@@ -1,6 +1,12 @@
+// GL 3 entry points of the shader colormap, exported by libGL
+#define GL_GLEXT_PROTOTYPES
+
 #include "utility.h"
 
 #include <GL/gl.h>
+#include <GL/glext.h>
+
+#include <cstdio>
 
 #include <opencv2/imgcodecs.hpp>
 #include <opencv2/imgproc.hpp>
@@ -56,6 +62,214 @@ void UploadCvMatToGpuTexture(const cv::Mat& image, GLuint* pTextureId,
   if (pSize != nullptr) *pSize = ImVec2(rgba.cols, rgba.rows);
 }
 
+void UploadFloatToGpuTexture(const cv::Mat& image, GLuint* pTextureId,
+                             ImVec2* pSize) {
+  ImVec2 size(image.cols, image.rows);
+  bool reallocate = (*pTextureId == 0) || pSize == nullptr || *pSize != size;
+  if (*pTextureId == 0) {
+    glGenTextures(1, pTextureId);
+  }
+
+  glBindTexture(GL_TEXTURE_2D, *pTextureId);
+#if defined(GL_UNPACK_ROW_LENGTH) && !defined(__EMSCRIPTEN__)
+  glPixelStorei(GL_UNPACK_ROW_LENGTH, image.step1());
+#endif
+  if (reallocate) {
+    // no filtering, invalid pixels must not bleed into their neighbours
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R32F, image.cols, image.rows, 0, GL_RED,
+                 GL_FLOAT, image.data);
+  } else {
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, image.cols, image.rows, GL_RED,
+                    GL_FLOAT, image.data);
+  }
+#if defined(GL_UNPACK_ROW_LENGTH) && !defined(__EMSCRIPTEN__)
+  glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+#endif
+  glBindTexture(GL_TEXTURE_2D, 0);
+
+  if (pSize != nullptr) *pSize = size;
+}
+
+void UploadColormapLut(int cmapType, GLuint* pTextureId) {
+  cv::Mat ramp(1, 256, CV_8UC1);
+  for (int i = 0; i < 256; i++) {
+    ramp.at<uint8_t>(0, i) = i;
+  }
+  cv::Mat bgr, rgba;
+  if (cmapType >= 0) {
+    cv::applyColorMap(ramp, bgr, cmapType);
+  } else {
+    cv::cvtColor(ramp, bgr, cv::COLOR_GRAY2BGR);
+  }
+  cv::cvtColor(bgr, rgba, cv::COLOR_BGR2RGBA);
+
+  if (*pTextureId == 0) {
+    glGenTextures(1, pTextureId);
+  }
+  glBindTexture(GL_TEXTURE_1D, *pTextureId);
+  glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glTexImage1D(GL_TEXTURE_1D, 0, GL_RGBA, 256, 0, GL_RGBA, GL_UNSIGNED_BYTE,
+               rgba.data);
+  glBindTexture(GL_TEXTURE_1D, 0);
+}
+
+// same interface as the vertex shader of the imgui opengl3 backend
+static const char* colormapVertexShader =
+    "#version 130\n"
+    "uniform mat4 ProjMtx;\n"
+    "in vec2 Position;\n"
+    "in vec2 UV;\n"
+    "in vec4 Color;\n"
+    "out vec2 Frag_UV;\n"
+    "out vec4 Frag_Color;\n"
+    "void main() {\n"
+    "  Frag_UV = UV;\n"
+    "  Frag_Color = Color;\n"
+    "  gl_Position = ProjMtx * vec4(Position.xy, 0, 1);\n"
+    "}\n";
+
+// Range is (min, 1 / (max - min)), the LUT is sampled at texel centers
+static const char* colormapFragmentShader =
+    "#version 130\n"
+    "uniform sampler2D Texture;\n"
+    "uniform sampler1D Lut;\n"
+    "uniform vec2 Range;\n"
+    "in vec2 Frag_UV;\n"
+    "in vec4 Frag_Color;\n"
+    "out vec4 Out_Color;\n"
+    "void main() {\n"
+    "  float v = texture(Texture, Frag_UV.st).r;\n"
+    "  float t = clamp((v - Range.x) * Range.y, 0.0, 1.0);\n"
+    "  vec4 c = texture(Lut, t * (255.0 / 256.0) + 0.5 / 256.0);\n"
+    "  Out_Color = Frag_Color * (isnan(v) ? vec4(0, 0, 0, 1) : c);\n"
+    "}\n";
+
+struct ColormapProgram {
+  GLuint program = 0;
+  bool failed = false;
+  GLint projLocation;
+  GLint textureLocation;
+  GLint lutLocation;
+  GLint rangeLocation;
+};
+
+static ColormapProgram colormapProgram;
+
+static GLuint CompileShader(GLenum type, const char* source) {
+  GLuint shader = glCreateShader(type);
+  glShaderSource(shader, 1, &source, nullptr);
+  glCompileShader(shader);
+  GLint status;
+  glGetShaderiv(shader, GL_COMPILE_STATUS, &status);
+  if (status != GL_TRUE) {
+    char log[512];
+    glGetShaderInfoLog(shader, sizeof(log), nullptr, log);
+    fprintf(stderr, "colormap shader: %s\n", log);
+    glDeleteShader(shader);
+    return 0;
+  }
+  return shader;
+}
+
+/**
+ * @brief Build the colormap program, with the vertex attributes at the
+ * locations of the backend program, so that its vertex arrays can be used as
+ * they are.
+ *
+ */
+static bool CreateColormapProgram(GLuint backendProgram) {
+  GLuint vs = CompileShader(GL_VERTEX_SHADER, colormapVertexShader);
+  GLuint fs = CompileShader(GL_FRAGMENT_SHADER, colormapFragmentShader);
+  if (vs == 0 || fs == 0) {
+    glDeleteShader(vs);
+    glDeleteShader(fs);
+    return false;
+  }
+
+  GLuint program = glCreateProgram();
+  glAttachShader(program, vs);
+  glAttachShader(program, fs);
+  for (const char* name : {"Position", "UV", "Color"}) {
+    GLint location = glGetAttribLocation(backendProgram, name);
+    if (location >= 0) {
+      glBindAttribLocation(program, location, name);
+    }
+  }
+  glLinkProgram(program);
+  glDetachShader(program, vs);
+  glDetachShader(program, fs);
+  glDeleteShader(vs);
+  glDeleteShader(fs);
+
+  GLint status;
+  glGetProgramiv(program, GL_LINK_STATUS, &status);
+  if (status != GL_TRUE) {
+    char log[512];
+    glGetProgramInfoLog(program, sizeof(log), nullptr, log);
+    fprintf(stderr, "colormap program: %s\n", log);
+    glDeleteProgram(program);
+    return false;
+  }
+
+  colormapProgram.program = program;
+  colormapProgram.projLocation = glGetUniformLocation(program, "ProjMtx");
+  colormapProgram.textureLocation = glGetUniformLocation(program, "Texture");
+  colormapProgram.lutLocation = glGetUniformLocation(program, "Lut");
+  colormapProgram.rangeLocation = glGetUniformLocation(program, "Range");
+  return true;
+}
+
+/**
+ * @brief Draw callback, run by the backend between its draw commands, with
+ * its render state set up and its program current.
+ *
+ */
+static void ColormapCallback(const ImDrawList* parentList,
+                             const ImDrawCmd* cmd) {
+  auto data = (const ColormapDrawData*)cmd->UserCallbackData;
+  GLint backendProgram;
+  glGetIntegerv(GL_CURRENT_PROGRAM, &backendProgram);
+
+  if (colormapProgram.program == 0) {
+    // no retry every frame, the image is drawn raw then
+    if (colormapProgram.failed || !CreateColormapProgram(backendProgram)) {
+      colormapProgram.failed = true;
+      return;
+    }
+  }
+
+  // the projection of the current frame
+  GLfloat proj[16];
+  glGetUniformfv(backendProgram,
+                 glGetUniformLocation(backendProgram, "ProjMtx"), proj);
+
+  float scale = (data->max > data->min) ? 1.0f / (data->max - data->min) : 0;
+  glUseProgram(colormapProgram.program);
+  glUniformMatrix4fv(colormapProgram.projLocation, 1, GL_FALSE, proj);
+  glUniform1i(colormapProgram.textureLocation, 0);
+  glUniform1i(colormapProgram.lutLocation, 1);
+  glUniform2f(colormapProgram.rangeLocation, data->min, scale);
+  glActiveTexture(GL_TEXTURE1);
+  glBindTexture(GL_TEXTURE_1D, data->lutTextureId);
+  glActiveTexture(GL_TEXTURE0);
+}
+
+void AddColormappedImage(ImDrawList* drawList, ImTextureID textureId,
+                         const ColormapDrawData* data, const ImVec2& pmin,
+                         const ImVec2& pmax, const ImVec2& uv0,
+                         const ImVec2& uv1) {
+  drawList->AddCallback(ColormapCallback, (void*)data);
+  drawList->AddImage(textureId, pmin, pmax, uv0, uv1);
+  // back to the backend program
+  drawList->AddCallback(ImDrawCallback_ResetRenderState, nullptr);
+}
+
 std::vector<cv::Mat> splitChannels(const cv::Mat& image) {
   std::vector<cv::Mat> channels;
   int channel, width, height;
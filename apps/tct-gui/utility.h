@@ -18,6 +18,40 @@
 void UploadCvMatToGpuTexture(const cv::Mat& image, GLuint* textureId,
                              ImVec2* size = nullptr);
 
+/**
+ * @brief Upload a CV_32FC1 image as a R32F texture, as is. The texture is
+ * updated in place if it already has the size of the image.
+ *
+ */
+void UploadFloatToGpuTexture(const cv::Mat& image, GLuint* textureId,
+                             ImVec2* size = nullptr);
+
+/**
+ * @brief Upload a 256 entries 1D RGBA texture of an opencv colormap.
+ *
+ * @param cmapType cv::ColormapTypes, or -1 for grayscale
+ */
+void UploadColormapLut(int cmapType, GLuint* textureId);
+
+struct ColormapDrawData {
+  GLuint lutTextureId;
+  // values are clamped to [min, max], then mapped to the LUT
+  float min;
+  float max;
+};
+
+/**
+ * @brief Draw a float texture (see UploadFloatToGpuTexture) through a
+ * colormap. The clamp, normalization and LUT lookup run in a fragment
+ * shader, invalid (NaN) pixels are black. data is read when the draw list is
+ * rendered, so it has to live until then.
+ *
+ */
+void AddColormappedImage(ImDrawList* drawList, ImTextureID textureId,
+                         const ColormapDrawData* data, const ImVec2& pmin,
+                         const ImVec2& pmax, const ImVec2& uv0,
+                         const ImVec2& uv1);
+
 static inline bool operator==(const ImVec2& lhs, const ImVec2& rhs) {
   return lhs.x == rhs.x && lhs.y == rhs.y;
 }
@@ -45,6 +45,9 @@
  * Subframe header contains sensor information: pixel range check, sensor
  * temperature, etc. These go to the frame buffer metadatas.
  *
+ * Pixel data is 16 bits samples (pixel_size 2). Packed 12 bits recordings
+ * (pixel_size 3) are rejected with a stream format error.
+ *
  * The tofparser produces GstBuffer with following content:
  *  Frame Buffer
  *  |--memory:
@@ -218,6 +221,15 @@ static GstFlowReturn gst_tofparser_handle_frame(GstBaseParse* parse,
   if (tofparser->is_first_frame) {
     tofparser->is_first_frame = FALSE;
     tofparser_parse_file_header(parse, frame->buffer);
+    // packed 12 bits recordings (pixel_size 3) hold pairs of samples in 3
+    // bytes, the elements downstream only take 16 bits samples
+    if (sh->pixel_size == 3) {
+      GST_ELEMENT_ERROR(tofparser, STREAM, FORMAT,
+                        ("Packed 12 bits recordings are not supported"),
+                        ("pixel_size 3, play the file with the SDK "
+                         "PlaybackSource or record it unpacked"));
+      return GST_FLOW_ERROR;
+    }
     gst_base_parse_set_frame_rate(parse, tofparser->sh.framerate_num,
                                   tofparser->sh.framerate_den, 0, 0);
 
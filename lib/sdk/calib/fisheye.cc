@@ -1,90 +1,233 @@
 #include <sdk/calib/fisheye.h>
+#include <sdk/calib/map-cache.h>
+#include <spdlog/sinks/stdout_color_sinks.h>
+#include <spdlog/spdlog.h>
+
+using namespace spdlog;
+
+static logger *logger_ = stdout_color_mt("Fisheye").get();
 
 Fisheye::Fisheye(const string &name) : BaseTransform(name) {
   shape_ = MatShape({2, 480, 640});
   type_ = CV_32FC1;
   enabled_ = true;
+  interpolation_ = kFisheyeInterLinear;
+  edgeThreshold_ = 0.1f;
+
+  // same sub-pixel quantization as cv::remap with fixed-point maps
+  const int tabSize = INTER_TAB_SIZE;
+  weights_.resize(tabSize * tabSize * 4);
+  nearest_.resize(tabSize * tabSize);
+  for (int fy = 0; fy < tabSize; fy++) {
+    for (int fx = 0; fx < tabSize; fx++) {
+      int idx = fy * tabSize + fx;
+      float wx = (float)fx / tabSize;
+      float wy = (float)fy / tabSize;
+      float *w = &weights_[idx * 4];
+      w[0] = (1 - wx) * (1 - wy);
+      w[1] = wx * (1 - wy);
+      w[2] = (1 - wx) * wy;
+      w[3] = wx * wy;
+      nearest_[idx] = (wy >= 0.5f ? 2 : 0) + (wx >= 0.5f ? 1 : 0);
+    }
+  }
 }
 
 Fisheye::~Fisheye() {}
 
 void Fisheye::SetEnable(bool enable) {
-  enabled_ = enable;
-  if (enable) {
-    // send valid shape to downstream
-    PrepareParams();
-  } else {
-    // send original shape to downstream
-    GetSourcePad()->SetFrameFormat(shape_, type_);
+  MatShape shape;
+  int type;
+  {
+    lock_guard<mutex> lock(mutex_);
+    enabled_ = enable;
+    // valid shape when enabled, original shape otherwise
+    shape = PrepareParams();
+    type = type_;
   }
+  GetSourcePad()->SetFrameFormat(shape, type);
 }
 
 void Fisheye::SetFrameFormat(const MatShape &shape, int type) {
   if (shape.dims() != 3 || type != CV_32FC1)
     throw std::runtime_error(
         "Fisheye only support 3 dimension CV_32FC1 format");
-  shape_ = shape;
-  type_ = type;
-  PrepareParams();
+  MatShape resultShape;
+  {
+    lock_guard<mutex> lock(mutex_);
+    shape_ = shape;
+    type_ = type;
+    resultShape = PrepareParams();
+  }
+  GetSourcePad()->SetFrameFormat(resultShape, type);
 }
 
 void Fisheye::SetParams(FisheyeParams &params) {
-  params_ = params;
-  PrepareParams();
+  MatShape shape;
+  int type;
+  bool enabled;
+  {
+    lock_guard<mutex> lock(mutex_);
+    params_ = params;
+    shape = PrepareParams();
+    type = type_;
+    enabled = enabled_;
+  }
+  // the original shape did not change
+  if (enabled) GetSourcePad()->SetFrameFormat(shape, type);
 }
 
-void Fisheye::PrepareParams() {
-  int height = shape_[1];
-  int width = shape_[2];
-  float camMat[] = {params_.fx, 0, params_.cx, 0, params_.fy,
-                    params_.cy, 0, 0,          1};
-  float distCoeffs[] = {params_.k1, params_.k2, params_.p1, params_.p2,
-                        params_.k3};
-  float upscale = params_.upscale;
-  Mat cameraMatrix = Mat(3, 3, CV_32FC1, camMat);
-  Mat distCoeff = Mat(1, 5, CV_32FC1, distCoeffs);
-  int width_up = (int)(width * upscale);
-  int height_up = (int)(height * upscale);
-
-  Mat newCameraMatrix =
-      getOptimalNewCameraMatrix(cameraMatrix, distCoeff, Size(width, height),
-                                1.0f, Size(width_up, height_up), &validRoi_);
-  initUndistortRectifyMap(cameraMatrix, distCoeff, Mat(), newCameraMatrix,
-                          Size(width_up, height_up), CV_32FC1, tmapx_, tmapy_);
-
-  if (enabled_)
-    GetSourcePad()->SetFrameFormat({2, validRoi_.height, validRoi_.width},
-                                   type_);
+void Fisheye::SetInterpolation(FisheyeInterpolation interpolation) {
+  lock_guard<mutex> lock(mutex_);
+  interpolation_ = interpolation;
 }
 
-void Fisheye::TransformFrame(Mat &frame) {
-  if (!enabled_) {
-    GetSourcePad()->PushFrame(frame);
-    return;
-  }
+FisheyeInterpolation Fisheye::GetInterpolation() { return interpolation_; }
 
-  int height = frame.size[1];
-  int width = frame.size[2];
-  int elemSize = frame.elemSize();
+void Fisheye::SetDepthEdgeThreshold(float threshold) {
+  lock_guard<mutex> lock(mutex_);
+  edgeThreshold_ = threshold;
+}
 
-  Mat depth = Mat(height, width, type_, frame.data);
-  Mat amplitude =
-      Mat(height, width, type_, frame.data + height * width * elemSize);
+float Fisheye::GetDepthEdgeThreshold() { return edgeThreshold_; }
 
-  remap(depth, depth, tmapx_, tmapy_, INTER_LINEAR);
-  remap(amplitude, amplitude, tmapx_, tmapy_, INTER_LINEAR);
+MatShape Fisheye::PrepareParams() {
+  if (!enabled_) {
+    // maps are built when enabled again
+    return shape_;
+  }
+  int height = shape_[1];
+  int width = shape_[2];
+  UndistortMapKey key(params_, width, height);
+  auto &cache = UndistortMapCache::GetDefault();
+  maps_ = cache.Get(key);
+  if (!maps_) {
+    maps_ = make_shared<UndistortMaps>();
+    float camMat[] = {params_.fx, 0, params_.cx, 0, params_.fy,
+                      params_.cy, 0, 0,          1};
+    float distCoeffs[] = {params_.k1, params_.k2, params_.p1, params_.p2,
+                          params_.k3};
+    float upscale = params_.upscale;
+    Mat cameraMatrix = Mat(3, 3, CV_32FC1, camMat);
+    Mat distCoeff = Mat(1, 5, CV_32FC1, distCoeffs);
+    int width_up = (int)(width * upscale);
+    int height_up = (int)(height * upscale);
+
+    Rect roi;
+    Mat newCameraMatrix = getOptimalNewCameraMatrix(
+        cameraMatrix, distCoeff, Size(width, height), 1.0f,
+        Size(width_up, height_up), &roi);
+    if (roi.area() == 0) {
+      logger_->warn("Empty valid roi, using the whole undistorted image");
+      roi = Rect(0, 0, width_up, height_up);
+    }
+
+    // only compute the maps of the valid roi, by moving the principal point
+    // to the roi origin
+    Mat roiCameraMatrix;
+    newCameraMatrix.convertTo(roiCameraMatrix, CV_64F);
+    roiCameraMatrix.at<double>(0, 2) -= roi.x;
+    roiCameraMatrix.at<double>(1, 2) -= roi.y;
+    initUndistortRectifyMap(cameraMatrix, distCoeff, Mat(), roiCameraMatrix,
+                            roi.size(), CV_16SC2, maps_->map1, maps_->map2);
+    maps_->roi = roi;
+    cache.Put(key, maps_);
+  }
 
-  Mat depth_crop = depth(validRoi_);
-  Mat amplitude_crop = amplitude(validRoi_);
+  map1_ = maps_->map1;
+  map2_ = maps_->map2;
+  validRoi_ = maps_->roi;
 
-  Mat result({2, validRoi_.height, validRoi_.width}, type_);
-  Mat depth_result(validRoi_.height, validRoi_.width, type_, result.data);
-  Mat amplitude_result(
-      validRoi_.height, validRoi_.width, type_,
-      result.data + validRoi_.height * validRoi_.width * elemSize);
+  MatShape resultShape(shape_[0], validRoi_.height, validRoi_.width);
+  pool_.SetFrameFormat(resultShape, type_);
+  return resultShape;
+}
 
-  depth_crop.copyTo(depth_result);
-  amplitude_crop.copyTo(amplitude_result);
+void Fisheye::TransformFrame(Mat &frame) {
+  Mat result;
+  {
+    lock_guard<mutex> lock(mutex_);
+    if (!enabled_) {
+      result = frame;
+    } else {
+      // the pool format follows validRoi_, both change under the lock
+      result = pool_.Acquire();
+      parallel_for_(Range(0, validRoi_.height), [&](const Range &rows) {
+        RemapRows(frame, result, rows);
+      });
+    }
+  }
 
   GetSourcePad()->PushFrame(result);
 }
+
+/**
+ * Remap all planes (depth and amplitude) in one pass: the map lookup, weights
+ * and depth edge test are shared by the planes. Samples outside the source
+ * frame are 0, the same as cv::remap with BORDER_CONSTANT.
+ */
+void Fisheye::RemapRows(const Mat &frame, Mat &result, const Range &rows) {
+  const int channels = frame.size[0];
+  const int srcHeight = frame.size[1];
+  const int srcWidth = frame.size[2];
+  const int srcPlane = srcHeight * srcWidth;
+  const int dstWidth = validRoi_.width;
+  const int dstPlane = validRoi_.height * dstWidth;
+  const int tabMask = INTER_TAB_SIZE * INTER_TAB_SIZE - 1;
+  const float *src = (const float *)frame.data;
+  float *dst = (float *)result.data;
+
+  for (int y = rows.start; y < rows.end; y++) {
+    const short *xy = map1_.ptr<short>(y);
+    const ushort *fxy = map2_.ptr<ushort>(y);
+
+    for (int x = 0; x < dstWidth; x++) {
+      int sx = xy[2 * x];
+      int sy = xy[2 * x + 1];
+      int tab = fxy[x] & tabMask;
+      const float *w = &weights_[tab * 4];
+      // offsets of the 4 neighbours, -1 when outside the frame
+      int o[4];
+      if (sx >= 0 && sy >= 0 && sx < srcWidth - 1 && sy < srcHeight - 1) {
+        o[0] = sy * srcWidth + sx;
+        o[1] = o[0] + 1;
+        o[2] = o[0] + srcWidth;
+        o[3] = o[2] + 1;
+      } else {
+        for (int k = 0; k < 4; k++) {
+          int nx = sx + (k & 1);
+          int ny = sy + (k >> 1);
+          bool inside = nx >= 0 && ny >= 0 && nx < srcWidth && ny < srcHeight;
+          o[k] = inside ? ny * srcWidth + nx : -1;
+        }
+      }
+
+      bool useNearest = (interpolation_ == kFisheyeInterNearest);
+      if (interpolation_ == kFisheyeInterDepthAware) {
+        float dmin = std::numeric_limits<float>::max();
+        float dmax = std::numeric_limits<float>::lowest();
+        for (int k = 0; k < 4; k++) {
+          float d = (o[k] >= 0) ? src[o[k]] : 0.0f;
+          dmin = std::min(dmin, d);
+          dmax = std::max(dmax, d);
+        }
+        useNearest = (dmax - dmin) > edgeThreshold_;
+      }
+
+      int n = nearest_[tab];
+      for (int c = 0; c < channels; c++) {
+        const float *plane = src + c * srcPlane;
+        float value;
+        if (useNearest) {
+          value = (o[n] >= 0) ? plane[o[n]] : 0.0f;
+        } else {
+          value = 0.0f;
+          for (int k = 0; k < 4; k++) {
+            value += (o[k] >= 0) ? w[k] * plane[o[k]] : 0.0f;
+          }
+        }
+        dst[c * dstPlane + y * dstWidth + x] = value;
+      }
+    }
+  }
+}
@@ -2,9 +2,13 @@
 #define __FISHEYE_H__
 
 #include <sdk/core/base-transform.h>
+#include <sdk/core/frame-pool.h>
 
+#include <memory>
 #include <opencv2/opencv.hpp>
 
+struct UndistortMaps;
+
 struct FisheyeParams {
   float fx;
   float fy;
@@ -18,6 +22,19 @@ struct FisheyeParams {
   float upscale;
 };
 
+/**
+ * @brief Interpolation used when remapping the depth and amplitude planes.
+ * kFisheyeInterDepthAware interpolates linearly, except at depth edges (the 4
+ * neighbours span more than the edge threshold) where it falls back to nearest
+ * neighbour, so foreground and background depths are never blended.
+ *
+ */
+enum FisheyeInterpolation {
+  kFisheyeInterLinear,
+  kFisheyeInterNearest,
+  kFisheyeInterDepthAware
+};
+
 class Fisheye : public BaseTransform {
  public:
   Fisheye(const string &name = "");
@@ -26,20 +43,49 @@ class Fisheye : public BaseTransform {
   void SetParams(FisheyeParams &params);
   void SetEnable(bool enable);
 
+  void SetInterpolation(FisheyeInterpolation interpolation);
+  FisheyeInterpolation GetInterpolation();
+  /**
+   * @brief Set the depth difference (in meter) between neighbour pixels above
+   * which kFisheyeInterDepthAware stops interpolating.
+   *
+   * @param threshold
+   */
+  void SetDepthEdgeThreshold(float threshold);
+  float GetDepthEdgeThreshold();
+
   void TransformFrame(Mat &frame) override;
   void SetFrameFormat(const MatShape &shape, int type) override;
 
  private:
-  void PrepareParams();
+  /**
+   * @brief Build the maps of the current parameters and input shape, with
+   * mutex_ held. The caller pushes the returned format downstream once the
+   * lock is released.
+   *
+   * @return MatShape output shape, the input shape when disabled
+   */
+  MatShape PrepareParams();
+  void RemapRows(const Mat &frame, Mat &result, const Range &rows);
 
  private:
-  Mat tmapx_;
-  Mat tmapy_;
+  // fixed-point maps of the valid roi only: integer source coordinates and
+  // INTER_TAB_SIZE x INTER_TAB_SIZE sub-pixel index. maps_ owns their memory.
+  shared_ptr<UndistortMaps> maps_;
+  Mat map1_;
+  Mat map2_;
+  // bilinear weights and nearest neighbour of each sub-pixel index
+  vector<float> weights_;
+  vector<uint8_t> nearest_;
   cv::Rect validRoi_;
   MatShape shape_;
   FisheyeParams params_;
   int type_;
   bool enabled_;
+  FisheyeInterpolation interpolation_;
+  float edgeThreshold_;
+  FramePool pool_;
+  mutex mutex_;
 };
 
-#endif  // __FISHEYE_H__
\ No newline at end of file
+#endif  // __FISHEYE_H__
@@ -0,0 +1,388 @@
+#include <dirent.h>
+#include <fcntl.h>
+#include <sdk/calib/map-cache.h>
+#include <spdlog/sinks/stdout_color_sinks.h>
+#include <spdlog/spdlog.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
+
+using namespace spdlog;
+
+static logger *logger_ = stdout_color_mt("UndistortMapCache").get();
+
+#define MAP_FILE_MAGIC "TCTUMAP"
+#define MAP_FILE_VERSION 1
+// map data starts at a cache line boundary
+#define MAP_FILE_ALIGN 64
+// temporary files older than that were left by a killed writer
+#define MAP_FILE_STALE_TMP_SECONDS 60
+
+/**
+ * @brief Layout of a map file:
+ *   | MapFileHeader | padding | map1 (CV_16SC2) | map2 (CV_16UC1) |
+ *
+ */
+struct MapFileHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t data_offset;
+  FisheyeParams params;
+  int32_t width;
+  int32_t height;
+  int32_t roi_x;
+  int32_t roi_y;
+  int32_t roi_width;
+  int32_t roi_height;
+  uint64_t map1_size;
+  uint64_t map2_size;
+};
+
+UndistortMapKey::UndistortMapKey(const FisheyeParams &params, int width,
+                                 int height)
+    : params(params), width(width), height(height) {}
+
+uint64_t UndistortMapKey::Hash() const {
+  // FNV-1a over the raw parameters and resolution
+  uint64_t hash = 14695981039346656037ULL;
+  auto mix = [&hash](const void *data, size_t size) {
+    const uint8_t *p = (const uint8_t *)data;
+    for (size_t i = 0; i < size; i++) {
+      hash ^= p[i];
+      hash *= 1099511628211ULL;
+    }
+  };
+  mix(&params, sizeof(params));
+  mix(&width, sizeof(width));
+  mix(&height, sizeof(height));
+  return hash;
+}
+
+bool UndistortMapKey::operator==(const UndistortMapKey &other) const {
+  return memcmp(&params, &other.params, sizeof(params)) == 0 &&
+         width == other.width && height == other.height;
+}
+
+static bool MakeDirectories(const string &path) {
+  for (size_t pos = 1; pos <= path.size(); pos++) {
+    if (pos == path.size() || path[pos] == '/') {
+      string dir = path.substr(0, pos);
+      if (mkdir(dir.c_str(), 0755) != 0 && errno != EEXIST) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+UndistortMapCache::UndistortMapCache(const string &directory, int capacity)
+    : capacity_(capacity),
+      writing_(false),
+      stop_(false),
+      diskCapacity_(DEFAULT_MAP_CACHE_DISK_CAPACITY),
+      thread_(nullptr) {
+  SetDirectory(directory);
+}
+
+UndistortMapCache::~UndistortMapCache() {
+  {
+    lock_guard<mutex> lock(mutex_);
+    stop_ = true;
+  }
+  condvar_.notify_all();
+  // the writer empties the queue before it stops
+  if (thread_ != nullptr) {
+    thread_->join();
+    delete thread_;
+  }
+}
+
+static string GetDefaultDirectory() {
+  const char *xdg = getenv("XDG_CACHE_HOME");
+  const char *home = getenv("HOME");
+  if (xdg != nullptr && xdg[0] != '\0') {
+    return string(xdg) + "/tct";
+  } else if (home != nullptr && home[0] != '\0') {
+    return string(home) + "/.cache/tct";
+  }
+  return "";
+}
+
+UndistortMapCache &UndistortMapCache::GetDefault() {
+  // destroyed at exit, which writes the maps still queued
+  static UndistortMapCache cache(GetDefaultDirectory());
+  return cache;
+}
+
+void UndistortMapCache::SetDirectory(const string &directory) {
+  lock_guard<mutex> lock(mutex_);
+  directory_ = directory;
+  if (!directory_.empty() && !MakeDirectories(directory_)) {
+    logger_->warn("Cannot create {}, maps are cached in memory only",
+                  directory_);
+    directory_.clear();
+  }
+}
+
+const string &UndistortMapCache::GetDirectory() { return directory_; }
+
+void UndistortMapCache::SetCapacity(int capacity) {
+  lock_guard<mutex> lock(mutex_);
+  capacity_ = capacity;
+  while (entries_.size() > capacity_) {
+    index_.erase(entries_.back().first.Hash());
+    entries_.pop_back();
+  }
+}
+
+void UndistortMapCache::SetDiskCapacity(size_t capacity) {
+  lock_guard<mutex> lock(mutex_);
+  diskCapacity_ = capacity;
+}
+
+int UndistortMapCache::GetSize() {
+  lock_guard<mutex> lock(mutex_);
+  return entries_.size();
+}
+
+shared_ptr<UndistortMaps> UndistortMapCache::Get(const UndistortMapKey &key) {
+  lock_guard<mutex> lock(mutex_);
+  auto it = index_.find(key.Hash());
+  if (it != index_.end() && it->second->first == key) {
+    // move to front, most recently used
+    entries_.splice(entries_.begin(), entries_, it->second);
+    return entries_.front().second;
+  }
+
+  auto maps = Load(key);
+  if (maps) {
+    Insert(key, maps);
+  }
+  return maps;
+}
+
+void UndistortMapCache::Put(const UndistortMapKey &key,
+                            shared_ptr<UndistortMaps> maps) {
+  {
+    lock_guard<mutex> lock(mutex_);
+    Insert(key, maps);
+    if (directory_.empty()) {
+      return;
+    }
+    // Fisheye calls us with its own lock held, the disk write must not
+    // stall its frames
+    pending_.push_back({directory_, GetFilename(key), key, maps});
+    if (thread_ == nullptr) {
+      thread_ = new thread(&UndistortMapCache::WriteLoop, this);
+    }
+  }
+  condvar_.notify_all();
+}
+
+void UndistortMapCache::Flush() {
+  unique_lock<mutex> lock(mutex_);
+  condvar_.wait(lock, [this] { return pending_.empty() && !writing_; });
+}
+
+void UndistortMapCache::WriteLoop() {
+  unique_lock<mutex> lock(mutex_);
+  while (true) {
+    condvar_.wait(lock, [this] { return stop_ || !pending_.empty(); });
+    if (pending_.empty()) {
+      break;
+    }
+    PendingWrite write = pending_.front();
+    pending_.pop_front();
+    size_t capacity = diskCapacity_;
+    writing_ = true;
+    lock.unlock();
+
+    if (!Store(write)) {
+      logger_->warn("Failed to write {}", write.filename);
+    }
+    Evict(write.directory, capacity);
+
+    lock.lock();
+    writing_ = false;
+    condvar_.notify_all();
+  }
+}
+
+void UndistortMapCache::Insert(const UndistortMapKey &key,
+                               shared_ptr<UndistortMaps> maps) {
+  uint64_t hash = key.Hash();
+  auto it = index_.find(hash);
+  if (it != index_.end()) {
+    entries_.erase(it->second);
+    index_.erase(it);
+  }
+  entries_.emplace_front(key, maps);
+  index_[hash] = entries_.begin();
+
+  while (entries_.size() > capacity_) {
+    index_.erase(entries_.back().first.Hash());
+    entries_.pop_back();
+  }
+}
+
+string UndistortMapCache::GetFilename(const UndistortMapKey &key) {
+  char name[64];
+  snprintf(name, sizeof(name), "/fisheye-%016llx.map",
+           (unsigned long long)key.Hash());
+  return directory_ + name;
+}
+
+shared_ptr<UndistortMaps> UndistortMapCache::Load(const UndistortMapKey &key) {
+  if (directory_.empty()) {
+    return nullptr;
+  }
+
+  string filename = GetFilename(key);
+  int fd = open(filename.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return nullptr;
+  }
+
+  struct stat st;
+  if (fstat(fd, &st) != 0 || st.st_size < sizeof(MapFileHeader)) {
+    close(fd);
+    return nullptr;
+  }
+
+  size_t length = st.st_size;
+  void *addr = mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0);
+  // the modification time orders the files for eviction
+  futimens(fd, nullptr);
+  // the mapping stays valid after the descriptor is closed
+  close(fd);
+  if (addr == MAP_FAILED) {
+    logger_->warn("Failed to map {}", filename);
+    return nullptr;
+  }
+
+  shared_ptr<void> storage(addr,
+                           [length](void *p) { munmap(p, length); });
+  const MapFileHeader *header = (const MapFileHeader *)addr;
+  size_t map1Size = (size_t)header->roi_width * header->roi_height * 4;
+  size_t map2Size = (size_t)header->roi_width * header->roi_height * 2;
+
+  UndistortMapKey fileKey(header->params, header->width, header->height);
+  if (memcmp(header->magic, MAP_FILE_MAGIC, sizeof(header->magic)) != 0 ||
+      header->version != MAP_FILE_VERSION || !(fileKey == key) ||
+      header->map1_size != map1Size || header->map2_size != map2Size ||
+      header->data_offset + map1Size + map2Size > length) {
+    logger_->warn("Ignoring stale or corrupted {}", filename);
+    return nullptr;
+  }
+
+  uint8_t *data = (uint8_t *)addr + header->data_offset;
+  auto maps = make_shared<UndistortMaps>();
+  maps->roi = Rect(header->roi_x, header->roi_y, header->roi_width,
+                   header->roi_height);
+  maps->map1 = Mat(maps->roi.height, maps->roi.width, CV_16SC2, data);
+  maps->map2 =
+      Mat(maps->roi.height, maps->roi.width, CV_16UC1, data + map1Size);
+  maps->storage = storage;
+
+  logger_->info("Loaded undistortion maps from {}", filename);
+  return maps;
+}
+
+bool UndistortMapCache::Store(const PendingWrite &write) {
+  const UndistortMapKey &key = write.key;
+  const UndistortMaps &maps = *write.maps;
+  if (!maps.map1.isContinuous() || !maps.map2.isContinuous()) {
+    return false;
+  }
+
+  MapFileHeader header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, MAP_FILE_MAGIC, sizeof(header.magic));
+  header.version = MAP_FILE_VERSION;
+  header.data_offset =
+      (sizeof(header) + MAP_FILE_ALIGN - 1) / MAP_FILE_ALIGN * MAP_FILE_ALIGN;
+  header.params = key.params;
+  header.width = key.width;
+  header.height = key.height;
+  header.roi_x = maps.roi.x;
+  header.roi_y = maps.roi.y;
+  header.roi_width = maps.roi.width;
+  header.roi_height = maps.roi.height;
+  header.map1_size = maps.map1.total() * maps.map1.elemSize();
+  header.map2_size = maps.map2.total() * maps.map2.elemSize();
+
+  // write to a temporary file then rename, so readers never see a partial map
+  const string &filename = write.filename;
+  string tmpname = filename + ".tmp" + to_string(getpid());
+  FILE *file = fopen(tmpname.c_str(), "wb");
+  if (file == nullptr) {
+    return false;
+  }
+
+  vector<uint8_t> padding(header.data_offset - sizeof(header), 0);
+  bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+  ok = ok && fwrite(padding.data(), 1, padding.size(), file) == padding.size();
+  ok = ok && fwrite(maps.map1.data, 1, header.map1_size, file) ==
+                 header.map1_size;
+  ok = ok && fwrite(maps.map2.data, 1, header.map2_size, file) ==
+                 header.map2_size;
+  ok = (fclose(file) == 0) && ok;
+
+  if (!ok || rename(tmpname.c_str(), filename.c_str()) != 0) {
+    unlink(tmpname.c_str());
+    return false;
+  }
+  return true;
+}
+
+void UndistortMapCache::Evict(const string &directory, size_t capacity) {
+  struct MapFile {
+    string path;
+    int64_t mtime;
+    size_t size;
+  };
+
+  DIR *dir = opendir(directory.c_str());
+  if (dir == nullptr) {
+    return;
+  }
+  vector<MapFile> files;
+  time_t now = time(nullptr);
+  struct dirent *entry;
+  while ((entry = readdir(dir)) != nullptr) {
+    string name = entry->d_name;
+    if (name.compare(0, 8, "fisheye-") != 0) {
+      continue;
+    }
+    string path = directory + "/" + name;
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0) {
+      continue;
+    }
+    if (name.find(".map.tmp") != string::npos) {
+      if (now - st.st_mtime > MAP_FILE_STALE_TMP_SECONDS) {
+        unlink(path.c_str());
+      }
+      continue;
+    }
+    int64_t mtime = st.st_mtim.tv_sec * 1000000000LL + st.st_mtim.tv_nsec;
+    files.push_back({path, mtime, (size_t)st.st_size});
+  }
+  closedir(dir);
+
+  // most recently used first
+  sort(files.begin(), files.end(), [](const MapFile &a, const MapFile &b) {
+    return a.mtime > b.mtime;
+  });
+  size_t total = 0;
+  for (auto &file : files) {
+    total += file.size;
+    if (total > capacity) {
+      // mapped files stay readable until they are unmapped
+      unlink(file.path.c_str());
+    }
+  }
+}
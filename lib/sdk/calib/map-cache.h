@@ -0,0 +1,168 @@
+/* Copyright (C) 2023 Deep In Sight
+ * Author: Le Ngoc Linh <lnlinh93@dinsight.ai>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Suite 500,
+ * Boston, MA 02110-1335, USA.
+ */
+
+#ifndef __MAP_CACHE_H__
+#define __MAP_CACHE_H__
+
+#include <sdk/calib/fisheye.h>
+
+#include <condition_variable>
+#include <deque>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+#define DEFAULT_MAP_CACHE_CAPACITY 8
+// the map files are evicted, least recently used first, above that size
+#define DEFAULT_MAP_CACHE_DISK_CAPACITY ((size_t)256 << 20)
+
+/**
+ * @brief What the undistortion maps depend on: the lens parameters and the
+ * input resolution.
+ *
+ */
+struct UndistortMapKey {
+  UndistortMapKey(const FisheyeParams &params, int width, int height);
+  uint64_t Hash() const;
+  bool operator==(const UndistortMapKey &other) const;
+
+  FisheyeParams params;
+  int width;
+  int height;
+};
+
+/**
+ * @brief Fixed-point undistortion maps (see Fisheye) and the valid roi they
+ * cover. When loaded from disk, map1 and map2 point into a read-only memory
+ * mapping that stays alive as long as this object.
+ *
+ */
+struct UndistortMaps {
+  Mat map1;
+  Mat map2;
+  Rect roi;
+  shared_ptr<void> storage;
+};
+
+/**
+ * @brief Cache of undistortion maps. Recently used maps are kept in memory
+ * (LRU), and every map is also written to one file per key in the cache
+ * directory, so it can be memory-mapped back after a restart instead of being
+ * recomputed. Files are written by a background thread, and the least
+ * recently used ones are deleted when the directory grows above its disk
+ * capacity.
+ *
+ */
+class UndistortMapCache {
+ public:
+  /**
+   * @brief Construct a new UndistortMapCache object
+   *
+   * @param directory where the map files are stored. Empty for memory only.
+   * @param capacity maximum number of maps kept in memory.
+   */
+  UndistortMapCache(const string &directory = "",
+                    int capacity = DEFAULT_MAP_CACHE_CAPACITY);
+  ~UndistortMapCache();
+
+  /**
+   * @brief Get the cache shared by all Fisheye elements. Its files are stored
+   * in $XDG_CACHE_HOME/tct or $HOME/.cache/tct. Maps still queued for disk
+   * are written when the program exits.
+   *
+   * @return UndistortMapCache&
+   */
+  static UndistortMapCache &GetDefault();
+
+  void SetDirectory(const string &directory);
+  const string &GetDirectory();
+  void SetCapacity(int capacity);
+  /**
+   * @brief Set the maximum total size of the map files.
+   *
+   * @param capacity bytes
+   */
+  void SetDiskCapacity(size_t capacity);
+
+  /**
+   * @brief Look up the maps in memory, then on disk.
+   *
+   * @param key
+   * @return shared_ptr<UndistortMaps> nullptr on miss.
+   */
+  shared_ptr<UndistortMaps> Get(const UndistortMapKey &key);
+
+  /**
+   * @brief Add the maps to memory, and queue them to be written to disk.
+   * Does not wait for the disk.
+   *
+   * @param key
+   * @param maps
+   */
+  void Put(const UndistortMapKey &key, shared_ptr<UndistortMaps> maps);
+
+  /**
+   * @brief Wait until the queued maps are written to disk.
+   *
+   */
+  void Flush();
+
+  /**
+   * @brief Get number of maps in memory.
+   *
+   * @return int
+   */
+  int GetSize();
+
+ private:
+  typedef pair<UndistortMapKey, shared_ptr<UndistortMaps>> Entry;
+
+  struct PendingWrite {
+    string directory;
+    string filename;
+    UndistortMapKey key;
+    shared_ptr<UndistortMaps> maps;
+  };
+
+  void Insert(const UndistortMapKey &key, shared_ptr<UndistortMaps> maps);
+  string GetFilename(const UndistortMapKey &key);
+  shared_ptr<UndistortMaps> Load(const UndistortMapKey &key);
+  static bool Store(const PendingWrite &write);
+  static void Evict(const string &directory, size_t capacity);
+  void WriteLoop();
+
+  mutex mutex_;
+  string directory_;
+  int capacity_;
+  list<Entry> entries_;
+  unordered_map<uint64_t, list<Entry>::iterator> index_;
+
+  // background writer, started on the first Put with a directory
+  condition_variable condvar_;
+  deque<PendingWrite> pending_;
+  bool writing_;
+  bool stop_;
+  size_t diskCapacity_;
+  thread *thread_;
+};
+
+#endif  // __MAP_CACHE_H__
@@ -0,0 +1,39 @@
+#include <sdk/core/frame-pacer.h>
+
+#include <algorithm>
+#include <thread>
+
+static chrono::steady_clock::duration GetMaxLateness(double frame_duration) {
+  auto duration = chrono::duration_cast<chrono::steady_clock::duration>(
+      chrono::duration<double>(frame_duration));
+  return max<chrono::steady_clock::duration>(duration,
+                                             chrono::milliseconds(100));
+}
+
+FramePacer::FramePacer() : resync_(true), anchor_us_(0) {}
+
+void FramePacer::Resync() { resync_ = true; }
+
+void FramePacer::WaitDeadline(double frame_duration) {
+  auto now = chrono::steady_clock::now();
+  if (resync_.exchange(false) ||
+      now - deadline_ > GetMaxLateness(frame_duration)) {
+    deadline_ = now;
+  } else {
+    deadline_ += chrono::duration_cast<chrono::steady_clock::duration>(
+        chrono::duration<double>(frame_duration));
+  }
+  this_thread::sleep_until(deadline_);
+}
+
+void FramePacer::WaitTimestamp(int64_t timestamp_us, double frame_duration) {
+  auto now = chrono::steady_clock::now();
+  auto due = anchor_ + chrono::microseconds(timestamp_us - anchor_us_);
+  if (resync_.exchange(false) || timestamp_us < anchor_us_ ||
+      now - due > GetMaxLateness(frame_duration)) {
+    anchor_ = now;
+    anchor_us_ = timestamp_us;
+    due = now;
+  }
+  this_thread::sleep_until(due);
+}
@@ -0,0 +1,72 @@
+/* Copyright (C) 2023 Deep In Sight
+ * Author: Le Ngoc Linh <lnlinh93@dinsight.ai>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Suite 500,
+ * Boston, MA 02110-1335, USA.
+ */
+#ifndef __FRAME_PACER_H__
+#define __FRAME_PACER_H__
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+using namespace std;
+
+/**
+ * @brief Spaces the frames of a playback source in time. Schedules are
+ * absolute, so they do not drift with processing time. When playback falls
+ * behind by more than a frame duration (paused, stepped, slow downstream)
+ * the schedule restarts instead of bursting frames to catch up.
+ *
+ */
+class FramePacer {
+ public:
+  FramePacer();
+
+  /**
+   * @brief Restart the schedule from the next frame, after a seek or a
+   * pause. Can be called from any thread.
+   *
+   */
+  void Resync();
+
+  /**
+   * @brief Sleep until the next frame is due, one frame duration after the
+   * previous one.
+   *
+   * @param frame_duration in seconds
+   */
+  void WaitDeadline(double frame_duration);
+
+  /**
+   * @brief Sleep until the frame captured at timestamp_us is due, relative to
+   * the first frame of the schedule. Time going backward, e.g. on loop,
+   * restarts the schedule.
+   *
+   * @param timestamp_us
+   * @param frame_duration in seconds, bounds how late a frame can be
+   */
+  void WaitTimestamp(int64_t timestamp_us, double frame_duration);
+
+ private:
+  atomic<bool> resync_;
+  chrono::steady_clock::time_point deadline_;
+  // the frame with timestamp anchor_us_ is due at anchor_
+  chrono::steady_clock::time_point anchor_;
+  int64_t anchor_us_;
+};
+
+#endif  // __FRAME_PACER_H__
@@ -0,0 +1,49 @@
+#include <sdk/core/frame-pool.h>
+#include <spdlog/sinks/stdout_color_sinks.h>
+#include <spdlog/spdlog.h>
+
+using namespace spdlog;
+
+static logger *logger_ = stdout_color_mt("FramePool").get();
+
+FramePool::FramePool(int max_frames)
+    : shape_(DEFAULT_MAT_SHAPE),
+      type_(DEFAULT_MAT_TYPE),
+      max_frames_(max_frames) {}
+
+FramePool::~FramePool() {}
+
+void FramePool::SetFrameFormat(const MatShape &shape, int type) {
+  lock_guard<mutex> lock(mutex_);
+  if (shape_ == shape && type_ == type) {
+    return;
+  }
+  shape_ = shape;
+  type_ = type;
+  // frames still in use stay alive through their own reference count
+  frames_.clear();
+}
+
+Mat FramePool::Acquire() {
+  lock_guard<mutex> lock(mutex_);
+  for (auto &frame : frames_) {
+    // the pool's own reference is the only one left
+    if (frame.u != nullptr && frame.u->refcount == 1) {
+      return frame;
+    }
+  }
+
+  Mat frame(shape_.dims(), shape_.p(), type_);
+  if (frames_.size() < max_frames_) {
+    frames_.push_back(frame);
+  } else {
+    logger_->warn("All {} pooled frames are in use, allocating a new one",
+                  max_frames_);
+  }
+  return frame;
+}
+
+int FramePool::GetPoolSize() {
+  lock_guard<mutex> lock(mutex_);
+  return frames_.size();
+}
@@ -0,0 +1,83 @@
+/* Copyright (C) 2023 Deep In Sight
+ * Author: Le Ngoc Linh <lnlinh93@dinsight.ai>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Suite 500,
+ * Boston, MA 02110-1335, USA.
+ */
+
+#ifndef __FRAME_POOL_H__
+#define __FRAME_POOL_H__
+
+#include <sdk/core/pad.h>
+
+#include <mutex>
+#include <vector>
+
+#define DEFAULT_POOL_SIZE 8
+
+using namespace std;
+using namespace cv;
+
+/**
+ * @brief A pool of preallocated frames of the same shape and type. Elements
+ * use it to avoid allocating a new output frame for every input frame. A frame
+ * goes back to the pool automatically when all downstream references to it
+ * (queues, observers, ...) are released.
+ *
+ */
+class FramePool {
+ public:
+  /**
+   * @brief Construct a new FramePool object
+   *
+   * @param max_frames maximum number of frames kept in the pool. When all of
+   * them are in use, Acquire() falls back to a plain allocation.
+   */
+  FramePool(int max_frames = DEFAULT_POOL_SIZE);
+  ~FramePool();
+
+  /**
+   * @brief Set the shape and type of the pooled frames. Frames of the old
+   * format are dropped from the pool (not freed while still in use).
+   *
+   * @param shape
+   * @param type
+   */
+  void SetFrameFormat(const MatShape &shape, int type);
+
+  /**
+   * @brief Get a frame that is not referenced by anyone else. Its content is
+   * undefined.
+   *
+   * @return Mat
+   */
+  Mat Acquire();
+
+  /**
+   * @brief Get number of frames currently owned by the pool.
+   *
+   * @return int
+   */
+  int GetPoolSize();
+
+ private:
+  mutex mutex_;
+  vector<Mat> frames_;
+  MatShape shape_;
+  int type_;
+  int max_frames_;
+};
+
+#endif  // __FRAME_POOL_H__
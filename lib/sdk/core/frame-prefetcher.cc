@@ -0,0 +1,335 @@
+#include <fcntl.h>
+#include <sdk/core/frame-prefetcher.h>
+#include <spdlog/sinks/stdout_color_sinks.h>
+#include <spdlog/spdlog.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+
+#ifdef HAVE_LIBURING
+#include <liburing.h>
+#endif
+
+using namespace spdlog;
+
+static logger *logger_ = stdout_color_mt("FramePrefetcher").get();
+
+struct ReadRequest {
+  uint8_t *data;
+  size_t length;
+  size_t offset;
+};
+
+static bool ReadFully(int fd, uint8_t *data, size_t length, size_t offset) {
+  while (length > 0) {
+    ssize_t n = pread(fd, data, length, offset);
+    if (n < 0 && errno == EINTR) continue;
+    if (n <= 0) return false;
+    data += n;
+    length -= n;
+    offset += n;
+  }
+  return true;
+}
+
+/**
+ * @brief Performs a batch of reads, returns once all of them completed.
+ *
+ */
+class PrefetchBackend {
+ public:
+  virtual ~PrefetchBackend() {}
+  virtual bool Read(int fd, vector<ReadRequest> &requests) = 0;
+};
+
+class PreadBackend : public PrefetchBackend {
+ public:
+  bool Read(int fd, vector<ReadRequest> &requests) override {
+    for (auto &request : requests) {
+      if (!ReadFully(fd, request.data, request.length, request.offset)) {
+        return false;
+      }
+    }
+    return true;
+  }
+};
+
+#ifdef HAVE_LIBURING
+/**
+ * @brief Submits up to a ring worth of reads with a single syscall and lets
+ * the kernel run them concurrently.
+ *
+ */
+class UringBackend : public PrefetchBackend {
+ public:
+  ~UringBackend() {
+    if (entries_ > 0) io_uring_queue_exit(&ring_);
+  }
+
+  /**
+   * @brief Returns nullptr if the kernel does not support io_uring.
+   *
+   */
+  static unique_ptr<PrefetchBackend> Create(int entries) {
+    unique_ptr<UringBackend> backend(new UringBackend());
+    if (io_uring_queue_init(entries, &backend->ring_, 0) < 0) {
+      return nullptr;
+    }
+    backend->entries_ = entries;
+    return move(backend);
+  }
+
+  bool Read(int fd, vector<ReadRequest> &requests) override {
+    bool ok = true;
+    // submit as many requests as the ring can hold, then wait for them
+    for (size_t begin = 0; begin < requests.size(); begin += entries_) {
+      size_t end = min(begin + entries_, requests.size());
+      int queued = 0;
+      for (size_t i = begin; i < end; i++) {
+        io_uring_sqe *sqe = io_uring_get_sqe(&ring_);
+        if (sqe == nullptr) break;
+        io_uring_prep_read(sqe, fd, requests[i].data, requests[i].length,
+                           requests[i].offset);
+        io_uring_sqe_set_data(sqe, &requests[i]);
+        queued++;
+      }
+
+      int submitted = io_uring_submit(&ring_);
+      ok = ok && (submitted == queued) && (queued == end - begin);
+      for (int i = 0; i < max(submitted, 0); i++) {
+        io_uring_cqe *cqe;
+        if (io_uring_wait_cqe(&ring_, &cqe) < 0) {
+          return false;
+        }
+        auto request = (ReadRequest *)io_uring_cqe_get_data(cqe);
+        int res = cqe->res;
+        io_uring_cqe_seen(&ring_, cqe);
+
+        if (res < 0) {
+          ok = false;
+        } else if ((size_t)res < request->length) {
+          // short read, finish it synchronously
+          ok = ok && ReadFully(fd, request->data + res,
+                               request->length - res, request->offset + res);
+        }
+      }
+      if (!ok) break;
+    }
+    return ok;
+  }
+
+ private:
+  UringBackend() : entries_(0) {}
+  io_uring ring_;
+  size_t entries_;
+};
+#endif
+
+FramePrefetcher::FramePrefetcher(int depth, int retained)
+    : depth_(depth),
+      fd_(-1),
+      segments_(1),
+      segment_stride_(0),
+      count_(0),
+      loop_(false),
+      pool_(2 * depth + retained),
+      thread_(nullptr),
+      running_(false),
+      next_(-1),
+      generation_(0),
+      error_(false),
+      hits_(0),
+      misses_(0) {}
+
+FramePrefetcher::~FramePrefetcher() { Close(); }
+
+bool FramePrefetcher::Open(const string &filename, size_t offset,
+                           size_t stride, int count, const MatShape &shape,
+                           int type, int segments, size_t segment_stride) {
+  Close();
+
+  fd_ = open(filename.c_str(), O_RDONLY);
+  if (fd_ < 0) {
+    logger_->error("Failed to open file {}", filename);
+    return false;
+  }
+  posix_fadvise(fd_, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+  offset_ = offset;
+  stride_ = stride;
+  count_ = count;
+  shape_ = shape;
+  type_ = type;
+  frame_size_ = CV_ELEM_SIZE(type);
+  for (int i = 0; i < shape.dims(); i++) {
+    frame_size_ *= shape[i];
+  }
+  segments_ = segments;
+  segment_stride_ = segment_stride;
+  pool_.SetFrameFormat(shape, type);
+
+#ifdef HAVE_LIBURING
+  backend_ = UringBackend::Create(PREFETCH_URING_ENTRIES);
+  if (backend_ == nullptr) {
+    logger_->warn("io_uring is not available, falling back to pread");
+  }
+#endif
+  if (backend_ == nullptr) {
+    backend_.reset(new PreadBackend());
+  }
+
+  {
+    lock_guard<mutex> lock(mutex_);
+    ring_.clear();
+    pending_.clear();
+    next_ = count_ > 0 ? 0 : -1;
+    generation_++;
+    error_ = false;
+    running_ = true;
+  }
+  thread_ = new thread(&FramePrefetcher::IoLoop, this);
+  return true;
+}
+
+void FramePrefetcher::Close() {
+  if (thread_ != nullptr) {
+    {
+      lock_guard<mutex> lock(mutex_);
+      running_ = false;
+    }
+    condvar_.notify_all();
+    thread_->join();
+    delete thread_;
+    thread_ = nullptr;
+  }
+
+  ring_.clear();
+  backend_.reset();
+  if (fd_ >= 0) {
+    close(fd_);
+    fd_ = -1;
+  }
+}
+
+bool FramePrefetcher::IsOpen() { return fd_ >= 0; }
+
+void FramePrefetcher::SetLoop(bool loop) {
+  lock_guard<mutex> lock(mutex_);
+  loop_ = loop;
+  // resume prefetching if the I/O thread stopped at the end of file
+  if (loop_ && next_ < 0 && !error_ && count_ > 0) {
+    next_ = ring_.empty() ? 0 : NextIndex(ring_.back().first);
+    condvar_.notify_all();
+  }
+}
+
+int FramePrefetcher::NextIndex(int index) {
+  if (index + 1 < count_) return index + 1;
+  return loop_ ? 0 : -1;
+}
+
+bool FramePrefetcher::IsPending(int index) {
+  return find(pending_.begin(), pending_.end(), index) != pending_.end();
+}
+
+void FramePrefetcher::IoLoop() {
+  unique_lock<mutex> lock(mutex_);
+  while (running_) {
+    condvar_.wait(lock, [this] {
+      return !running_ || (next_ >= 0 && ring_.size() < depth_);
+    });
+    if (!running_) break;
+
+    int generation = generation_;
+    int batch = min<int>(PREFETCH_BATCH_SIZE, depth_ - ring_.size());
+    while (pending_.size() < batch && next_ >= 0) {
+      pending_.push_back(next_);
+      next_ = NextIndex(next_);
+    }
+    vector<int> indices = pending_;
+    lock.unlock();
+
+    vector<Mat> frames;
+    vector<ReadRequest> requests;
+    size_t segment_size = frame_size_ / segments_;
+    for (int index : indices) {
+      frames.push_back(pool_.Acquire());
+      for (int s = 0; s < segments_; s++) {
+        requests.push_back({frames.back().data + s * segment_size,
+                            segment_size,
+                            offset_ + index * stride_ + s * segment_stride_});
+      }
+    }
+    bool ok = backend_->Read(fd_, requests);
+
+    lock.lock();
+    pending_.clear();
+    if (generation == generation_) {
+      if (ok) {
+        for (int i = 0; i < indices.size(); i++) {
+          ring_.emplace_back(indices[i], frames[i]);
+        }
+      } else {
+        logger_->error("Failed to read frames {} to {}", indices.front(),
+                       indices.back());
+        error_ = true;
+        next_ = -1;
+      }
+    }
+    condvar_.notify_all();
+  }
+}
+
+Mat FramePrefetcher::GetFrame(int index) {
+  if (index < 0 || index >= count_) {
+    return Mat();
+  }
+
+  unique_lock<mutex> lock(mutex_);
+  auto isReady = [this, index] {
+    return find_if(ring_.begin(), ring_.end(), [index](pair<int, Mat> &p) {
+             return p.first == index;
+           }) != ring_.end();
+  };
+
+  if (isReady()) {
+    hits_++;
+  } else {
+    misses_++;
+    // what is in the ring now was read for another position
+    ring_.clear();
+    // a batch in flight that doesn't hold the frame would refill the ring
+    // with stale frames and stall the I/O thread, so it is dropped too
+    if (!IsPending(index)) {
+      next_ = index;
+      generation_++;
+      error_ = false;
+    }
+    condvar_.notify_all();
+    condvar_.wait(lock, [this, &isReady] {
+      return !running_ || error_ || isReady();
+    });
+    if (!isReady()) {
+      return Mat();
+    }
+  }
+
+  // frames before the requested one are skipped
+  while (ring_.front().first != index) {
+    ring_.pop_front();
+  }
+  Mat frame = ring_.front().second;
+  ring_.pop_front();
+  condvar_.notify_all();
+  return frame;
+}
+
+uint64_t FramePrefetcher::GetHits() { return hits_; }
+
+uint64_t FramePrefetcher::GetMisses() { return misses_; }
+
+void FramePrefetcher::ResetStats() {
+  hits_ = 0;
+  misses_ = 0;
+}
@@ -0,0 +1,161 @@
+/* Copyright (C) 2023 Deep In Sight
+ * Author: Le Ngoc Linh <lnlinh93@dinsight.ai>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Suite 500,
+ * Boston, MA 02110-1335, USA.
+ */
+#ifndef __FRAME_PREFETCHER_H__
+#define __FRAME_PREFETCHER_H__
+
+#include <sdk/core/frame-pool.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#define DEFAULT_PREFETCH_DEPTH 8
+// maximum number of frames submitted to the I/O backend at once
+#define PREFETCH_BATCH_SIZE 4
+// number of reads in flight in the io_uring backend
+#define PREFETCH_URING_ENTRIES 16
+
+using namespace std;
+using namespace cv;
+
+class PrefetchBackend;
+
+/**
+ * @brief Reads frames of a recording ahead of the consumer on a dedicated I/O
+ * thread, so that slow storage (network filesystems, spinning disks) does not
+ * stall the pipeline. Up to depth frames following the last requested one are
+ * kept in a bounded ring. Reads go through io_uring when the SDK is built with
+ * liburing and the kernel supports it, else through pread.
+ *
+ * Frame i of the file is located at offset + i * stride. It is either
+ * continuous, or split in equal segments that are segment_stride bytes apart
+ * in the file (e.g. planes interleaved with headers), and gathered into one
+ * continuous frame.
+ *
+ */
+class FramePrefetcher {
+ public:
+  /**
+   * @brief Construct a new FramePrefetcher object
+   *
+   * @param depth number of frames kept ahead of the consumer
+   * @param retained number of frames the consumer keeps alive on top of the
+   * one it is using (e.g. a cache), so that the pool never runs dry
+   */
+  FramePrefetcher(int depth = DEFAULT_PREFETCH_DEPTH, int retained = 0);
+  ~FramePrefetcher();
+
+  /**
+   * @brief Open the file and start the I/O thread, prefetching from frame 0.
+   *
+   * @param filename
+   * @param offset byte offset of the first frame
+   * @param stride distance in bytes between two frames
+   * @param count number of frames
+   * @param shape shape of a frame
+   * @param type type of a frame
+   * @param segments number of segments a frame is split in
+   * @param segment_stride distance in bytes between two segments
+   * @return true
+   * @return false if the file cannot be opened
+   */
+  bool Open(const string &filename, size_t offset, size_t stride, int count,
+            const MatShape &shape, int type, int segments = 1,
+            size_t segment_stride = 0);
+  void Close();
+  bool IsOpen();
+
+  /**
+   * @brief Whether the frame after the last one is frame 0.
+   *
+   * @param loop
+   */
+  void SetLoop(bool loop);
+
+  /**
+   * @brief Get a frame, waiting for the I/O thread if it is not prefetched
+   * yet. Requesting a frame that is not coming next (a seek) flushes the ring
+   * and restarts prefetching from that frame.
+   *
+   * @param index
+   * @return Mat empty if index is out of range or the read failed
+   */
+  Mat GetFrame(int index);
+
+  /**
+   * @brief Number of frames that were already in the ring when requested.
+   *
+   * @return uint64_t
+   */
+  uint64_t GetHits();
+
+  /**
+   * @brief Number of frames the consumer had to wait for.
+   *
+   * @return uint64_t
+   */
+  uint64_t GetMisses();
+
+  void ResetStats();
+
+ private:
+  void IoLoop();
+  int NextIndex(int index);
+  bool IsPending(int index);
+
+  int depth_;
+  int fd_;
+  size_t offset_;
+  size_t stride_;
+  size_t frame_size_;
+  int segments_;
+  size_t segment_stride_;
+  int count_;
+  bool loop_;
+  MatShape shape_;
+  int type_;
+
+  FramePool pool_;
+  unique_ptr<PrefetchBackend> backend_;
+  thread *thread_;
+
+  mutex mutex_;
+  condition_variable condvar_;
+  bool running_;
+  // prefetched frames, in reading order
+  deque<pair<int, Mat>> ring_;
+  // frames being read by the I/O thread
+  vector<int> pending_;
+  // next frame the I/O thread reads, -1 at the end of a non-looping file
+  int next_;
+  // bumped on seek, reads started before are dropped
+  int generation_;
+  // a frame failed to read, consumers waiting for it give up
+  bool error_;
+
+  atomic<uint64_t> hits_;
+  atomic<uint64_t> misses_;
+};
+
+#endif  // __FRAME_PREFETCHER_H__
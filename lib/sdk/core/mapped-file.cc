@@ -0,0 +1,166 @@
+#include <fcntl.h>
+#include <sdk/core/mapped-file.h>
+#include <spdlog/sinks/stdout_color_sinks.h>
+#include <spdlog/spdlog.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace spdlog;
+
+static logger *logger_ = stdout_color_mt("MappedFile").get();
+
+struct MappedFile::Window {
+  Window(uint8_t *addr, size_t offset, size_t length)
+      : addr(addr), offset(offset), length(length) {}
+  ~Window() { munmap(addr, length); }
+
+  bool Contains(size_t begin, size_t size) {
+    return begin >= offset && begin + size <= offset + length;
+  }
+
+  uint8_t *addr;
+  size_t offset;
+  size_t length;
+};
+
+/**
+ * @brief Allocator of the frames returned by MappedFile::GetFrame. It never
+ * allocates, it only releases the reference to the window when the last Mat
+ * referencing a frame goes away.
+ *
+ */
+class MappedFrameAllocator : public MatAllocator {
+ public:
+  UMatData *allocate(int dims, const int *sizes, int type, void *data,
+                     size_t *step, AccessFlag flags,
+                     UMatUsageFlags usageFlags) const override {
+    return nullptr;
+  }
+
+  bool allocate(UMatData *data, AccessFlag accessflags,
+                UMatUsageFlags usageFlags) const override {
+    return false;
+  }
+
+  void deallocate(UMatData *u) const override {
+    if (u == nullptr) return;
+    delete (shared_ptr<void> *)u->userdata;
+    delete u;
+  }
+};
+
+static MappedFrameAllocator *GetMappedFrameAllocator() {
+  // never destroyed, frames may outlive static destruction order
+  static MappedFrameAllocator *allocator = new MappedFrameAllocator();
+  return allocator;
+}
+
+MappedFile::MappedFile(size_t window_size)
+    : fd_(-1), size_(0), window_size_(window_size) {
+  page_size_ = sysconf(_SC_PAGESIZE);
+}
+
+MappedFile::~MappedFile() { Close(); }
+
+bool MappedFile::Open(const string &filename) {
+  Close();
+
+  fd_ = open(filename.c_str(), O_RDONLY);
+  if (fd_ < 0) {
+    logger_->error("Failed to open file {}", filename);
+    return false;
+  }
+
+  struct stat st;
+  if (fstat(fd_, &st) != 0) {
+    logger_->error("Failed to stat file {}", filename);
+    Close();
+    return false;
+  }
+  size_ = st.st_size;
+  return true;
+}
+
+void MappedFile::Close() {
+  // frames still in use keep their own reference to the window
+  window_.reset();
+  if (fd_ >= 0) {
+    close(fd_);
+    fd_ = -1;
+  }
+  size_ = 0;
+}
+
+bool MappedFile::IsOpen() { return fd_ >= 0; }
+
+size_t MappedFile::GetSize() { return size_; }
+
+bool MappedFile::MapWindow(size_t offset, size_t length) {
+  if (window_ && window_->Contains(offset, length)) {
+    return true;
+  }
+
+  size_t begin = offset / page_size_ * page_size_;
+  size_t end = max(offset + length, begin + window_size_);
+  end = min(end, size_);
+
+  void *addr = mmap(nullptr, end - begin, PROT_READ | PROT_WRITE, MAP_PRIVATE,
+                    fd_, begin);
+  if (addr == MAP_FAILED) {
+    logger_->error("Failed to map {} bytes at offset {}", end - begin, begin);
+    window_.reset();
+    return false;
+  }
+  madvise(addr, end - begin, MADV_SEQUENTIAL);
+
+  window_ = make_shared<Window>((uint8_t *)addr, begin, end - begin);
+  return true;
+}
+
+Mat MappedFile::GetFrame(size_t offset, const MatShape &shape, int type,
+                         const size_t *steps) {
+  int last = shape.dims() - 1;
+  size_t length = CV_ELEM_SIZE(type) * shape[last];
+  for (int i = 0; i < last; i++) {
+    length = steps ? length + (shape[i] - 1) * steps[i] : length * shape[i];
+  }
+  if (fd_ < 0 || offset + length > size_ || !MapWindow(offset, length)) {
+    return Mat();
+  }
+
+  uint8_t *data = window_->addr + (offset - window_->offset);
+  Mat frame(shape.dims(), shape.p(), type, data, steps);
+
+  // hand the frame a reference to its window, released by the allocator
+  MatAllocator *allocator = GetMappedFrameAllocator();
+  UMatData *u = new UMatData(allocator);
+  u->data = u->origdata = data;
+  u->size = length;
+  u->refcount = 1;
+  u->flags |= UMatData::USER_ALLOCATED;
+  u->userdata = new shared_ptr<void>(window_);
+  frame.allocator = allocator;
+  frame.u = u;
+  return frame;
+}
+
+bool MappedFile::Read(size_t offset, void *data, size_t length) {
+  if (fd_ < 0 || offset + length > size_) {
+    return false;
+  }
+  return pread(fd_, data, length, offset) == (ssize_t)length;
+}
+
+void MappedFile::WillNeed(size_t offset, size_t length) {
+  if (!window_ || length == 0) return;
+
+  // clip to the current window, the next one is advised when it gets mapped
+  size_t begin = max(offset, window_->offset);
+  size_t end = min(offset + length, window_->offset + window_->length);
+  if (begin >= end) return;
+
+  size_t aligned = begin / page_size_ * page_size_;
+  madvise(window_->addr + (aligned - window_->offset), end - aligned,
+          MADV_WILLNEED);
+}
@@ -0,0 +1,107 @@
+/* Copyright (C) 2023 Deep In Sight
+ * Author: Le Ngoc Linh <lnlinh93@dinsight.ai>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Suite 500,
+ * Boston, MA 02110-1335, USA.
+ */
+#ifndef __MAPPED_FILE_H__
+#define __MAPPED_FILE_H__
+
+#include <sdk/core/pad.h>
+
+#include <memory>
+#include <string>
+
+// 256MB windows keep the address space usage bounded for multi-GB recordings
+#define DEFAULT_MAP_WINDOW_SIZE ((size_t)256 << 20)
+
+using namespace std;
+using namespace cv;
+
+/**
+ * @brief Read-only view of a file through memory mapped windows. Frames are
+ * returned as Mat headers wrapped directly around the mapped pages, so reading
+ * a frame costs neither an allocation nor a copy. Each frame keeps its window
+ * mapped until the last reference to it is released, so frames stay valid
+ * after the file moves to another window or is closed.
+ *
+ * Pages are mapped private and writable: an element writing into a frame in
+ * place gets its own copy of the touched pages, the file is never modified.
+ *
+ */
+class MappedFile {
+ public:
+  /**
+   * @brief Construct a new MappedFile object
+   *
+   * @param window_size size of a mapped window. Files smaller than that are
+   * mapped at once.
+   */
+  MappedFile(size_t window_size = DEFAULT_MAP_WINDOW_SIZE);
+  ~MappedFile();
+
+  bool Open(const string &filename);
+  void Close();
+  bool IsOpen();
+  size_t GetSize();
+
+  /**
+   * @brief Get a frame backed by the bytes at [offset, offset + frame size).
+   *
+   * @param offset byte offset of the frame in the file
+   * @param shape
+   * @param type
+   * @param steps bytes between consecutive elements of each dimension except
+   * the last one, like cv::Mat steps. nullptr for a continuous frame. Used to
+   * skip headers interleaved with the planes of a frame.
+   * @return Mat empty if the frame is not entirely inside the file
+   */
+  Mat GetFrame(size_t offset, const MatShape &shape, int type,
+               const size_t *steps = nullptr);
+
+  /**
+   * @brief Copy bytes out of the file, for small headers that are parsed
+   * rather than passed downstream.
+   *
+   * @return true if all length bytes were read
+   */
+  bool Read(size_t offset, void *data, size_t length);
+
+  /**
+   * @brief Hint the kernel that [offset, offset + length) will be read soon
+   * so that it starts reading ahead asynchronously.
+   *
+   */
+  void WillNeed(size_t offset, size_t length);
+
+ private:
+  struct Window;
+
+  /**
+   * @brief Make sure the current window covers [offset, offset + length).
+   *
+   * @return true
+   * @return false when mmap fails
+   */
+  bool MapWindow(size_t offset, size_t length);
+
+  int fd_;
+  size_t size_;
+  size_t window_size_;
+  size_t page_size_;
+  shared_ptr<Window> window_;
+};
+
+#endif  // __MAPPED_FILE_H__
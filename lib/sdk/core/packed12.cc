@@ -0,0 +1,254 @@
+#include <sdk/core/packed12.h>
+
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define PACKED12_X86
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#define PACKED12_NEON
+#endif
+
+static void PackScalar(const int16_t *in, uint8_t *out, size_t count) {
+  for (size_t i = 0; i + 1 < count; i += 2) {
+    uint16_t a = in[i] & 0xfff;
+    uint16_t b = in[i + 1] & 0xfff;
+    out[0] = a;
+    out[1] = (a >> 8) | (b << 4);
+    out[2] = b >> 4;
+    out += 3;
+  }
+}
+
+static void UnpackScalar(const uint8_t *in, int16_t *out, size_t count) {
+  for (size_t i = 0; i + 1 < count; i += 2) {
+    uint16_t a = in[0] | ((in[1] & 0xf) << 8);
+    uint16_t b = (in[1] >> 4) | (in[2] << 4);
+    // sign extend from bit 11
+    out[i] = (int16_t)(a << 4) >> 4;
+    out[i + 1] = (int16_t)(b << 4) >> 4;
+    in += 3;
+  }
+}
+
+// SIMD kernels return the number of samples done, the scalar code finishes.
+// They load and store whole vectors, so they stop a vector before the end.
+#ifdef PACKED12_X86
+
+__attribute__((target("ssse3"))) static size_t PackSsse3(const int16_t *in,
+                                                         uint8_t *out,
+                                                         size_t count) {
+  const __m128i mask = _mm_set1_epi16(0x0fff);
+  const __m128i low = _mm_set1_epi32(0xffff);
+  // bytes 0-2 of every 32 bits pair
+  const __m128i shuffle =
+      _mm_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+  size_t size = count / 2 * 3;
+  size_t i = 0;
+  for (; i + 8 <= count && i / 2 * 3 + 16 <= size; i += 8) {
+    __m128i v = _mm_and_si128(_mm_loadu_si128((const __m128i *)(in + i)), mask);
+    // a | b << 12 in every 32 bits pair
+    v = _mm_or_si128(_mm_and_si128(v, low),
+                     _mm_slli_epi32(_mm_srli_epi32(v, 16), 12));
+    v = _mm_shuffle_epi8(v, shuffle);
+    _mm_storeu_si128((__m128i *)(out + i / 2 * 3), v);
+  }
+  return i;
+}
+
+__attribute__((target("ssse3"))) static size_t UnpackSsse3(const uint8_t *in,
+                                                           int16_t *out,
+                                                           size_t count) {
+  // a in bytes 0-1 of a pair, b in bytes 1-2
+  const __m128i shuffle =
+      _mm_setr_epi8(0, 1, 1, 2, 3, 4, 4, 5, 6, 7, 7, 8, 9, 10, 10, 11);
+  // a << 4 and b << 0, then an arithmetic shift right by 4 sign extends both
+  const __m128i scale = _mm_setr_epi16(16, 1, 16, 1, 16, 1, 16, 1);
+  size_t size = count / 2 * 3;
+  size_t i = 0;
+  for (; i + 8 <= count && i / 2 * 3 + 16 <= size; i += 8) {
+    __m128i v = _mm_loadu_si128((const __m128i *)(in + i / 2 * 3));
+    v = _mm_shuffle_epi8(v, shuffle);
+    v = _mm_srai_epi16(_mm_mullo_epi16(v, scale), 4);
+    _mm_storeu_si128((__m128i *)(out + i), v);
+  }
+  return i;
+}
+
+__attribute__((target("avx2"))) static size_t PackAvx2(const int16_t *in,
+                                                       uint8_t *out,
+                                                       size_t count) {
+  const __m256i mask = _mm256_set1_epi16(0x0fff);
+  const __m256i low = _mm256_set1_epi32(0xffff);
+  const __m256i shuffle = _mm256_setr_epi8(
+      0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1,  //
+      0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+  // 12 bytes of each lane back to back
+  const __m256i gather = _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 7, 7);
+  size_t size = count / 2 * 3;
+  size_t i = 0;
+  for (; i + 16 <= count && i / 2 * 3 + 32 <= size; i += 16) {
+    __m256i v = _mm256_and_si256(
+        _mm256_loadu_si256((const __m256i *)(in + i)), mask);
+    v = _mm256_or_si256(_mm256_and_si256(v, low),
+                        _mm256_slli_epi32(_mm256_srli_epi32(v, 16), 12));
+    v = _mm256_shuffle_epi8(v, shuffle);
+    v = _mm256_permutevar8x32_epi32(v, gather);
+    _mm256_storeu_si256((__m256i *)(out + i / 2 * 3), v);
+  }
+  return i;
+}
+
+__attribute__((target("avx2"))) static size_t UnpackAvx2(const uint8_t *in,
+                                                         int16_t *out,
+                                                         size_t count) {
+  // bytes 0-11 in the low lane, 12-23 in the high lane
+  const __m256i spread = _mm256_setr_epi32(0, 1, 2, 3, 3, 4, 5, 6);
+  const __m256i shuffle = _mm256_setr_epi8(
+      0, 1, 1, 2, 3, 4, 4, 5, 6, 7, 7, 8, 9, 10, 10, 11,  //
+      0, 1, 1, 2, 3, 4, 4, 5, 6, 7, 7, 8, 9, 10, 10, 11);
+  const __m256i scale =
+      _mm256_setr_epi16(16, 1, 16, 1, 16, 1, 16, 1, 16, 1, 16, 1, 16, 1, 16, 1);
+  size_t size = count / 2 * 3;
+  size_t i = 0;
+  for (; i + 16 <= count && i / 2 * 3 + 32 <= size; i += 16) {
+    __m256i v = _mm256_loadu_si256((const __m256i *)(in + i / 2 * 3));
+    v = _mm256_permutevar8x32_epi32(v, spread);
+    v = _mm256_shuffle_epi8(v, shuffle);
+    v = _mm256_srai_epi16(_mm256_mullo_epi16(v, scale), 4);
+    _mm256_storeu_si256((__m256i *)(out + i), v);
+  }
+  return i;
+}
+
+static bool HasAvx2() {
+  static bool avx2 = __builtin_cpu_supports("avx2");
+  return avx2;
+}
+
+static bool HasSsse3() {
+  static bool ssse3 = __builtin_cpu_supports("ssse3");
+  return ssse3;
+}
+
+#endif  // PACKED12_X86
+
+#ifdef PACKED12_NEON
+
+static size_t PackNeon(const int16_t *in, uint8_t *out, size_t count) {
+  const uint16x8_t mask = vdupq_n_u16(0x0fff);
+  size_t i = 0;
+  for (; i + 16 <= count; i += 16) {
+    // a and b samples deinterleaved
+    int16x8x2_t v = vld2q_s16(in + i);
+    uint16x8_t a = vandq_u16(vreinterpretq_u16_s16(v.val[0]), mask);
+    uint16x8_t b = vandq_u16(vreinterpretq_u16_s16(v.val[1]), mask);
+    uint8x8x3_t bytes;
+    bytes.val[0] = vmovn_u16(a);
+    bytes.val[1] = vmovn_u16(vorrq_u16(vshrq_n_u16(a, 8), vshlq_n_u16(b, 4)));
+    bytes.val[2] = vmovn_u16(vshrq_n_u16(b, 4));
+    vst3_u8(out + i / 2 * 3, bytes);
+  }
+  return i;
+}
+
+static size_t UnpackNeon(const uint8_t *in, int16_t *out, size_t count) {
+  const uint8x8_t mask = vdup_n_u8(0x0f);
+  size_t i = 0;
+  for (; i + 16 <= count; i += 16) {
+    uint8x8x3_t bytes = vld3_u8(in + i / 2 * 3);
+    uint16x8_t high = vmovl_u8(vand_u8(bytes.val[1], mask));
+    uint16x8_t a = vorrq_u16(vmovl_u8(bytes.val[0]), vshlq_n_u16(high, 8));
+    uint16x8_t b = vorrq_u16(vmovl_u8(vshr_n_u8(bytes.val[1], 4)),
+                             vshlq_n_u16(vmovl_u8(bytes.val[2]), 4));
+    int16x8x2_t v;
+    v.val[0] = vshrq_n_s16(vreinterpretq_s16_u16(vshlq_n_u16(a, 4)), 4);
+    v.val[1] = vshrq_n_s16(vreinterpretq_s16_u16(vshlq_n_u16(b, 4)), 4);
+    vst2q_s16(out + i, v);
+  }
+  return i;
+}
+
+#endif  // PACKED12_NEON
+
+bool Packed12::IsPacked(const MatShape &shape, int type) {
+  return type == CV_12SP && shape.dims() == 3 && shape[0] > 0 &&
+         shape[2] > 0;
+}
+
+MatShape Packed12::GetPackedShape(const MatShape &shape) {
+  if (shape.dims() == 3) {
+    return MatShape(shape[0], shape[1], shape[2] / 2);
+  }
+  return MatShape(shape[0], shape[1] / 2);
+}
+
+MatShape Packed12::GetUnpackedShape(const MatShape &shape) {
+  if (shape.dims() == 3) {
+    return MatShape(shape[0], shape[1], shape[2] * 2);
+  }
+  return MatShape(shape[0], shape[1] * 2);
+}
+
+void Packed12::Pack(const int16_t *in, uint8_t *out, size_t count) {
+  size_t done = 0;
+#if defined(PACKED12_X86)
+  if (HasAvx2()) {
+    done = PackAvx2(in, out, count);
+  } else if (HasSsse3()) {
+    done = PackSsse3(in, out, count);
+  }
+#elif defined(PACKED12_NEON)
+  done = PackNeon(in, out, count);
+#endif
+  PackScalar(in + done, out + done / 2 * 3, count - done);
+}
+
+void Packed12::Unpack(const uint8_t *in, int16_t *out, size_t count) {
+  size_t done = 0;
+#if defined(PACKED12_X86)
+  if (HasAvx2()) {
+    done = UnpackAvx2(in, out, count);
+  } else if (HasSsse3()) {
+    done = UnpackSsse3(in, out, count);
+  }
+#elif defined(PACKED12_NEON)
+  done = UnpackNeon(in, out, count);
+#endif
+  UnpackScalar(in + done / 2 * 3, out + done, count - done);
+}
+
+void Packed12::Pack(const Mat &in, Mat &out) {
+  MatShape shape = GetPackedShape(MatShape(in.size));
+  out.create(shape.dims(), shape.p(), CV_12SP);
+
+  int planes = (in.dims == 3) ? in.size[0] : 1;
+  int rows = in.size[in.dims - 2];
+  int cols = in.size[in.dims - 1];
+  for (int p = 0; p < planes; p++) {
+    for (int r = 0; r < rows; r++) {
+      const int16_t *src =
+          (in.dims == 3) ? in.ptr<int16_t>(p, r) : in.ptr<int16_t>(r);
+      uint8_t *dst = (out.dims == 3) ? out.ptr<uint8_t>(p, r) : out.ptr(r);
+      Pack(src, dst, cols);
+    }
+  }
+}
+
+void Packed12::Unpack(const Mat &in, Mat &out) {
+  MatShape shape = GetUnpackedShape(MatShape(in.size));
+  out.create(shape.dims(), shape.p(), CV_16SC1);
+
+  int planes = (in.dims == 3) ? in.size[0] : 1;
+  int rows = in.size[in.dims - 2];
+  int cols = shape[shape.dims() - 1];
+  for (int p = 0; p < planes; p++) {
+    for (int r = 0; r < rows; r++) {
+      const uint8_t *src = (in.dims == 3) ? in.ptr<uint8_t>(p, r) : in.ptr(r);
+      int16_t *dst =
+          (out.dims == 3) ? out.ptr<int16_t>(p, r) : out.ptr<int16_t>(r);
+      Unpack(src, dst, cols);
+    }
+  }
+}
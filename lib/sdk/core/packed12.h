@@ -0,0 +1,114 @@
+/* Copyright (C) 2023 Deep In Sight
+ * Author: Le Ngoc Linh <lnlinh93@dinsight.ai>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Suite 500,
+ * Boston, MA 02110-1335, USA.
+ */
+#ifndef __PACKED12_H__
+#define __PACKED12_H__
+
+#include <sdk/core/pad.h>
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief Frame type of packed 12 bits samples. Two consecutive samples a, b
+ * are stored in 3 bytes, little endian:
+ *
+ *  byte 0: a[7:0]
+ *  byte 1: b[3:0] a[11:8]
+ *  byte 2: b[11:4]
+ *
+ * so a packed frame of planes x rows x cols samples is a planes x rows x
+ * cols/2 frame of CV_8UC3, each element a pair of samples. Samples are
+ * signed, in [-2048, 2047].
+ *
+ * CV_12SP is not a distinct OpenCV type, a frame format is packed only if it
+ * also has the 3 dimensions of a packed frame (see Packed12::IsPacked), so
+ * that 2D color images are never taken for packed samples.
+ *
+ */
+#define CV_12SP CV_8UC3
+
+using namespace std;
+using namespace cv;
+
+class Packed12 {
+ public:
+  /**
+   * @brief Whether a frame format is packed 12 bits: CV_12SP, planes x rows x
+   * pairs of samples.
+   *
+   * @param shape
+   * @param type
+   * @return true
+   * @return false
+   */
+  static bool IsPacked(const MatShape &shape, int type);
+
+  /**
+   * @brief Shape of the packed frame of a CV_16SC1 shape, cols must be even.
+   *
+   * @param shape
+   * @return MatShape
+   */
+  static MatShape GetPackedShape(const MatShape &shape);
+
+  /**
+   * @brief Shape of the CV_16SC1 frame of a packed shape.
+   *
+   * @param shape
+   * @return MatShape
+   */
+  static MatShape GetUnpackedShape(const MatShape &shape);
+
+  /**
+   * @brief Pack samples, the 4 most significant bits are dropped. Uses
+   * AVX2/SSSE3 or NEON when the CPU supports them.
+   *
+   * @param in
+   * @param out 3 bytes per pair of samples
+   * @param count number of samples, even
+   */
+  static void Pack(const int16_t *in, uint8_t *out, size_t count);
+
+  /**
+   * @brief Unpack samples, sign extended.
+   *
+   * @param in
+   * @param out
+   * @param count number of samples, even
+   */
+  static void Unpack(const uint8_t *in, int16_t *out, size_t count);
+
+  /**
+   * @brief Pack a CV_16SC1 frame, planes do not need to be continuous.
+   *
+   * @param in
+   * @param out allocated if needed
+   */
+  static void Pack(const Mat &in, Mat &out);
+
+  /**
+   * @brief Unpack a packed frame to CV_16SC1.
+   *
+   * @param in
+   * @param out allocated if needed
+   */
+  static void Unpack(const Mat &in, Mat &out);
+};
+
+#endif  // __PACKED12_H__
@@ -142,6 +142,18 @@ bool MatShape::operator!=(const MatSize &size) {
   return false;
 }
 
+bool MatShape::Matches(const MatSize &size) const {
+  if (dims_ != size.dims()) {
+    return false;
+  }
+  for (int i = 0; i < dims_; i++) {
+    if (p_[i] != MAT_DIM_DYNAMIC && p_[i] != size[i]) {
+      return false;
+    }
+  }
+  return true;
+}
+
 const int MatShape::operator[](int index) const {
   assert(index < dims_);
   return p_[index];
@@ -229,7 +241,7 @@ void Pad::PushFrame(cv::Mat &frame) {
   // size of the matrix, in case dims=2. frame.size is the MatSize that can have
   // dims>2.
 
-  if (mat_shape_ != frame.size || frame.type() != mat_type_) {
+  if (!mat_shape_.Matches(frame.size) || frame.type() != mat_type_) {
     string elemName = (parent_ == nullptr) ? "" : parent_->GetName();
     string padName = GetName();
     logger_->error("[{}/{}]Frame size or type does not match", elemName,
@@ -71,6 +71,13 @@ enum DepthAmplitudeChannel { kDepthChannel, kAmplitudeChannel };
   { 2, 480, 640 }
 #define DEFAULT_MAT_TYPE CV_32FC1
 
+/**
+ * @brief A MatShape dimension with this size matches any size. Used by elements
+ * whose output length changes from frame to frame, e.g. compact point clouds.
+ *
+ */
+#define MAT_DIM_DYNAMIC -1
+
 /**
  * @brief OpenCV MatSize is very unnatural to use. This class is a alternative
  *
@@ -99,6 +106,16 @@ class MatShape {
   bool operator==(const MatSize &size);
   bool operator!=(const MatSize &size);
 
+  /**
+   * @brief Check if a frame of this size can be pushed to a pad of this shape.
+   * Same as operator==, except MAT_DIM_DYNAMIC dimensions match any size.
+   *
+   * @param size
+   * @return true
+   * @return false
+   */
+  bool Matches(const MatSize &size) const;
+
   const int operator[](int index) const;
 
  private:
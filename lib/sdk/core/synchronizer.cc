@@ -0,0 +1,368 @@
+#include <sdk/core/synchronizer.h>
+#include <spdlog/sinks/stdout_color_sinks.h>
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+using namespace spdlog;
+
+static logger *logger_ = stdout_color_mt("Synchronizer").get();
+
+SynchronizerInput::SynchronizerInput(Synchronizer *parent, int index,
+                                     const string &name)
+    : Element(name), parent_(parent), index_(index) {
+  sink_pad_ = new Pad(kPadSink, "sink");
+  AddPad(sink_pad_);
+}
+
+SynchronizerInput::~SynchronizerInput() {
+  sink_pad_->Unlink();
+  delete sink_pad_;
+}
+
+void SynchronizerInput::PushFrame(Mat &frame) {
+  parent_->OnFrame(index_, frame);
+}
+
+void SynchronizerInput::PushState(StreamState state) {
+  parent_->OnState(index_, state);
+}
+
+void SynchronizerInput::SetFrameFormat(const MatShape &shape, int type) {
+  parent_->OnFrameFormat(index_, shape, type);
+}
+
+Pad *SynchronizerInput::GetSinkPad() { return sink_pad_; }
+
+Synchronizer::Synchronizer(const string &name, int inputs)
+    : Element(name),
+      tolerance_us_(DEFAULT_SYNC_TOLERANCE_US),
+      policy_(kSyncDropIncomplete),
+      depth_(DEFAULT_SYNC_DEPTH),
+      last_emitted_us_(0),
+      emitted_(false),
+      last_state_(kStreamStateStopped),
+      stacked_(false) {
+  source_pad_ = new Pad(kPadSource, "src");
+  AddPad(source_pad_);
+  inputs_.resize(max(1, inputs));
+  for (int i = 0; i < (int)inputs_.size(); i++) {
+    Input &input = inputs_[i];
+    input.element.reset(
+        new SynchronizerInput(this, i, GetName() + "-sink" + to_string(i)));
+    input.ring.resize(depth_);
+    input.head = 0;
+    input.size = 0;
+    input.type = -1;
+    input.has_format = false;
+  }
+  ResetStats();
+}
+
+Synchronizer::~Synchronizer() {
+  // inputs unlink from upstream before the parent is gone
+  for (auto &input : inputs_) {
+    input.element.reset();
+  }
+  source_pad_->Unlink();
+  delete source_pad_;
+}
+
+int Synchronizer::GetInputCount() { return inputs_.size(); }
+
+Pad *Synchronizer::GetSinkPad(int input) {
+  if (input < 0 || input >= (int)inputs_.size()) {
+    return nullptr;
+  }
+  return inputs_[input].element->GetSinkPad();
+}
+
+Pad *Synchronizer::GetSourcePad() { return source_pad_; }
+
+void Synchronizer::SetTolerance(int64_t tolerance_us) {
+  logger_->info("Setting tolerance to {}us", tolerance_us);
+  lock_guard<mutex> lock(mutex_);
+  tolerance_us_ = max<int64_t>(0, tolerance_us);
+}
+
+void Synchronizer::SetPolicy(SyncPolicy policy) {
+  lock_guard<mutex> lock(mutex_);
+  policy_ = policy;
+}
+
+void Synchronizer::SetDepth(int depth) {
+  lock_guard<mutex> lock(mutex_);
+  Clear();
+  depth_ = max(1, depth);
+  for (auto &input : inputs_) {
+    input.ring.assign(depth_, Entry());
+  }
+}
+
+void Synchronizer::SetTimestampFunction(SyncTimestampFunction function) {
+  lock_guard<mutex> lock(mutex_);
+  timestamp_function_ = function;
+}
+
+void Synchronizer::SetGroupCallback(function<void(SyncGroup &)> callback) {
+  lock_guard<mutex> lock(emit_mutex_);
+  callback_ = callback;
+}
+
+SyncStats Synchronizer::GetStats() {
+  lock_guard<mutex> lock(mutex_);
+  return stats_;
+}
+
+void Synchronizer::ResetStats() {
+  lock_guard<mutex> lock(mutex_);
+  memset(&stats_, 0, sizeof(stats_));
+}
+
+void Synchronizer::PushFrame(Mat &frame) {}
+
+Synchronizer::Entry &Synchronizer::Front(Input &input) {
+  return input.ring[input.head];
+}
+
+void Synchronizer::PopFront(Input &input) {
+  // release the frame now, not when the slot is reused
+  input.ring[input.head].frame.release();
+  input.head = (input.head + 1) % depth_;
+  input.size--;
+}
+
+void Synchronizer::Clear() {
+  for (auto &input : inputs_) {
+    while (input.size > 0) PopFront(input);
+    input.head = 0;
+  }
+  emitted_ = false;
+}
+
+void Synchronizer::OnFrame(int index, Mat &frame) {
+  {
+    lock_guard<mutex> lock(mutex_);
+    if (!Insert(index, frame)) {
+      return;
+    }
+    SyncGroup group;
+    size_t queued = matched_.size();
+    while (Match(group)) {
+      matched_.push_back({move(group), stacked_});
+    }
+    // the groups already queued are pushed by the inputs that matched them
+    if (matched_.size() == queued) {
+      return;
+    }
+  }
+
+  // groups are pushed in the order they were matched, by whichever input
+  // gets emit_mutex_ first. mutex_ is not held meanwhile, so the callback
+  // and downstream may call back into the synchronizer.
+  lock_guard<mutex> emitLock(emit_mutex_);
+  while (true) {
+    Matched matched;
+    {
+      lock_guard<mutex> lock(mutex_);
+      if (matched_.empty()) {
+        return;
+      }
+      matched = move(matched_.front());
+      matched_.pop_front();
+    }
+    Emit(matched.group, matched.stacked);
+  }
+}
+
+bool Synchronizer::Insert(int index, Mat &frame) {
+  int64_t timestamp;
+  if (timestamp_function_) {
+    timestamp = timestamp_function_(index, frame);
+  } else {
+    timestamp = chrono::duration_cast<chrono::microseconds>(
+                    chrono::steady_clock::now().time_since_epoch())
+                    .count();
+  }
+
+  Input &input = inputs_[index];
+  bool outOfOrder = input.size > 0 &&
+                    timestamp < input.ring[(input.head + input.size - 1) %
+                                           depth_].timestamp_us;
+  // its group is gone already
+  if (outOfOrder ||
+      (emitted_ && timestamp < last_emitted_us_ - tolerance_us_)) {
+    stats_.late++;
+    return false;
+  }
+  if (input.size == depth_) {
+    PopFront(input);
+    stats_.dropped++;
+  }
+  Entry &entry = input.ring[(input.head + input.size) % depth_];
+  entry.timestamp_us = timestamp;
+  entry.frame = frame;
+  input.size++;
+  return true;
+}
+
+bool Synchronizer::Match(SyncGroup &group) {
+  while (true) {
+    int oldest = -1;
+    int64_t minTs = 0;
+    int64_t maxTs = 0;
+    bool anyEmpty = false;
+    bool anyFull = false;
+    for (int i = 0; i < (int)inputs_.size(); i++) {
+      Input &input = inputs_[i];
+      if (input.size == 0) {
+        anyEmpty = true;
+        continue;
+      }
+      anyFull = anyFull || (input.size == depth_);
+      int64_t ts = Front(input).timestamp_us;
+      if (oldest < 0) {
+        maxTs = ts;
+      }
+      if (oldest < 0 || ts < minTs) {
+        oldest = i;
+        minTs = ts;
+      }
+      maxTs = max(maxTs, ts);
+    }
+    if (oldest < 0) {
+      return false;
+    }
+
+    bool complete = !anyEmpty && (maxTs - minTs <= tolerance_us_);
+    if (!complete) {
+      // an empty input may still get the match of the oldest frame, unless
+      // another input is full and cannot wait any longer
+      if (anyEmpty && !(policy_ == kSyncEmitPartial && anyFull)) {
+        return false;
+      }
+      if (policy_ == kSyncDropIncomplete) {
+        // the other inputs are past it already, it will never have a match
+        PopFront(inputs_[oldest]);
+        stats_.dropped++;
+        continue;
+      }
+    }
+
+    // the oldest frame and the frames within the tolerance after it
+    group.frames.assign(inputs_.size(), Mat());
+    group.timestamps_us.assign(inputs_.size(), 0);
+    int64_t sum = 0;
+    int64_t last = minTs;
+    int count = 0;
+    for (int i = 0; i < (int)inputs_.size(); i++) {
+      Input &input = inputs_[i];
+      if (input.size == 0 ||
+          Front(input).timestamp_us > minTs + tolerance_us_) {
+        continue;
+      }
+      group.frames[i] = Front(input).frame;
+      group.timestamps_us[i] = Front(input).timestamp_us;
+      sum += group.timestamps_us[i];
+      last = max(last, group.timestamps_us[i]);
+      count++;
+      PopFront(input);
+    }
+    group.timestamp_us = sum / count;
+    group.skew_us = last - minTs;
+
+    stats_.groups++;
+    if (count < (int)inputs_.size()) stats_.partial_groups++;
+    stats_.mean_skew_us +=
+        (group.skew_us - stats_.mean_skew_us) / stats_.groups;
+    stats_.max_skew_us = max(stats_.max_skew_us, group.skew_us);
+    last_emitted_us_ = group.timestamp_us;
+    emitted_ = true;
+    return true;
+  }
+}
+
+void Synchronizer::Emit(SyncGroup &group, bool stacked) {
+  if (callback_) {
+    callback_(group);
+  }
+  if (!stacked) {
+    return;
+  }
+
+  // inputs one after the other along the first dimension
+  Mat out = pool_.Acquire();
+  for (int i = 0; i < (int)group.frames.size(); i++) {
+    Mat &frame = group.frames[i];
+    int planes = (frame.dims == 3) ? frame.size[0] : 1;
+    int rows = (frame.dims == 3) ? frame.size[1] : frame.rows;
+    size_t rowSize = ((frame.dims == 3) ? frame.size[2] : frame.cols) *
+                     frame.elemSize();
+    int outPlanes = out.size[0] / group.frames.size();
+    for (int p = 0; p < outPlanes; p++) {
+      for (int r = 0; r < out.size[1]; r++) {
+        uint8_t *dst = out.ptr<uint8_t>(i * outPlanes + p, r);
+        size_t outRowSize = out.size[2] * out.elemSize();
+        if (frame.empty() || p >= planes || r >= rows) {
+          memset(dst, 0, outRowSize);
+        } else if (frame.dims == 3) {
+          memcpy(dst, frame.ptr<uint8_t>(p, r), min(rowSize, outRowSize));
+        } else {
+          memcpy(dst, frame.ptr<uint8_t>(r), min(rowSize, outRowSize));
+        }
+      }
+    }
+  }
+  source_pad_->PushFrame(out);
+}
+
+void Synchronizer::OnState(int index, StreamState state) {
+  {
+    lock_guard<mutex> lock(mutex_);
+    if (state != kStreamStatePlaying) {
+      Clear();
+    }
+    if (state == last_state_) {
+      return;
+    }
+    last_state_ = state;
+  }
+  source_pad_->PushState(state);
+}
+
+void Synchronizer::OnFrameFormat(int index, const MatShape &shape, int type) {
+  MatShape outShape;
+  int outType;
+  {
+    // not while a group is pushed from the pool. Same order as OnFrame,
+    // emit_mutex_ then mutex_
+    lock_guard<mutex> emitLock(emit_mutex_);
+    lock_guard<mutex> lock(mutex_);
+    Input &input = inputs_[index];
+    input.shape = shape;
+    input.type = type;
+    input.has_format = true;
+
+    stacked_ = false;
+    for (auto &other : inputs_) {
+      if (!other.has_format || !(other.shape == shape) ||
+          other.type != type || (shape.dims() != 2 && shape.dims() != 3)) {
+        return;
+      }
+    }
+    int n = inputs_.size();
+    if (shape.dims() == 3) {
+      outShape = MatShape(n * shape[0], shape[1], shape[2]);
+    } else {
+      outShape = MatShape(n, shape[0], shape[1]);
+    }
+    outType = type;
+    stacked_ = true;
+    pool_.SetFrameFormat(outShape, outType);
+  }
+  logger_->info("Stacking {} inputs into {}x{}x{} frames", inputs_.size(),
+                outShape[0], outShape[1], outShape[2]);
+  source_pad_->SetFrameFormat(outShape, outType);
+}
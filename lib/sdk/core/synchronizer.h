@@ -0,0 +1,248 @@
+/* Copyright (C) 2023 Deep In Sight
+ * Author: Le Ngoc Linh <lnlinh93@dinsight.ai>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Suite 500,
+ * Boston, MA 02110-1335, USA.
+ */
+#ifndef __SYNCHRONIZER_H__
+#define __SYNCHRONIZER_H__
+
+#include <sdk/core/element.h>
+#include <sdk/core/frame-pool.h>
+#include <sdk/core/pad.h>
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// frames buffered per input, the oldest is dropped beyond that
+#define DEFAULT_SYNC_DEPTH 8
+#define DEFAULT_SYNC_TOLERANCE_US 5000
+
+/**
+ * @brief What to do with a frame that cannot be matched with frames of all
+ * the other inputs.
+ *
+ */
+enum SyncPolicy {
+  // drop it, only complete groups are emitted
+  kSyncDropIncomplete,
+  // emit it in a partial group, missing inputs are empty Mats (zeros in the
+  // stacked frame). Also done when an input stops sending and another one
+  // fills its buffer, so a dead camera does not stall the others.
+  kSyncEmitPartial
+};
+
+/**
+ * @brief Frames of all inputs captured at about the same time.
+ *
+ */
+struct SyncGroup {
+  // mean capture time of the frames
+  int64_t timestamp_us;
+  // max - min capture time
+  int64_t skew_us;
+  // one per input, empty if missing
+  vector<Mat> frames;
+  vector<int64_t> timestamps_us;
+};
+
+struct SyncStats {
+  uint64_t groups;
+  uint64_t partial_groups;
+  // could not be matched, or pushed out of a full buffer
+  uint64_t dropped;
+  // older than the last emitted group
+  uint64_t late;
+  double mean_skew_us;
+  int64_t max_skew_us;
+};
+
+/**
+ * @brief Capture time of a frame, in microseconds of any monotonic clock
+ * shared by all inputs.
+ *
+ */
+typedef function<int64_t(int input, const Mat &frame)> SyncTimestampFunction;
+
+class Synchronizer;
+
+/**
+ * @brief One input of a Synchronizer, so that frames are told apart by their
+ * sink pad.
+ *
+ */
+class SynchronizerInput : public Element {
+ public:
+  SynchronizerInput(Synchronizer *parent, int index, const string &name);
+  ~SynchronizerInput();
+
+  void PushFrame(Mat &frame) override;
+  void PushState(StreamState state) override;
+  void SetFrameFormat(const MatShape &shape, int type) override;
+
+  Pad *GetSinkPad();
+
+ private:
+  Synchronizer *parent_;
+  int index_;
+  Pad *sink_pad_;
+};
+
+/**
+ * @brief Groups frames of N inputs, e.g. the cameras of a rig, by capture
+ * time. Frames within the tolerance of each other make a group, pushed on the
+ * source pad stacked along the first dimension ({N * planes, h, w}) when all
+ * inputs have the same format, and to the group callback if any.
+ *
+ * Each input buffers a bounded number of frames, in capture order. A group is
+ * matched on the oldest frame of each input: when they are all within the
+ * tolerance they make a group, otherwise the oldest of all cannot have a match
+ * and is given up. So every frame is handled in O(N), with no search.
+ *
+ */
+class Synchronizer : public Element {
+ public:
+  Synchronizer(const string &name = "", int inputs = 2);
+  ~Synchronizer();
+
+  int GetInputCount();
+  Pad *GetSinkPad(int input);
+  Pad *GetSourcePad();
+
+  /**
+   * @brief Set the max difference between capture times of grouped frames.
+   *
+   * @param tolerance_us
+   */
+  void SetTolerance(int64_t tolerance_us);
+  void SetPolicy(SyncPolicy policy);
+
+  /**
+   * @brief Set the number of frames buffered per input.
+   *
+   * @param depth
+   */
+  void SetDepth(int depth);
+
+  /**
+   * @brief Set how the capture time of frames is known. By default it is the
+   * time they reach the synchronizer.
+   *
+   * @param function
+   */
+  void SetTimestampFunction(SyncTimestampFunction function);
+
+  /**
+   * @brief Get every group, with the original frames and their capture times,
+   * in order. Called on the thread of an input, without the synchronizer
+   * locked, so the callback may use the synchronizer.
+   *
+   * @param callback
+   */
+  void SetGroupCallback(function<void(SyncGroup &)> callback);
+
+  SyncStats GetStats();
+  void ResetStats();
+
+  void PushFrame(Mat &frame) override;
+
+ private:
+  friend class SynchronizerInput;
+
+  struct Entry {
+    int64_t timestamp_us;
+    Mat frame;
+  };
+
+  // a group waiting to be pushed
+  struct Matched {
+    SyncGroup group;
+    // stacked_ when the group was matched
+    bool stacked;
+  };
+
+  // fixed capacity ring of frames in capture order
+  struct Input {
+    unique_ptr<SynchronizerInput> element;
+    vector<Entry> ring;
+    int head;
+    int size;
+    MatShape shape;
+    int type;
+    bool has_format;
+  };
+
+  void OnFrame(int input, Mat &frame);
+  void OnState(int input, StreamState state);
+  void OnFrameFormat(int input, const MatShape &shape, int type);
+
+  /**
+   * @brief Time stamp a frame and append it to the buffer of its input, with
+   * mutex_ held.
+   *
+   * @param index
+   * @param frame
+   * @return true
+   * @return false if it is late and was dropped
+   */
+  bool Insert(int index, Mat &frame);
+  Entry &Front(Input &input);
+  void PopFront(Input &input);
+  void Clear();
+  /**
+   * @brief Find the next group in the buffers.
+   *
+   * @param group
+   * @return true if there is one to emit
+   */
+  bool Match(SyncGroup &group);
+  /**
+   * @brief Call the group callback and push the stacked frame, with
+   * emit_mutex_ held.
+   *
+   * @param group
+   * @param stacked stacked_ when the group was matched
+   */
+  void Emit(SyncGroup &group, bool stacked);
+
+  mutex mutex_;
+  // held while groups are pushed, taken before mutex_
+  mutex emit_mutex_;
+  // matched groups, in order, guarded by mutex_
+  deque<Matched> matched_;
+  vector<Input> inputs_;
+  Pad *source_pad_;
+  int64_t tolerance_us_;
+  SyncPolicy policy_;
+  int depth_;
+  SyncTimestampFunction timestamp_function_;
+  function<void(SyncGroup &)> callback_;
+  // capture time of the last emitted group, older frames are late
+  int64_t last_emitted_us_;
+  bool emitted_;
+  // forwarded once, all inputs push it
+  StreamState last_state_;
+  SyncStats stats_;
+  // guarded by mutex_
+  bool stacked_;
+  // its format is guarded by emit_mutex_, Emit() acquires from it
+  FramePool pool_;
+};
+
+#endif  // __SYNCHRONIZER_H__
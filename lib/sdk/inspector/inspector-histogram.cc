@@ -18,34 +18,31 @@
  */
 
 #include <sdk/inspector/inspector-histogram.h>
+#include <sdk/inspector/inspector-roi.h>
 
 #include <algorithm>
 #include <cmath>
 #include <limits>
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+// pixels binned at once, each lane has its own counters
+#define HISTOGRAM_LANES 4
+
 InspectorHistogram::InspectorHistogram() {
   roi_ = Rect(0, 0, mat_shape_[2], mat_shape_[1]);
   ranges_[0] = 0;
   ranges_[1] = 0;
   bins_ = 50;
   isAutoRange_ = true;
+  hist_ranges_[0] = 0;
+  hist_ranges_[1] = 0;
 }
 
 void InspectorHistogram::SetRoi(int x, int y, int x2, int y2) {
-  int tl_x = max(0, min(x, mat_shape_[2] - 1));
-  int tl_y = max(0, min(y, mat_shape_[1] - 1));
-  int br_x = max(0, min(x2, mat_shape_[2] - 1));
-  int br_y = max(0, min(y2, mat_shape_[1] - 1));
-  if (tl_x > br_x) {
-    swap(tl_x, br_x);
-  }
-  if (tl_y > br_y) {
-    swap(tl_y, br_y);
-  }
-  roi_.x = tl_x;
-  roi_.y = tl_y;
-  roi_.width = br_x - tl_x + 1;
-  roi_.height = br_y - tl_y + 1;
+  roi_ = ClampInspectorRoi(mat_shape_, x, y, x2, y2);
 }
 
 void InspectorHistogram::GetRoi(int& x, int& y, int& x2, int& y2) {
@@ -85,31 +82,143 @@ std::vector<float> InspectorHistogram::GetEdges() {
   return edges;
 }
 
+void InspectorHistogram::GetHistogramRanges(float& min, float& max) {
+  min = hist_ranges_[0];
+  max = hist_ranges_[1];
+}
+
 void InspectorHistogram::OnNewFrame(Mat& frame) {
   auto& hist = CalculateHistogram(frame);
   RenderHistogram(hist);
 }
 
+/**
+ * @brief Update lo/hi with the finite values of a row.
+ *
+ */
+static void RowMinMax(const float* row, int n, float& lo, float& hi) {
+  int i = 0;
+#ifdef __SSE2__
+  const __m128 inf = _mm_set1_ps(numeric_limits<float>::infinity());
+  const __m128 neginf = _mm_set1_ps(-numeric_limits<float>::infinity());
+  const __m128 abs = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+  __m128 vlo = _mm_set1_ps(lo);
+  __m128 vhi = _mm_set1_ps(hi);
+  for (; i + 4 <= n; i += 4) {
+    __m128 v = _mm_loadu_ps(row + i);
+    // false for NaN too
+    __m128 finite = _mm_cmplt_ps(_mm_and_ps(v, abs), inf);
+    __m128 kept = _mm_and_ps(finite, v);
+    vlo = _mm_min_ps(vlo, _mm_or_ps(kept, _mm_andnot_ps(finite, inf)));
+    vhi = _mm_max_ps(vhi, _mm_or_ps(kept, _mm_andnot_ps(finite, neginf)));
+  }
+  float l[4], h[4];
+  _mm_storeu_ps(l, vlo);
+  _mm_storeu_ps(h, vhi);
+  for (int k = 0; k < 4; k++) {
+    lo = min(lo, l[k]);
+    hi = max(hi, h[k]);
+  }
+#endif
+  for (; i < n; i++) {
+    if (std::isfinite(row[i])) {
+      lo = min(lo, row[i]);
+      hi = max(hi, row[i]);
+    }
+  }
+}
+
+/**
+ * @brief Count the values of a row in [lo, hi), or [lo, hi] if closed. Bin k
+ * of lane l is counts[k * HISTOGRAM_LANES + l], values out of range go to bin
+ * num_bins.
+ *
+ */
+static void RowBins(const float* row, int n, float lo, float hi, bool closed,
+                    int num_bins, uint32_t* counts) {
+  float scale = (hi > lo) ? num_bins / (hi - lo) : 0;
+  int i = 0;
+#ifdef __SSE2__
+  const __m128 vlo = _mm_set1_ps(lo);
+  const __m128 vhi = _mm_set1_ps(hi);
+  const __m128 vscale = _mm_set1_ps(scale);
+  const __m128i last = _mm_set1_epi32(num_bins - 1);
+  const __m128i discard = _mm_set1_epi32(num_bins);
+  const __m128i lanes = _mm_setr_epi32(0, 1, 2, 3);
+  alignas(16) int32_t index[4];
+  for (; i + 4 <= n; i += 4) {
+    __m128 v = _mm_loadu_ps(row + i);
+    // false for NaN too
+    __m128 valid = _mm_and_ps(
+        _mm_cmpge_ps(v, vlo),
+        closed ? _mm_cmple_ps(v, vhi) : _mm_cmplt_ps(v, vhi));
+    __m128i k = _mm_cvttps_epi32(_mm_mul_ps(_mm_sub_ps(v, vlo), vscale));
+    // hi itself, or rounding just below it
+    __m128i over = _mm_cmpgt_epi32(k, last);
+    k = _mm_or_si128(_mm_andnot_si128(over, k), _mm_and_si128(over, last));
+    __m128i ok = _mm_castps_si128(valid);
+    k = _mm_or_si128(_mm_and_si128(ok, k), _mm_andnot_si128(ok, discard));
+    k = _mm_add_epi32(_mm_slli_epi32(k, 2), lanes);
+    _mm_store_si128((__m128i*)index, k);
+    counts[index[0]]++;
+    counts[index[1]]++;
+    counts[index[2]]++;
+    counts[index[3]]++;
+  }
+#endif
+  for (; i < n; i++) {
+    float v = row[i];
+    if (!(v >= lo && (v < hi || (closed && v == hi)))) {
+      continue;
+    }
+    int k = min((int)((v - lo) * scale), num_bins - 1);
+    counts[k * HISTOGRAM_LANES]++;
+  }
+}
+
 const Mat& InspectorHistogram::CalculateHistogram(Mat& frame) {
-  int width = mat_shape_[2];
-  int height = mat_shape_[1];
-  uint8_t* data = frame.data;
-  if (channel_ == kAmplitudeChannel) {
-    data = &frame.data[width * height * frame.elemSize()];
+  // the GUI may change them meanwhile
+  int num_bins = bins_;
+  bool autoRange = isAutoRange_;
+  float lo = ranges_[0];
+  float hi = ranges_[1];
+
+  if (num_bins <= 0) {
+    histogram_.release();
+    return histogram_;
   }
-  Mat m(height, width, mat_type_, data);
-  Mat roi = m(roi_).clone();  // to make it continuous
-
-  int nimages = 1;
-  int channels[] = {0};
-  Mat mask;
-  int dims = 1;
-  int histSize[] = {bins_};
-  const float* ranges[] = {ranges_};
-
-  // calcHist(&roi, nimages, channels, mask, histogram_, 1, histSize, ranges,
-  // true,
-  //          false);
-  histogram_ = roi;
+  int plane = (channel_ == kAmplitudeChannel) ? 1 : 0;
+  Rect roi = roi_ & Rect(0, 0, frame.size[2], frame.size[1]);
+
+  if (autoRange) {
+    lo = numeric_limits<float>::infinity();
+    hi = -numeric_limits<float>::infinity();
+    for (int y = roi.y; y < roi.y + roi.height; y++) {
+      RowMinMax(frame.ptr<float>(plane, y) + roi.x, roi.width, lo, hi);
+    }
+    if (lo > hi) {
+      // nothing finite
+      lo = hi = 0;
+    }
+  }
+
+  counts_.assign((num_bins + 1) * HISTOGRAM_LANES, 0);
+  histogram_.create(num_bins, 1, CV_32FC1);
+  if (hi >= lo) {
+    for (int y = roi.y; y < roi.y + roi.height; y++) {
+      // with auto range, the max is in the last bin
+      RowBins(frame.ptr<float>(plane, y) + roi.x, roi.width, lo, hi,
+              autoRange, num_bins, counts_.data());
+    }
+  }
+  for (int k = 0; k < num_bins; k++) {
+    uint32_t count = 0;
+    for (int l = 0; l < HISTOGRAM_LANES; l++) {
+      count += counts_[k * HISTOGRAM_LANES + l];
+    }
+    histogram_.at<float>(k) = count;
+  }
+  hist_ranges_[0] = lo;
+  hist_ranges_[1] = hi;
   return histogram_;
-}
\ No newline at end of file
+}
@@ -22,6 +22,7 @@
 
 #include <sdk/core/pad.h>
 
+#include <cstdint>
 #include <vector>
 
 /**
@@ -29,6 +30,10 @@
  * histogram of a GstBuffer and renders it. The user has to guess the range of
  * the histogram, and call SetBins() to set the bins' edges.
  *
+ * The ROI is read in place, row by row: with a fixed range, the bins are
+ * counted in a single pass against the configured range; with auto range, a
+ * min/max pass over the ROI comes first. Only the bins' counts are rendered.
+ *
  */
 class InspectorHistogram : public PadObserver {
  public:
@@ -84,6 +89,15 @@ class InspectorHistogram : public PadObserver {
    */
   vector<float> GetEdges();
 
+  /**
+   * @brief Get the range of the last histogram, i.e. the min/max of the ROI
+   * with auto range.
+   *
+   * @param min
+   * @param max
+   */
+  void GetHistogramRanges(float& min, float& max);
+
   /**
    * @brief Calculate the histogram and render it.
    *
@@ -98,7 +112,8 @@ class InspectorHistogram : public PadObserver {
    * protected only for unit test.
    *
    * @param frame input matrix to calculate histogram
-   * @return HistogramData& histogram data
+   * @return const Mat& bins_ x 1 CV_32FC1 counts. NaN, infinite and out of
+   * range values are not counted.
    */
   const Mat& CalculateHistogram(Mat& frame);
   /**
@@ -116,6 +131,9 @@ class InspectorHistogram : public PadObserver {
   int bins_;
   bool isAutoRange_;
   Mat histogram_;
+  float hist_ranges_[2];
+  // interleaved per lane so that consecutive pixels hit different counters
+  vector<uint32_t> counts_;
 };
 
 #endif  //__INSPECTOR_HISTOGRAM_H__
\ No newline at end of file
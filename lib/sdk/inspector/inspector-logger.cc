@@ -0,0 +1,261 @@
+/* Copyright (C) 2023 Deep In Sight
+ * Author: Le Ngoc Linh <lnlinh93@dinsight.ai>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Suite 500,
+ * Boston, MA 02110-1335, USA.
+ */
+
+#include <sdk/inspector/inspector-logger.h>
+
+#include <algorithm>
+#include <cstring>
+
+InspectorLog::InspectorLog()
+    : buffer_size_(DEFAULT_INSPECTOR_LOG_BUFFER_SIZE),
+      head_(0),
+      tail_(0),
+      open_(false),
+      records_written_(0),
+      records_dropped_(0),
+      running_(false),
+      thread_(nullptr),
+      fp_(nullptr),
+      format_(kInspectorLogCsv),
+      columns_(-1) {}
+
+InspectorLog::~InspectorLog() { Close(); }
+
+void InspectorLog::SetBufferSize(size_t size) {
+  lock_guard<mutex> lock(mutex_);
+  buffer_size_ = 64;
+  while (buffer_size_ < size) {
+    buffer_size_ <<= 1;
+  }
+}
+
+bool InspectorLog::Open(const string& filename, InspectorLogFormat format) {
+  Close();
+  lock_guard<mutex> lock(mutex_);
+  fp_ = fopen(filename.c_str(), (format == kInspectorLogCsv) ? "w" : "wb");
+  if (fp_ == nullptr) {
+    return false;
+  }
+  setvbuf(fp_, nullptr, _IOFBF, 1 << 20);
+  format_ = format;
+  columns_ = -1;
+  chunk_time_.clear();
+  chunk_values_.clear();
+  chunk_start_ = chrono::steady_clock::now();
+  // the ring is only resized while closed, nothing writes to it then
+  ring_.resize(buffer_size_);
+  head_ = 0;
+  tail_ = 0;
+  records_written_ = 0;
+  records_dropped_ = 0;
+  running_ = true;
+  thread_ = new thread(&InspectorLog::WriteLoop, this);
+  open_.store(true, memory_order_release);
+  return true;
+}
+
+void InspectorLog::Close() {
+  {
+    lock_guard<mutex> lock(mutex_);
+    if (thread_ == nullptr) {
+      return;
+    }
+    open_.store(false, memory_order_release);
+    running_ = false;
+  }
+  condvar_.notify_one();
+  // the writer drains the ring once more before it stops
+  thread_->join();
+  delete thread_;
+  thread_ = nullptr;
+  if (format_ == kInspectorLogColumnar) {
+    FlushChunk();
+  }
+  fclose(fp_);
+  fp_ = nullptr;
+}
+
+bool InspectorLog::IsOpen() { return open_.load(memory_order_acquire); }
+
+uint64_t InspectorLog::GetRecordsWritten() { return records_written_; }
+
+uint64_t InspectorLog::GetRecordsDropped() { return records_dropped_; }
+
+size_t InspectorLog::RecordSize(int count) {
+  // records stay 8 bytes aligned for the time of the next one
+  return sizeof(RecordHeader) + ((count * sizeof(float) + 7) & ~(size_t)7);
+}
+
+void InspectorLog::CopyIn(size_t position, const void* data, size_t length) {
+  size_t offset = position & (ring_.size() - 1);
+  size_t first = min(length, ring_.size() - offset);
+  memcpy(ring_.data() + offset, data, first);
+  memcpy(ring_.data(), (const uint8_t*)data + first, length - first);
+}
+
+void InspectorLog::CopyOut(size_t position, void* data, size_t length) {
+  size_t offset = position & (ring_.size() - 1);
+  size_t first = min(length, ring_.size() - offset);
+  memcpy(data, ring_.data() + offset, first);
+  memcpy((uint8_t*)data + first, ring_.data(), length - first);
+}
+
+bool InspectorLog::Write(const float* values, int count) {
+  if (count < 0) {
+    return false;
+  }
+  // Open() and Close() wait for the record to be in the ring before they
+  // swap it or drain it for the last time
+  lock_guard<mutex> lock(mutex_);
+  if (!open_.load(memory_order_relaxed)) {
+    return false;
+  }
+  size_t size = RecordSize(count);
+  size_t head = head_.load(memory_order_relaxed);
+  size_t tail = tail_.load(memory_order_acquire);
+  // never block the pipeline, the disk may be slow
+  if (size > ring_.size() - (head - tail)) {
+    records_dropped_++;
+    return false;
+  }
+
+  RecordHeader header;
+  header.count = count;
+  header.reserved = 0;
+  header.time = chrono::duration<double>(
+                    chrono::system_clock::now().time_since_epoch())
+                    .count();
+  CopyIn(head, &header, sizeof(header));
+  CopyIn(head + sizeof(header), values, count * sizeof(float));
+  head_.store(head + size, memory_order_release);
+  return true;
+}
+
+void InspectorLog::WriteLoop() {
+  unique_lock<mutex> lock(mutex_);
+  while (true) {
+    bool stop = !running_;
+    lock.unlock();
+    bool wrote = Drain();
+    if (format_ == kInspectorLogColumnar &&
+        chrono::steady_clock::now() - chunk_start_ >=
+            chrono::milliseconds(INSPECTOR_LOG_CHUNK_MS)) {
+      FlushChunk();
+    }
+    if (wrote) {
+      fflush(fp_);
+    }
+    lock.lock();
+    if (stop) {
+      break;
+    }
+    condvar_.wait_for(lock, chrono::milliseconds(INSPECTOR_LOG_FLUSH_MS),
+                      [this] { return !running_; });
+  }
+}
+
+bool InspectorLog::Drain() {
+  size_t tail = tail_.load(memory_order_relaxed);
+  size_t head = head_.load(memory_order_acquire);
+  if (tail == head) {
+    return false;
+  }
+  while (tail != head) {
+    RecordHeader header;
+    CopyOut(tail, &header, sizeof(header));
+    record_.resize(header.count);
+    CopyOut(tail + sizeof(header), record_.data(),
+            header.count * sizeof(float));
+    tail += RecordSize(header.count);
+    // hand the space back before the slow part
+    tail_.store(tail, memory_order_release);
+    WriteRecord(header.time, record_.data(), header.count);
+    records_written_++;
+  }
+  return true;
+}
+
+void InspectorLog::WriteRecord(double time, const float* values, int count) {
+  if (format_ == kInspectorLogCsv) {
+    if (count != columns_) {
+      columns_ = count;
+      fputs("time", fp_);
+      for (int i = 0; i < count; i++) {
+        fprintf(fp_, ",%d", i);
+      }
+      fputc('\n', fp_);
+    }
+    fprintf(fp_, "%.6f", time);
+    for (int i = 0; i < count; i++) {
+      fprintf(fp_, ",%.7g", values[i]);
+    }
+    fputc('\n', fp_);
+    return;
+  }
+
+  if (count != columns_) {
+    FlushChunk();
+    columns_ = count;
+  }
+  chunk_time_.push_back(time);
+  chunk_values_.insert(chunk_values_.end(), values, values + count);
+  if (chunk_time_.size() >= INSPECTOR_LOG_CHUNK_ROWS) {
+    FlushChunk();
+  }
+}
+
+void InspectorLog::FlushChunk() {
+  chunk_start_ = chrono::steady_clock::now();
+  int rows = chunk_time_.size();
+  if (rows == 0) {
+    return;
+  }
+  InspectorLogChunkHeader header;
+  header.magic = INSPECTOR_LOG_MAGIC;
+  header.rows = rows;
+  header.columns = columns_;
+  header.reserved = 0;
+  fwrite(&header, sizeof(header), 1, fp_);
+  fwrite(chunk_time_.data(), sizeof(double), rows, fp_);
+  column_.resize(rows);
+  for (int c = 0; c < columns_; c++) {
+    for (int r = 0; r < rows; r++) {
+      column_[r] = chunk_values_[r * columns_ + c];
+    }
+    fwrite(column_.data(), sizeof(float), rows, fp_);
+  }
+  chunk_time_.clear();
+  chunk_values_.clear();
+}
+
+void TrackerLogger::RenderPoint(float value) { Write(&value, 1); }
+
+void ScannerLogger::RenderRange(const std::vector<float>& vec) {
+  Write(vec.data(), vec.size());
+}
+
+void HistogramLogger::RenderHistogram(const Mat& histogram) {
+  values_.resize(histogram.rows + 2);
+  values_[0] = hist_ranges_[0];
+  values_[1] = hist_ranges_[1];
+  for (int i = 0; i < histogram.rows; i++) {
+    values_[i + 2] = histogram.at<float>(i, 0);
+  }
+  Write(values_.data(), values_.size());
+}
@@ -0,0 +1,209 @@
+/* Copyright (C) 2023 Deep In Sight
+ * Author: Le Ngoc Linh <lnlinh93@dinsight.ai>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Suite 500,
+ * Boston, MA 02110-1335, USA.
+ */
+#ifndef __INSPECTOR_LOGGER_H__
+#define __INSPECTOR_LOGGER_H__
+
+#include <sdk/inspector/inspector-histogram.h>
+#include <sdk/inspector/inspector-scanner.h>
+#include <sdk/inspector/inspector-tracker.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// size of the ring between the pipeline and the writer thread, power of 2
+#define DEFAULT_INSPECTOR_LOG_BUFFER_SIZE ((size_t)4 << 20)
+// the writer wakes up that often, and flushes what it got
+#define INSPECTOR_LOG_FLUSH_MS 10
+// a columnar chunk is written when it has that many rows, or is that old
+#define INSPECTOR_LOG_CHUNK_ROWS 4096
+#define INSPECTOR_LOG_CHUNK_MS 1000
+// "TLOG", first word of each columnar chunk
+#define INSPECTOR_LOG_MAGIC 0x474f4c54
+
+enum InspectorLogFormat {
+  /**
+   * @brief One line per record, "time,v0,v1,...", after a "time,0,1,..."
+   * header line each time the number of values changes.
+   *
+   */
+  kInspectorLogCsv,
+  /**
+   * @brief A sequence of chunks, each an InspectorLogChunkHeader, the times
+   * (double) of its rows, then each column of values (float) in turn. A chunk
+   * holds consecutive records with the same number of values.
+   *
+   */
+  kInspectorLogColumnar
+};
+
+struct InspectorLogChunkHeader {
+  uint32_t magic;
+  uint32_t rows;
+  uint32_t columns;
+  uint32_t reserved;
+};
+
+/**
+ * @brief InspectorLog writes records of float values, stamped with the wall
+ * clock time in seconds, to a CSV or columnar file. Write() only copies the
+ * record into a ring buffer, a writer thread formats and writes the records,
+ * so that logging at full frame rate never stalls the pipeline. The writer
+ * takes the records out of the ring without locking, the mutex Write() takes
+ * is otherwise only held by Open(), Close() and briefly by the writer. When
+ * the writer falls behind and the ring is full, records are dropped and
+ * counted.
+ *
+ * The ring has a single producer: Write() is meant to be called from the
+ * pipeline thread of one inspector, and each inspector owns its log.
+ *
+ */
+class InspectorLog {
+ public:
+  InspectorLog();
+  virtual ~InspectorLog();
+
+  /**
+   * @brief Set the size of the ring buffer, rounded up to a power of 2. Takes
+   * effect on the next Open().
+   *
+   * @param size bytes
+   */
+  void SetBufferSize(size_t size);
+
+  /**
+   * @brief Create the file and start the writer thread.
+   *
+   * @param filename
+   * @param format
+   * @return false if the file cannot be created
+   */
+  bool Open(const string& filename, InspectorLogFormat format);
+  /**
+   * @brief Write the pending records and close the file.
+   *
+   */
+  void Close();
+  bool IsOpen();
+
+  /**
+   * @brief Queue a record. Never waits for the disk, called by a single
+   * thread.
+   *
+   * @param values
+   * @param count
+   * @return false if the log is closed, or the ring is full
+   */
+  bool Write(const float* values, int count);
+
+  uint64_t GetRecordsWritten();
+  uint64_t GetRecordsDropped();
+
+ private:
+  struct RecordHeader {
+    uint32_t count;
+    uint32_t reserved;
+    double time;
+  };
+
+  static size_t RecordSize(int count);
+  void CopyIn(size_t position, const void* data, size_t length);
+  void CopyOut(size_t position, void* data, size_t length);
+  void WriteLoop();
+  /**
+   * @brief Write the records of the ring.
+   *
+   * @return true if there were any
+   */
+  bool Drain();
+  void WriteRecord(double time, const float* values, int count);
+  void FlushChunk();
+
+  // ring, head_ only moves forward on the producer, tail_ on the writer
+  vector<uint8_t> ring_;
+  size_t buffer_size_;
+  atomic<size_t> head_;
+  atomic<size_t> tail_;
+  atomic<bool> open_;
+  atomic<uint64_t> records_written_;
+  atomic<uint64_t> records_dropped_;
+
+  mutex mutex_;
+  condition_variable condvar_;
+  bool running_;
+  thread* thread_;
+
+  // owned by the writer thread
+  FILE* fp_;
+  InspectorLogFormat format_;
+  int columns_;
+  vector<float> record_;
+  vector<double> chunk_time_;
+  // row-major, transposed when written
+  vector<float> chunk_values_;
+  vector<float> column_;
+  chrono::steady_clock::time_point chunk_start_;
+};
+
+/**
+ * @brief Logs the value of an InspectorTracker, one value per record.
+ *
+ */
+class TrackerLogger : public InspectorTracker, public InspectorLog {
+ public:
+  void OnFrameFormatChanged(const MatShape& shape, int type) override{};
+
+ protected:
+  void RenderPoint(float value) override;
+};
+
+/**
+ * @brief Logs the samples of an InspectorScanner, all its lines in a record.
+ *
+ */
+class ScannerLogger : public InspectorScanner, public InspectorLog {
+ public:
+  void OnFrameFormatChanged(const MatShape& shape, int type) override{};
+
+ protected:
+  void RenderRange(const std::vector<float>& vec) override;
+};
+
+/**
+ * @brief Logs the histograms of an InspectorHistogram, a record being the
+ * range min and max, then the counts.
+ *
+ */
+class HistogramLogger : public InspectorHistogram, public InspectorLog {
+ public:
+  void OnFrameFormatChanged(const MatShape& shape, int type) override{};
+
+ protected:
+  void RenderHistogram(const Mat& histogram) override;
+
+  vector<float> values_;
+};
+
+#endif  //__INSPECTOR_LOGGER_H__
@@ -0,0 +1,354 @@
+/* Copyright (C) 2023 Deep In Sight
+ * Author: Le Ngoc Linh <lnlinh93@dinsight.ai>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Suite 500,
+ * Boston, MA 02110-1335, USA.
+ */
+
+#include <sdk/inspector/inspector-multi-tracker.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+TimeSeries::TimeSeries(int capacity, int factor, int levels)
+    : capacity_(max(1, capacity)), factor_(max(2, factor)), total_(0) {
+  levels_.resize(max(1, levels));
+  for (auto& level : levels_) {
+    level.ring.resize(capacity_);
+  }
+  Clear();
+}
+
+void TimeSeries::Clear() {
+  for (auto& level : levels_) {
+    level.head = 0;
+    level.size = 0;
+    level.added = 0;
+    level.pending_count = 0;
+  }
+  total_ = 0;
+}
+
+uint64_t TimeSeries::GetTotal() { return total_; }
+
+TimeSeriesPoint& TimeSeries::At(Level& level, int i) {
+  return level.ring[(level.head + i) % capacity_];
+}
+
+void TimeSeries::Add(double t, float value) {
+  TimeSeriesPoint point = {t, value, value, value};
+  total_++;
+  Push(0, point);
+}
+
+void TimeSeries::Push(int index, const TimeSeriesPoint& point) {
+  Level& level = levels_[index];
+  if (level.size == capacity_) {
+    level.head = (level.head + 1) % capacity_;
+    level.size--;
+  }
+  At(level, level.size) = point;
+  level.size++;
+  level.added++;
+
+  if (index + 1 == (int)levels_.size()) {
+    return;
+  }
+  if (level.pending_count == 0) {
+    level.pending.t = point.t;
+    level.pending.min = numeric_limits<float>::infinity();
+    level.pending.max = -numeric_limits<float>::infinity();
+    level.pending_valid = 0;
+    level.pending_sum = 0;
+  }
+  if (std::isfinite(point.mean)) {
+    level.pending.min = min(level.pending.min, point.min);
+    level.pending.max = max(level.pending.max, point.max);
+    level.pending_sum += point.mean;
+    level.pending_valid++;
+  }
+  level.pending_count++;
+  if (level.pending_count == factor_) {
+    TimeSeriesPoint summary = level.pending;
+    if (level.pending_valid > 0) {
+      summary.mean = level.pending_sum / level.pending_valid;
+    } else {
+      summary.mean = summary.min = summary.max = NAN;
+    }
+    level.pending_count = 0;
+    Push(index + 1, summary);
+  }
+}
+
+void TimeSeries::Query(double t0, double t1, int max_points,
+                       vector<TimeSeriesPoint>& points) {
+  points.clear();
+  candidates_.clear();
+  if (total_ == 0) {
+    return;
+  }
+
+  // the finest level that has not dropped t0 yet
+  int chosen = levels_.size() - 1;
+  for (int i = 0; i < (int)levels_.size(); i++) {
+    Level& level = levels_[i];
+    if (level.added <= (uint64_t)capacity_ ||
+        (level.size > 0 && At(level, 0).t <= t0)) {
+      chosen = i;
+      break;
+    }
+  }
+
+  // the entries of the chosen level, then the newer ones only in the levels
+  // below as they are not summarized yet
+  for (int i = chosen; i >= 0; i--) {
+    Level& level = levels_[i];
+    int first = 0;
+    if (i < chosen) {
+      first = max(0, level.size - level.pending_count);
+    }
+    // skip the entries before t0 in time order
+    int lo = first, hi = level.size;
+    while (lo < hi) {
+      int mid = (lo + hi) / 2;
+      if (At(level, mid).t < t0) {
+        lo = mid + 1;
+      } else {
+        hi = mid;
+      }
+    }
+    for (int j = lo; j < level.size && At(level, j).t <= t1; j++) {
+      candidates_.push_back(At(level, j));
+    }
+  }
+
+  int n = candidates_.size();
+  if (max_points < 3 || n <= max_points) {
+    points = candidates_;
+    return;
+  }
+
+  // LTTB: the first and last points, then per bucket the point making the
+  // largest triangle with the previous pick and the mean of the next bucket
+  points.reserve(max_points);
+  points.push_back(candidates_[0]);
+  double every = (double)(n - 2) / (max_points - 2);
+  int a = 0;
+  for (int i = 0; i < max_points - 2; i++) {
+    int start = (int)(i * every) + 1;
+    int end = min((int)((i + 1) * every) + 1, n - 1);
+    int nextStart = end;
+    int nextEnd = min((int)((i + 2) * every) + 1, n);
+    double avgT = 0, avgV = 0;
+    int avgN = 0;
+    for (int j = nextStart; j < nextEnd; j++) {
+      if (std::isfinite(candidates_[j].mean)) {
+        avgT += candidates_[j].t;
+        avgV += candidates_[j].mean;
+        avgN++;
+      }
+    }
+    if (avgN > 0) {
+      avgT /= avgN;
+      avgV /= avgN;
+    }
+
+    const TimeSeriesPoint& pa = candidates_[a];
+    double maxArea = -1;
+    int picked = start;
+    float bucketMin = numeric_limits<float>::infinity();
+    float bucketMax = -numeric_limits<float>::infinity();
+    for (int j = start; j < end; j++) {
+      const TimeSeriesPoint& p = candidates_[j];
+      if (!std::isfinite(p.mean)) {
+        continue;
+      }
+      bucketMin = min(bucketMin, p.min);
+      bucketMax = max(bucketMax, p.max);
+      double area = fabs((pa.t - avgT) * (p.mean - pa.mean) -
+                         (pa.t - p.t) * (avgV - pa.mean));
+      if (area > maxArea) {
+        maxArea = area;
+        picked = j;
+      }
+    }
+    TimeSeriesPoint point = candidates_[picked];
+    if (maxArea >= 0) {
+      point.min = bucketMin;
+      point.max = bucketMax;
+    }
+    points.push_back(point);
+    a = picked;
+  }
+  points.push_back(candidates_[n - 1]);
+}
+
+MultiPointTracker::MultiPointTracker()
+    : plan_valid_(false),
+      plan_width_(0),
+      plan_height_(0),
+      plan_stride_(0),
+      started_(false) {}
+
+int MultiPointTracker::AddPoint(int x, int y, int radius) {
+  lock_guard<mutex> lock(mutex_);
+  points_.push_back({x, y, max(0, radius)});
+  histories_.emplace_back(new TimeSeries());
+  plan_valid_ = false;
+  return points_.size() - 1;
+}
+
+void MultiPointTracker::SetPoint(int index, int x, int y, int radius) {
+  lock_guard<mutex> lock(mutex_);
+  if (index < 0 || index >= (int)points_.size()) {
+    return;
+  }
+  points_[index] = {x, y, max(0, radius)};
+  histories_[index]->Clear();
+  plan_valid_ = false;
+}
+
+void MultiPointTracker::GetPoint(int index, int& x, int& y, int& radius) {
+  lock_guard<mutex> lock(mutex_);
+  if (index < 0 || index >= (int)points_.size()) {
+    return;
+  }
+  x = points_[index].x;
+  y = points_[index].y;
+  radius = points_[index].radius;
+}
+
+void MultiPointTracker::RemovePoint(int index) {
+  lock_guard<mutex> lock(mutex_);
+  if (index < 0 || index >= (int)points_.size()) {
+    return;
+  }
+  points_.erase(points_.begin() + index);
+  histories_.erase(histories_.begin() + index);
+  plan_valid_ = false;
+}
+
+void MultiPointTracker::ClearPoints() {
+  lock_guard<mutex> lock(mutex_);
+  points_.clear();
+  histories_.clear();
+  plan_valid_ = false;
+}
+
+int MultiPointTracker::GetPointCount() {
+  lock_guard<mutex> lock(mutex_);
+  return points_.size();
+}
+
+void MultiPointTracker::QueryHistory(int index, double t0, double t1,
+                                     int max_points,
+                                     vector<TimeSeriesPoint>& points) {
+  lock_guard<mutex> lock(mutex_);
+  if (index < 0 || index >= (int)histories_.size()) {
+    points.clear();
+    return;
+  }
+  histories_[index]->Query(t0, t1, max_points, points);
+}
+
+void MultiPointTracker::ClearHistory() {
+  lock_guard<mutex> lock(mutex_);
+  for (auto& history : histories_) {
+    history->Clear();
+  }
+  started_ = false;
+}
+
+void MultiPointTracker::OnNewFrame(Mat& frame) {
+  double t;
+  {
+    // points may be added or removed meanwhile, value i must go to the
+    // history of the point it was sampled for
+    lock_guard<mutex> lock(mutex_);
+    if (points_.empty()) {
+      return;
+    }
+    auto now = chrono::steady_clock::now();
+    if (!started_) {
+      start_ = now;
+      started_ = true;
+    }
+    t = chrono::duration<double>(now - start_).count();
+
+    Sample(frame);
+    for (size_t i = 0; i < values_.size() && i < histories_.size(); i++) {
+      histories_[i]->Add(t, values_[i]);
+    }
+  }
+  // values_ is only written by the pipeline thread
+  RenderPoints(t, values_);
+}
+
+void MultiPointTracker::BuildPlan(int width, int height, int stride) {
+  plan_width_ = width;
+  plan_height_ = height;
+  plan_stride_ = stride;
+  offsets_.clear();
+  starts_.clear();
+  for (auto& p : points_) {
+    starts_.push_back(offsets_.size());
+    int cx = max(0, min(p.x, width - 1));
+    int cy = max(0, min(p.y, height - 1));
+    int x0 = max(0, cx - p.radius);
+    int x1 = min(width - 1, cx + p.radius);
+    int y0 = max(0, cy - p.radius);
+    int y1 = min(height - 1, cy + p.radius);
+    for (int y = y0; y <= y1; y++) {
+      for (int x = x0; x <= x1; x++) {
+        offsets_.push_back(y * stride + x);
+      }
+    }
+  }
+  starts_.push_back(offsets_.size());
+  values_.resize(points_.size());
+  plan_valid_ = true;
+}
+
+const vector<float>& MultiPointTracker::SamplePoints(Mat& frame) {
+  lock_guard<mutex> lock(mutex_);
+  Sample(frame);
+  return values_;
+}
+
+void MultiPointTracker::Sample(Mat& frame) {
+  int height = frame.size[1];
+  int width = frame.size[2];
+  int stride = frame.step[1] / sizeof(float);
+  if (!plan_valid_ || width != plan_width_ || height != plan_height_ ||
+      stride != plan_stride_) {
+    BuildPlan(width, height, stride);
+  }
+
+  const float* plane = frame.ptr<float>(channel_);
+  const int* offsets = offsets_.data();
+  for (size_t i = 0; i < values_.size(); i++) {
+    float sum = 0;
+    int count = 0;
+    for (int j = starts_[i]; j < starts_[i + 1]; j++) {
+      float v = plane[offsets[j]];
+      if (std::isfinite(v)) {
+        sum += v;
+        count++;
+      }
+    }
+    values_[i] = (count > 0) ? sum / count : NAN;
+  }
+}
@@ -0,0 +1,189 @@
+/* Copyright (C) 2023 Deep In Sight
+ * Author: Le Ngoc Linh <lnlinh93@dinsight.ai>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Suite 500,
+ * Boston, MA 02110-1335, USA.
+ */
+#ifndef __INSPECTOR_MULTI_TRACKER_H__
+#define __INSPECTOR_MULTI_TRACKER_H__
+
+#include <sdk/core/pad.h>
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// entries per level of a TimeSeries
+#define DEFAULT_TIME_SERIES_CAPACITY 4096
+// entries of a level summarized by one entry of the next level
+#define DEFAULT_TIME_SERIES_FACTOR 16
+// with the defaults, the last level spans 2^28 samples, 100 days at 30 fps
+#define DEFAULT_TIME_SERIES_LEVELS 5
+
+/**
+ * @brief A sample, or the summary of consecutive samples: the time of the
+ * first one, the mean, min and max of the finite values (NaN if none).
+ *
+ */
+struct TimeSeriesPoint {
+  double t;
+  float mean;
+  float min;
+  float max;
+};
+
+/**
+ * @brief Bounded history of a value. Level 0 keeps the last samples, each next
+ * level keeps min/max/mean summaries of FACTOR entries of the level below, in
+ * rings of the same capacity. Memory is fixed, while the coarsest level spans
+ * CAPACITY * FACTOR^(LEVELS - 1) samples.
+ *
+ */
+class TimeSeries {
+ public:
+  TimeSeries(int capacity = DEFAULT_TIME_SERIES_CAPACITY,
+             int factor = DEFAULT_TIME_SERIES_FACTOR,
+             int levels = DEFAULT_TIME_SERIES_LEVELS);
+
+  /**
+   * @brief Add a sample, times must be increasing.
+   *
+   * @param t
+   * @param value
+   */
+  void Add(double t, float value);
+  void Clear();
+  uint64_t GetTotal();
+
+  /**
+   * @brief Get the points to draw [t0, t1]: the entries of the finest level
+   * that still has t0, reduced to max_points with LTTB (Largest Triangle Three
+   * Buckets) on the means. The min/max of the entries a point stands for are
+   * kept in it, so spikes stay in the envelope.
+   *
+   * @param t0
+   * @param t1
+   * @param max_points at least 3 to reduce
+   * @param points in time order
+   */
+  void Query(double t0, double t1, int max_points,
+             vector<TimeSeriesPoint>& points);
+
+ private:
+  struct Level {
+    vector<TimeSeriesPoint> ring;
+    int head;
+    int size;
+    uint64_t added;
+    // summary of the entries not yet pushed to the next level
+    TimeSeriesPoint pending;
+    int pending_count;
+    int pending_valid;
+    double pending_sum;
+  };
+
+  void Push(int level, const TimeSeriesPoint& point);
+  TimeSeriesPoint& At(Level& level, int i);
+
+  int capacity_;
+  int factor_;
+  vector<Level> levels_;
+  uint64_t total_;
+  vector<TimeSeriesPoint> candidates_;
+};
+
+struct TrackedPoint {
+  int x;
+  int y;
+  // the mean of (2 * radius + 1)^2 pixels is tracked
+  int radius;
+};
+
+/**
+ * @brief MultiPointTracker samples any number of points of each frame, in one
+ * pass over offsets computed when the points or the frame size change, and
+ * keeps the history of each point in a TimeSeries. A point is the mean of the
+ * finite values of its neighbourhood, clamped to the frame.
+ *
+ */
+class MultiPointTracker : public PadObserver {
+ public:
+  MultiPointTracker();
+  virtual ~MultiPointTracker(){};
+
+  /**
+   * @brief Add a point to track, clamped to the frame.
+   *
+   * @return int index of the point in the values
+   */
+  int AddPoint(int x, int y, int radius = 0);
+  void SetPoint(int index, int x, int y, int radius = 0);
+  void GetPoint(int index, int& x, int& y, int& radius);
+  void RemovePoint(int index);
+  void ClearPoints();
+  int GetPointCount();
+
+  /**
+   * @brief Get the history of a point, see TimeSeries::Query(). Times are in
+   * seconds since the first frame.
+   *
+   */
+  void QueryHistory(int index, double t0, double t1, int max_points,
+                    vector<TimeSeriesPoint>& points);
+  void ClearHistory();
+
+  void OnNewFrame(Mat& frame) override;
+
+ protected:
+  /**
+   * @brief Sample all the points. Called by OnNewFrame(Mat&), only made
+   * protected for unit test.
+   *
+   * @param frame
+   * @return const vector<float>& one value per point
+   */
+  const vector<float>& SamplePoints(Mat& frame);
+  /**
+   * @brief Render the values of all the points of a frame, called once per
+   * frame by OnNewFrame(Mat&).
+   *
+   * @param t seconds since the first frame
+   * @param values
+   */
+  virtual void RenderPoints(double t, const vector<float>& values) = 0;
+
+ private:
+  void BuildPlan(int width, int height, int stride);
+  // SamplePoints, with mutex_ held
+  void Sample(Mat& frame);
+
+  mutex mutex_;
+  vector<TrackedPoint> points_;
+  vector<unique_ptr<TimeSeries>> histories_;
+  bool plan_valid_;
+  int plan_width_;
+  int plan_height_;
+  int plan_stride_;
+  // pixels of point i are offsets_[starts_[i]..starts_[i + 1])
+  vector<int> offsets_;
+  vector<int> starts_;
+  vector<float> values_;
+  bool started_;
+  chrono::steady_clock::time_point start_;
+};
+
+#endif  //__INSPECTOR_MULTI_TRACKER_H__
@@ -0,0 +1,217 @@
+/* Copyright (C) 2023 Deep In Sight
+ * Author: Le Ngoc Linh <lnlinh93@dinsight.ai>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Suite 500,
+ * Boston, MA 02110-1335, USA.
+ */
+
+#include <sdk/inspector/inspector-noise.h>
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+InspectorNoise::InspectorNoise()
+    : window_(0),
+      publish_ms_(DEFAULT_NOISE_PUBLISH_MS),
+      curve_bins_(DEFAULT_NOISE_CURVE_BINS),
+      frames_(0),
+      width_(0),
+      height_(0),
+      planes_(0) {}
+
+void InspectorNoise::SetWindow(int frames) {
+  lock_guard<mutex> lock(mutex_);
+  window_ = max(0, frames);
+}
+
+int InspectorNoise::GetWindow() { return window_; }
+
+void InspectorNoise::SetPublishInterval(int ms) { publish_ms_ = max(0, ms); }
+
+int InspectorNoise::GetPublishInterval() { return publish_ms_; }
+
+void InspectorNoise::SetCurveBins(int bins) {
+  lock_guard<mutex> lock(mutex_);
+  curve_bins_ = max(1, bins);
+}
+
+void InspectorNoise::Reset() {
+  lock_guard<mutex> lock(mutex_);
+  // the buffers are cleared by the next frame
+  width_ = 0;
+  height_ = 0;
+  frames_ = 0;
+}
+
+uint64_t InspectorNoise::GetFrameCount() { return frames_; }
+
+void InspectorNoise::OnNewFrame(Mat& frame) {
+  auto now = chrono::steady_clock::now();
+  {
+    lock_guard<mutex> lock(mutex_);
+    Accumulate(frame);
+    if (frames_ == 1) {
+      last_publish_ = now;
+    }
+    if (now - last_publish_ < chrono::milliseconds(publish_ms_)) {
+      return;
+    }
+    last_publish_ = now;
+    BuildReport(report_);
+  }
+  RenderNoise(report_);
+}
+
+void InspectorNoise::Accumulate(Mat& frame) {
+  int height = frame.size[1];
+  int width = frame.size[2];
+  int planes = min(frame.size[0], 2);
+  if (width != width_ || height != height_ || planes != planes_) {
+    width_ = width;
+    height_ = height;
+    planes_ = planes;
+    frames_ = 0;
+    count_.assign(width * height, 0);
+    for (int p = 0; p < 2; p++) {
+      mean_[p].assign(p < planes ? width * height : 0, 0);
+      var_[p].assign(p < planes ? width * height : 0, 0);
+    }
+  }
+  frames_++;
+
+  // a weight of 1/n is Welford's update, a floor on it makes the window
+  float minAlpha = (window_ > 0) ? 2.0f / (window_ + 1) : 0;
+  for (int y = 0; y < height; y++) {
+    const float* depth = frame.ptr<float>(0, y);
+    const float* amplitude = frame.ptr<float>(planes - 1, y);
+    float* count = &count_[y * width];
+    float* depthMean = &mean_[0][y * width];
+    float* depthVar = &var_[0][y * width];
+    // branchless, so that it is vectorised
+    for (int x = 0; x < width; x++) {
+      bool ok = depth[x] > 0 && depth[x] <= FLT_MAX;
+      float n = count[x] + (ok ? 1 : 0);
+      count[x] = n;
+      float alpha = ok ? max(1.0f / max(n, 1.0f), minAlpha) : 0;
+      // an invalid sample leaves mean and variance as they are
+      float delta = (ok ? depth[x] : depthMean[x]) - depthMean[x];
+      depthMean[x] += alpha * delta;
+      depthVar[x] = (1 - alpha) * (depthVar[x] + alpha * delta * delta);
+    }
+    if (planes < 2) {
+      continue;
+    }
+    float* amplitudeMean = &mean_[1][y * width];
+    float* amplitudeVar = &var_[1][y * width];
+    for (int x = 0; x < width; x++) {
+      bool ok = depth[x] > 0 && depth[x] <= FLT_MAX;
+      float alpha = ok ? max(1.0f / max(count[x], 1.0f), minAlpha) : 0;
+      float delta = (ok ? amplitude[x] : amplitudeMean[x]) - amplitudeMean[x];
+      amplitudeMean[x] += alpha * delta;
+      amplitudeVar[x] = (1 - alpha) * (amplitudeVar[x] + alpha * delta * delta);
+    }
+  }
+}
+
+/**
+ * @brief Mean of the noise of the pixels binned by another value.
+ *
+ */
+static void BinCurve(const Mat& by, const Mat& noise, int bins,
+                     vector<NoiseCurvePoint>& curve) {
+  curve.clear();
+  float lo = FLT_MAX;
+  float hi = -FLT_MAX;
+  int total = by.total();
+  const float* b = by.ptr<float>();
+  const float* n = noise.ptr<float>();
+  for (int i = 0; i < total; i++) {
+    if (std::isfinite(n[i]) && std::isfinite(b[i])) {
+      lo = min(lo, b[i]);
+      hi = max(hi, b[i]);
+    }
+  }
+  if (lo > hi) {
+    return;
+  }
+
+  vector<double> sums(bins, 0);
+  vector<int> counts(bins, 0);
+  float scale = (hi > lo) ? bins / (hi - lo) : 0;
+  for (int i = 0; i < total; i++) {
+    if (std::isfinite(n[i]) && std::isfinite(b[i])) {
+      int k = min((int)((b[i] - lo) * scale), bins - 1);
+      sums[k] += n[i];
+      counts[k]++;
+    }
+  }
+  float width = (hi > lo) ? (hi - lo) / bins : 0;
+  for (int k = 0; k < bins; k++) {
+    if (counts[k] > 0) {
+      curve.push_back({lo + (k + 0.5f) * width, (float)(sums[k] / counts[k]),
+                       counts[k]});
+    }
+  }
+}
+
+void InspectorNoise::BuildReport(NoiseReport& report) {
+  report.frames = frames_;
+  report.median_depth_std = NAN;
+  report.noise_vs_amplitude.clear();
+  report.noise_vs_distance.clear();
+  if (width_ == 0 || height_ == 0) {
+    return;
+  }
+
+  Mat* means[] = {&report.depth_mean, &report.amplitude_mean};
+  Mat* stds[] = {&report.depth_std, &report.amplitude_std};
+  for (int p = 0; p < 2; p++) {
+    if (p >= planes_) {
+      means[p]->release();
+      stds[p]->release();
+      continue;
+    }
+    means[p]->create(height_, width_, CV_32FC1);
+    stds[p]->create(height_, width_, CV_32FC1);
+    float* mean = means[p]->ptr<float>();
+    float* std = stds[p]->ptr<float>();
+    for (int i = 0; i < width_ * height_; i++) {
+      float n = count_[i];
+      mean[i] = (n > 0) ? mean_[p][i] : NAN;
+      std[i] = (n >= NOISE_MIN_SAMPLES) ? sqrt(var_[p][i]) : NAN;
+    }
+  }
+
+  if (planes_ > 1) {
+    BinCurve(report.amplitude_mean, report.depth_std, curve_bins_,
+             report.noise_vs_amplitude);
+  }
+  BinCurve(report.depth_mean, report.depth_std, curve_bins_,
+           report.noise_vs_distance);
+
+  scratch_.clear();
+  const float* std = report.depth_std.ptr<float>();
+  for (int i = 0; i < width_ * height_; i++) {
+    if (std::isfinite(std[i])) {
+      scratch_.push_back(std[i]);
+    }
+  }
+  if (!scratch_.empty()) {
+    auto middle = scratch_.begin() + scratch_.size() / 2;
+    nth_element(scratch_.begin(), middle, scratch_.end());
+    report.median_depth_std = *middle;
+  }
+}
@@ -0,0 +1,144 @@
+/* Copyright (C) 2023 Deep In Sight
+ * Author: Le Ngoc Linh <lnlinh93@dinsight.ai>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Suite 500,
+ * Boston, MA 02110-1335, USA.
+ */
+#ifndef __INSPECTOR_NOISE_H__
+#define __INSPECTOR_NOISE_H__
+
+#include <sdk/core/pad.h>
+
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <opencv2/opencv.hpp>
+#include <vector>
+
+#define DEFAULT_NOISE_PUBLISH_MS 1000
+#define DEFAULT_NOISE_CURVE_BINS 32
+// samples of a pixel before its noise is known
+#define NOISE_MIN_SAMPLES 2
+
+struct NoiseCurvePoint {
+  // center of the bin
+  float x;
+  // mean depth stddev of the pixels in the bin
+  float noise;
+  int pixels;
+};
+
+/**
+ * @brief Per pixel temporal statistics of the frames since the last Reset(),
+ * or of the last frames with a window. The stddev maps are NaN where a pixel
+ * has fewer than NOISE_MIN_SAMPLES valid samples.
+ *
+ */
+struct NoiseReport {
+  uint64_t frames;
+  // h x w CV_32FC1, the amplitude ones are empty if frames only have depth
+  Mat depth_mean;
+  Mat depth_std;
+  Mat amplitude_mean;
+  Mat amplitude_std;
+  // depth stddev binned by mean amplitude, and by mean depth
+  vector<NoiseCurvePoint> noise_vs_amplitude;
+  vector<NoiseCurvePoint> noise_vs_distance;
+  float median_depth_std;
+};
+
+/**
+ * @brief InspectorNoise measures the temporal noise of each pixel: it updates
+ * a running mean and variance of the depth and amplitude with every frame
+ * (Welford's algorithm, in one branchless pass so it is vectorised), and
+ * publishes the precision maps and noise curves at a fixed interval, which
+ * costs a few milliseconds per report instead of per frame. A sample is valid
+ * when its depth is finite and positive.
+ *
+ */
+class InspectorNoise : public PadObserver {
+ public:
+  InspectorNoise();
+  virtual ~InspectorNoise(){};
+
+  /**
+   * @brief Set the window of the statistics. With 0, all the frames since
+   * Reset() count the same. Otherwise the weight of older frames decays
+   * exponentially, like a moving average over about that many frames, so
+   * that no frame has to be kept.
+   *
+   * @param frames
+   */
+  void SetWindow(int frames);
+  int GetWindow();
+
+  /**
+   * @brief Set the time between two reports.
+   *
+   * @param ms
+   */
+  void SetPublishInterval(int ms);
+  int GetPublishInterval();
+  void SetCurveBins(int bins);
+
+  /**
+   * @brief Start over from the next frame.
+   *
+   */
+  void Reset();
+  uint64_t GetFrameCount();
+
+  void OnNewFrame(Mat& frame) override;
+
+ protected:
+  /**
+   * @brief Update the per pixel statistics with a frame. Called by
+   * OnNewFrame(Mat&), only made protected for unit test.
+   *
+   * @param frame
+   */
+  void Accumulate(Mat& frame);
+  /**
+   * @brief Compute the maps and curves from the statistics.
+   *
+   * @param report
+   */
+  void BuildReport(NoiseReport& report);
+  /**
+   * @brief Render a report, called by OnNewFrame(Mat&) once per publish
+   * interval. Child class implements it to show or store the results.
+   *
+   * @param report
+   */
+  virtual void RenderNoise(const NoiseReport& report) = 0;
+
+  mutex mutex_;
+  int window_;
+  int publish_ms_;
+  int curve_bins_;
+  chrono::steady_clock::time_point last_publish_;
+  uint64_t frames_;
+  int width_;
+  int height_;
+  int planes_;
+  // per pixel valid samples, mean and population variance of each plane
+  vector<float> count_;
+  vector<float> mean_[2];
+  vector<float> var_[2];
+  NoiseReport report_;
+  vector<float> scratch_;
+};
+
+#endif  //__INSPECTOR_NOISE_H__
@@ -0,0 +1,381 @@
+/* Copyright (C) 2023 Deep In Sight
+ * Author: Le Ngoc Linh <lnlinh93@dinsight.ai>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Suite 500,
+ * Boston, MA 02110-1335, USA.
+ */
+
+#include <sdk/inspector/inspector-plane-fit.h>
+#include <sdk/inspector/inspector-roi.h>
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <limits>
+
+InspectorPlaneFit::InspectorPlaneFit()
+    : params_(PinholeParams::DefaultParams()),
+      threshold_(DEFAULT_PLANE_FIT_THRESHOLD),
+      iterations_(DEFAULT_PLANE_FIT_ITERATIONS),
+      has_reference_(false),
+      reference_{0, 0, 1, 0},
+      width_(0),
+      height_(0),
+      geometry_{0, 0, 0, 0, 0, 0},
+      dirty_(true) {}
+
+void InspectorPlaneFit::SetParams(const PinholeParams& params) {
+  lock_guard<mutex> lock(mutex_);
+  params_ = params;
+  dirty_ = true;
+}
+
+PinholeParams InspectorPlaneFit::GetParams() { return params_; }
+
+void InspectorPlaneFit::SetRoi(int x, int y, int x2, int y2) {
+  lock_guard<mutex> lock(mutex_);
+  roi_ = ClampInspectorRoi(mat_shape_, x, y, x2, y2);
+  dirty_ = true;
+}
+
+void InspectorPlaneFit::GetRoi(int& x, int& y, int& x2, int& y2) {
+  lock_guard<mutex> lock(mutex_);
+  x = roi_.x;
+  y = roi_.y;
+  x2 = roi_.x + roi_.width - 1;
+  y2 = roi_.y + roi_.height - 1;
+}
+
+void InspectorPlaneFit::SetThreshold(float threshold) {
+  threshold_ = max(0.0f, threshold);
+}
+
+float InspectorPlaneFit::GetThreshold() { return threshold_; }
+
+void InspectorPlaneFit::SetIterations(int iterations) {
+  iterations_ = max(0, iterations);
+}
+
+int InspectorPlaneFit::GetIterations() { return iterations_; }
+
+void InspectorPlaneFit::SetReference(float distance, float nx, float ny,
+                                     float nz) {
+  lock_guard<mutex> lock(mutex_);
+  float norm = sqrt(nx * nx + ny * ny + nz * nz);
+  if (!(norm > 0)) {
+    return;
+  }
+  reference_[0] = nx / norm;
+  reference_[1] = ny / norm;
+  reference_[2] = nz / norm;
+  reference_[3] = distance;
+  has_reference_ = true;
+}
+
+void InspectorPlaneFit::ClearReference() {
+  lock_guard<mutex> lock(mutex_);
+  has_reference_ = false;
+}
+
+void InspectorPlaneFit::OnNewFrame(Mat& frame) {
+  {
+    lock_guard<mutex> lock(mutex_);
+    if (roi_.area() == 0) {
+      return;
+    }
+    Fit(frame, report_);
+  }
+  RenderPlaneFit(report_);
+}
+
+void InspectorPlaneFit::PrepareGeometry() {
+  float fx_pixel = params_.fx_ * 1e-3 / (params_.dx_ * 1e-6);
+  float fy_pixel = params_.fy_ * 1e-3 / (params_.dy_ * 1e-6);
+  coeff_x_.resize(width_);
+  coeff_y_.resize(height_);
+  for (int x = 0; x < width_; x++) {
+    coeff_x_[x] = (x - params_.cx_) / fx_pixel;
+  }
+  for (int y = 0; y < height_; y++) {
+    coeff_y_[y] = (y - params_.cy_) / fy_pixel;
+  }
+
+  // the frame format may have changed since the ROI was set
+  roi_ = roi_ & Rect(0, 0, width_, height_);
+  double su = 0;
+  double suu = 0;
+  for (int x = roi_.x; x < roi_.x + roi_.width; x++) {
+    su += coeff_x_[x];
+    suu += (double)coeff_x_[x] * coeff_x_[x];
+  }
+  double sv = 0;
+  double svv = 0;
+  for (int y = roi_.y; y < roi_.y + roi_.height; y++) {
+    sv += coeff_y_[y];
+    svv += (double)coeff_y_[y] * coeff_y_[y];
+  }
+  // separable, the ray of (x, y) is (u[x], v[y], 1)
+  geometry_[0] = suu * roi_.height;
+  geometry_[1] = su * sv;
+  geometry_[2] = su * roi_.height;
+  geometry_[3] = svv * roi_.width;
+  geometry_[4] = sv * roi_.width;
+  geometry_[5] = roi_.area();
+
+  // a regular grid of about PLANE_FIT_SAMPLES pixels
+  int step = max(1, (int)sqrt((double)roi_.area() / PLANE_FIT_SAMPLES));
+  samples_.clear();
+  for (int y = roi_.y + step / 2; y < roi_.y + roi_.height; y += step) {
+    for (int x = roi_.x + step / 2; x < roi_.x + roi_.width; x += step) {
+      samples_.push_back(Point(x, y));
+    }
+  }
+  dirty_ = false;
+}
+
+/**
+ * @brief Solve the normal equations a * n = b, a being symmetric and given by
+ * its upper triangle.
+ *
+ * @return false if a is singular, e.g. all the pixels on a line
+ */
+static bool Solve3(const double a[6], const double b[3], double n[3]) {
+  // cofactors
+  double c00 = a[3] * a[5] - a[4] * a[4];
+  double c01 = a[2] * a[4] - a[1] * a[5];
+  double c02 = a[1] * a[4] - a[2] * a[3];
+  double c11 = a[0] * a[5] - a[2] * a[2];
+  double c12 = a[1] * a[2] - a[0] * a[4];
+  double c22 = a[0] * a[3] - a[1] * a[1];
+  double det = a[0] * c00 + a[1] * c01 + a[2] * c02;
+  // relative to the diagonal, as a is positive semi-definite
+  if (!(det > 1e-12 * a[0] * a[3] * a[5])) {
+    return false;
+  }
+  n[0] = (c00 * b[0] + c01 * b[1] + c02 * b[2]) / det;
+  n[1] = (c01 * b[0] + c11 * b[1] + c12 * b[2]) / det;
+  n[2] = (c02 * b[0] + c12 * b[1] + c22 * b[2]) / det;
+  return true;
+}
+
+bool InspectorPlaneFit::Ransac(Mat& frame, double n[3]) {
+  sample_points_.clear();
+  for (auto& s : samples_) {
+    float z = frame.at<float>(0, s.y, s.x);
+    if (z > 0 && z <= FLT_MAX) {
+      sample_points_.push_back(z * coeff_x_[s.x]);
+      sample_points_.push_back(z * coeff_y_[s.y]);
+      sample_points_.push_back(z);
+    }
+  }
+  int count = sample_points_.size() / 3;
+  if (count < 3) {
+    return false;
+  }
+
+  const float* p = sample_points_.data();
+  int best = 0;
+  for (int it = 0; it < iterations_; it++) {
+    int i = rng_() % count;
+    int j = rng_() % count;
+    int k = rng_() % count;
+    if (i == j || j == k || i == k) {
+      continue;
+    }
+    const float* p1 = p + 3 * i;
+    const float* p2 = p + 3 * j;
+    const float* p3 = p + 3 * k;
+    double e1[3] = {p2[0] - p1[0], p2[1] - p1[1], p2[2] - p1[2]};
+    double e2[3] = {p3[0] - p1[0], p3[1] - p1[1], p3[2] - p1[2]};
+    double c[3] = {e1[1] * e2[2] - e1[2] * e2[1],
+                   e1[2] * e2[0] - e1[0] * e2[2],
+                   e1[0] * e2[1] - e1[1] * e2[0]};
+    double offset = c[0] * p1[0] + c[1] * p1[1] + c[2] * p1[2];
+    double norm = sqrt(c[0] * c[0] + c[1] * c[1] + c[2] * c[2]);
+    // collinear, or a plane through the camera which no wall is
+    if (!(fabs(offset) > 1e-6 * norm * p1[2])) {
+      continue;
+    }
+    float h[3] = {(float)(c[0] / offset), (float)(c[1] / offset),
+                  (float)(c[2] / offset)};
+    float threshold = threshold_ * (float)(norm / fabs(offset));
+    int inliers = 0;
+    for (int s = 0; s < count; s++) {
+      const float* q = p + 3 * s;
+      float d = h[0] * q[0] + h[1] * q[1] + h[2] * q[2] - 1;
+      inliers += fabs(d) <= threshold;
+    }
+    if (inliers > best) {
+      best = inliers;
+      n[0] = h[0];
+      n[1] = h[1];
+      n[2] = h[2];
+    }
+  }
+  return best >= 3;
+}
+
+void InspectorPlaneFit::Fit(Mat& frame, PlaneFitReport& report) {
+  int height = frame.size[1];
+  int width = frame.size[2];
+  if (dirty_ || height != height_ || width != width_) {
+    height_ = height;
+    width_ = width;
+    PrepareGeometry();
+  }
+
+  const float nan = numeric_limits<float>::quiet_NaN();
+  const Rect& r = roi_;
+  report.roi = r;
+  report.ok = false;
+  report.valid = 0;
+  report.inliers = 0;
+  report.normal[0] = report.normal[1] = report.normal[2] = 0;
+  report.distance = 0;
+  report.rms = 0;
+  report.bias = nan;
+  report.tilt = nan;
+  report.residual.create(r.height, r.width, CV_32FC1);
+  report.residual.setTo(Scalar(nan));
+  if (r.area() == 0) {
+    return;
+  }
+  const float* u = coeff_x_.data() + r.x;
+
+  // normal equations of all the valid pixels: the precomputed geometry minus
+  // the invalid ones, and the inverse depths, in one pass over each row.
+  double a[6];
+  copy(geometry_, geometry_ + 6, a);
+  double b[3] = {0, 0, 0};
+  int invalid = 0;
+  for (int y = r.y; y < r.y + r.height; y++) {
+    const float* z = frame.ptr<float>(0, y) + r.x;
+    double v = coeff_y_[y];
+    double sw = 0, swu = 0, mu = 0, muu = 0;
+    int m = 0;
+    for (int x = 0; x < r.width; x++) {
+      bool ok = z[x] > 0 && z[x] <= FLT_MAX;
+      float w = ok ? 1 / z[x] : 0;
+      float bad = !ok;
+      sw += w;
+      swu += w * u[x];
+      mu += bad * u[x];
+      muu += bad * u[x] * u[x];
+      m += !ok;
+    }
+    b[0] += swu;
+    b[1] += v * sw;
+    b[2] += sw;
+    a[0] -= muu;
+    a[1] -= v * mu;
+    a[2] -= mu;
+    a[3] -= v * v * m;
+    a[4] -= v * m;
+    a[5] -= m;
+    invalid += m;
+  }
+  report.valid = r.area() - invalid;
+  if (report.valid < 3) {
+    return;
+  }
+
+  double n[3];
+  bool robust = threshold_ > 0 && iterations_ > 0 && Ransac(frame, n);
+  if (!robust && !Solve3(a, b, n)) {
+    return;
+  }
+
+  // remove the outliers of that model and fit again
+  if (threshold_ > 0) {
+    float h[3] = {(float)n[0], (float)n[1], (float)n[2]};
+    float threshold =
+        threshold_ * sqrt(h[0] * h[0] + h[1] * h[1] + h[2] * h[2]);
+    for (int y = r.y; y < r.y + r.height; y++) {
+      const float* z = frame.ptr<float>(0, y) + r.x;
+      double v = coeff_y_[y];
+      float hv = h[1] * coeff_y_[y] + h[2];
+      double sw = 0, swu = 0, mu = 0, muu = 0;
+      int m = 0;
+      for (int x = 0; x < r.width; x++) {
+        bool ok = z[x] > 0 && z[x] <= FLT_MAX;
+        bool out = ok && fabs(z[x] * (h[0] * u[x] + hv) - 1) > threshold;
+        float w = out ? 1 / z[x] : 0;
+        float bad = out;
+        sw += w;
+        swu += w * u[x];
+        mu += bad * u[x];
+        muu += bad * u[x] * u[x];
+        m += out;
+      }
+      b[0] -= swu;
+      b[1] -= v * sw;
+      b[2] -= sw;
+      a[0] -= muu;
+      a[1] -= v * mu;
+      a[2] -= mu;
+      a[3] -= v * v * m;
+      a[4] -= v * m;
+      a[5] -= m;
+    }
+    if (!Solve3(a, b, n)) {
+      return;
+    }
+  }
+
+  double norm = sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+  if (!(norm > 0)) {
+    return;
+  }
+  float h[3] = {(float)n[0], (float)n[1], (float)n[2]};
+  float scale = 1 / norm;
+  float threshold = threshold_ > 0 ? threshold_ : FLT_MAX;
+  const float* ref = reference_;
+  double sum_sq = 0;
+  double sum_bias = 0;
+  int inliers = 0;
+  for (int y = r.y; y < r.y + r.height; y++) {
+    const float* z = frame.ptr<float>(0, y) + r.x;
+    float* residual = report.residual.ptr<float>(y - r.y);
+    float v = coeff_y_[y];
+    float hv = h[1] * v + h[2];
+    float rv = ref[1] * v + ref[2];
+    double sq = 0, bias = 0;
+    for (int x = 0; x < r.width; x++) {
+      bool ok = z[x] > 0 && z[x] <= FLT_MAX;
+      float d = (z[x] * (h[0] * u[x] + hv) - 1) * scale;
+      bool in = ok && fabs(d) <= threshold;
+      residual[x] = ok ? d : nan;
+      sq += in ? d * d : 0;
+      bias += in ? z[x] * (ref[0] * u[x] + rv) - ref[3] : 0;
+      inliers += in;
+    }
+    sum_sq += sq;
+    sum_bias += bias;
+  }
+
+  report.ok = true;
+  report.inliers = inliers;
+  for (int i = 0; i < 3; i++) {
+    report.normal[i] = n[i] / norm;
+  }
+  report.distance = scale;
+  report.rms = inliers > 0 ? sqrt(sum_sq / inliers) : 0;
+  if (has_reference_) {
+    report.bias = inliers > 0 ? sum_bias / inliers : nan;
+    double dot = report.normal[0] * ref[0] + report.normal[1] * ref[1] +
+                 report.normal[2] * ref[2];
+    report.tilt = acos(max(-1.0, min(1.0, dot))) * 180 / M_PI;
+  }
+}
@@ -0,0 +1,166 @@
+/* Copyright (C) 2023 Deep In Sight
+ * Author: Le Ngoc Linh <lnlinh93@dinsight.ai>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Suite 500,
+ * Boston, MA 02110-1335, USA.
+ */
+#ifndef __INSPECTOR_PLANE_FIT_H__
+#define __INSPECTOR_PLANE_FIT_H__
+
+#include <sdk/core/pad.h>
+#include <sdk/tof/unprojection.h>
+
+#include <mutex>
+#include <opencv2/opencv.hpp>
+#include <random>
+#include <vector>
+
+// max distance of an inlier to the plane, in depth unit
+#define DEFAULT_PLANE_FIT_THRESHOLD 0.01f
+#define DEFAULT_PLANE_FIT_ITERATIONS 32
+// pixels of the ROI the RANSAC hypotheses are scored on
+#define PLANE_FIT_SAMPLES 256
+
+/**
+ * @brief Plane fitted to the ROI of a frame. The plane is the points p with
+ * dot(normal, p) = distance, normal is unit and points away from the camera.
+ *
+ */
+struct PlaneFitReport {
+  Rect roi;
+  // false if there were not enough valid pixels, or they were degenerate
+  bool ok;
+  int valid;
+  int inliers;
+  float normal[3];
+  float distance;
+  // RMS of the distances of the inliers to the fitted plane
+  float rms;
+  // mean signed distance of the inliers to the reference plane, NaN without
+  float bias;
+  // angle between the fitted and reference normals, in degrees
+  float tilt;
+  // roi size CV_32FC1 signed distance of each pixel to the fitted plane, NaN
+  // where the depth is invalid
+  Mat residual;
+};
+
+/**
+ * @brief InspectorPlaneFit fits a plane to the unprojected pixels of a ROI,
+ * e.g. a flat wall in an accuracy test, and reports the fit and its error
+ * against a reference plane every frame.
+ *
+ * A pixel (u, v) with depth z is the point z * r, r = (u', v', 1) its ray.
+ * The plane dot(n, p) = 1 is then linear in the inverse depth,
+ * 1 / z = dot(n, r), so the normal equations only depend on the depth through
+ * their right-hand side: the sums of r * r^T over the ROI are computed once,
+ * and each frame only removes its invalid pixels and outliers from them. The
+ * outliers are found with a few RANSAC hypotheses scored on a sparse grid of
+ * the ROI, then the least squares fit of the inliers takes one more pass.
+ *
+ */
+class InspectorPlaneFit : public PadObserver {
+ public:
+  InspectorPlaneFit();
+  virtual ~InspectorPlaneFit(){};
+
+  /**
+   * @brief Set the lens parameters used to unproject the pixels.
+   *
+   * @param params
+   */
+  void SetParams(const PinholeParams& params);
+  PinholeParams GetParams();
+
+  /**
+   * @brief Set the ROI. The range is inclusive-start and inclusive-end,
+   * clamped to the frame size, and swapped if x2 < x or y2 < y.
+   *
+   */
+  void SetRoi(int x, int y, int x2, int y2);
+  void GetRoi(int& x, int& y, int& x2, int& y2);
+
+  /**
+   * @brief Set the max distance of an inlier to the plane. With 0, all the
+   * valid pixels are fitted.
+   *
+   * @param threshold
+   */
+  void SetThreshold(float threshold);
+  float GetThreshold();
+
+  /**
+   * @brief Set the number of RANSAC hypotheses. With 0, the outliers are
+   * those of the least squares fit of all the valid pixels, which is enough
+   * when there are only a few of them.
+   *
+   * @param iterations
+   */
+  void SetIterations(int iterations);
+  int GetIterations();
+
+  /**
+   * @brief Set the reference plane dot(normal, p) = distance, e.g. the
+   * measured position of the target. The normal is normalized.
+   *
+   */
+  void SetReference(float distance, float nx = 0, float ny = 0, float nz = 1);
+  void ClearReference();
+
+  void OnNewFrame(Mat& frame) override;
+
+ protected:
+  /**
+   * @brief Fit the plane of a frame. Called by OnNewFrame(Mat&), only made
+   * protected for unit test.
+   *
+   * @param frame
+   * @param report
+   */
+  void Fit(Mat& frame, PlaneFitReport& report);
+  /**
+   * @brief Render the fit of a frame. Called once per frame by
+   * OnNewFrame(Mat&), child class implements it to show or store the results.
+   *
+   * @param report
+   */
+  virtual void RenderPlaneFit(const PlaneFitReport& report) = 0;
+
+  void PrepareGeometry();
+  bool Ransac(Mat& frame, double n[3]);
+
+  mutex mutex_;
+  PinholeParams params_;
+  Rect roi_;
+  float threshold_;
+  int iterations_;
+  bool has_reference_;
+  float reference_[4];
+  int width_;
+  int height_;
+  // ray of each column and row, like Unprojection
+  vector<float> coeff_x_;
+  vector<float> coeff_y_;
+  // sums of r * r^T over the ROI: uu, uv, u, vv, v, 1
+  double geometry_[6];
+  vector<Point> samples_;
+  vector<float> sample_points_;
+  minstd_rand rng_;
+  // the geometry is computed again before the next fit
+  bool dirty_;
+  PlaneFitReport report_;
+};
+
+#endif  //__INSPECTOR_PLANE_FIT_H__
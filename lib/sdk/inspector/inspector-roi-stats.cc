@@ -0,0 +1,207 @@
+/* Copyright (C) 2023 Deep In Sight
+ * Author: Le Ngoc Linh <lnlinh93@dinsight.ai>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Suite 500,
+ * Boston, MA 02110-1335, USA.
+ */
+
+#include <sdk/inspector/inspector-roi-stats.h>
+#include <sdk/inspector/inspector-roi.h>
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+
+InspectorRoiStats::InspectorRoiStats() : minmax_(true), planes_(0) {}
+
+int InspectorRoiStats::AddRoi(int x, int y, int x2, int y2) {
+  lock_guard<mutex> lock(mutex_);
+  rois_.push_back(ClampInspectorRoi(mat_shape_, x, y, x2, y2));
+  return rois_.size() - 1;
+}
+
+void InspectorRoiStats::SetRoi(int index, int x, int y, int x2, int y2) {
+  lock_guard<mutex> lock(mutex_);
+  if (index >= 0 && index < (int)rois_.size()) {
+    rois_[index] = ClampInspectorRoi(mat_shape_, x, y, x2, y2);
+  }
+}
+
+void InspectorRoiStats::GetRoi(int index, int& x, int& y, int& x2, int& y2) {
+  lock_guard<mutex> lock(mutex_);
+  if (index < 0 || index >= (int)rois_.size()) {
+    return;
+  }
+  const Rect& roi = rois_[index];
+  x = roi.x;
+  y = roi.y;
+  x2 = roi.x + roi.width - 1;
+  y2 = roi.y + roi.height - 1;
+}
+
+void InspectorRoiStats::RemoveRoi(int index) {
+  lock_guard<mutex> lock(mutex_);
+  if (index >= 0 && index < (int)rois_.size()) {
+    rois_.erase(rois_.begin() + index);
+  }
+}
+
+void InspectorRoiStats::ClearRois() {
+  lock_guard<mutex> lock(mutex_);
+  rois_.clear();
+}
+
+int InspectorRoiStats::GetRoiCount() {
+  lock_guard<mutex> lock(mutex_);
+  return rois_.size();
+}
+
+void InspectorRoiStats::SetMinMax(bool enabled) { minmax_ = enabled; }
+
+void InspectorRoiStats::OnNewFrame(Mat& frame) {
+  {
+    lock_guard<mutex> lock(mutex_);
+    if (rois_.empty()) {
+      return;
+    }
+    BuildIntegral(frame);
+    stats_.resize(rois_.size());
+    for (size_t i = 0; i < rois_.size(); i++) {
+      ComputeStats(frame, rois_[i], stats_[i]);
+    }
+  }
+  RenderStats(stats_);
+}
+
+void InspectorRoiStats::BuildIntegral(Mat& frame) {
+  int height = frame.size[1];
+  int width = frame.size[2];
+  planes_ = min(frame.size[0], 2);
+  for (int p = 0; p < planes_; p++) {
+    // the first row and column stay zero
+    sum_[p].create(height + 1, width + 1, CV_64FC1);
+    sqsum_[p].create(height + 1, width + 1, CV_64FC1);
+    memset(sum_[p].ptr<double>(0), 0, (width + 1) * sizeof(double));
+    memset(sqsum_[p].ptr<double>(0), 0, (width + 1) * sizeof(double));
+    row_[p].resize(width);
+  }
+  count_.create(height + 1, width + 1, CV_32SC1);
+  memset(count_.ptr<int>(0), 0, (width + 1) * sizeof(int));
+  row_valid_.resize(width);
+
+  for (int y = 0; y < height; y++) {
+    const float* depth = frame.ptr<float>(0, y);
+    float* masked = row_[0].data();
+    int* valid = row_valid_.data();
+    // branchless, so that it is vectorised
+    for (int x = 0; x < width; x++) {
+      bool ok = depth[x] > 0 && depth[x] <= FLT_MAX;
+      masked[x] = ok ? depth[x] : 0;
+      valid[x] = ok;
+    }
+    if (planes_ > 1) {
+      const float* amplitude = frame.ptr<float>(1, y);
+      float* maskedAmplitude = row_[1].data();
+      for (int x = 0; x < width; x++) {
+        maskedAmplitude[x] = valid[x] ? amplitude[x] : 0;
+      }
+    }
+
+    const int* countAbove = count_.ptr<int>(y);
+    int* count = count_.ptr<int>(y + 1);
+    int rowCount = 0;
+    count[0] = 0;
+    for (int x = 0; x < width; x++) {
+      rowCount += valid[x];
+      count[x + 1] = countAbove[x + 1] + rowCount;
+    }
+    for (int p = 0; p < planes_; p++) {
+      const float* v = row_[p].data();
+      const double* sumAbove = sum_[p].ptr<double>(y);
+      const double* sqsumAbove = sqsum_[p].ptr<double>(y);
+      double* sum = sum_[p].ptr<double>(y + 1);
+      double* sqsum = sqsum_[p].ptr<double>(y + 1);
+      double rowSum = 0;
+      double rowSqsum = 0;
+      sum[0] = 0;
+      sqsum[0] = 0;
+      for (int x = 0; x < width; x++) {
+        rowSum += v[x];
+        rowSqsum += (double)v[x] * v[x];
+        sum[x + 1] = sumAbove[x + 1] + rowSum;
+        sqsum[x + 1] = sqsumAbove[x + 1] + rowSqsum;
+      }
+    }
+  }
+}
+
+/**
+ * @brief Sum of a rectangle of an integral image.
+ *
+ */
+template <typename T>
+static T RectSum(const Mat& integral, const Rect& r) {
+  return integral.at<T>(r.y + r.height, r.x + r.width) -
+         integral.at<T>(r.y, r.x + r.width) -
+         integral.at<T>(r.y + r.height, r.x) + integral.at<T>(r.y, r.x);
+}
+
+void InspectorRoiStats::ComputeStats(Mat& frame, const Rect& roi,
+                                     RoiStats& stats) {
+  memset(&stats.depth, 0, sizeof(stats.depth));
+  memset(&stats.amplitude, 0, sizeof(stats.amplitude));
+  // the frame format may have changed since the ROI was set
+  stats.roi = roi & Rect(0, 0, count_.cols - 1, count_.rows - 1);
+  stats.valid = stats.roi.area() > 0 ? RectSum<int>(count_, stats.roi) : 0;
+  if (stats.valid == 0) {
+    return;
+  }
+
+  RoiChannelStats* channels[] = {&stats.depth, &stats.amplitude};
+  for (int p = 0; p < planes_; p++) {
+    RoiChannelStats& s = *channels[p];
+    s.mean = RectSum<double>(sum_[p], stats.roi) / stats.valid;
+    double variance =
+        RectSum<double>(sqsum_[p], stats.roi) / stats.valid - s.mean * s.mean;
+    // cancellation may make it slightly negative
+    s.stddev = sqrt(max(0.0, variance));
+  }
+
+  if (!minmax_) {
+    return;
+  }
+  for (int p = 0; p < planes_; p++) {
+    channels[p]->min = FLT_MAX;
+    channels[p]->max = -FLT_MAX;
+  }
+  for (int y = stats.roi.y; y < stats.roi.y + stats.roi.height; y++) {
+    const float* depth = frame.ptr<float>(0, y);
+    const float* amplitude = frame.ptr<float>(planes_ - 1, y);
+    for (int x = stats.roi.x; x < stats.roi.x + stats.roi.width; x++) {
+      if (!(depth[x] > 0 && depth[x] <= FLT_MAX)) {
+        continue;
+      }
+      stats.depth.min = min(stats.depth.min, depth[x]);
+      stats.depth.max = max(stats.depth.max, depth[x]);
+      stats.amplitude.min = min(stats.amplitude.min, amplitude[x]);
+      stats.amplitude.max = max(stats.amplitude.max, amplitude[x]);
+    }
+  }
+  if (planes_ < 2) {
+    stats.amplitude.min = 0;
+    stats.amplitude.max = 0;
+  }
+}
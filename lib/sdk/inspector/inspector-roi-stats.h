@@ -0,0 +1,122 @@
+/* Copyright (C) 2023 Deep In Sight
+ * Author: Le Ngoc Linh <lnlinh93@dinsight.ai>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Suite 500,
+ * Boston, MA 02110-1335, USA.
+ */
+#ifndef __INSPECTOR_ROI_STATS_H__
+#define __INSPECTOR_ROI_STATS_H__
+
+#include <sdk/core/pad.h>
+
+#include <mutex>
+#include <opencv2/opencv.hpp>
+#include <vector>
+
+struct RoiChannelStats {
+  double mean;
+  double stddev;
+  float min;
+  float max;
+};
+
+/**
+ * @brief Statistics of the valid pixels of a ROI. A pixel is valid when its
+ * depth is finite and positive, the amplitude stats use the same pixels.
+ *
+ */
+struct RoiStats {
+  Rect roi;
+  int valid;
+  RoiChannelStats depth;
+  // zeros if the frames only have depth
+  RoiChannelStats amplitude;
+};
+
+/**
+ * @brief InspectorRoiStats computes the statistics of any number of ROIs of
+ * each frame. The integral images of the valid values, of their squares and of
+ * the valid count are built once per frame, then the mean and stddev of each
+ * ROI take four lookups whatever its size. Min/max have no such shortcut and
+ * walk the pixels of each ROI, so they can be turned off.
+ *
+ */
+class InspectorRoiStats : public PadObserver {
+ public:
+  InspectorRoiStats();
+  virtual ~InspectorRoiStats(){};
+
+  /**
+   * @brief Add a ROI. The range is inclusive-start and inclusive-end, clamped
+   * to the frame size, and swapped if x2 < x or y2 < y.
+   *
+   * @return int index of the ROI in the results
+   */
+  int AddRoi(int x, int y, int x2, int y2);
+  void SetRoi(int index, int x, int y, int x2, int y2);
+  void GetRoi(int index, int& x, int& y, int& x2, int& y2);
+  void RemoveRoi(int index);
+  void ClearRois();
+  int GetRoiCount();
+
+  /**
+   * @brief Enable min/max, on by default.
+   *
+   * @param enabled
+   */
+  void SetMinMax(bool enabled);
+
+  void OnNewFrame(Mat& frame) override;
+
+ protected:
+  /**
+   * @brief Build the integral images of the frame. Called by OnNewFrame(Mat&),
+   * only made protected for unit test.
+   *
+   * @param frame
+   */
+  void BuildIntegral(Mat& frame);
+  /**
+   * @brief Get the stats of a ROI from the integral images of the last frame.
+   *
+   * @param frame the frame the integral images were built from, for min/max
+   * @param roi
+   * @param stats
+   */
+  void ComputeStats(Mat& frame, const Rect& roi, RoiStats& stats);
+  /**
+   * @brief Render the stats of all the ROIs of a frame, in the order they were
+   * added. Called once per frame by OnNewFrame(Mat&), child class implements
+   * it to show or store the stats.
+   *
+   * @param stats
+   */
+  virtual void RenderStats(const vector<RoiStats>& stats) = 0;
+
+  mutex mutex_;
+  vector<Rect> rois_;
+  bool minmax_;
+  // (h + 1) x (w + 1), like cv::integral, one per plane
+  Mat sum_[2];
+  Mat sqsum_[2];
+  Mat count_;
+  int planes_;
+  vector<RoiStats> stats_;
+  // masked values of a row
+  vector<float> row_[2];
+  vector<int> row_valid_;
+};
+
+#endif  //__INSPECTOR_ROI_STATS_H__
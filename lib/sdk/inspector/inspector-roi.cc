@@ -0,0 +1,36 @@
+/* Copyright (C) 2023 Deep In Sight
+ * Author: Le Ngoc Linh <lnlinh93@dinsight.ai>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Suite 500,
+ * Boston, MA 02110-1335, USA.
+ */
+
+#include <sdk/inspector/inspector-roi.h>
+
+#include <algorithm>
+
+Rect ClampInspectorRoi(const MatShape &shape, int x, int y, int x2, int y2) {
+  int tl_x = max(0, min(x, shape[2] - 1));
+  int tl_y = max(0, min(y, shape[1] - 1));
+  int br_x = max(0, min(x2, shape[2] - 1));
+  int br_y = max(0, min(y2, shape[1] - 1));
+  if (tl_x > br_x) {
+    swap(tl_x, br_x);
+  }
+  if (tl_y > br_y) {
+    swap(tl_y, br_y);
+  }
+  return Rect(tl_x, tl_y, br_x - tl_x + 1, br_y - tl_y + 1);
+}
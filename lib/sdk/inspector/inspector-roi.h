@@ -0,0 +1,40 @@
+/* Copyright (C) 2023 Deep In Sight
+ * Author: Le Ngoc Linh <lnlinh93@dinsight.ai>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Suite 500,
+ * Boston, MA 02110-1335, USA.
+ */
+#ifndef __INSPECTOR_ROI_H__
+#define __INSPECTOR_ROI_H__
+
+#include <sdk/core/pad.h>
+
+#include <opencv2/opencv.hpp>
+
+/**
+ * @brief Clamp an inclusive ROI given by 2 corners to the planes of a frame
+ * format (planes x rows x cols). Corners are swapped if x2 < x or y2 < y.
+ * Shared by the inspectors that take an ROI.
+ *
+ * @param shape frame format of the inspector
+ * @param x start point x
+ * @param y start point y
+ * @param x2 end point x
+ * @param y2 end point y
+ * @return Rect
+ */
+Rect ClampInspectorRoi(const MatShape &shape, int x, int y, int x2, int y2);
+
+#endif  //__INSPECTOR_ROI_H__
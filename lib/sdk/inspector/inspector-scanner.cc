@@ -21,17 +21,25 @@
 #include <spdlog/sinks/stdout_color_sinks.h>
 #include <spdlog/spdlog.h>
 
+#include <cmath>
+
 using namespace spdlog;
 static logger* logger_ = stdout_color_mt("InspectorScanner").get();
 
-InspectorScanner::InspectorScanner() {
+InspectorScanner::InspectorScanner()
+    : interpolation_(kScannerNearest),
+      plan_valid_(false),
+      plan_width_(0),
+      plan_height_(0),
+      plan_stride_(0) {
   start_x_ = -1;
   start_y_ = -1;
   end_x_ = -1;
   end_y_ = -1;
 }
 
-InspectorScanner::InspectorScanner(int x1, int y1, int x2, int y2) {
+InspectorScanner::InspectorScanner(int x1, int y1, int x2, int y2)
+    : InspectorScanner() {
   SetRoi(x1, y1, x2, y2);
 }
 
@@ -43,8 +51,10 @@ void InspectorScanner::GetRoi(int& x1, int& y1, int& x2, int& y2) {
 }
 
 void InspectorScanner::OnNewFrame(Mat& frame) {
-  auto vec = CollectRange(frame);
-  RenderRange(vec);
+  auto& vec = CollectRange(frame);
+  if (!vec.empty()) {
+    RenderRange(vec);
+  }
 }
 
 void InspectorScanner::SetRoi(int x1, int y1, int x2, int y2) {
@@ -58,32 +68,155 @@ void InspectorScanner::SetRoi(int x1, int y1, int x2, int y2) {
 
   liang_barsky_clipper(start_x_, start_y_, end_x_, end_y_, 0, 0, width - 1,
                        height - 1);
+
+  lock_guard<mutex> lock(mutex_);
+  vector<Point> line = {Point(start_x_, start_y_), Point(end_x_, end_y_)};
+  if (lines_.empty()) {
+    lines_.push_back(line);
+  } else {
+    lines_[0] = line;
+  }
+  plan_valid_ = false;
 }
 
-const std::vector<float>& InspectorScanner::CollectRange(Mat& frame) {
-  collected_.clear();
+int InspectorScanner::AddLine(const vector<Point>& points) {
+  if (points.empty()) {
+    logger_->error("A line needs at least one point");
+    return -1;
+  }
+  lock_guard<mutex> lock(mutex_);
+  lines_.push_back(points);
+  plan_valid_ = false;
+  return lines_.size() - 1;
+}
+
+void InspectorScanner::SetLine(int index, const vector<Point>& points) {
+  lock_guard<mutex> lock(mutex_);
+  if (index < 0 || index >= (int)lines_.size() || points.empty()) {
+    return;
+  }
+  lines_[index] = points;
+  plan_valid_ = false;
+}
 
-  int dx = end_x_ - start_x_;
-  int dy = end_y_ - start_y_;
+void InspectorScanner::ClearLines() {
+  lock_guard<mutex> lock(mutex_);
+  lines_.clear();
+  plan_valid_ = false;
+}
 
-  int steps = max(abs(dx), abs(dy));
+int InspectorScanner::GetLineCount() {
+  lock_guard<mutex> lock(mutex_);
+  return lines_.size();
+}
 
-  float Xinc = dx / (float)steps;
-  float Yinc = dy / (float)steps;
+void InspectorScanner::SetInterpolation(ScannerInterpolation interpolation) {
+  lock_guard<mutex> lock(mutex_);
+  interpolation_ = interpolation;
+  plan_valid_ = false;
+}
+
+ScannerInterpolation InspectorScanner::GetInterpolation() {
+  return interpolation_;
+}
+
+vector<int> InspectorScanner::GetLineStarts() {
+  lock_guard<mutex> lock(mutex_);
+  return line_starts_;
+}
 
-  float X = start_x_;
-  float Y = start_y_;
-  for (int i = 0; i <= steps; i++) {
-    // round up to nearest pixel
-    auto x = (int)(X + 0.5);
-    auto y = (int)(Y + 0.5);
-    auto val = frame.at<float>(channel_, y, x);
-    collected_.push_back(val);
+void InspectorScanner::AddSegment(Point p0, Point p1, bool first,
+                                  int stride) {
+  int dx = p1.x - p0.x;
+  int dy = p1.y - p0.y;
 
-    X += Xinc;
-    Y += Yinc;
+  if (interpolation_ == kScannerNearest) {
+    int steps = max(abs(dx), abs(dy));
+    float Xinc = (steps > 0) ? dx / (float)steps : 0;
+    float Yinc = (steps > 0) ? dy / (float)steps : 0;
+    // the first point is the last one of the previous segment
+    for (int i = first ? 0 : 1; i <= steps; i++) {
+      // round up to nearest pixel
+      int x = (int)(p0.x + i * Xinc + 0.5f);
+      int y = (int)(p0.y + i * Yinc + 0.5f);
+      offsets_.push_back(y * stride + x);
+    }
+    return;
+  }
+
+  // one sample per pixel of length, vertices included
+  float length = sqrt((float)(dx * dx + dy * dy));
+  int steps = (int)ceil(length);
+  for (int i = first ? 0 : 1; i <= steps; i++) {
+    float t = (steps > 0) ? i / (float)steps : 0;
+    float X = p0.x + t * dx;
+    float Y = p0.y + t * dy;
+    int x = min((int)X, plan_width_ - 1);
+    int y = min((int)Y, plan_height_ - 1);
+    float fx = X - x;
+    float fy = Y - y;
+    // no neighbor past the last column/row, its weight is 0 anyway
+    int right = (x + 1 < plan_width_) ? 1 : 0;
+    int below = (y + 1 < plan_height_) ? stride : 0;
+    int offset = y * stride + x;
+    offsets_.insert(offsets_.end(), {offset, offset + right, offset + below,
+                                     offset + below + right});
+    weights_.insert(weights_.end(), {(1 - fx) * (1 - fy), fx * (1 - fy),
+                                     (1 - fx) * fy, fx * fy});
   }
+}
+
+void InspectorScanner::BuildPlan(int width, int height, int stride) {
+  plan_width_ = width;
+  plan_height_ = height;
+  plan_stride_ = stride;
+  offsets_.clear();
+  weights_.clear();
+  line_starts_.clear();
 
+  int taps = (interpolation_ == kScannerNearest) ? 1 : 4;
+  for (auto& line : lines_) {
+    line_starts_.push_back(offsets_.size() / taps);
+    vector<Point> points;
+    for (auto& p : line) {
+      points.push_back(Point(max(0, min(p.x, width - 1)),
+                             max(0, min(p.y, height - 1))));
+    }
+    AddSegment(points[0], points[0], true, stride);
+    for (size_t i = 1; i < points.size(); i++) {
+      AddSegment(points[i - 1], points[i], false, stride);
+    }
+  }
+  line_starts_.push_back(offsets_.size() / taps);
+  collected_.resize(line_starts_.back());
+  plan_valid_ = true;
+}
+
+const std::vector<float>& InspectorScanner::CollectRange(Mat& frame) {
+  lock_guard<mutex> lock(mutex_);
+  int height = frame.size[1];
+  int width = frame.size[2];
+  int stride = frame.step[1] / sizeof(float);
+  if (!plan_valid_ || width != plan_width_ || height != plan_height_ ||
+      stride != plan_stride_) {
+    BuildPlan(width, height, stride);
+  }
+
+  const float* plane = frame.ptr<float>(channel_);
+  const int* offsets = offsets_.data();
+  float* out = collected_.data();
+  int samples = collected_.size();
+  if (interpolation_ == kScannerNearest) {
+    for (int i = 0; i < samples; i++) {
+      out[i] = plane[offsets[i]];
+    }
+  } else {
+    const float* w = weights_.data();
+    for (int i = 0; i < samples; i++, offsets += 4, w += 4) {
+      out[i] = w[0] * plane[offsets[0]] + w[1] * plane[offsets[1]] +
+               w[2] * plane[offsets[2]] + w[3] * plane[offsets[3]];
+    }
+  }
   return collected_;
 }
 
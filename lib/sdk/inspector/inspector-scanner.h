@@ -21,8 +21,23 @@
 
 #include <sdk/core/pad.h>
 
+#include <mutex>
 #include <vector>
 
+enum ScannerInterpolation {
+  // the pixels a DDA walk goes through
+  kScannerNearest,
+  // one sample per pixel of length, bilinearly interpolated
+  kScannerBilinear
+};
+
+/**
+ * @brief InspectorScanner collects the values along one or more polylines of
+ * each frame. The pixel offsets (and bilinear weights) of all the samples are
+ * computed once, when the lines, the interpolation or the frame size change,
+ * so each frame is a gather into a preallocated buffer.
+ *
+ */
 class InspectorScanner : public PadObserver {
  public:
   InspectorScanner();
@@ -50,6 +65,28 @@ class InspectorScanner : public PadObserver {
    */
   void GetRoi(int& x1, int& y1, int& x2, int& y2);
 
+  /**
+   * @brief Add a polyline to scan. Its vertices are clamped to the frame.
+   *
+   * @param points at least one vertex
+   * @return int index of the line, -1 if points is empty
+   */
+  int AddLine(const vector<Point>& points);
+  void SetLine(int index, const vector<Point>& points);
+  void ClearLines();
+  int GetLineCount();
+
+  void SetInterpolation(ScannerInterpolation interpolation);
+  ScannerInterpolation GetInterpolation();
+
+  /**
+   * @brief Get where each line starts in the collected range: the samples of
+   * line i are [starts[i], starts[i + 1]).
+   *
+   * @return vector<int> GetLineCount() + 1 indexes
+   */
+  vector<int> GetLineStarts();
+
   void OnNewFrame(Mat& frame) override;
 
  protected:
@@ -58,7 +95,8 @@ class InspectorScanner : public PadObserver {
    * OnNewFrame(Mat&). protected for unittesting.
    *
    * @param frame Mat to collect data from
-   * @return std::vector<float>& collected data
+   * @return std::vector<float>& collected data, all the lines one after the
+   * other, the line set by SetRoi() first
    */
   const vector<float>& CollectRange(Mat& frame);
   /**
@@ -78,6 +116,28 @@ class InspectorScanner : public PadObserver {
   vector<float> collected_;
 
  private:
+  /**
+   * @brief Compute the samples of all the lines for a frame size.
+   *
+   * @param width
+   * @param height
+   * @param stride elements between two rows
+   */
+  void BuildPlan(int width, int height, int stride);
+  void AddSegment(Point p0, Point p1, bool first, int stride);
+
+  mutex mutex_;
+  // the line of SetRoi() is the first one
+  vector<vector<Point>> lines_;
+  ScannerInterpolation interpolation_;
+  bool plan_valid_;
+  int plan_width_;
+  int plan_height_;
+  int plan_stride_;
+  // nearest: one offset per sample, bilinear: four offsets and weights
+  vector<int> offsets_;
+  vector<float> weights_;
+  vector<int> line_starts_;
 };
 
 void liang_barsky_clipper(int& x1, int& y1, int& x2, int& y2, int xmin,
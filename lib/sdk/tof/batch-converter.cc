@@ -0,0 +1,397 @@
+#include <fcntl.h>
+#include <sdk/core/base-sink.h>
+#include <sdk/core/packed12.h>
+#include <sdk/tof/batch-converter.h>
+#include <sdk/tof/frame-index.h>
+#include <sdk/tof/playback-src.h>
+#include <sdk/tof/tof-container.h>
+#include <spdlog/sinks/stdout_color_sinks.h>
+#include <spdlog/spdlog.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <thread>
+
+using namespace spdlog;
+
+static logger *logger_ = stdout_color_mt("BatchConverter").get();
+
+// stdio buffer of the chunk result files
+#define BATCH_WRITE_BUFFER_SIZE ((size_t)8 << 20)
+// copy size when stitching without copy_file_range
+#define BATCH_COPY_SIZE ((size_t)8 << 20)
+
+/**
+ * @brief Writes the frames of one chunk pipeline back to back in a file,
+ * synchronously so that no frame is ever dropped.
+ *
+ */
+class BatchSink : public BaseSink {
+ public:
+  BatchSink(const string &name, const string &filename)
+      : BaseSink(name),
+        filename_(filename),
+        file_(nullptr),
+        type_(-1),
+        frames_(0),
+        error_(false) {}
+
+  ~BatchSink() { Close(); }
+
+  bool Open() {
+    file_ = fopen(filename_.c_str(), "wb");
+    if (file_ == nullptr) {
+      logger_->error("Failed to create {}: {}", filename_, strerror(errno));
+      return false;
+    }
+    setvbuf(file_, nullptr, _IOFBF, BATCH_WRITE_BUFFER_SIZE);
+    return true;
+  }
+
+  bool Close() {
+    if (file_ == nullptr) {
+      return !error_;
+    }
+    error_ = (fclose(file_) != 0) || error_;
+    file_ = nullptr;
+    return !error_;
+  }
+
+  void SetFrameFormat(const MatShape &shape, int type) override {
+    shape_ = shape;
+    type_ = type;
+  }
+
+  MatShape shape_;
+  int type_;
+  int frames_;
+  bool error_;
+
+ protected:
+  void SinkFrame(Mat &frame) override {
+    if (file_ == nullptr || error_) return;
+    // zero-copy frames of the mapped recording may have gaps between planes
+    Mat continuous = frame.isContinuous() ? frame : frame.clone();
+    size_t size = continuous.total() * continuous.elemSize();
+    if (fwrite(continuous.data, 1, size, file_) != size) {
+      logger_->error("Failed to write {}: {}", filename_, strerror(errno));
+      error_ = true;
+      return;
+    }
+    frames_++;
+  }
+
+ private:
+  string filename_;
+  FILE *file_;
+};
+
+BatchConverter::BatchConverter()
+    : overlap_(0),
+      workers_(0),
+      chunk_size_(0),
+      next_chunk_(0),
+      frames_processed_(0),
+      cancelled_(false),
+      frames_written_(0) {}
+
+BatchConverter::~BatchConverter() {}
+
+void BatchConverter::SetInput(const string &filename) { input_ = filename; }
+
+void BatchConverter::SetOutput(const string &filename) { output_ = filename; }
+
+void BatchConverter::SetPipeline(BatchPipelineFactory factory) {
+  factory_ = factory;
+}
+
+void BatchConverter::SetOverlap(int frames) { overlap_ = max(0, frames); }
+
+void BatchConverter::SetWorkers(int workers) { workers_ = max(0, workers); }
+
+void BatchConverter::SetChunkSize(int frames) { chunk_size_ = max(0, frames); }
+
+void BatchConverter::Cancel() { cancelled_ = true; }
+
+int BatchConverter::GetFramesProcessed() { return frames_processed_; }
+
+int BatchConverter::GetFramesWritten() { return frames_written_; }
+
+int BatchConverter::PrepareInput() {
+  struct stat st;
+  if (stat(input_.c_str(), &st) != 0) {
+    logger_->error("Failed to open {}: {}", input_, strerror(errno));
+    return -1;
+  }
+
+  PlaybackSource source("batch-input", false, false);
+  source.SetFilename(input_);
+  FrameIndex index;
+  if (!index.Open(FrameIndex::GetFilename(input_), st.st_size)) {
+    // otherwise every chunk of an encoded recording walks the whole file
+    logger_->info("No index for {}, building it", input_);
+    if (!source.BuildIndex()) {
+      logger_->warn("Failed to build index of {}", input_);
+    }
+  }
+
+  if (!source.InitializeSource()) {
+    return -1;
+  }
+  int frames = source.GetFrameCount();
+  source.CleanupSource();
+  return frames;
+}
+
+bool BatchConverter::Run() {
+  cancelled_ = false;
+  frames_processed_ = 0;
+  frames_written_ = 0;
+  chunks_.clear();
+
+  int frames = PrepareInput();
+  if (frames < 0) {
+    return false;
+  }
+  if (frames == 0) {
+    logger_->error("No frame in {}", input_);
+    return false;
+  }
+
+  int workers = workers_;
+  if (workers == 0) {
+    workers = max(1, (int)thread::hardware_concurrency());
+  }
+  int chunkSize = chunk_size_;
+  if (chunkSize == 0) {
+    chunkSize = (frames + workers - 1) / workers;
+  }
+  for (int first = 0; first < frames; first += chunkSize) {
+    Chunk chunk;
+    chunk.first = first;
+    chunk.count = min(chunkSize, frames - first);
+    char suffix[16];
+    snprintf(suffix, sizeof(suffix), "%04d", (int)chunks_.size());
+    chunk.filename = output_ + BATCH_PART_SUFFIX + suffix;
+    chunk.type = -1;
+    chunk.frames = 0;
+    chunk.ok = false;
+    chunks_.push_back(chunk);
+  }
+  workers = min(workers, (int)chunks_.size());
+  logger_->info("Converting {} frames of {} in {} chunks on {} workers",
+                frames, input_, chunks_.size(), workers);
+
+  auto start = chrono::steady_clock::now();
+  next_chunk_ = 0;
+  vector<thread> threads;
+  for (int i = 0; i < workers; i++) {
+    threads.emplace_back(&BatchConverter::WorkLoop, this);
+  }
+  for (auto &t : threads) {
+    t.join();
+  }
+
+  bool ok = !cancelled_;
+  for (auto &chunk : chunks_) {
+    ok = ok && chunk.ok;
+  }
+  ok = ok && Stitch();
+  for (auto &chunk : chunks_) {
+    unlink(chunk.filename.c_str());
+  }
+
+  chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+  if (ok) {
+    logger_->info("Converted {} frames to {} in {:.2f}s, {:.1f} fps",
+                  frames_written_, output_, elapsed.count(),
+                  frames / elapsed.count());
+  } else {
+    logger_->error("Conversion of {} failed", input_);
+  }
+  return ok;
+}
+
+void BatchConverter::WorkLoop() {
+  while (!cancelled_) {
+    int index = next_chunk_++;
+    if (index >= (int)chunks_.size()) {
+      return;
+    }
+    RunChunk(chunks_[index]);
+    if (!chunks_[index].ok) {
+      // the result would have a hole, no point in going on
+      cancelled_ = true;
+    }
+  }
+}
+
+void BatchConverter::RunChunk(Chunk &chunk) {
+  int warmup = min(overlap_, chunk.first);
+  string name = "batch-" + to_string(chunk.first);
+
+  PlaybackSource source(name, false, false);
+  source.SetFilename(input_);
+  source.SetPacing(kPlaybackPacingUnthrottled);
+  source.SetRange(chunk.first - warmup, chunk.count + warmup);
+
+  vector<shared_ptr<Element>> elements;
+  Pad *last = source.GetSourcePad();
+  if (factory_) {
+    last = factory_(source.GetSourcePad(), elements);
+  }
+  BatchSink sink(name + "-sink", chunk.filename);
+  last->Link(sink.GetSinkPad());
+
+  // frames are pulled and pushed on this thread, not the source one
+  bool ok = sink.Open() && source.InitializeSource();
+  if (ok) {
+    int played = 0;
+    while (!cancelled_ && played < chunk.count + warmup) {
+      Mat frame = source.GenerateFrame();
+      if (frame.empty()) {
+        break;
+      }
+      source.GetSourcePad()->PushFrame(frame);
+      played++;
+      frames_processed_++;
+    }
+    source.CleanupSource();
+    ok = (played == chunk.count + warmup);
+  }
+  ok = sink.Close() && ok;
+
+  chunk.shape = sink.shape_;
+  chunk.type = sink.type_;
+  chunk.frames = sink.frames_;
+  chunk.ok = ok;
+  if (!ok && !cancelled_) {
+    logger_->error("Chunk {}+{} failed", chunk.first, chunk.count);
+  }
+
+  // downstream first, pads unlink from peers that are still alive
+  sink.GetSinkPad()->Unlink();
+  while (!elements.empty()) {
+    elements.pop_back();
+  }
+}
+
+/**
+ * @brief Copy a range of a file to the end of another.
+ *
+ */
+static bool CopyRange(int in, off_t offset, size_t size, int out) {
+  // in kernel, even shared extents on filesystems that support it
+  while (size > 0) {
+    ssize_t copied = copy_file_range(in, &offset, out, nullptr, size, 0);
+    if (copied <= 0) {
+      break;
+    }
+    size -= copied;
+  }
+
+  vector<uint8_t> buffer(size > 0 ? BATCH_COPY_SIZE : 0);
+  while (size > 0) {
+    ssize_t got = pread(in, buffer.data(), min(size, buffer.size()), offset);
+    if (got <= 0) {
+      return false;
+    }
+    for (ssize_t done = 0; done < got;) {
+      ssize_t put = write(out, buffer.data() + done, got - done);
+      if (put < 0 && errno != EINTR) {
+        return false;
+      }
+      done += max<ssize_t>(put, 0);
+    }
+    offset += got;
+    size -= got;
+  }
+  return true;
+}
+
+bool BatchConverter::Stitch() {
+  MatShape shape = chunks_[0].shape;
+  int type = chunks_[0].type;
+  ToFStreamHeader header;
+  memset(&header, 0, sizeof(header));
+  header.container_header_size = BATCH_HEADER_SIZE;
+  header.subframe_header_size = 0;
+  header.pixel_size = CV_ELEM_SIZE(type);
+  if (shape.dims() == 3) {
+    header.num_subframes = shape[0];
+    header.frame_height = shape[1];
+    header.frame_width = shape[2];
+  } else if (shape.dims() == 2) {
+    header.num_subframes = 1;
+    header.frame_height = shape[0];
+    header.frame_width = shape[1];
+  }
+  size_t frameSize = header.GetFrameSize();
+  // 3 bytes pixels are read back as packed 12 bits, nothing else may use them
+  if (type < 0 || frameSize == 0 || header.GetType() < 0 ||
+      (header.GetType() == CV_12SP && !Packed12::IsPacked(shape, type))) {
+    logger_->error("Cannot store frames of {} dims and {} bytes pixels",
+                   shape.dims(), header.pixel_size);
+    return false;
+  }
+  for (auto &chunk : chunks_) {
+    if (!(chunk.shape == shape) || chunk.type != type) {
+      logger_->error("Chunk {} has another frame format", chunk.first);
+      return false;
+    }
+  }
+
+  // keep the frame rate of the recording
+  FILE *fp = fopen(input_.c_str(), "rb");
+  if (fp != nullptr) {
+    ToFStreamHeader input;
+    struct stat st;
+    if (fread(&input, sizeof(input), 1, fp) == 1 &&
+        fstat(fileno(fp), &st) == 0 && input.IsValid(st.st_size, true)) {
+      header.framerate_num = input.framerate_num;
+      header.framerate_den = input.framerate_den;
+    }
+    fclose(fp);
+  }
+
+  int out = open(output_.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (out < 0) {
+    logger_->error("Failed to create {}: {}", output_, strerror(errno));
+    return false;
+  }
+  bool ok = (lseek(out, BATCH_HEADER_SIZE, SEEK_SET) == BATCH_HEADER_SIZE);
+
+  for (auto &chunk : chunks_) {
+    if (!ok) break;
+    // results of the overlap frames come first, the chunk owns the last ones
+    int skip = max(0, chunk.frames - chunk.count);
+    if (chunk.first > 0 && chunk.frames < chunk.count) {
+      logger_->warn("Overlap of {} frames is too short for the pipeline",
+                    overlap_);
+    }
+    int in = open(chunk.filename.c_str(), O_RDONLY);
+    if (in < 0) {
+      logger_->error("Failed to open {}: {}", chunk.filename, strerror(errno));
+      ok = false;
+      break;
+    }
+    int frames = chunk.frames - skip;
+    ok = CopyRange(in, (off_t)skip * frameSize, frames * frameSize, out);
+    close(in);
+    frames_written_ += frames;
+  }
+
+  header.num_frames = frames_written_;
+  vector<uint8_t> block(BATCH_HEADER_SIZE, 0);
+  memcpy(block.data(), &header, sizeof(header));
+  ok = ok && (pwrite(out, block.data(), block.size(), 0) ==
+              (ssize_t)block.size());
+  ok = (close(out) == 0) && ok;
+  if (!ok) {
+    logger_->error("Failed to write {}", output_);
+  }
+  return ok;
+}
@@ -0,0 +1,157 @@
+/* Copyright (C) 2023 Deep In Sight
+ * Author: Le Ngoc Linh <lnlinh93@dinsight.ai>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Suite 500,
+ * Boston, MA 02110-1335, USA.
+ */
+#ifndef __BATCH_CONVERTER_H__
+#define __BATCH_CONVERTER_H__
+
+#include <sdk/core/element.h>
+#include <sdk/core/pad.h>
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// stitched result file, a ToF container like RecorderSink writes
+#define BATCH_HEADER_SIZE 4096
+// suffix of the per chunk results, removed once stitched
+#define BATCH_PART_SUFFIX ".part"
+
+/**
+ * @brief Builds the processing elements of one chunk pipeline.
+ *
+ * @param src source pad of the chunk playback source, to link the first
+ * element to
+ * @param elements the built elements, in pipeline order, owned by the caller
+ * @return Pad* source pad of the last element, linked to the chunk sink
+ */
+typedef function<Pad *(Pad *src, vector<shared_ptr<Element>> &elements)>
+    BatchPipelineFactory;
+
+/**
+ * @brief Offline conversion of one recording on all cores. The recording is
+ * split into frame ranges located by the frame index, each processed by an
+ * independent pipeline instance on a worker thread, and their results are
+ * stitched in order into one ToF container.
+ *
+ * Stateful elements like MovingAverage warm up over the overlap frames played
+ * before each chunk, so the stitched result matches a sequential conversion
+ * as long as the overlap covers their history.
+ *
+ */
+class BatchConverter {
+ public:
+  BatchConverter();
+  ~BatchConverter();
+
+  void SetInput(const string &filename);
+  void SetOutput(const string &filename);
+  void SetPipeline(BatchPipelineFactory factory);
+
+  /**
+   * @brief Set the number of frames played before each chunk to warm up
+   * stateful elements, e.g. window size - 1 for a MovingAverage. Their
+   * results are dropped.
+   *
+   * @param frames
+   */
+  void SetOverlap(int frames);
+
+  /**
+   * @brief Set the number of worker threads.
+   *
+   * @param workers 0 for one per core (default)
+   */
+  void SetWorkers(int workers);
+
+  /**
+   * @brief Set the number of frames per chunk. Smaller chunks balance the
+   * load better but play more overlap frames.
+   *
+   * @param frames 0 for one chunk per worker (default)
+   */
+  void SetChunkSize(int frames);
+
+  /**
+   * @brief Convert the recording, blocks until done.
+   *
+   * @return true
+   * @return false on error or if cancelled
+   */
+  bool Run();
+
+  /**
+   * @brief Stop a running conversion, can be called from any thread.
+   *
+   */
+  void Cancel();
+
+  /**
+   * @brief Number of input frames processed so far, overlap frames included.
+   *
+   * @return int
+   */
+  int GetFramesProcessed();
+
+  /**
+   * @brief Number of frames in the result, valid after Run().
+   *
+   * @return int
+   */
+  int GetFramesWritten();
+
+ private:
+  struct Chunk {
+    // first owned frame and number of owned frames
+    int first;
+    int count;
+    string filename;
+    MatShape shape;
+    int type;
+    int frames;
+    bool ok;
+  };
+
+  /**
+   * @brief Make sure the recording has an index, so chunks locate their first
+   * frame without scanning the file.
+   *
+   * @return int number of frames, -1 on error
+   */
+  int PrepareInput();
+  void WorkLoop();
+  void RunChunk(Chunk &chunk);
+  bool Stitch();
+
+  string input_;
+  string output_;
+  BatchPipelineFactory factory_;
+  int overlap_;
+  int workers_;
+  int chunk_size_;
+  vector<Chunk> chunks_;
+  atomic<int> next_chunk_;
+  atomic<int> frames_processed_;
+  atomic<bool> cancelled_;
+  int frames_written_;
+};
+
+#endif  // __BATCH_CONVERTER_H__
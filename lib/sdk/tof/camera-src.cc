@@ -1,14 +1,22 @@
 #include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
 #include <sdk/tof/camera-src.h>
 #include <spdlog/sinks/stdout_color_sinks.h>
 #include <sys/socket.h>
 #include <unistd.h>
 
+#include <cerrno>
+#include <cstring>
+
 using namespace spdlog;
 
 static logger* logger_ = stdout_color_mt("ToFCameraSrc").get();
 
-IPCamera::IPCamera() { socketFd_ = -1; }
+IPCamera::IPCamera() {
+  socketFd_ = -1;
+  timeoutMs_ = 0;
+}
 
 IPCamera::~IPCamera() { Close(); }
 
@@ -26,15 +34,39 @@ bool IPCamera::Open(string host, int port) {
   serverAddr.sin_port = htons(port);
   serverAddr.sin_addr.s_addr = inet_addr(host.c_str());
 
+  // frames in flight are buffered by the kernel while the last one is
+  // processed, before connect so that the window scaling is negotiated
+  int rcvbuf = CAMERA_RCVBUF_SIZE;
+  setsockopt(socketFd_, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+
   if (connect(socketFd_, (struct sockaddr*)&serverAddr, sizeof(serverAddr)) <
       0) {
     logger_->error("Failed to connect to camera");
+    Close();
     return false;
   }
 
+  // requests are tiny, do not hold them back waiting for more to send
+  int nodelay = 1;
+  setsockopt(socketFd_, IPPROTO_TCP, TCP_NODELAY, &nodelay, sizeof(nodelay));
+  SetTimeout(timeoutMs_);
+
   return true;
 }
 
+void IPCamera::SetTimeout(int timeoutMs) {
+  timeoutMs_ = timeoutMs;
+  if (socketFd_ < 0) {
+    return;
+  }
+
+  struct timeval tv;
+  tv.tv_sec = timeoutMs / 1000;
+  tv.tv_usec = (timeoutMs % 1000) * 1000;
+  setsockopt(socketFd_, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+  setsockopt(socketFd_, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+}
+
 bool IPCamera::Close() {
   if (socketFd_ < 0) {
     return false;
@@ -53,8 +85,21 @@ int IPCamera::Read(char* buffer, int size) {
 
   int remain = size;
   while (remain > 0) {
-    int n = read(socketFd_, buffer, remain);
+    // a whole frame in one call, unless interrupted by a signal or a timeout
+    int n = recv(socketFd_, buffer, remain, MSG_WAITALL);
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+      logger_->error("Camera did not answer within {}ms", timeoutMs_);
+      return -1;
+    }
     if (n < 0) {
+      logger_->error("Failed to read from camera: {}", strerror(errno));
+      return -1;
+    }
+    if (n == 0) {
+      logger_->error("Camera closed the connection");
       return -1;
     }
 
@@ -72,8 +117,13 @@ int IPCamera::Write(const char* buffer, int size) {
 
   int remain = size;
   while (remain > 0) {
-    int n = write(socketFd_, buffer, remain);
+    // no SIGPIPE if the camera is gone, just an error
+    int n = send(socketFd_, buffer, remain, MSG_NOSIGNAL);
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
     if (n < 0) {
+      logger_->error("Failed to write to camera: {}", strerror(errno));
       return -1;
     }
 
@@ -85,7 +135,9 @@ int IPCamera::Write(const char* buffer, int size) {
 }
 
 ToFCameraSrc::ToFCameraSrc(const string& name, CameraType type)
-    : BaseSource(name, true) {
+    : BaseSource(name, true),
+      requests_(DEFAULT_CAMERA_REQUESTS),
+      timeoutMs_(DEFAULT_CAMERA_TIMEOUT_MS) {
   name_ = name;
   switch (type) {
     case kIPCamera:
@@ -101,6 +153,21 @@ ToFCameraSrc::~ToFCameraSrc() { delete cameraImpl_; }
 
 void ToFCameraSrc::SetDeviceName(const string& name) { name_ = name; }
 
+void ToFCameraSrc::SetOutstandingRequests(int requests) {
+  logger_->info("Setting outstanding requests to {}", requests);
+  requests_ = max(1, requests);
+  if (requests_ > 1) {
+    logger_->warn("The camera firmware must split NUL terminated requests");
+  }
+}
+
+int ToFCameraSrc::GetOutstandingRequests() { return requests_; }
+
+void ToFCameraSrc::SetTimeout(int timeoutMs) {
+  logger_->info("Setting camera timeout to {}ms", timeoutMs);
+  timeoutMs_ = max(0, timeoutMs);
+}
+
 bool ToFCameraSrc::InitializeSource() {
   // split name into host and port
   size_t pos = name_.find(":");
@@ -113,6 +180,7 @@ bool ToFCameraSrc::InitializeSource() {
     throw std::runtime_error("Invalid camera device name");
   }
 
+  cameraImpl_->SetTimeout(timeoutMs_);
   if (!cameraImpl_->Open(address, port)) {
     throw std::runtime_error("Failed to open camera");
   }
@@ -121,74 +189,74 @@ bool ToFCameraSrc::InitializeSource() {
 
   shape_ = MatShape({4, 480, 640});
   type_ = CV_16SC1;
+  pool_.SetFrameFormat(shape_, type_);
   GetSourcePad()->SetFrameFormat(shape_, type_);
 
+  for (int i = 0; i < requests_; i++) {
+    if (!RequestFrame()) {
+      cameraImpl_->Close();
+      return false;
+    }
+  }
+
   return true;
 };
 
+bool ToFCameraSrc::RequestFrame() {
+  string cmd = "getFrame";
+  // back to back requests are told apart by their terminating NUL, which
+  // the firmware must support, see SetOutstandingRequests
+  int size = (requests_ > 1) ? cmd.size() + 1 : cmd.size();
+  return cameraImpl_->Write(cmd.c_str(), size) == size;
+}
+
 Mat ToFCameraSrc::GenerateFrame() {
-  Mat frame({shape_[0], shape_[1], shape_[2]}, type_);
-  string cmd = "getFrame\0";
-  cameraImpl_->Write(cmd.c_str(), cmd.size());
-  cameraImpl_->Read((char*)frame.data, frame.total() * frame.elemSize());
+  Mat frame = pool_.Acquire();
+  int size = frame.total() * frame.elemSize();
+  if (cameraImpl_->Read((char*)frame.data, size) != size) {
+    // stops the source
+    return Mat();
+  }
+  // keep requests_ frames in flight
+  if (!RequestFrame()) {
+    return Mat();
+  }
   return frame;
 }
 
 void ToFCameraSrc::CleanupSource() { cameraImpl_->Close(); }
 
+const vector<string>& ToFCameraSrc::GetSetupCommands() {
+  static const vector<string> commands = {
+      // set modulation frequency (commented out because camera is locked to
+      // 20MHz)
+      // "changeModFreq 20",
+      // disable range check
+      "w 0x1433 0x00",
+      // set fpga mode
+      "setMode 0",
+      // set output mode
+      "changeOutputMode 0",
+      // set phase delays
+      "w 0x217c 0x0c",
+      "w 0x2184 0x0d",
+      "w 0x2188 0x0d",
+      "w 0x2189 0x13",
+      "w 0x218a 0x18",
+      "w 0x218b 0x1F",
+  };
+  return commands;
+}
+
 void ToFCameraSrc::InitSensor() {
-  string cmd;
   int16_t ack;
 
-  // set modulation frequency (commedted out because camera is locked to 20MHz)
-  // cmd = "changeModFreq 20\0";
-  // cameraImpl_->Write(cmd.c_str(), cmd.size());
-  // cameraImpl_->Read((char*)&ack, sizeof(ack));
-  // if (ack != 0) {
-  //   logger_->error("Failed to set modulation frequency");
-  //   return;
-  // }
-
-  // disable range check
-  cmd = "w 0x1433 0x00\0";
-  cameraImpl_->Write(cmd.c_str(), cmd.size());
-  cameraImpl_->Read((char*)&ack, sizeof(ack));
-
-  // set fpga mode
-  cmd = "setMode 0\0";
-  cameraImpl_->Write(cmd.c_str(), cmd.size());
-  cameraImpl_->Read((char*)&ack, sizeof(ack));
-
-  // set output mode
-  cmd = "changeOutputMode 0\0";
-  cameraImpl_->Write(cmd.c_str(), cmd.size());
-  cameraImpl_->Read((char*)&ack, sizeof(ack));
-
-  // set phase delays
-  cmd = "w 0x217c 0x0c\0";
-  cameraImpl_->Write(cmd.c_str(), cmd.size());
-  cameraImpl_->Read((char*)&ack, sizeof(ack));
-
-  cmd = "w 0x2184 0x0d\0";
-  cameraImpl_->Write(cmd.c_str(), cmd.size());
-  cameraImpl_->Read((char*)&ack, sizeof(ack));
-
-  cmd = "w 0x2188 0x0d\0";
-  cameraImpl_->Write(cmd.c_str(), cmd.size());
-  cameraImpl_->Read((char*)&ack, sizeof(ack));
-
-  cmd = "w 0x2189 0x13\0";
-  cameraImpl_->Write(cmd.c_str(), cmd.size());
-  cameraImpl_->Read((char*)&ack, sizeof(ack));
-
-  cmd = "w 0x218a 0x18\0";
-  cameraImpl_->Write(cmd.c_str(), cmd.size());
-  cameraImpl_->Read((char*)&ack, sizeof(ack));
-
-  cmd = "w 0x218b 0x1F\0";
-  cameraImpl_->Write(cmd.c_str(), cmd.size());
-  cameraImpl_->Read((char*)&ack, sizeof(ack));
+  for (const string& cmd : GetSetupCommands()) {
+    cameraImpl_->Write(cmd.c_str(), cmd.size());
+    cameraImpl_->Read((char*)&ack, sizeof(ack));
+  }
 }
+
 bool ToFCameraSrc::SetFmod(int fmodMHz) { return true; }
 
 bool ToFCameraSrc::SetMode(string mode = "raw") { return true; }
\ No newline at end of file
@@ -20,6 +20,17 @@
 #define __TOF_CAMERA_H__
 
 #include <sdk/core/base-src.h>
+#include <sdk/core/frame-pool.h>
+
+#include <string>
+#include <vector>
+
+// frames requested ahead, 1 is the plain request/response protocol
+#define DEFAULT_CAMERA_REQUESTS 1
+// a frame or an ack not received by then means the link is dead
+#define DEFAULT_CAMERA_TIMEOUT_MS 2000
+// socket receive buffer, room for a few frames in flight
+#define CAMERA_RCVBUF_SIZE (8 << 20)
 
 enum CameraType {
   kIPCamera,
@@ -34,11 +45,28 @@ class IPCamera {
   ~IPCamera();
   bool Open(string host, int port);
   bool Close();
+
+  /**
+   * @brief Set how long Read() and Write() wait for the camera.
+   *
+   * @param timeoutMs 0 to wait forever
+   */
+  void SetTimeout(int timeoutMs);
+
+  /**
+   * @brief Read exactly size bytes.
+   *
+   * @param buffer
+   * @param size
+   * @return int size, -1 on error, timeout or if the camera closed the
+   * connection
+   */
   int Read(char* buffer, int size);
   int Write(const char* buffer, int size);
 
  private:
   int socketFd_;
+  int timeoutMs_;
 };
 
 class ToFCameraSrc : public BaseSource {
@@ -58,17 +86,55 @@ class ToFCameraSrc : public BaseSource {
   Mat GenerateFrame() override;
   void CleanupSource() override;
 
+  /**
+   * @brief Set the number of frames requested ahead. With more than one, the
+   * camera sends the next frame while the last one is received, instead of
+   * idling for a network round trip per frame. Takes effect on next start.
+   *
+   * Firmware requirement: with more than one, requests are sent as
+   * "getFrame\0", NUL terminated, because back to back requests can arrive
+   * in a single read on the camera. The camera must split its input on NUL
+   * and serve each request in order. Only the simulator (tct-camera-sim) is
+   * known to do so, check the firmware before raising it. With 1 (the
+   * default) the baseline "getFrame" framing is unchanged.
+   *
+   * @param requests
+   */
+  void SetOutstandingRequests(int requests);
+  int GetOutstandingRequests();
+
+  /**
+   * @brief Set how long to wait for a frame before giving up, which stops the
+   * source. Takes effect on next start.
+   *
+   * @param timeoutMs 0 to wait forever
+   */
+  void SetTimeout(int timeoutMs);
+
   bool SetFmod(int fmodMHz);
   bool SetMode(string mode);
 
   void InitSensor();
 
+  /**
+   * @brief Commands that set the sensor up, each answered by an int16 ack.
+   *
+   * @return const vector<string>&
+   */
+  static const vector<string>& GetSetupCommands();
+
  private:
+  bool RequestFrame();
+
   string deviceName_;
   IPCamera* cameraImpl_;
   string name_;
   MatShape shape_;
   int type_;
+  int requests_;
+  int timeoutMs_;
+  // frames are received straight into pooled buffers
+  FramePool pool_;
 };
 
 #endif  // __TOF_CAMERA_H__
\ No newline at end of file
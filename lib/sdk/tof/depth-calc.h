@@ -21,6 +21,13 @@
 
 #include <sdk/core/base-transform.h>
 
+#include <vector>
+
+/**
+ * @brief Computes depth and amplitude from 4 phase frames, CV_16SC1 or packed
+ * 12 bits (see Packed12).
+ *
+ */
 class DepthCalc : public BaseTransform {
  public:
   DepthCalc(const string &name = "");
@@ -35,6 +42,10 @@ class DepthCalc : public BaseTransform {
 
   float fmod_;
   float offset_;
+  // set by the frame format, not guessed from the type of each frame
+  bool packed_;
+  // unpacked rows of the 4 phases of packed frames
+  vector<int16_t> scratch_;
 };
 
 #endif  //__DEPTH_CALC_H__
\ No newline at end of file
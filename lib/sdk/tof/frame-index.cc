@@ -0,0 +1,171 @@
+#include <fcntl.h>
+#include <sdk/tof/frame-index.h>
+#include <spdlog/sinks/stdout_color_sinks.h>
+#include <spdlog/spdlog.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
+
+using namespace spdlog;
+
+static logger *logger_ = stdout_color_mt("FrameIndex").get();
+
+#define FRAME_INDEX_MAGIC "TCTFIDX"
+#define FRAME_INDEX_VERSION 2
+// the recording was closed, the index covers all of it
+#define FRAME_INDEX_COMPLETE 0x1
+
+struct FrameIndexHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t entry_size;
+  uint64_t num_entries;
+  // size of the recording when the index was last flushed
+  uint64_t recording_size;
+  uint32_t flags;
+  uint32_t reserved;
+};
+
+FrameIndex::FrameIndex() : entries_(nullptr), size_(0) {}
+
+FrameIndex::~FrameIndex() { Close(); }
+
+bool FrameIndex::Open(const string &filename, size_t recording_size) {
+  Close();
+
+  int fd = open(filename.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return false;
+  }
+
+  struct stat st;
+  if (fstat(fd, &st) != 0 || st.st_size < sizeof(FrameIndexHeader)) {
+    close(fd);
+    return false;
+  }
+
+  size_t length = st.st_size;
+  void *addr = mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (addr == MAP_FAILED) {
+    logger_->warn("Failed to map {}", filename);
+    return false;
+  }
+  shared_ptr<void> storage(addr, [length](void *p) { munmap(p, length); });
+
+  auto header = (const FrameIndexHeader *)addr;
+  // a recording still growing (or cut after the last flush) is indexed up to
+  // recording_size, a smaller one is not the indexed recording. A complete
+  // index only matches a recording of exactly the indexed size, another one
+  // was written over it.
+  bool complete = header->flags & FRAME_INDEX_COMPLETE;
+  if (memcmp(header->magic, FRAME_INDEX_MAGIC, sizeof(header->magic)) != 0 ||
+      header->version != FRAME_INDEX_VERSION ||
+      header->entry_size != sizeof(FrameIndexEntry) ||
+      header->recording_size > recording_size ||
+      (complete && header->recording_size != recording_size)) {
+    logger_->warn("Ignoring stale or corrupted index {}", filename);
+    return false;
+  }
+
+  size_t available =
+      (length - sizeof(FrameIndexHeader)) / sizeof(FrameIndexEntry);
+  storage_ = storage;
+  entries_ = (const FrameIndexEntry *)(header + 1);
+  size_ = min<size_t>(header->num_entries, available);
+  logger_->info("Loaded index {} with {} frames", filename, size_);
+  return true;
+}
+
+void FrameIndex::Close() {
+  storage_.reset();
+  entries_ = nullptr;
+  size_ = 0;
+}
+
+bool FrameIndex::IsOpen() { return entries_ != nullptr; }
+
+int FrameIndex::GetSize() { return size_; }
+
+const FrameIndexEntry &FrameIndex::GetEntry(int index) {
+  return entries_[index];
+}
+
+int FrameIndex::FindFrame(int64_t timestamp_us) {
+  auto it = upper_bound(entries_, entries_ + size_, timestamp_us,
+                        [](int64_t t, const FrameIndexEntry &entry) {
+                          return t < entry.timestamp_us;
+                        });
+  return max<int>(it - entries_ - 1, 0);
+}
+
+string FrameIndex::GetFilename(const string &recording) {
+  return recording + FRAME_INDEX_EXTENSION;
+}
+
+FrameIndexWriter::FrameIndexWriter() : file_(nullptr), num_entries_(0) {}
+
+FrameIndexWriter::~FrameIndexWriter() {
+  if (file_ != nullptr) {
+    fclose(file_);
+  }
+}
+
+bool FrameIndexWriter::Open(const string &filename) {
+  file_ = fopen(filename.c_str(), "wb");
+  if (file_ == nullptr) {
+    logger_->error("Failed to create index {}", filename);
+    return false;
+  }
+  num_entries_ = 0;
+
+  FrameIndexHeader header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, FRAME_INDEX_MAGIC, sizeof(header.magic));
+  header.version = FRAME_INDEX_VERSION;
+  header.entry_size = sizeof(FrameIndexEntry);
+  return fwrite(&header, sizeof(header), 1, file_) == 1;
+}
+
+bool FrameIndexWriter::Append(const FrameIndexEntry &entry) {
+  if (file_ == nullptr || fwrite(&entry, sizeof(entry), 1, file_) != 1) {
+    return false;
+  }
+  num_entries_++;
+  return true;
+}
+
+bool FrameIndexWriter::Flush(size_t recording_size) {
+  return WriteHeader(recording_size, 0);
+}
+
+bool FrameIndexWriter::WriteHeader(size_t recording_size, uint32_t flags) {
+  if (file_ == nullptr || fflush(file_) != 0) {
+    return false;
+  }
+
+  // entries first, then the header that makes them visible
+  FrameIndexHeader header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, FRAME_INDEX_MAGIC, sizeof(header.magic));
+  header.version = FRAME_INDEX_VERSION;
+  header.entry_size = sizeof(FrameIndexEntry);
+  header.num_entries = num_entries_;
+  header.recording_size = recording_size;
+  header.flags = flags;
+  return pwrite(fileno(file_), &header, sizeof(header), 0) == sizeof(header);
+}
+
+bool FrameIndexWriter::Close(size_t recording_size) {
+  bool ok = WriteHeader(recording_size, FRAME_INDEX_COMPLETE);
+  if (file_ != nullptr) {
+    ok = (fclose(file_) == 0) && ok;
+    file_ = nullptr;
+  }
+  return ok;
+}
+
+bool FrameIndexWriter::IsOpen() { return file_ != nullptr; }
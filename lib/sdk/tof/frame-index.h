@@ -0,0 +1,144 @@
+/* Copyright (C) 2023 Deep In Sight
+ * Author: Le Ngoc Linh <lnlinh93@dinsight.ai>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Suite 500,
+ * Boston, MA 02110-1335, USA.
+ */
+#ifndef __FRAME_INDEX_H__
+#define __FRAME_INDEX_H__
+
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+
+using namespace std;
+
+#define FRAME_INDEX_EXTENSION ".idx"
+
+// the entry carries min/max/mean of the first plane
+#define FRAME_INDEX_HAS_STATS 0x1
+// the timestamp was captured, not derived from the frame rate
+#define FRAME_INDEX_HAS_TIMESTAMP 0x2
+
+/**
+ * @brief Location and summary of one frame of a recording.
+ *
+ */
+struct FrameIndexEntry {
+  // byte offset of the frame in the recording, its headers included
+  uint64_t offset;
+  // capture time relative to the first frame
+  int64_t timestamp_us;
+  uint32_t sequence;
+  uint32_t flags;
+  float min;
+  float max;
+  float mean;
+  uint32_t reserved;
+};
+
+/**
+ * @brief Sidecar index of a recording (<recording>.idx), memory mapped so that
+ * any frame of a huge recording is located in O(1) by number, and in
+ * O(log n) by time.
+ *
+ */
+class FrameIndex {
+ public:
+  FrameIndex();
+  ~FrameIndex();
+
+  /**
+   * @brief Map an index file.
+   *
+   * @param filename
+   * @param recording_size size of the indexed recording. A closed index built
+   * for a file of another size, or a flushed one built for a larger file, is
+   * stale and rejected
+   * @return true
+   * @return false
+   */
+  bool Open(const string &filename, size_t recording_size);
+  void Close();
+  bool IsOpen();
+
+  int GetSize();
+  const FrameIndexEntry &GetEntry(int index);
+
+  /**
+   * @brief Find the frame displayed at a given time, that is the last frame
+   * captured at or before it.
+   *
+   * @param timestamp_us
+   * @return int 0 if the time is before the first frame
+   */
+  int FindFrame(int64_t timestamp_us);
+
+  /**
+   * @brief Get the sidecar index filename of a recording.
+   *
+   */
+  static string GetFilename(const string &recording);
+
+ private:
+  shared_ptr<void> storage_;
+  const FrameIndexEntry *entries_;
+  int size_;
+};
+
+/**
+ * @brief Writes an index file entry by entry, as frames are recorded or
+ * scanned.
+ *
+ */
+class FrameIndexWriter {
+ public:
+  FrameIndexWriter();
+  ~FrameIndexWriter();
+
+  bool Open(const string &filename);
+
+  bool Append(const FrameIndexEntry &entry);
+
+  /**
+   * @brief Write entries buffered so far and update the header, so that the
+   * index is usable while the recording still grows.
+   *
+   * @param recording_size size of the recording covered by the entries
+   * @return true
+   * @return false
+   */
+  bool Flush(size_t recording_size);
+
+  /**
+   * @brief Flush and close, marking the index complete: it is only valid for
+   * a recording of exactly recording_size bytes.
+   *
+   * @param recording_size
+   * @return true
+   * @return false
+   */
+  bool Close(size_t recording_size);
+  bool IsOpen();
+
+ private:
+  bool WriteHeader(size_t recording_size, uint32_t flags);
+
+  FILE *file_;
+  uint64_t num_entries_;
+};
+
+#endif  // __FRAME_INDEX_H__
@@ -0,0 +1,490 @@
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sdk/core/pad.h>
+#include <sdk/tof/camera-src.h>
+#include <sdk/tof/multi-camera-src.h>
+#include <spdlog/sinks/stdout_color_sinks.h>
+#include <spdlog/spdlog.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+using namespace spdlog;
+
+static logger *logger_ = stdout_color_mt("MultiCameraSource").get();
+
+#define MULTI_CAMERA_MAX_EVENTS 64
+// how often timeouts and reconnections are checked
+#define MULTI_CAMERA_TICK_MS 100
+
+MultiCameraSource::MultiCameraSource(const string &name)
+    : Element(name),
+      requests_(DEFAULT_CAMERA_REQUESTS),
+      timeout_ms_(DEFAULT_CAMERA_TIMEOUT_MS),
+      dispatch_threads_(0),
+      epoll_fd_(-1),
+      wake_fd_(-1),
+      state_(kStreamStateStopped),
+      thread_(nullptr),
+      dispatching_(false),
+      shape_({4, 480, 640}),
+      type_(CV_16SC1) {}
+
+MultiCameraSource::~MultiCameraSource() {
+  if (state_ != kStreamStateStopped) {
+    Stop();
+  }
+  for (auto &camera : cameras_) {
+    delete camera->pad;
+  }
+}
+
+int MultiCameraSource::AddCamera(const string &address) {
+  if (state_ != kStreamStateStopped) {
+    logger_->error("Stop the source before adding cameras");
+    return -1;
+  }
+  size_t pos = address.find(":");
+  if (pos == string::npos) {
+    logger_->error("Invalid camera address {}", address);
+    return -1;
+  }
+  string host = address.substr(0, pos);
+  int port = atoi(address.substr(pos + 1).c_str());
+  if (inet_addr(host.c_str()) == INADDR_NONE || port <= 0) {
+    logger_->error("Invalid camera address {}", address);
+    return -1;
+  }
+
+  int index = cameras_.size();
+  unique_ptr<Camera> camera(new Camera());
+  camera->address = address;
+  camera->host = host;
+  camera->port = port;
+  camera->pad = new Pad(kPadSource, "cam" + to_string(index));
+  camera->fd = -1;
+  camera->state = kCameraDisconnected;
+  camera->busy = false;
+  camera->frames = 0;
+  camera->dropped = 0;
+  AddPad(camera->pad);
+  cameras_.push_back(move(camera));
+  logger_->info("Added camera {} at {}", index, address);
+  return index;
+}
+
+int MultiCameraSource::GetCameraCount() { return cameras_.size(); }
+
+Pad *MultiCameraSource::GetSourcePad(int camera) {
+  if (camera < 0 || camera >= (int)cameras_.size()) {
+    return nullptr;
+  }
+  return cameras_[camera]->pad;
+}
+
+void MultiCameraSource::SetOutstandingRequests(int requests) {
+  logger_->info("Setting outstanding requests to {}", requests);
+  requests_ = max(1, requests);
+  if (requests_ > 1) {
+    logger_->warn("The camera firmware must split NUL terminated requests");
+  }
+}
+
+void MultiCameraSource::SetTimeout(int timeoutMs) {
+  logger_->info("Setting camera timeout to {}ms", timeoutMs);
+  timeout_ms_ = max(0, timeoutMs);
+}
+
+void MultiCameraSource::SetDispatchThreads(int threads) {
+  dispatch_threads_ = max(0, threads);
+}
+
+StreamState MultiCameraSource::GetState() { return state_; }
+
+CameraConnectionState MultiCameraSource::GetConnectionState(int camera) {
+  return cameras_[camera]->state;
+}
+
+uint64_t MultiCameraSource::GetFramesReceived(int camera) {
+  return cameras_[camera]->frames;
+}
+
+uint64_t MultiCameraSource::GetFramesDropped(int camera) {
+  return cameras_[camera]->dropped;
+}
+
+void MultiCameraSource::PushFrame(Mat &frame) {}
+
+bool MultiCameraSource::Start() {
+  if (state_ != kStreamStateStopped) {
+    logger_->warn("Source is already started.");
+    return false;
+  }
+  if (cameras_.empty()) {
+    logger_->error("No camera to start");
+    return false;
+  }
+
+  epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+  wake_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (epoll_fd_ < 0 || wake_fd_ < 0) {
+    logger_->error("Failed to create epoll: {}", strerror(errno));
+    if (epoll_fd_ >= 0) close(epoll_fd_);
+    if (wake_fd_ >= 0) close(wake_fd_);
+    epoll_fd_ = wake_fd_ = -1;
+    return false;
+  }
+  struct epoll_event event;
+  memset(&event, 0, sizeof(event));
+  event.events = EPOLLIN;
+  event.data.ptr = nullptr;
+  epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, wake_fd_, &event);
+
+  auto now = chrono::steady_clock::now();
+  for (auto &camera : cameras_) {
+    camera->state = kCameraDisconnected;
+    camera->retry_at = now;
+    camera->frames = 0;
+    camera->dropped = 0;
+    camera->pool.SetFrameFormat(shape_, type_);
+    camera->pad->SetFrameFormat(shape_, type_);
+    camera->pad->PushState(kStreamStatePlaying);
+  }
+
+  int threads = dispatch_threads_;
+  if (threads == 0) {
+    threads = min((int)cameras_.size(),
+                  max(1, (int)thread::hardware_concurrency()));
+  }
+  dispatching_ = true;
+  for (int i = 0; i < threads; i++) {
+    dispatchers_.emplace_back(&MultiCameraSource::DispatchLoop, this);
+  }
+
+  state_ = kStreamStatePlaying;
+  thread_ = new thread(&MultiCameraSource::Loop, this);
+  logger_->info("Streaming {} cameras, {} dispatch threads", cameras_.size(),
+                threads);
+  return true;
+}
+
+bool MultiCameraSource::Stop() {
+  if (state_ == kStreamStateStopped) {
+    logger_->warn("Source is already stopped.");
+    return false;
+  }
+
+  state_ = kStreamStateStopped;
+  uint64_t one = 1;
+  write(wake_fd_, &one, sizeof(one));
+  thread_->join();
+  delete thread_;
+  thread_ = nullptr;
+
+  {
+    lock_guard<mutex> lock(dispatch_mutex_);
+    dispatching_ = false;
+  }
+  dispatch_condvar_.notify_all();
+  for (auto &dispatcher : dispatchers_) {
+    dispatcher.join();
+  }
+  dispatchers_.clear();
+  runnable_.clear();
+  for (auto &camera : cameras_) {
+    camera->ready.clear();
+    camera->busy = false;
+    camera->pad->PushState(kStreamStateStopped);
+  }
+
+  close(epoll_fd_);
+  close(wake_fd_);
+  epoll_fd_ = wake_fd_ = -1;
+  return true;
+}
+
+void MultiCameraSource::Loop() {
+  struct epoll_event events[MULTI_CAMERA_MAX_EVENTS];
+
+  while (state_ != kStreamStateStopped) {
+    auto now = chrono::steady_clock::now();
+    for (auto &camera : cameras_) {
+      if (camera->state == kCameraDisconnected) {
+        if (now >= camera->retry_at) Connect(*camera);
+      } else if (timeout_ms_ > 0 &&
+                 now - camera->last_activity >
+                     chrono::milliseconds(timeout_ms_)) {
+        Disconnect(*camera, "did not answer in time");
+      }
+    }
+
+    int n = epoll_wait(epoll_fd_, events, MULTI_CAMERA_MAX_EVENTS,
+                       MULTI_CAMERA_TICK_MS);
+    if (n < 0 && errno != EINTR) {
+      logger_->error("epoll_wait failed: {}", strerror(errno));
+      break;
+    }
+    for (int i = 0; i < n; i++) {
+      if (events[i].data.ptr == nullptr) {
+        uint64_t value;
+        read(wake_fd_, &value, sizeof(value));
+        continue;
+      }
+      Camera &camera = *(Camera *)events[i].data.ptr;
+      // disconnected by an earlier event of this batch
+      if (camera.fd < 0) continue;
+      if (events[i].events & EPOLLOUT) {
+        OnWritable(camera);
+      }
+      if (camera.fd >= 0 &&
+          (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR))) {
+        OnReadable(camera);
+      }
+    }
+  }
+
+  for (auto &camera : cameras_) {
+    if (camera->fd >= 0) {
+      close(camera->fd);
+      camera->fd = -1;
+    }
+    camera->state = kCameraDisconnected;
+    camera->frame.release();
+  }
+}
+
+void MultiCameraSource::Connect(Camera &camera) {
+  camera.fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  if (camera.fd < 0) {
+    Disconnect(camera, strerror(errno));
+    return;
+  }
+  int rcvbuf = CAMERA_RCVBUF_SIZE;
+  setsockopt(camera.fd, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+
+  camera.state = kCameraConnecting;
+  camera.last_activity = chrono::steady_clock::now();
+  camera.command = 0;
+  camera.ack_received = 0;
+  camera.received = 0;
+  camera.out.clear();
+  camera.frame.release();
+
+  struct sockaddr_in addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(camera.port);
+  addr.sin_addr.s_addr = inet_addr(camera.host.c_str());
+  if (connect(camera.fd, (struct sockaddr *)&addr, sizeof(addr)) < 0 &&
+      errno != EINPROGRESS) {
+    Disconnect(camera, strerror(errno));
+    return;
+  }
+
+  // writable once connected
+  struct epoll_event event;
+  memset(&event, 0, sizeof(event));
+  event.events = EPOLLIN | EPOLLOUT;
+  event.data.ptr = &camera;
+  epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, camera.fd, &event);
+}
+
+void MultiCameraSource::Disconnect(Camera &camera, const string &reason) {
+  if (camera.fd >= 0) {
+    epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, camera.fd, nullptr);
+    close(camera.fd);
+    camera.fd = -1;
+  }
+  // a partly received frame is lost
+  camera.frame.release();
+  camera.out.clear();
+  camera.state = kCameraDisconnected;
+  camera.retry_at = chrono::steady_clock::now() +
+                    chrono::milliseconds(DEFAULT_MULTI_CAMERA_RECONNECT_MS);
+  logger_->warn("Camera {}: {}, reconnecting in {}ms", camera.address, reason,
+                DEFAULT_MULTI_CAMERA_RECONNECT_MS);
+}
+
+void MultiCameraSource::UpdateEvents(Camera &camera) {
+  struct epoll_event event;
+  memset(&event, 0, sizeof(event));
+  event.events = EPOLLIN;
+  if (!camera.out.empty() || camera.state == kCameraConnecting) {
+    event.events |= EPOLLOUT;
+  }
+  event.data.ptr = &camera;
+  epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, camera.fd, &event);
+}
+
+bool MultiCameraSource::Send(Camera &camera, const string &data) {
+  bool pending = !camera.out.empty();
+  camera.out += data;
+  while (!camera.out.empty()) {
+    ssize_t n =
+        send(camera.fd, camera.out.data(), camera.out.size(), MSG_NOSIGNAL);
+    if (n < 0 && errno == EINTR) continue;
+    if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+    if (n < 0) {
+      Disconnect(camera, strerror(errno));
+      return false;
+    }
+    camera.out.erase(0, n);
+  }
+  // only watch for writability while there is something left to send
+  if (pending != !camera.out.empty()) UpdateEvents(camera);
+  return true;
+}
+
+void MultiCameraSource::OnWritable(Camera &camera) {
+  if (camera.state != kCameraConnecting) {
+    Send(camera, "");
+    return;
+  }
+
+  int error = 0;
+  socklen_t len = sizeof(error);
+  getsockopt(camera.fd, SOL_SOCKET, SO_ERROR, &error, &len);
+  if (error != 0) {
+    Disconnect(camera, strerror(error));
+    return;
+  }
+  int nodelay = 1;
+  setsockopt(camera.fd, IPPROTO_TCP, TCP_NODELAY, &nodelay, sizeof(nodelay));
+  logger_->info("Camera {} connected", camera.address);
+
+  camera.state = kCameraSetup;
+  camera.last_activity = chrono::steady_clock::now();
+  UpdateEvents(camera);
+  const auto &commands = ToFCameraSrc::GetSetupCommands();
+  Send(camera, commands[0]);
+}
+
+void MultiCameraSource::OnReadable(Camera &camera) {
+  if (camera.state == kCameraConnecting) {
+    // connection refused or reset, reported by SO_ERROR
+    OnWritable(camera);
+    return;
+  }
+
+  while (camera.fd >= 0) {
+    char *buffer;
+    size_t size;
+    if (camera.state == kCameraSetup) {
+      buffer = (char *)&camera.ack + camera.ack_received;
+      size = sizeof(camera.ack) - camera.ack_received;
+    } else {
+      if (camera.frame.empty()) {
+        camera.frame = camera.pool.Acquire();
+        camera.received = 0;
+      }
+      size_t frameSize = camera.frame.total() * camera.frame.elemSize();
+      // straight into the pooled frame, as much as is there
+      buffer = (char *)camera.frame.data + camera.received;
+      size = frameSize - camera.received;
+    }
+
+    ssize_t n = recv(camera.fd, buffer, size, 0);
+    if (n < 0 && errno == EINTR) continue;
+    if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return;
+    if (n < 0) {
+      Disconnect(camera, strerror(errno));
+      return;
+    }
+    if (n == 0) {
+      Disconnect(camera, "closed the connection");
+      return;
+    }
+    camera.last_activity = chrono::steady_clock::now();
+
+    if (camera.state == kCameraSetup) {
+      camera.ack_received += n;
+      if (camera.ack_received < sizeof(camera.ack)) continue;
+      if (camera.ack != 0) {
+        logger_->warn("Camera {} answered {} to \"{}\"", camera.address,
+                      camera.ack,
+                      ToFCameraSrc::GetSetupCommands()[camera.command]);
+      }
+      camera.ack_received = 0;
+      const auto &commands = ToFCameraSrc::GetSetupCommands();
+      if (++camera.command < commands.size()) {
+        Send(camera, commands[camera.command]);
+        continue;
+      }
+
+      camera.state = kCameraStreaming;
+      // back to back requests are told apart by their terminating NUL, which
+      // the firmware must support, see ToFCameraSrc::SetOutstandingRequests
+      string request = "getFrame";
+      if (requests_ > 1) request.push_back('\0');
+      string requests;
+      for (int i = 0; i < requests_; i++) requests += request;
+      Send(camera, requests);
+      continue;
+    }
+
+    camera.received += n;
+    if (camera.received < camera.frame.total() * camera.frame.elemSize()) {
+      continue;
+    }
+    OnFrame(camera);
+    camera.frame.release();
+    string request = "getFrame";
+    if (requests_ > 1) request.push_back('\0');
+    Send(camera, request);
+    // give the other cameras a turn, the rest is read on the next event
+    return;
+  }
+}
+
+void MultiCameraSource::OnFrame(Camera &camera) {
+  camera.frames++;
+  {
+    lock_guard<mutex> lock(dispatch_mutex_);
+    // the pipeline does not keep up, drop the oldest frame
+    if (camera.ready.size() >= MULTI_CAMERA_MAX_PENDING) {
+      camera.ready.pop_front();
+      camera.dropped++;
+    }
+    camera.ready.push_back(camera.frame);
+    if (camera.busy) {
+      return;
+    }
+    camera.busy = true;
+    runnable_.push_back(&camera);
+  }
+  dispatch_condvar_.notify_one();
+}
+
+void MultiCameraSource::DispatchLoop() {
+  unique_lock<mutex> lock(dispatch_mutex_);
+  while (true) {
+    dispatch_condvar_.wait(
+        lock, [this] { return !dispatching_ || !runnable_.empty(); });
+    if (!dispatching_) {
+      return;
+    }
+
+    // frames of a camera are pushed in order, by one thread at a time
+    Camera *camera = runnable_.front();
+    runnable_.pop_front();
+    Mat frame = camera->ready.front();
+    camera->ready.pop_front();
+    lock.unlock();
+    camera->pad->PushFrame(frame);
+    frame.release();
+    lock.lock();
+
+    if (camera->ready.empty()) {
+      camera->busy = false;
+    } else {
+      // behind the other cameras waiting
+      runnable_.push_back(camera);
+    }
+  }
+}
@@ -0,0 +1,160 @@
+/* Copyright (C) 2023 Deep In Sight
+ * Author: Le Ngoc Linh <lnlinh93@dinsight.ai>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Suite 500,
+ * Boston, MA 02110-1335, USA.
+ */
+#ifndef __MULTI_CAMERA_SRC_H__
+#define __MULTI_CAMERA_SRC_H__
+
+#include <sdk/core/element.h>
+#include <sdk/core/frame-pool.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// frames waiting for their pipeline, beyond that the oldest is dropped
+#define MULTI_CAMERA_MAX_PENDING 4
+// delay before reconnecting a camera that failed
+#define DEFAULT_MULTI_CAMERA_RECONNECT_MS 1000
+
+enum CameraConnectionState {
+  kCameraDisconnected,
+  kCameraConnecting,
+  // sending the setup commands, one at a time
+  kCameraSetup,
+  kCameraStreaming
+};
+
+/**
+ * @brief Drives many IP cameras (see ToFCameraSrc) from one epoll loop on
+ * non-blocking sockets, instead of a blocking source thread and a queue thread
+ * per camera. Frames are received into pooled buffers and handed to a small
+ * pool of dispatch threads, which push them on the source pad of their camera
+ * ("cam0", "cam1", ...) in order, one frame of a camera at a time.
+ *
+ */
+class MultiCameraSource : public Element {
+ public:
+  MultiCameraSource(const string &name = "");
+  ~MultiCameraSource();
+
+  /**
+   * @brief Add a camera. Must be stopped.
+   *
+   * @param address "host:port"
+   * @return int index of the camera, -1 if the address is invalid
+   */
+  int AddCamera(const string &address);
+  int GetCameraCount();
+  Pad *GetSourcePad(int camera);
+
+  /**
+   * @brief Frames requested ahead per camera, see
+   * ToFCameraSrc::SetOutstandingRequests, more than one needs a camera
+   * firmware that splits NUL terminated requests. Takes effect on next start.
+   *
+   * @param requests
+   */
+  void SetOutstandingRequests(int requests);
+
+  /**
+   * @brief Set how long a camera may stay silent while frames are requested
+   * before it is reconnected.
+   *
+   * @param timeoutMs
+   */
+  void SetTimeout(int timeoutMs);
+
+  /**
+   * @brief Set the number of dispatch threads running the pipelines.
+   *
+   * @param threads 0 for one per camera up to the number of cores (default)
+   */
+  void SetDispatchThreads(int threads);
+
+  bool Start();
+  bool Stop();
+  StreamState GetState();
+
+  CameraConnectionState GetConnectionState(int camera);
+  uint64_t GetFramesReceived(int camera);
+  uint64_t GetFramesDropped(int camera);
+
+  void PushFrame(Mat &frame) override;
+
+ private:
+  struct Camera {
+    string address;
+    string host;
+    int port;
+    Pad *pad;
+    int fd;
+    atomic<CameraConnectionState> state;
+    // index of the setup command waiting for its ack
+    size_t command;
+    int16_t ack;
+    size_t ack_received;
+    // requests not sent yet, the socket was full
+    string out;
+    // frame being received
+    Mat frame;
+    size_t received;
+    FramePool pool;
+    chrono::steady_clock::time_point last_activity;
+    chrono::steady_clock::time_point retry_at;
+    // dispatch strand, guarded by dispatch_mutex_
+    deque<Mat> ready;
+    bool busy;
+    atomic<uint64_t> frames;
+    atomic<uint64_t> dropped;
+  };
+
+  void Loop();
+  void Connect(Camera &camera);
+  void Disconnect(Camera &camera, const string &reason);
+  void OnWritable(Camera &camera);
+  void OnReadable(Camera &camera);
+  bool Send(Camera &camera, const string &data);
+  void UpdateEvents(Camera &camera);
+  void OnFrame(Camera &camera);
+  void DispatchLoop();
+
+  vector<unique_ptr<Camera>> cameras_;
+  int requests_;
+  int timeout_ms_;
+  int dispatch_threads_;
+  int epoll_fd_;
+  int wake_fd_;
+  atomic<StreamState> state_;
+  thread *thread_;
+  vector<thread> dispatchers_;
+  mutex dispatch_mutex_;
+  condition_variable dispatch_condvar_;
+  // cameras with frames ready and no dispatcher on them
+  deque<Camera *> runnable_;
+  bool dispatching_;
+  MatShape shape_;
+  int type_;
+};
+
+#endif  // __MULTI_CAMERA_SRC_H__
@@ -0,0 +1,84 @@
+#include <sdk/core/pad.h>
+#include <sdk/tof/packer.h>
+#include <spdlog/sinks/stdout_color_sinks.h>
+#include <spdlog/spdlog.h>
+
+using namespace spdlog;
+
+static logger *logger_ = stdout_color_mt("Packer").get();
+
+Packer::Packer(const string &name, PackerMode mode)
+    : BaseTransform(name),
+      mode_(mode),
+      shape_(DEFAULT_MAT_SHAPE),
+      type_(DEFAULT_MAT_TYPE),
+      convert_(false) {}
+
+Packer::~Packer() {}
+
+void Packer::SetMode(PackerMode mode) {
+  logger_->info("Setting packer mode to {}", (int)mode);
+  {
+    lock_guard<mutex> lock(mutex_);
+    mode_ = mode;
+  }
+  PushFrameFormat();
+}
+
+PackerMode Packer::GetMode() { return mode_; }
+
+void Packer::SetFrameFormat(const MatShape &shape, int type) {
+  {
+    lock_guard<mutex> lock(mutex_);
+    shape_ = shape;
+    type_ = type;
+  }
+  PushFrameFormat();
+}
+
+void Packer::PushFrameFormat() {
+  MatShape shape;
+  int type;
+  {
+    lock_guard<mutex> lock(mutex_);
+    bool packed = Packed12::IsPacked(shape_, type_);
+    shape = shape_;
+    type = type_;
+    convert_ = false;
+    if (mode_ == kPackerPack && !packed) {
+      // a packed frame must look packed to the elements downstream
+      if (type_ != CV_16SC1 || shape_.dims() != 3 || shape_[2] % 2 != 0) {
+        logger_->error(
+            "Only 3 dimensions CV_16SC1 frames of even width can be packed");
+      } else {
+        shape = Packed12::GetPackedShape(shape_);
+        type = CV_12SP;
+        convert_ = true;
+      }
+    } else if (mode_ == kPackerUnpack && packed) {
+      shape = Packed12::GetUnpackedShape(shape_);
+      type = CV_16SC1;
+      convert_ = true;
+    }
+    pool_.SetFrameFormat(shape, type);
+  }
+  GetSourcePad()->SetFrameFormat(shape, type);
+}
+
+void Packer::TransformFrame(Mat &frame) {
+  Mat out;
+  {
+    lock_guard<mutex> lock(mutex_);
+    if (!convert_) {
+      out = frame;
+    } else {
+      out = pool_.Acquire();
+      if (mode_ == kPackerPack) {
+        Packed12::Pack(frame, out);
+      } else {
+        Packed12::Unpack(frame, out);
+      }
+    }
+  }
+  GetSourcePad()->PushFrame(out);
+}
@@ -0,0 +1,67 @@
+/* Copyright (C) 2023 Deep In Sight
+ * Author: Le Ngoc Linh <lnlinh93@dinsight.ai>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Suite 500,
+ * Boston, MA 02110-1335, USA.
+ */
+#ifndef __PACKER_H__
+#define __PACKER_H__
+
+#include <sdk/core/base-transform.h>
+#include <sdk/core/frame-pool.h>
+#include <sdk/core/packed12.h>
+
+#include <mutex>
+
+enum PackerMode {
+  // CV_16SC1 to packed 12 bits, 25% less to queue and record
+  kPackerPack,
+  // packed 12 bits to CV_16SC1, for elements that do not read packed frames
+  kPackerUnpack
+};
+
+/**
+ * @brief Converts phase frames between CV_16SC1 and packed 12 bits (see
+ * Packed12). Frames already in the output format pass through.
+ *
+ */
+class Packer : public BaseTransform {
+ public:
+  Packer(const string &name = "", PackerMode mode = kPackerPack);
+  ~Packer();
+
+  /**
+   * @brief Set the conversion, renegotiates the output format.
+   *
+   * @param mode
+   */
+  void SetMode(PackerMode mode);
+  PackerMode GetMode();
+
+  void SetFrameFormat(const MatShape &shape, int type) override;
+
+ private:
+  void TransformFrame(Mat &frame) override;
+  void PushFrameFormat();
+
+  mutex mutex_;
+  PackerMode mode_;
+  MatShape shape_;
+  int type_;
+  bool convert_;
+  FramePool pool_;
+};
+
+#endif  // __PACKER_H__
@@ -0,0 +1,299 @@
+#include <sdk/tof/phase-codec.h>
+
+#include <atomic>
+#include <cstring>
+#include <vector>
+
+#define PHASE_CODEC_MAGIC 0x43485054  // "TPHC"
+
+// worst case: a bit width byte and 16 bits per residual
+static size_t GetMaxRowSize(int cols) {
+  size_t blocks = (cols + PHASE_CODEC_BLOCK_SIZE - 1) / PHASE_CODEC_BLOCK_SIZE;
+  return blocks * (1 + 2 * PHASE_CODEC_BLOCK_SIZE);
+}
+
+static int GetChunkCount(int planes, int rows) {
+  int chunksPerPlane =
+      (rows + PHASE_CODEC_CHUNK_ROWS - 1) / PHASE_CODEC_CHUNK_ROWS;
+  return planes * chunksPerPlane;
+}
+
+template <typename T>
+static inline const T *GetRow(const Mat &frame, int plane, int row) {
+  return (frame.dims == 3) ? frame.ptr<T>(plane, row) : frame.ptr<T>(row);
+}
+
+template <typename T>
+static inline T *GetRow(Mat &frame, int plane, int row) {
+  return (frame.dims == 3) ? frame.ptr<T>(plane, row) : frame.ptr<T>(row);
+}
+
+/**
+ * @brief LOCO-I median edge detector, picks the left or upper neighbour
+ * across an edge and the planar prediction elsewhere.
+ *
+ */
+static inline int Predict(int left, int up, int upLeft) {
+  int hi = max(left, up);
+  int lo = min(left, up);
+  if (upLeft >= hi) return lo;
+  if (upLeft <= lo) return hi;
+  return left + up - upLeft;
+}
+
+template <typename T>
+static inline int PredictPixel(const T *row, const T *up, int c) {
+  if (up == nullptr) {
+    return (c == 0) ? 0 : row[c - 1];
+  }
+  if (c == 0) {
+    return up[0];
+  }
+  return Predict(row[c - 1], up[c], up[c - 1]);
+}
+
+static inline uint8_t *PackBlock(const uint16_t *values, uint8_t *out) {
+  uint16_t all = 0;
+  for (int i = 0; i < PHASE_CODEC_BLOCK_SIZE; i++) all |= values[i];
+  int width = (all == 0) ? 0 : 32 - __builtin_clz(all);
+  *out++ = width;
+
+  uint32_t acc = 0;
+  int bits = 0;
+  for (int i = 0; i < PHASE_CODEC_BLOCK_SIZE; i++) {
+    acc |= (uint32_t)values[i] << bits;
+    bits += width;
+    if (bits >= 16) {
+      uint16_t word = acc;
+      memcpy(out, &word, 2);
+      out += 2;
+      acc >>= 16;
+      bits -= 16;
+    }
+  }
+  // 16 x width bits, always a whole number of 16 bits words
+  return out;
+}
+
+static inline const uint8_t *UnpackBlock(const uint8_t *in, const uint8_t *end,
+                                         uint16_t *values) {
+  if (in >= end) return nullptr;
+  int width = *in++;
+  if (width > 16 || end - in < 2 * width) return nullptr;
+
+  uint32_t mask = (1u << width) - 1;
+  uint32_t acc = 0;
+  int bits = 0;
+  for (int i = 0; i < PHASE_CODEC_BLOCK_SIZE; i++) {
+    if (bits < width) {
+      uint16_t word;
+      memcpy(&word, in, 2);
+      in += 2;
+      acc |= (uint32_t)word << bits;
+      bits += 16;
+    }
+    values[i] = acc & mask;
+    acc >>= width;
+    bits -= width;
+  }
+  return in;
+}
+
+template <typename T>
+static size_t EncodeChunk(const Mat &frame, int plane, int row0, int rows,
+                          int cols, uint8_t *out) {
+  int blocks = (cols + PHASE_CODEC_BLOCK_SIZE - 1) / PHASE_CODEC_BLOCK_SIZE;
+  vector<uint16_t> residuals(blocks * PHASE_CODEC_BLOCK_SIZE, 0);
+  uint8_t *p = out;
+
+  // the first row of a chunk is not predicted from the previous chunk, so
+  // chunks decode independently
+  const T *up = nullptr;
+  for (int r = row0; r < row0 + rows; r++) {
+    const T *row = GetRow<T>(frame, plane, r);
+    for (int c = 0; c < cols; c++) {
+      uint16_t d = (uint16_t)(row[c] - PredictPixel(row, up, c));
+      // zigzag, small negative residuals become small positive values
+      residuals[c] = (uint16_t)((d << 1) ^ (uint16_t)((int16_t)d >> 15));
+    }
+    for (int b = 0; b < blocks; b++) {
+      p = PackBlock(&residuals[b * PHASE_CODEC_BLOCK_SIZE], p);
+    }
+    up = row;
+  }
+  return p - out;
+}
+
+template <typename T>
+static bool DecodeChunk(const uint8_t *in, size_t size, Mat &frame, int plane,
+                        int row0, int rows, int cols) {
+  int blocks = (cols + PHASE_CODEC_BLOCK_SIZE - 1) / PHASE_CODEC_BLOCK_SIZE;
+  vector<uint16_t> residuals(blocks * PHASE_CODEC_BLOCK_SIZE);
+  const uint8_t *end = in + size;
+
+  const T *up = nullptr;
+  for (int r = row0; r < row0 + rows; r++) {
+    for (int b = 0; b < blocks; b++) {
+      in = UnpackBlock(in, end, &residuals[b * PHASE_CODEC_BLOCK_SIZE]);
+      if (in == nullptr) return false;
+    }
+    T *row = GetRow<T>(frame, plane, r);
+    for (int c = 0; c < cols; c++) {
+      uint16_t z = residuals[c];
+      uint16_t d = (z >> 1) ^ (uint16_t)(-(z & 1));
+      row[c] = (T)(uint16_t)(PredictPixel(row, up, c) + d);
+    }
+    up = row;
+  }
+  return in == end;
+}
+
+template <typename T>
+static size_t EncodeFrame(const Mat &frame, int planes, int rows, int cols,
+                          uint8_t *out) {
+  int chunksPerPlane = GetChunkCount(1, rows);
+  int chunks = planes * chunksPerPlane;
+  size_t maxRowSize = GetMaxRowSize(cols);
+  uint8_t *data = out + sizeof(PhaseFrameHeader) + chunks * sizeof(uint32_t);
+
+  // chunks are coded in place at their worst case offset, the worst case
+  // size of the rows before them (the last chunk of a plane may be short),
+  // then packed
+  vector<uint32_t> sizes(chunks);
+  vector<size_t> offsets(chunks);
+  for (int i = 0; i < chunks; i++) {
+    int row0 = (i % chunksPerPlane) * PHASE_CODEC_CHUNK_ROWS;
+    offsets[i] = ((size_t)(i / chunksPerPlane) * rows + row0) * maxRowSize;
+  }
+  parallel_for_(Range(0, chunks), [&](const Range &range) {
+    for (int i = range.start; i < range.end; i++) {
+      int row0 = (i % chunksPerPlane) * PHASE_CODEC_CHUNK_ROWS;
+      int n = min(PHASE_CODEC_CHUNK_ROWS, rows - row0);
+      sizes[i] = EncodeChunk<T>(frame, i / chunksPerPlane, row0, n, cols,
+                                data + offsets[i]);
+    }
+  });
+
+  uint8_t *p = data;
+  for (int i = 0; i < chunks; i++) {
+    memmove(p, data + offsets[i], sizes[i]);
+    p += sizes[i];
+  }
+
+  PhaseFrameHeader header;
+  header.magic = PHASE_CODEC_MAGIC;
+  header.size = p - out;
+  header.planes = planes;
+  header.rows = rows;
+  header.cols = cols;
+  header.chunk_rows = PHASE_CODEC_CHUNK_ROWS;
+  memcpy(out, &header, sizeof(header));
+  memcpy(out + sizeof(header), sizes.data(), chunks * sizeof(uint32_t));
+  return header.size;
+}
+
+template <typename T>
+static bool DecodeFrame(const uint8_t *data, const PhaseFrameHeader &header,
+                        Mat &frame) {
+  int chunksPerPlane =
+      (header.rows + header.chunk_rows - 1) / header.chunk_rows;
+  int chunks = header.planes * chunksPerPlane;
+  const uint8_t *table = data + sizeof(PhaseFrameHeader);
+  size_t available = header.size - sizeof(PhaseFrameHeader) -
+                     chunks * sizeof(uint32_t);
+
+  vector<size_t> offsets(chunks + 1, 0);
+  for (int i = 0; i < chunks; i++) {
+    uint32_t size;
+    memcpy(&size, table + i * sizeof(uint32_t), sizeof(size));
+    offsets[i + 1] = offsets[i] + size;
+  }
+  if (offsets[chunks] != available) {
+    return false;
+  }
+
+  const uint8_t *chunkData = table + chunks * sizeof(uint32_t);
+  atomic<bool> ok(true);
+  parallel_for_(Range(0, chunks), [&](const Range &range) {
+    for (int i = range.start; i < range.end; i++) {
+      int row0 = (i % chunksPerPlane) * header.chunk_rows;
+      int n = min<int>(header.chunk_rows, header.rows - row0);
+      if (!DecodeChunk<T>(chunkData + offsets[i], offsets[i + 1] - offsets[i],
+                          frame, i / chunksPerPlane, row0, n, header.cols)) {
+        ok = false;
+      }
+    }
+  });
+  return ok;
+}
+
+bool PhaseCodec::IsSupported(int type) {
+  return type == CV_16SC1 || type == CV_16UC1;
+}
+
+size_t PhaseCodec::GetMaxEncodedSize(const MatShape &shape) {
+  int planes = (shape.dims() == 3) ? shape[0] : 1;
+  int rows = shape[shape.dims() - 2];
+  int cols = shape[shape.dims() - 1];
+  return sizeof(PhaseFrameHeader) +
+         GetChunkCount(planes, rows) * sizeof(uint32_t) +
+         (size_t)planes * rows * GetMaxRowSize(cols);
+}
+
+size_t PhaseCodec::Encode(const Mat &frame, uint8_t *out, size_t capacity) {
+  if (!IsSupported(frame.type()) || (frame.dims != 2 && frame.dims != 3)) {
+    return 0;
+  }
+  MatShape shape(frame.size);
+  int planes = (frame.dims == 3) ? frame.size[0] : 1;
+  int rows = frame.size[frame.dims - 2];
+  int cols = frame.size[frame.dims - 1];
+  if (planes > UINT16_MAX || rows > UINT16_MAX || cols > UINT16_MAX ||
+      capacity < GetMaxEncodedSize(shape)) {
+    return 0;
+  }
+
+  if (frame.type() == CV_16SC1) {
+    return EncodeFrame<int16_t>(frame, planes, rows, cols, out);
+  }
+  return EncodeFrame<uint16_t>(frame, planes, rows, cols, out);
+}
+
+size_t PhaseCodec::GetEncodedSize(const uint8_t *data, size_t size) {
+  PhaseFrameHeader header;
+  if (size < sizeof(header)) {
+    return 0;
+  }
+  memcpy(&header, data, sizeof(header));
+  if (header.magic != PHASE_CODEC_MAGIC || header.chunk_rows == 0 ||
+      header.planes == 0 || header.rows == 0 || header.cols == 0) {
+    return 0;
+  }
+  int chunks = GetChunkCount(header.planes, header.rows);
+  if (header.chunk_rows != PHASE_CODEC_CHUNK_ROWS ||
+      header.size < sizeof(header) + chunks * sizeof(uint32_t)) {
+    return 0;
+  }
+  return header.size;
+}
+
+bool PhaseCodec::Decode(const uint8_t *data, size_t size, Mat &frame) {
+  size_t encodedSize = GetEncodedSize(data, size);
+  if (encodedSize == 0 || encodedSize > size || !IsSupported(frame.type()) ||
+      (frame.dims != 2 && frame.dims != 3)) {
+    return false;
+  }
+
+  PhaseFrameHeader header;
+  memcpy(&header, data, sizeof(header));
+  int planes = (frame.dims == 3) ? frame.size[0] : 1;
+  if (header.planes != planes || header.rows != frame.size[frame.dims - 2] ||
+      header.cols != frame.size[frame.dims - 1]) {
+    return false;
+  }
+
+  if (frame.type() == CV_16SC1) {
+    return DecodeFrame<int16_t>(data, header, frame);
+  }
+  return DecodeFrame<uint16_t>(data, header, frame);
+}
@@ -0,0 +1,113 @@
+/* Copyright (C) 2023 Deep In Sight
+ * Author: Le Ngoc Linh <lnlinh93@dinsight.ai>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Suite 500,
+ * Boston, MA 02110-1335, USA.
+ */
+#ifndef __PHASE_CODEC_H__
+#define __PHASE_CODEC_H__
+
+#include <sdk/core/pad.h>
+
+#include <cstdint>
+
+// rows of a plane coded independently of the others, the unit of parallelism
+#define PHASE_CODEC_CHUNK_ROWS 32
+// residuals sharing one bit width
+#define PHASE_CODEC_BLOCK_SIZE 16
+
+using namespace std;
+using namespace cv;
+
+/**
+ * @brief Header of an encoded frame, followed by the size of every chunk
+ * (uint32) and the chunks:
+ *
+ *  Frame: | header | chunk sizes | chunk0 | chunk1 | ... | chunkN |
+ *  Chunk: | block0 | block1 | ... | blockM |
+ *  Block: | bit width (1 byte) | 16 residuals of bit width bits |
+ *
+ * Chunks are chunk_rows rows of one plane, blocks do not cross rows.
+ *
+ */
+struct PhaseFrameHeader {
+  uint32_t magic;
+  // encoded size, this header included
+  uint32_t size;
+  uint16_t planes;
+  uint16_t rows;
+  uint16_t cols;
+  uint16_t chunk_rows;
+};
+
+/**
+ * @brief Lossless codec for 16 bits phase frames. Pixels are predicted from
+ * their neighbours (LOCO-I median predictor), residuals are zigzag mapped and
+ * bit-packed in small blocks, which adapts to the noise level of the sensor
+ * across the frame. Chunks are coded and decoded in parallel.
+ *
+ */
+class PhaseCodec {
+ public:
+  /**
+   * @brief Whether frames of a type can be coded, CV_16SC1 and CV_16UC1.
+   *
+   * @param type
+   * @return true
+   * @return false
+   */
+  static bool IsSupported(int type);
+
+  /**
+   * @brief Size of the largest encoded frame of a shape, in bytes.
+   *
+   * @param shape planes x rows x cols, or rows x cols
+   * @return size_t
+   */
+  static size_t GetMaxEncodedSize(const MatShape &shape);
+
+  /**
+   * @brief Encode a frame. Planes do not need to be continuous.
+   *
+   * @param frame
+   * @param out
+   * @param capacity at least GetMaxEncodedSize() bytes
+   * @return size_t encoded size, 0 on error
+   */
+  static size_t Encode(const Mat &frame, uint8_t *out, size_t capacity);
+
+  /**
+   * @brief Get the size of an encoded frame from its header.
+   *
+   * @param data
+   * @param size bytes available at data
+   * @return size_t 0 if data does not start with a valid header
+   */
+  static size_t GetEncodedSize(const uint8_t *data, size_t size);
+
+  /**
+   * @brief Decode a frame.
+   *
+   * @param data
+   * @param size
+   * @param frame allocated by the caller with the shape and type of the
+   * encoded frame
+   * @return true
+   * @return false if the data is corrupted or does not match the frame
+   */
+  static bool Decode(const uint8_t *data, size_t size, Mat &frame);
+};
+
+#endif  // __PHASE_CODEC_H__
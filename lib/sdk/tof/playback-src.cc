@@ -1,6 +1,9 @@
 #include <sdk/tof/playback-src.h>
 #include <spdlog/sinks/stdout_color_sinks.h>
 
+#include <algorithm>
+#include <cstring>
+
 using namespace spdlog;
 
 static logger *logger_ = stdout_color_mt("PlaybackSource").get();
@@ -8,12 +11,27 @@ static logger *logger_ = stdout_color_mt("PlaybackSource").get();
 PlaybackSource::PlaybackSource(const string &name, bool is_async, bool loop)
     : BaseSource(name, is_async),
       loop_(loop),
-      file_(nullptr),
+      range_first_(0),
+      range_count_(-1),
+      container_(kPlaybackContainerAuto),
+      has_header_(false),
+      frame_type_(CV_16SC1),
+      data_offset_(0),
+      frame_stride_(0),
+      plane_stride_(0),
+      plane_offset_(0),
+      codec_(kToFCodecNone),
+      pool_(PLAYBACK_CACHE_SIZE + 2),
+      frame_count_(0),
+      position_(0),
+      last_position_(-1),
+      prefetch_depth_(0),
+      fps_set_(false),
       frame_duration_(1.0f / 30.0f),
+      pacing_(kPlaybackPacingDeadline),
+      recorded_time_(false),
       shape_({4, 480, 640}),
-      type_(CV_16SC1) {
-  last_frame_time_ = chrono::steady_clock::now();
-}
+      type_(CV_16SC1) {}
 
 PlaybackSource::~PlaybackSource() {
   if (GetState() != kStreamStateStopped) {
@@ -26,35 +44,164 @@ void PlaybackSource::SetFilename(const string &filename) {
   filename_ = filename;
 }
 
+bool PlaybackSource::ParseContainer() {
+  has_header_ = false;
+  codec_ = kToFCodecNone;
+  if (container_ != kPlaybackContainerRaw) {
+    memset(&header_, 0, sizeof(header_));
+    ToFCodecHeader codec;
+    memset(&codec, 0, sizeof(codec));
+    has_header_ = file_.Read(0, &header_, sizeof(header_));
+    if (has_header_ && header_.container_header_size >=
+                           sizeof(header_) + sizeof(codec)) {
+      file_.Read(sizeof(header_), &codec, sizeof(codec));
+    }
+    if (codec.magic == TOF_CODEC_MAGIC) {
+      if (codec.codec != kToFCodecPhase) {
+        logger_->error("Unsupported codec {} in {}", codec.codec, filename_);
+        return false;
+      }
+      codec_ = (ToFCodec)codec.codec;
+    }
+    has_header_ = has_header_ &&
+                  header_.IsValid(file_.GetSize(), codec_ != kToFCodecNone);
+    if (!has_header_) codec_ = kToFCodecNone;
+  }
+
+  if (has_header_) {
+    frame_shape_ = header_.GetShape();
+    frame_type_ = header_.GetType();
+    data_offset_ = header_.container_header_size;
+    frame_stride_ = header_.GetFrameSize();
+    plane_stride_ = header_.GetSubframeSize();
+    plane_offset_ = header_.subframe_header_size;
+    logger_->info("ToF container: {}x{}x{}, pixel size {}, {}/{} fps, codec {}",
+                  frame_shape_[0], frame_shape_[1], frame_shape_[2],
+                  header_.pixel_size, header_.framerate_num,
+                  header_.framerate_den, (int)codec_);
+    if (!fps_set_ && header_.framerate_num > 0 && header_.framerate_den > 0) {
+      frame_duration_ = (float)header_.framerate_den / header_.framerate_num;
+    }
+  } else if (container_ == kPlaybackContainerToF) {
+    logger_->error("Invalid ToF container header in {}", filename_);
+    return false;
+  } else {
+    if (shape_.dims() != 3) {
+      logger_->error("Did you forget to set format?");
+      return false;
+    }
+    frame_shape_ = shape_;
+    frame_type_ = type_;
+    data_offset_ = 0;
+    plane_offset_ = 0;
+    plane_stride_ = shape_[1] * shape_[2] * CV_ELEM_SIZE(type_);
+    frame_stride_ = shape_[0] * plane_stride_;
+  }
+
+  frame_offsets_.clear();
+  if (codec_ != kToFCodecNone) {
+    if (!PhaseCodec::IsSupported(frame_type_)) {
+      logger_->error("Encoded frames of type {} are not supported",
+                     frame_type_);
+      return false;
+    }
+    pool_.SetFrameFormat(frame_shape_, frame_type_);
+    if (index_.IsOpen()) {
+      frame_count_ = index_.GetSize();
+    } else {
+      ScanFrames();
+      frame_count_ = frame_offsets_.size();
+    }
+    return true;
+  }
+
+  frame_count_ = (file_.GetSize() - data_offset_) / frame_stride_;
+  if (has_header_ && header_.num_frames != 0 &&
+      header_.num_frames != frame_count_) {
+    logger_->warn("Header says {} frames, file has {}", header_.num_frames,
+                  frame_count_);
+  }
+  return true;
+}
+
 bool PlaybackSource::InitializeSource() {
   logger_->info("Initializing playback source");
 
-  file_ = fopen(filename_.c_str(), "rb");
-  if (file_ == nullptr) {
+  if (!file_.Open(filename_)) {
     logger_->error("Failed to open file {}", filename_);
     return false;
   }
 
-  if (shape_.dims() != 3) {
-    logger_->error("Did you forget to set format?");
+  index_.Close();
+  index_.Open(FrameIndex::GetFilename(filename_), file_.GetSize());
+  if (!ParseContainer()) {
+    index_.Close();
+    file_.Close();
     return false;
   }
+  if (index_.IsOpen()) {
+    frame_count_ = min(frame_count_, index_.GetSize());
+  }
+  recorded_time_ = index_.IsOpen() && index_.GetSize() > 0 &&
+                   (index_.GetEntry(0).flags & FRAME_INDEX_HAS_TIMESTAMP);
+  if (pacing_ == kPlaybackPacingRecorded && !recorded_time_) {
+    logger_->warn("No captured timestamps, pacing frames at {} fps",
+                  1.0 / frame_duration_);
+  }
 
-  // check file size
-  fseek(file_, 0, SEEK_END);
-  long size = ftell(file_);
-  fseek(file_, 0, SEEK_SET);
-  logger_->info("File size: {} bytes", size);
+  position_ = max(0, min(range_first_, frame_count_));
+  last_position_ = -1;
+  pacer_.Resync();
+  cache_.clear();
+  // the prefetch depth or the codec may have changed since the last run
+  prefetcher_.reset();
+  {
+    lock_guard<mutex> lock(mutex_);
+    meta_.frame_index = -1;
+    meta_.subframes.clear();
+  }
+  logger_->info("File size: {} bytes, {} frames", file_.GetSize(),
+                frame_count_);
 
-  GetSourcePad()->SetFrameFormat(shape_, type_);
+  if (codec_ != kToFCodecNone) {
+    // frames have variable sizes, they are decoded from the mapped file
+    if (prefetch_depth_ > 0) {
+      logger_->info("Prefetching is not supported for encoded frames");
+    }
+    if (frame_count_ > 0) file_.WillNeed(GetFrameOffset(0), frame_stride_);
+  } else if (prefetch_depth_ > 0) {
+    // subframe headers are skipped, planes are gathered in one frame
+    // the frames in cache_ are prefetcher frames too
+    prefetcher_.reset(
+        new FramePrefetcher(prefetch_depth_, PLAYBACK_CACHE_SIZE));
+    prefetcher_->SetLoop(loop_);
+    if (!prefetcher_->Open(filename_, data_offset_ + plane_offset_,
+                           frame_stride_, frame_count_, frame_shape_,
+                           frame_type_, frame_shape_[0], plane_stride_)) {
+      prefetcher_.reset();
+      index_.Close();
+      file_.Close();
+      return false;
+    }
+  } else {
+    file_.WillNeed(data_offset_, frame_stride_ * PLAYBACK_READAHEAD_FRAMES);
+  }
+
+  GetSourcePad()->SetFrameFormat(frame_shape_, frame_type_);
   return true;
 }
 
 void PlaybackSource::CleanupSource() {
-  if (file_ != nullptr) {
+  cache_.clear();
+  index_.Close();
+  if (file_.IsOpen()) {
     logger_->info("Cleaning up playback source");
-    fclose(file_);
-    file_ = nullptr;
+    file_.Close();
+  }
+  if (prefetcher_) {
+    logger_->info("Prefetch hits: {}, misses: {}", prefetcher_->GetHits(),
+                  prefetcher_->GetMisses());
+    prefetcher_->Close();
   }
 }
 
@@ -67,48 +214,304 @@ void PlaybackSource::SetFormat(const MatShape &shape, int type) {
 
 void PlaybackSource::SetFrameRate(float fps) {
   logger_->info("Setting playback source fps to {}", fps);
+  fps_set_ = true;
   frame_duration_ = 1.0 / fps;
-  sleep_duration_ms_ = frame_duration_ * 1000;
+  pacer_.Resync();
 }
 
 void PlaybackSource::SetLoop(bool loop) {
   logger_->info("Setting playback source loop to {}", loop);
   loop_ = loop;
+  if (prefetcher_) prefetcher_->SetLoop(loop);
 }
 
-Mat PlaybackSource::GenerateFrame() {
-  Mat frame(shape_.dims(), shape_.p(), type_);
-
-  auto elapsed = (chrono::steady_clock::now() - last_frame_time_);
-  last_frame_time_ = chrono::steady_clock::now();
-  float elapsed_ms =
-      chrono::duration_cast<chrono::milliseconds>(elapsed).count();
-  float frame_duration_ms = frame_duration_ * 1000.0f;
-  float sleep_adjust_ms = elapsed_ms - frame_duration_ms;
-  float sleep_ms = sleep_duration_ms_ - sleep_adjust_ms;
-  if (sleep_ms <= 0) {
-    sleep_ms = 0;
-  } else {
-    std::this_thread::sleep_for(std::chrono::milliseconds((int)sleep_ms));
+void PlaybackSource::SetRange(int first, int count) {
+  logger_->info("Setting playback source range to {}+{}", first, count);
+  range_first_ = max(0, first);
+  range_count_ = count;
+}
+
+void PlaybackSource::SetPacing(PlaybackPacing pacing) {
+  logger_->info("Setting playback source pacing to {}", (int)pacing);
+  pacing_ = pacing;
+  pacer_.Resync();
+  if (pacing == kPlaybackPacingRecorded && file_.IsOpen() && !recorded_time_) {
+    logger_->warn("No captured timestamps, pacing frames at {} fps",
+                  1.0 / frame_duration_);
+  }
+}
+
+PlaybackPacing PlaybackSource::GetPacing() { return pacing_; }
+
+void PlaybackSource::SetContainer(PlaybackContainer container) {
+  logger_->info("Setting playback source container to {}", (int)container);
+  container_ = container;
+}
+
+PlaybackContainer PlaybackSource::GetContainer() { return container_; }
+
+bool PlaybackSource::GetFrameMeta(ToFFrameMeta &meta) {
+  lock_guard<mutex> lock(mutex_);
+  if (meta_.frame_index < 0) {
+    return false;
   }
-  sleep_duration_ms_ = sleep_ms;
+  meta = meta_;
+  return true;
+}
 
-  // logger_->info("Reading frame of shape: {} {}x{}x{} type: {}",
-  // shape_.dims(),
-  // shape_[0], shape_[1], shape_[2], type_);
+bool PlaybackSource::Seek(int frame) {
+  if (!file_.IsOpen() || frame < 0 || frame >= frame_count_) {
+    logger_->warn("Cannot seek to frame {}", frame);
+    return false;
+  }
+  position_ = frame;
+  pacer_.Resync();
+  return true;
+}
 
-  int read = fread(frame.data, 1, frame.total() * frame.elemSize(), file_);
+bool PlaybackSource::SeekTime(double seconds) {
+  if (!file_.IsOpen() || frame_count_ == 0) {
+    logger_->warn("Cannot seek to {}s", seconds);
+    return false;
+  }
 
-  if (read == frame.total() * frame.elemSize()) {
-    // logger_->info("Sending frame");
-    return frame;
-  } else if (loop_) {
-    logger_->info("Reached end of file, looping");
-    fseek(file_, 0, SEEK_SET);
-    fread(frame.data, frame.elemSize(), frame.total(), file_);
-    return frame;
+  int frame;
+  if (index_.IsOpen()) {
+    frame = index_.FindFrame((int64_t)(seconds * 1e6));
   } else {
-    logger_->info("Reached end of file, stopping");
+    frame = (int)(seconds / frame_duration_);
+  }
+  position_ = max(0, min(frame, frame_count_ - 1));
+  pacer_.Resync();
+  return true;
+}
+
+bool PlaybackSource::StepBackward() {
+  int previous = last_position_ - 1;
+  if (GetState() != kStreamStatePaused || previous < 0) {
+    logger_->warn("Cannot step backward");
+    return false;
+  }
+  position_ = previous;
+  return Step();
+}
+
+int PlaybackSource::GetPosition() { return last_position_; }
+
+int PlaybackSource::GetFrameCount() { return frame_count_; }
+
+int64_t PlaybackSource::GetFrameTimestamp(int index) {
+  if (index_.IsOpen()) {
+    return index_.GetEntry(index).timestamp_us;
+  }
+  return (int64_t)(index * frame_duration_ * 1e6);
+}
+
+void PlaybackSource::Pace(int index) {
+  switch (pacing_) {
+    case kPlaybackPacingUnthrottled:
+      return;
+
+    case kPlaybackPacingDeadline:
+      pacer_.WaitDeadline(frame_duration_);
+      return;
+
+    case kPlaybackPacingRecorded:
+      // timestamps derived from the frame rate would only replay it
+      if (recorded_time_) {
+        pacer_.WaitTimestamp(GetFrameTimestamp(index), frame_duration_);
+      } else {
+        pacer_.WaitDeadline(frame_duration_);
+      }
+      return;
+  }
+}
+
+size_t PlaybackSource::GetFrameOffset(int index) {
+  if (index_.IsOpen()) {
+    return index_.GetEntry(index).offset;
+  }
+  if (codec_ != kToFCodecNone) {
+    return frame_offsets_[index];
+  }
+  return data_offset_ + index * frame_stride_;
+}
+
+void PlaybackSource::ScanFrames() {
+  size_t offset = data_offset_;
+  PhaseFrameHeader header;
+  while (file_.Read(offset, &header, sizeof(header))) {
+    size_t size = PhaseCodec::GetEncodedSize((uint8_t *)&header,
+                                             sizeof(header));
+    // the last frame of a recording that was cut short is incomplete
+    if (size == 0 || offset + size > file_.GetSize()) break;
+    frame_offsets_.push_back(offset);
+    offset += size;
+  }
+  logger_->info("Found {} encoded frames", frame_offsets_.size());
+}
+
+Mat PlaybackSource::DecodeFrame(int index) {
+  size_t offset = GetFrameOffset(index);
+  PhaseFrameHeader header;
+  if (!file_.Read(offset, &header, sizeof(header))) {
+    logger_->error("Failed to read frame {}", index);
+    return Mat();
+  }
+  size_t size = PhaseCodec::GetEncodedSize((uint8_t *)&header, sizeof(header));
+  if (size == 0 || offset + size > file_.GetSize()) {
+    logger_->error("Invalid encoded frame {}", index);
     return Mat();
   }
-}
\ No newline at end of file
+
+  Mat encoded = file_.GetFrame(offset, MatShape(1, (int)size), CV_8UC1);
+  Mat frame = pool_.Acquire();
+  if (encoded.empty() || !PhaseCodec::Decode(encoded.data, size, frame)) {
+    logger_->error("Failed to decode frame {}", index);
+    return Mat();
+  }
+  file_.WillNeed(offset + size, size * PLAYBACK_READAHEAD_FRAMES);
+  return frame;
+}
+
+bool PlaybackSource::BuildIndex(bool stats) {
+  if (GetState() != kStreamStateStopped) {
+    logger_->error("Stop the source before building its index");
+    return false;
+  }
+  // encoded frames are located by their headers, not by the old index
+  index_.Close();
+  if (!file_.Open(filename_) || !ParseContainer()) {
+    file_.Close();
+    return false;
+  }
+
+  string filename = FrameIndex::GetFilename(filename_);
+  FrameIndexWriter writer;
+  if (!writer.Open(filename)) {
+    file_.Close();
+    return false;
+  }
+
+  logger_->info("Building index {} of {} frames", filename, frame_count_);
+  MatShape planeShape(frame_shape_[1], frame_shape_[2]);
+  for (int i = 0; i < frame_count_; i++) {
+    FrameIndexEntry entry;
+    memset(&entry, 0, sizeof(entry));
+    entry.offset = GetFrameOffset(i);
+    entry.timestamp_us = (int64_t)(i * frame_duration_ * 1e6);
+    entry.sequence = i;
+
+    if (stats) {
+      Mat plane;
+      if (codec_ != kToFCodecNone) {
+        Mat frame = DecodeFrame(i);
+        if (frame.empty()) break;
+        plane = Mat(frame_shape_[1], frame_shape_[2], frame_type_, frame.ptr());
+      } else {
+        plane = file_.GetFrame(entry.offset + plane_offset_, planeShape,
+                               frame_type_);
+      }
+      double minVal, maxVal;
+      minMaxLoc(plane, &minVal, &maxVal);
+      entry.min = minVal;
+      entry.max = maxVal;
+      entry.mean = mean(plane)[0];
+      entry.flags |= FRAME_INDEX_HAS_STATS;
+    }
+    writer.Append(entry);
+  }
+
+  bool ok = writer.Close(file_.GetSize());
+  file_.Close();
+  return ok;
+}
+
+void PlaybackSource::SetPrefetchDepth(int depth) {
+  logger_->info("Setting playback source prefetch depth to {}", depth);
+  prefetch_depth_ = depth;
+}
+
+uint64_t PlaybackSource::GetPrefetchHits() {
+  return prefetcher_ ? prefetcher_->GetHits() : 0;
+}
+
+uint64_t PlaybackSource::GetPrefetchMisses() {
+  return prefetcher_ ? prefetcher_->GetMisses() : 0;
+}
+
+Mat PlaybackSource::GenerateFrame() {
+  int current = position_;
+  int position = current;
+  int first = min(range_first_, frame_count_);
+  int end = frame_count_;
+  if (range_count_ >= 0) end = min(end, first + range_count_);
+  if (position >= end) {
+    if (loop_ && end > first) {
+      logger_->info("Reached end of file, looping");
+      position = first;
+    } else {
+      logger_->info("Reached end of file, stopping");
+      return Mat();
+    }
+  }
+
+  Pace(position);
+
+  Mat frame;
+  auto cached = find_if(cache_.begin(), cache_.end(),
+                        [position](pair<int, Mat> &p) {
+                          return p.first == position;
+                        });
+  if (cached != cache_.end()) {
+    frame = cached->second;
+    cache_.erase(cached);
+  } else if (codec_ != kToFCodecNone) {
+    frame = DecodeFrame(position);
+  } else if (prefetcher_) {
+    frame = prefetcher_->GetFrame(position);
+  } else {
+    // zero-copy, the frame points to the pixel data in the mapped file. Planes
+    // are not continuous when subframe headers are interleaved.
+    size_t offset = GetFrameOffset(position);
+    size_t steps[] = {plane_stride_,
+                      frame_shape_[2] * CV_ELEM_SIZE(frame_type_)};
+    frame = file_.GetFrame(offset + plane_offset_, frame_shape_, frame_type_,
+                           steps);
+    file_.WillNeed(offset + frame_stride_,
+                   frame_stride_ * PLAYBACK_READAHEAD_FRAMES);
+  }
+
+  if (!frame.empty()) {
+    cache_.emplace_back(position, frame);
+    if (cache_.size() > PLAYBACK_CACHE_SIZE) cache_.pop_front();
+  }
+
+  ReadFrameMeta(position);
+  last_position_ = position;
+  // unless seeked meanwhile
+  position_.compare_exchange_strong(current, position + 1);
+  return frame;
+}
+
+void PlaybackSource::ReadFrameMeta(int index) {
+  lock_guard<mutex> lock(mutex_);
+  // encoded frames start with their codec header, not a subframe header
+  if (!has_header_ || codec_ != kToFCodecNone ||
+      header_.subframe_header_size == 0) {
+    meta_.frame_index = -1;
+    meta_.subframes.clear();
+    return;
+  }
+
+  size_t offset = GetFrameOffset(index);
+  size_t size = min(sizeof(ToFSubframeHeader),
+                    (size_t)header_.subframe_header_size);
+  meta_.frame_index = index;
+  meta_.subframes.resize(header_.num_subframes);
+  for (int i = 0; i < header_.num_subframes; i++) {
+    auto &subframe = meta_.subframes[i];
+    memset(&subframe, 0, sizeof(subframe));
+    file_.Read(offset + i * plane_stride_, &subframe, size);
+  }
+}
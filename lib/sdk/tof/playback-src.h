@@ -20,6 +20,51 @@
 #define __PLAYBACK_SRC_H__
 
 #include <sdk/core/base-src.h>
+#include <sdk/core/frame-pacer.h>
+#include <sdk/core/frame-pool.h>
+#include <sdk/core/frame-prefetcher.h>
+#include <sdk/core/mapped-file.h>
+#include <sdk/tof/frame-index.h>
+#include <sdk/tof/phase-codec.h>
+#include <sdk/tof/tof-container.h>
+
+#include <atomic>
+#include <deque>
+#include <mutex>
+
+// number of frames ahead of the cursor the kernel is asked to read
+#define PLAYBACK_READAHEAD_FRAMES 4
+// number of recently generated frames kept for stepping back and forth
+#define PLAYBACK_CACHE_SIZE 8
+
+/**
+ * @brief Layout of the file to play.
+ *
+ */
+enum PlaybackContainer {
+  // ToF container if the file starts with a valid stream header, else raw
+  kPlaybackContainerAuto,
+  // headerless frames, format set by SetFormat
+  kPlaybackContainerRaw,
+  // stream header and subframe headers, see ToFStreamHeader
+  kPlaybackContainerToF
+};
+
+/**
+ * @brief How generated frames are spaced in time.
+ *
+ */
+enum PlaybackPacing {
+  // as fast as downstream consumes, for offline processing and benchmarks
+  kPlaybackPacingUnthrottled,
+  // one frame every frame duration, on an absolute schedule that does not
+  // drift with processing time
+  kPlaybackPacingDeadline,
+  // frames spaced like they were captured, using the frame index timestamps.
+  // Falls back to deadline pacing when the index has no captured timestamps,
+  // e.g. it was built by BuildIndex rather than written by RecorderSink
+  kPlaybackPacingRecorded
+};
 
 class PlaybackSource : public BaseSource {
  public:
@@ -28,31 +73,206 @@ class PlaybackSource : public BaseSource {
 
   void SetFilename(const string& filename);
   /**
-   * @brief Manually set the format of the source. To be removed later and parse
-   * file header instead.
+   * @brief Set the format of headerless raw files. Files in the ToF container
+   * carry their own format.
    *
    * @param size
    * @param type
    */
   void SetFormat(const MatShape& shape, int type);
 
+  /**
+   * @brief Set the playback frame rate. Overrides the one from the container.
+   *
+   * @param fps
+   */
   void SetFrameRate(float fps);
 
+  void SetPacing(PlaybackPacing pacing);
+  PlaybackPacing GetPacing();
+
+  void SetContainer(PlaybackContainer container);
+  PlaybackContainer GetContainer();
+
+  /**
+   * @brief Get the metadata parsed from the subframe headers of the last
+   * generated frame.
+   *
+   * @param meta
+   * @return true
+   * @return false if the file is not a ToF container, its frames carry no
+   * subframe headers or no frame was generated
+   */
+  bool GetFrameMeta(ToFFrameMeta& meta);
+
   void SetLoop(bool loop);
 
+  /**
+   * @brief Play only frames [first, first + count) of the file, e.g. for one
+   * chunk of a parallel offline conversion. Takes effect on next start.
+   *
+   * @param first
+   * @param count -1 up to the end of the file
+   */
+  void SetRange(int first, int count = -1);
+
+  /**
+   * @brief Move the playback cursor, the next generated frame is the given
+   * one. Can be called while streaming.
+   *
+   * @param frame index of the frame
+   * @return true
+   * @return false if the file is not open or the frame is out of range
+   */
+  bool Seek(int frame);
+
+  /**
+   * @brief Move the playback cursor to the frame displayed at a given time
+   * since the first frame. Uses the capture timestamps of the frame index if
+   * any, else the frame rate.
+   *
+   * @param seconds
+   * @return true
+   * @return false if the file is not open
+   */
+  bool SeekTime(double seconds);
+
+  /**
+   * @brief Like Step(), but generate the frame before the last one.
+   *
+   * @return true
+   * @return false if not paused or already at the first frame
+   */
+  bool StepBackward();
+
+  /**
+   * @brief Get index of the last generated frame, -1 if none.
+   *
+   * @return int
+   */
+  int GetPosition();
+
+  /**
+   * @brief Scan the recording and write its sidecar index
+   * (<filename>.idx), used on next start to locate frames by number or time.
+   * The source must be stopped.
+   *
+   * @param stats also store min/max/mean of the first plane of every frame,
+   * which reads the whole recording
+   * @return true
+   * @return false
+   */
+  bool BuildIndex(bool stats = false);
+
+  /**
+   * @brief Read frames on a dedicated I/O thread, depth frames ahead of the
+   * playback cursor, instead of mapping the file. Better on storage with
+   * unpredictable latency like network filesystems. Takes effect on next
+   * start.
+   *
+   * @param depth number of frames to read ahead, 0 to disable (default)
+   */
+  void SetPrefetchDepth(int depth);
+
+  /**
+   * @brief Number of frames that were prefetched in time.
+   *
+   * @return uint64_t
+   */
+  uint64_t GetPrefetchHits();
+
+  /**
+   * @brief Number of frames the source had to wait for.
+   *
+   * @return uint64_t
+   */
+  uint64_t GetPrefetchMisses();
+
+  /**
+   * @brief Get number of frames in the file. Only valid after the source is
+   * initialized.
+   *
+   * @return int
+   */
+  int GetFrameCount();
+
   bool InitializeSource() override;
   Mat GenerateFrame() override;
   void CleanupSource() override;
 
  private:
+  /**
+   * @brief Read the stream header and set up the frame layout accordingly.
+   *
+   * @return true
+   * @return false if the container is forced and the header is invalid
+   */
+  bool ParseContainer();
+  /**
+   * @brief Locate the frames of an encoded recording without index by
+   * walking their headers.
+   *
+   */
+  void ScanFrames();
+  /**
+   * @brief Decode a frame of an encoded recording.
+   *
+   * @param index
+   * @return Mat empty on error
+   */
+  Mat DecodeFrame(int index);
+  void ReadFrameMeta(int index);
+  size_t GetFrameOffset(int index);
+  int64_t GetFrameTimestamp(int index);
+
+  /**
+   * @brief Sleep until frame index is due.
+   *
+   * @param index
+   */
+  void Pace(int index);
+
   string filename_;
-  FILE* file_;
+  MappedFile file_;
+  PlaybackContainer container_;
+  bool has_header_;
+  ToFStreamHeader header_;
+  // negotiated format
+  MatShape frame_shape_;
+  int frame_type_;
+  // frame layout in the file
+  size_t data_offset_;
+  size_t frame_stride_;
+  size_t plane_stride_;
+  // offset of the pixel data in a subframe, after its header
+  size_t plane_offset_;
+  ToFCodec codec_;
+  // offsets of encoded frames, when there is no index
+  vector<size_t> frame_offsets_;
+  FramePool pool_;
+  int frame_count_;
+  FrameIndex index_;
+  // index of the next frame
+  atomic<int> position_;
+  atomic<int> last_position_;
+  // recently generated frames, most recent last
+  deque<pair<int, Mat>> cache_;
+  int prefetch_depth_;
+  unique_ptr<FramePrefetcher> prefetcher_;
   bool loop_;
+  // played frames, range_count_ < 0 up to the end of the file
+  int range_first_;
+  int range_count_;
   MatShape shape_;
   int type_;
+  bool fps_set_;
   float frame_duration_;
-  float sleep_duration_ms_;
-  chrono::time_point<chrono::steady_clock> last_frame_time_;
+  atomic<PlaybackPacing> pacing_;
+  FramePacer pacer_;
+  // the frame index holds captured timestamps, for recorded pacing
+  atomic<bool> recorded_time_;
+  mutex mutex_;
+  ToFFrameMeta meta_;
 };
 
 #endif  // __PLAYBACK_SRC_H__
\ No newline at end of file
@@ -0,0 +1,492 @@
+#include <fcntl.h>
+#include <sdk/core/packed12.h>
+#include <sdk/core/pad.h>
+#include <sdk/tof/recorder-sink.h>
+#include <spdlog/sinks/stdout_color_sinks.h>
+#include <spdlog/spdlog.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+
+using namespace spdlog;
+
+static logger *logger_ = stdout_color_mt("RecorderSink").get();
+
+RecorderSink::RecorderSink(const string &name)
+    : BaseSink(name),
+      segment_size_(0),
+      direct_(false),
+      codec_(kToFCodecNone),
+      fps_(30.0f),
+      shape_(DEFAULT_MAT_SHAPE),
+      type_(DEFAULT_MAT_TYPE),
+      recording_(false),
+      frame_size_(0),
+      buffer_size_(0),
+      sequence_(0),
+      current_(nullptr),
+      writing_(false),
+      thread_(nullptr),
+      rec_segment_size_(0),
+      rec_codec_(kToFCodecNone),
+      rec_type_(DEFAULT_MAT_TYPE),
+      segment_(0),
+      fd_(-1),
+      fd_direct_(false),
+      offset_(0),
+      allocated_(0),
+      segment_frames_(0),
+      error_(false),
+      frames_written_(0),
+      frames_dropped_(0),
+      bytes_written_(0) {}
+
+RecorderSink::~RecorderSink() { StopRecording(); }
+
+void RecorderSink::SetFilename(const string &filename) {
+  logger_->info("Setting recorder filename to {}", filename);
+  lock_guard<mutex> lock(mutex_);
+  filename_ = filename;
+}
+
+void RecorderSink::SetSegmentSize(size_t size) {
+  logger_->info("Setting recorder segment size to {}", size);
+  lock_guard<mutex> lock(mutex_);
+  segment_size_ = size;
+}
+
+size_t RecorderSink::GetSegmentSize() { return segment_size_; }
+
+void RecorderSink::SetDirectIO(bool direct) {
+  logger_->info("Setting recorder direct I/O to {}", direct);
+  lock_guard<mutex> lock(mutex_);
+  direct_ = direct;
+}
+
+bool RecorderSink::GetDirectIO() { return direct_; }
+
+void RecorderSink::SetCodec(ToFCodec codec) {
+  logger_->info("Setting recorder codec to {}", (int)codec);
+  lock_guard<mutex> lock(mutex_);
+  codec_ = codec;
+}
+
+ToFCodec RecorderSink::GetCodec() { return codec_; }
+
+void RecorderSink::SetFrameRate(float fps) {
+  lock_guard<mutex> lock(mutex_);
+  fps_ = fps;
+}
+
+void RecorderSink::SetFrameFormat(const MatShape &shape, int type) {
+  bool changed;
+  {
+    lock_guard<mutex> lock(mutex_);
+    changed = (shape_ != shape) || (type_ != type);
+    shape_ = shape;
+    type_ = type;
+  }
+  if (changed && recording_) {
+    logger_->warn("Frame format changed, stopping recording");
+    StopRecording();
+  }
+}
+
+string RecorderSink::GetSegmentFilename(int segment) {
+  lock_guard<mutex> lock(mutex_);
+  return GetSegmentFilename(filename_, segment_size_, segment);
+}
+
+string RecorderSink::GetSegmentFilename(const string &filename,
+                                        size_t segment_size, int segment) {
+  if (segment_size == 0) {
+    return filename;
+  }
+
+  char suffix[16];
+  snprintf(suffix, sizeof(suffix), "_%04d", segment);
+  size_t slash = filename.rfind('/');
+  size_t dot = filename.rfind('.');
+  if (dot == string::npos || (slash != string::npos && dot < slash)) {
+    return filename + suffix;
+  }
+  return filename.substr(0, dot) + suffix + filename.substr(dot);
+}
+
+bool RecorderSink::StartRecording() {
+  lock_guard<mutex> sinkLock(sink_mutex_);
+  if (recording_) {
+    logger_->warn("Already recording");
+    return false;
+  }
+
+  MatShape shape;
+  {
+    lock_guard<mutex> lock(mutex_);
+    shape = shape_;
+    memset(&header_, 0, sizeof(header_));
+    header_.container_header_size = RECORDER_HEADER_SIZE;
+    header_.subframe_header_size = 0;
+    header_.framerate_num = (uint32_t)roundf(fps_ * 1000);
+    header_.framerate_den = 1000;
+    header_.pixel_size = CV_ELEM_SIZE(type_);
+    rec_filename_ = filename_;
+    rec_segment_size_ = segment_size_;
+    rec_codec_ = codec_;
+    rec_shape_ = shape_;
+    rec_type_ = type_;
+    fd_direct_ = direct_;
+  }
+
+  if (shape.dims() == 3) {
+    header_.num_subframes = shape[0];
+    header_.frame_height = shape[1];
+    header_.frame_width = shape[2];
+  } else if (shape.dims() == 2) {
+    header_.num_subframes = 1;
+    header_.frame_height = shape[0];
+    header_.frame_width = shape[1];
+  }
+  frame_size_ = header_.GetFrameSize();
+  // 3 bytes pixels are read back as packed 12 bits, nothing else may use them
+  if (frame_size_ == 0 || header_.GetType() < 0 ||
+      (header_.GetType() == CV_12SP && !Packed12::IsPacked(shape, rec_type_))) {
+    logger_->error("Cannot record frames of {} dims and {} bytes pixels",
+                   shape.dims(), header_.pixel_size);
+    return false;
+  }
+  if (rec_codec_ != kToFCodecNone && !PhaseCodec::IsSupported(rec_type_)) {
+    logger_->warn("Cannot encode frames of type {}, recording raw frames",
+                  rec_type_);
+    rec_codec_ = kToFCodecNone;
+  }
+  if (fd_direct_ && rec_codec_ != kToFCodecNone) {
+    logger_->warn("Encoded frames are not aligned, not using O_DIRECT");
+    fd_direct_ = false;
+  }
+  if (fd_direct_ && frame_size_ % RECORDER_ALIGNMENT != 0) {
+    logger_->warn("Frames of {} bytes are not aligned, not using O_DIRECT",
+                  frame_size_);
+    fd_direct_ = false;
+  }
+
+  size_t framesPerBuffer = max<size_t>(1, RECORDER_BUFFER_SIZE / frame_size_);
+  buffer_size_ = framesPerBuffer * frame_size_;
+  buffers_.resize(RECORDER_BUFFER_COUNT);
+  free_.clear();
+  full_.clear();
+  for (auto &buffer : buffers_) {
+    void *data = nullptr;
+    if (posix_memalign(&data, RECORDER_ALIGNMENT, buffer_size_) != 0) {
+      logger_->error("Failed to allocate write buffers");
+      for (auto &b : buffers_) free(b.data);
+      buffers_.clear();
+      return false;
+    }
+    buffer.data = (uint8_t *)data;
+    buffer.used = 0;
+    buffer.frames.clear();
+    buffer.frames.reserve(framesPerBuffer);
+    free_.push_back(&buffer);
+  }
+  if (rec_codec_ != kToFCodecNone) {
+    encoded_.resize(framesPerBuffer * PhaseCodec::GetMaxEncodedSize(shape));
+  }
+
+  segment_ = 0;
+  error_ = false;
+  frames_written_ = 0;
+  frames_dropped_ = 0;
+  bytes_written_ = 0;
+  if (!OpenSegment()) {
+    for (auto &buffer : buffers_) free(buffer.data);
+    buffers_.clear();
+    return false;
+  }
+
+  logger_->info("Recording {} bytes frames to {}", frame_size_, rec_filename_);
+  sequence_ = 0;
+  current_ = nullptr;
+  start_time_ = chrono::steady_clock::now();
+  writing_ = true;
+  thread_ = new thread(&RecorderSink::WriteLoop, this);
+  recording_ = true;
+  return true;
+}
+
+void RecorderSink::StopRecording() {
+  {
+    lock_guard<mutex> sinkLock(sink_mutex_);
+    if (!recording_) {
+      return;
+    }
+    recording_ = false;
+
+    lock_guard<mutex> lock(buffer_mutex_);
+    if (current_ != nullptr) {
+      full_.push_back(current_);
+      current_ = nullptr;
+    }
+    writing_ = false;
+  }
+  buffer_condvar_.notify_one();
+
+  thread_->join();
+  delete thread_;
+  thread_ = nullptr;
+  CloseSegment();
+
+  for (auto &buffer : buffers_) free(buffer.data);
+  buffers_.clear();
+  free_.clear();
+  encoded_.clear();
+  encoded_.shrink_to_fit();
+  logger_->info("Recorded {} frames, {} bytes, dropped {} frames",
+                frames_written_, bytes_written_, frames_dropped_);
+}
+
+bool RecorderSink::IsRecording() { return recording_; }
+
+uint64_t RecorderSink::GetFramesWritten() { return frames_written_; }
+
+uint64_t RecorderSink::GetFramesDropped() { return frames_dropped_; }
+
+uint64_t RecorderSink::GetBytesWritten() { return bytes_written_; }
+
+void RecorderSink::SinkFrame(Mat &frame) {
+  if (!recording_) return;
+
+  lock_guard<mutex> sinkLock(sink_mutex_);
+  if (!recording_) return;
+
+  if (current_ == nullptr) {
+    lock_guard<mutex> lock(buffer_mutex_);
+    if (free_.empty()) {
+      // never block the streaming thread, the disk is too slow
+      if (frames_dropped_++ % 100 == 0) {
+        logger_->warn("Writer is falling behind, {} frames dropped",
+                      frames_dropped_);
+      }
+      return;
+    }
+    current_ = free_.front();
+    free_.pop_front();
+  }
+
+  // planes of zero-copy frames may not be continuous
+  uint8_t *dst = current_->data + current_->used;
+  if (frame.isContinuous()) {
+    memcpy(dst, frame.data, frame_size_);
+  } else {
+    size_t sliceSize = frame_size_ / frame.size[0];
+    for (int i = 0; i < frame.size[0]; i++) {
+      memcpy(dst + i * sliceSize, frame.ptr(i), sliceSize);
+    }
+  }
+
+  auto elapsed = chrono::steady_clock::now() - start_time_;
+  int64_t timestamp =
+      chrono::duration_cast<chrono::microseconds>(elapsed).count();
+  current_->frames.emplace_back(timestamp, sequence_++);
+  current_->used += frame_size_;
+
+  if (current_->used + frame_size_ > buffer_size_) {
+    {
+      lock_guard<mutex> lock(buffer_mutex_);
+      full_.push_back(current_);
+      current_ = nullptr;
+    }
+    buffer_condvar_.notify_one();
+  }
+}
+
+void RecorderSink::WriteLoop() {
+  unique_lock<mutex> lock(buffer_mutex_);
+  while (true) {
+    buffer_condvar_.wait(lock, [this] { return !full_.empty() || !writing_; });
+    if (full_.empty()) break;
+
+    Buffer *buffer = full_.front();
+    full_.pop_front();
+    lock.unlock();
+
+    if (!error_ && !WriteBuffer(buffer)) {
+      logger_->error("Failed to write {}: {}",
+                     GetSegmentFilename(rec_filename_, rec_segment_size_,
+                                        segment_),
+                     strerror(errno));
+      error_ = true;
+    }
+    if (error_) {
+      frames_dropped_ += buffer->frames.size();
+    }
+    buffer->used = 0;
+    buffer->frames.clear();
+
+    lock.lock();
+    free_.push_back(buffer);
+  }
+}
+
+bool RecorderSink::EncodeBuffer(Buffer *buffer) {
+  size_t count = buffer->frames.size();
+  size_t used = 0;
+  for (size_t i = 0; i < count; i++) {
+    Mat frame(rec_shape_.dims(), rec_shape_.p(), rec_type_,
+              buffer->data + i * frame_size_);
+    sizes_[i] = PhaseCodec::Encode(frame, encoded_.data() + used,
+                                   encoded_.size() - used);
+    if (sizes_[i] == 0) {
+      logger_->error("Failed to encode frame {}", buffer->frames[i].second);
+      return false;
+    }
+    used += sizes_[i];
+  }
+  return true;
+}
+
+bool RecorderSink::WriteBuffer(Buffer *buffer) {
+  size_t count = buffer->frames.size();
+  const uint8_t *data = buffer->data;
+  sizes_.assign(count, frame_size_);
+  if (rec_codec_ != kToFCodecNone) {
+    if (!EncodeBuffer(buffer)) return false;
+    data = encoded_.data();
+  }
+
+  // frames [begin, end) are written at the end of the segment, they are
+  // length bytes at data
+  size_t begin = 0;
+  size_t length = 0;
+  auto writeRun = [&](size_t end) {
+    if (end == begin) return true;
+    if (!WriteAt(data, length, offset_)) {
+      return false;
+    }
+
+    for (size_t i = begin; i < end; i++) {
+      FrameIndexEntry entry;
+      memset(&entry, 0, sizeof(entry));
+      entry.offset = offset_;
+      entry.timestamp_us = buffer->frames[i].first;
+      entry.sequence = buffer->frames[i].second;
+      entry.flags = FRAME_INDEX_HAS_TIMESTAMP;
+      index_.Append(entry);
+      offset_ += sizes_[i];
+      // the index on disk only references frames already written
+      if (++segment_frames_ % RECORDER_INDEX_FLUSH_FRAMES == 0) {
+        index_.Flush(offset_);
+      }
+    }
+
+    frames_written_ += end - begin;
+    bytes_written_ += length;
+    data += length;
+    begin = end;
+    length = 0;
+    return true;
+  };
+
+  for (size_t i = 0; i < count; i++) {
+    size_t end = offset_ + length + sizes_[i];
+    if (rec_segment_size_ > 0 && end > rec_segment_size_ &&
+        segment_frames_ + (i - begin) > 0) {
+      if (!writeRun(i) || !CloseSegment()) return false;
+      segment_++;
+      if (!OpenSegment()) return false;
+    }
+    length += sizes_[i];
+  }
+  return writeRun(count);
+}
+
+bool RecorderSink::WriteAt(const uint8_t *data, size_t length, size_t offset) {
+  // grow the file by large steps, keeping its size to what is written so that
+  // a crash leaves a readable recording
+  if (offset + length > allocated_) {
+    size_t size = max(offset + length, allocated_ + RECORDER_PREALLOC_SIZE);
+    if (rec_segment_size_ > 0) {
+      size = min(size, max(rec_segment_size_, offset + length));
+    }
+    if (fallocate(fd_, FALLOC_FL_KEEP_SIZE, allocated_, size - allocated_) ==
+        0) {
+      allocated_ = size;
+    } else {
+      logger_->debug("fallocate not supported, writing without preallocation");
+      allocated_ = SIZE_MAX;
+    }
+  }
+
+  while (length > 0) {
+    ssize_t n = pwrite(fd_, data, length, offset);
+    if (n < 0 && errno == EINTR) continue;
+    if (n <= 0) return false;
+    data += n;
+    length -= n;
+    offset += n;
+  }
+  return true;
+}
+
+bool RecorderSink::WriteHeader(uint32_t num_frames) {
+  // O_DIRECT needs an aligned buffer
+  void *block = nullptr;
+  if (posix_memalign(&block, RECORDER_ALIGNMENT, RECORDER_HEADER_SIZE) != 0) {
+    return false;
+  }
+  memset(block, 0, RECORDER_HEADER_SIZE);
+  ToFStreamHeader header = header_;
+  header.num_frames = num_frames;
+  memcpy(block, &header, sizeof(header));
+  if (rec_codec_ != kToFCodecNone) {
+    ToFCodecHeader codec = {TOF_CODEC_MAGIC, (uint32_t)rec_codec_};
+    memcpy((uint8_t *)block + sizeof(header), &codec, sizeof(codec));
+  }
+
+  bool ok = WriteAt((uint8_t *)block, RECORDER_HEADER_SIZE, 0);
+  free(block);
+  return ok;
+}
+
+bool RecorderSink::OpenSegment() {
+  string filename =
+      GetSegmentFilename(rec_filename_, rec_segment_size_, segment_);
+  int flags = O_WRONLY | O_CREAT | O_TRUNC;
+  fd_ = open(filename.c_str(), flags | (fd_direct_ ? O_DIRECT : 0), 0644);
+  if (fd_ < 0 && fd_direct_ && errno == EINVAL) {
+    logger_->warn("Filesystem does not support O_DIRECT");
+    fd_direct_ = false;
+    fd_ = open(filename.c_str(), flags, 0644);
+  }
+  if (fd_ < 0) {
+    logger_->error("Failed to create {}: {}", filename, strerror(errno));
+    return false;
+  }
+
+  offset_ = RECORDER_HEADER_SIZE;
+  allocated_ = 0;
+  segment_frames_ = 0;
+  // 0 frames in the header while recording, i.e. unknown length
+  if (!WriteHeader(0) || !index_.Open(FrameIndex::GetFilename(filename))) {
+    close(fd_);
+    fd_ = -1;
+    return false;
+  }
+  return true;
+}
+
+bool RecorderSink::CloseSegment() {
+  if (fd_ < 0) {
+    return true;
+  }
+
+  bool ok = WriteHeader(segment_frames_);
+  ok = index_.Close(offset_) && ok;
+  // release preallocated space past the last frame
+  ok = (ftruncate(fd_, offset_) == 0) && ok;
+  ok = (close(fd_) == 0) && ok;
+  fd_ = -1;
+  return ok;
+}
@@ -0,0 +1,219 @@
+/* Copyright (C) 2023 Deep In Sight
+ * Author: Le Ngoc Linh <lnlinh93@dinsight.ai>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Suite 500,
+ * Boston, MA 02110-1335, USA.
+ */
+#ifndef __RECORDER_SINK_H__
+#define __RECORDER_SINK_H__
+
+#include <sdk/core/base-sink.h>
+#include <sdk/tof/frame-index.h>
+#include <sdk/tof/phase-codec.h>
+#include <sdk/tof/tof-container.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// stream header is padded to a block so that frames stay aligned for O_DIRECT
+#define RECORDER_HEADER_SIZE 4096
+#define RECORDER_ALIGNMENT 4096
+// number of write buffers, one being filled while the others are written
+#define RECORDER_BUFFER_COUNT 4
+// target size of a write buffer, holds at least one frame
+#define RECORDER_BUFFER_SIZE ((size_t)8 << 20)
+// files grow by that much at once
+#define RECORDER_PREALLOC_SIZE ((size_t)256 << 20)
+// the index on disk lags at most that many frames behind the recording
+#define RECORDER_INDEX_FLUSH_FRAMES 30
+
+/**
+ * @brief Records incoming frames in the ToF container format, readable by
+ * PlaybackSource and the gstreamer tofparser.
+ *
+ * The streaming thread only copies the frame into a write buffer, a writer
+ * thread does the I/O. When the writer falls behind and all buffers are full,
+ * frames are dropped rather than blocking the pipeline. Files are
+ * preallocated with fallocate, optionally written with O_DIRECT from aligned
+ * buffers, and split in segments, each a standalone container with a rolling
+ * sidecar index (see FrameIndex) flushed as frames land on disk. Frames can
+ * be encoded losslessly on the writer thread (see PhaseCodec).
+ *
+ */
+class RecorderSink : public BaseSink {
+ public:
+  RecorderSink(const string &name = "");
+  ~RecorderSink();
+
+  /**
+   * @brief Set the output file. With segments, "rec.bin" is recorded as
+   * "rec_0000.bin", "rec_0001.bin", ...
+   *
+   * @param filename
+   */
+  void SetFilename(const string &filename);
+
+  /**
+   * @brief Start a new segment when the current one would exceed this size.
+   *
+   * @param size bytes, 0 for a single file (default)
+   */
+  void SetSegmentSize(size_t size);
+  size_t GetSegmentSize();
+
+  /**
+   * @brief Bypass the page cache. Only used when frames are a multiple of
+   * RECORDER_ALIGNMENT bytes, buffered I/O is used otherwise.
+   *
+   * @param direct
+   */
+  void SetDirectIO(bool direct);
+  bool GetDirectIO();
+
+  /**
+   * @brief Encode frames before writing them. Encoded frames have variable
+   * sizes, so O_DIRECT is not used. Frames of types the codec does not
+   * support are recorded raw.
+   *
+   * @param codec kToFCodecNone (default) or kToFCodecPhase
+   */
+  void SetCodec(ToFCodec codec);
+  ToFCodec GetCodec();
+
+  /**
+   * @brief Frame rate written in the stream header.
+   *
+   * @param fps
+   */
+  void SetFrameRate(float fps);
+
+  /**
+   * @brief Start recording the next frames, with the current frame format.
+   *
+   * @return true
+   * @return false if the first segment cannot be created
+   */
+  bool StartRecording();
+
+  /**
+   * @brief Write pending frames and close the files.
+   *
+   */
+  void StopRecording();
+  bool IsRecording();
+
+  uint64_t GetFramesWritten();
+  uint64_t GetFramesDropped();
+  /**
+   * @brief Bytes written to disk, encoded size for encoded frames.
+   *
+   * @return uint64_t
+   */
+  uint64_t GetBytesWritten();
+
+  /**
+   * @brief Get the name of the file of a segment of the current (or next)
+   * recording.
+   *
+   * @param segment
+   * @return string
+   */
+  string GetSegmentFilename(int segment);
+
+  void SetFrameFormat(const MatShape &shape, int type) override;
+
+ protected:
+  void SinkFrame(Mat &frame) override;
+
+ private:
+  struct Buffer {
+    uint8_t *data;
+    size_t used;
+    // timestamp and sequence number of the frames in the buffer
+    vector<pair<int64_t, uint32_t>> frames;
+  };
+
+  static string GetSegmentFilename(const string &filename,
+                                   size_t segment_size, int segment);
+  void WriteLoop();
+  /**
+   * @brief Encode the frames of a buffer into encoded_, their sizes in
+   * sizes_.
+   *
+   */
+  bool EncodeBuffer(Buffer *buffer);
+  bool WriteBuffer(Buffer *buffer);
+  bool WriteAt(const uint8_t *data, size_t length, size_t offset);
+  bool OpenSegment();
+  bool CloseSegment();
+  bool WriteHeader(uint32_t num_frames);
+
+  // config
+  mutex mutex_;
+  string filename_;
+  size_t segment_size_;
+  bool direct_;
+  ToFCodec codec_;
+  float fps_;
+  MatShape shape_;
+  int type_;
+
+  // recording, owned by the streaming thread
+  mutex sink_mutex_;
+  atomic<bool> recording_;
+  size_t frame_size_;
+  size_t buffer_size_;
+  uint32_t sequence_;
+  chrono::steady_clock::time_point start_time_;
+  Buffer *current_;
+
+  // buffers, handed over between the streaming and the writer thread
+  mutex buffer_mutex_;
+  condition_variable buffer_condvar_;
+  vector<Buffer> buffers_;
+  deque<Buffer *> free_;
+  deque<Buffer *> full_;
+  bool writing_;
+  thread *thread_;
+
+  // segment, owned by the writer thread
+  ToFStreamHeader header_;
+  // config snapshot of the current recording
+  string rec_filename_;
+  size_t rec_segment_size_;
+  ToFCodec rec_codec_;
+  MatShape rec_shape_;
+  int rec_type_;
+  vector<uint8_t> encoded_;
+  vector<size_t> sizes_;
+  int segment_;
+  int fd_;
+  bool fd_direct_;
+  size_t offset_;
+  size_t allocated_;
+  uint32_t segment_frames_;
+  FrameIndexWriter index_;
+  bool error_;
+
+  atomic<uint64_t> frames_written_;
+  atomic<uint64_t> frames_dropped_;
+  atomic<uint64_t> bytes_written_;
+};
+
+#endif  // __RECORDER_SINK_H__
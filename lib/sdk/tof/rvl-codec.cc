@@ -0,0 +1,139 @@
+#include <sdk/tof/rvl-codec.h>
+
+#include <cmath>
+#include <cstring>
+
+// 4 bits groups of a 32 bits word, most significant first
+struct NibbleWriter {
+  uint8_t *out;
+  uint32_t word;
+  int nibbles;
+};
+
+struct NibbleReader {
+  const uint8_t *in;
+  const uint8_t *end;
+  uint32_t word;
+  int nibbles;
+};
+
+static inline void WriteValue(NibbleWriter &writer, uint32_t value) {
+  do {
+    uint32_t nibble = value & 0x7;
+    value >>= 3;
+    if (value) nibble |= 0x8;
+    writer.word = (writer.word << 4) | nibble;
+    if (++writer.nibbles == 8) {
+      memcpy(writer.out, &writer.word, 4);
+      writer.out += 4;
+      writer.nibbles = 0;
+      writer.word = 0;
+    }
+  } while (value);
+}
+
+static uint8_t *FlushWriter(NibbleWriter &writer) {
+  if (writer.nibbles > 0) {
+    uint32_t word = writer.word << (4 * (8 - writer.nibbles));
+    memcpy(writer.out, &word, 4);
+    writer.out += 4;
+  }
+  return writer.out;
+}
+
+static inline bool ReadValue(NibbleReader &reader, uint32_t &value) {
+  value = 0;
+  int shift = 0;
+  uint32_t nibble;
+  do {
+    if (reader.nibbles == 0) {
+      if (reader.end - reader.in < 4) return false;
+      memcpy(&reader.word, reader.in, 4);
+      reader.in += 4;
+      reader.nibbles = 8;
+    }
+    nibble = reader.word >> 28;
+    reader.word <<= 4;
+    reader.nibbles--;
+    value |= (nibble & 0x7) << shift;
+    shift += 3;
+    // longer than any value the encoder writes
+    if (shift > 33) return false;
+  } while (nibble & 0x8);
+  return true;
+}
+
+size_t RvlCodec::GetMaxEncodedSize(size_t count) {
+  // at worst 2 nibbles of run lengths and 6 of delta per value
+  return count * 4 + 8;
+}
+
+size_t RvlCodec::Encode(const uint16_t *in, size_t count, uint8_t *out) {
+  NibbleWriter writer = {out, 0, 0};
+  const uint16_t *end = in + count;
+  int previous = 0;
+  while (in != end) {
+    uint32_t zeros = 0;
+    for (; in != end && *in == 0; in++) zeros++;
+    WriteValue(writer, zeros);
+
+    uint32_t nonzeros = 0;
+    for (const uint16_t *p = in; p != end && *p != 0; p++) nonzeros++;
+    WriteValue(writer, nonzeros);
+
+    for (uint32_t i = 0; i < nonzeros; i++) {
+      int current = *in++;
+      int delta = current - previous;
+      WriteValue(writer, ((uint32_t)delta << 1) ^ (uint32_t)(delta >> 31));
+      previous = current;
+    }
+  }
+  return FlushWriter(writer) - out;
+}
+
+bool RvlCodec::Decode(const uint8_t *in, size_t size, uint16_t *out,
+                      size_t count) {
+  NibbleReader reader = {in, in + size, 0, 0};
+  uint16_t *end = out + count;
+  int previous = 0;
+  while (out != end) {
+    uint32_t zeros, nonzeros;
+    if (!ReadValue(reader, zeros) || zeros > (size_t)(end - out)) {
+      return false;
+    }
+    memset(out, 0, zeros * sizeof(uint16_t));
+    out += zeros;
+
+    if (!ReadValue(reader, nonzeros) || nonzeros > (size_t)(end - out)) {
+      return false;
+    }
+    for (uint32_t i = 0; i < nonzeros; i++) {
+      uint32_t positive;
+      if (!ReadValue(reader, positive)) return false;
+      previous += (int)(positive >> 1) ^ -(int)(positive & 1);
+      *out++ = previous;
+    }
+  }
+  return reader.in == reader.end;
+}
+
+void RvlCodec::Quantize(const float *in, size_t count, float scale,
+                        uint16_t *out) {
+  float inverse = 1.0f / scale;
+  for (size_t i = 0; i < count; i++) {
+    float v = in[i] * inverse + 0.5f;
+    // also false for not a number
+    if (!(v >= 1.0f)) {
+      out[i] = 0;
+    } else {
+      out[i] = (v >= 65535.0f) ? 65535 : (uint16_t)v;
+    }
+  }
+}
+
+void RvlCodec::Dequantize(const uint16_t *in, size_t count, float scale,
+                          float *out) {
+  for (size_t i = 0; i < count; i++) {
+    out[i] = in[i] * scale;
+  }
+}
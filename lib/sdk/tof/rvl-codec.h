@@ -0,0 +1,118 @@
+/* Copyright (C) 2023 Deep In Sight
+ * Author: Le Ngoc Linh <lnlinh93@dinsight.ai>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Suite 500,
+ * Boston, MA 02110-1335, USA.
+ */
+#ifndef __RVL_CODEC_H__
+#define __RVL_CODEC_H__
+
+#include <cstddef>
+#include <cstdint>
+
+#define RVL_MAGIC "TCTRVL"
+#define RVL_VERSION 1
+// 1 mm depth units
+#define DEFAULT_RVL_DEPTH_SCALE 0.001f
+#define DEFAULT_RVL_AMPLITUDE_SCALE 1.0f
+
+/**
+ * @brief Depth recording, planes of a frame are quantized to uint16 units
+ * then RVL coded:
+ *
+ *  File:  | file header | frame0 | frame1 | ... | frameN |
+ *  Frame: | frame header | depth plane | amplitude plane |
+ *
+ */
+struct RvlFileHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t width;
+  uint32_t height;
+  // 1 (depth) or 2 (depth and amplitude)
+  uint32_t planes;
+  // meters per depth unit, 0 is no depth
+  float depth_scale;
+  float amplitude_scale;
+  uint32_t framerate_num;
+  uint32_t framerate_den;
+  uint32_t reserved[6];
+};
+
+struct RvlFrameHeader {
+  uint32_t sequence;
+  uint32_t plane_sizes[2];
+  uint32_t reserved;
+  int64_t timestamp_us;
+};
+
+/**
+ * @brief Run length / variable length codec of Wilson, "Fast Lossless Depth
+ * Image Compression", ISS 2017. Runs of zeros (invalid depth) and deltas
+ * between consecutive valid pixels are written as 4 bits groups, 3 bits of
+ * value and a continuation bit, packed in 32 bits words.
+ *
+ */
+class RvlCodec {
+ public:
+  /**
+   * @brief Size of the largest encoding of count values, in bytes.
+   *
+   * @param count
+   * @return size_t
+   */
+  static size_t GetMaxEncodedSize(size_t count);
+
+  /**
+   * @brief Encode count values.
+   *
+   * @param in
+   * @param count
+   * @param out at least GetMaxEncodedSize(count) bytes
+   * @return size_t encoded size, a multiple of 4 bytes
+   */
+  static size_t Encode(const uint16_t *in, size_t count, uint8_t *out);
+
+  /**
+   * @brief Decode count values.
+   *
+   * @param in
+   * @param size encoded size
+   * @param out
+   * @param count
+   * @return true
+   * @return false if the data is corrupted
+   */
+  static bool Decode(const uint8_t *in, size_t size, uint16_t *out,
+                     size_t count);
+
+  /**
+   * @brief Convert to units of scale, rounded to nearest. Negative, not a
+   * number and values below half a unit give 0, values out of range are
+   * clamped.
+   *
+   * @param in
+   * @param count
+   * @param scale
+   * @param out
+   */
+  static void Quantize(const float *in, size_t count, float scale,
+                       uint16_t *out);
+
+  static void Dequantize(const uint16_t *in, size_t count, float scale,
+                         float *out);
+};
+
+#endif  // __RVL_CODEC_H__
@@ -0,0 +1,174 @@
+#include <sdk/core/pad.h>
+#include <sdk/tof/rvl-sink.h>
+#include <spdlog/sinks/stdout_color_sinks.h>
+#include <spdlog/spdlog.h>
+
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+
+using namespace spdlog;
+
+static logger *logger_ = stdout_color_mt("RvlSink").get();
+
+RvlSink::RvlSink(const string &name)
+    : BaseSink(name),
+      depth_scale_(DEFAULT_RVL_DEPTH_SCALE),
+      amplitude_scale_(DEFAULT_RVL_AMPLITUDE_SCALE),
+      amplitude_(true),
+      fps_(30.0f),
+      shape_({2, 480, 640}),
+      type_(CV_32FC1),
+      fp_(nullptr),
+      sequence_(0),
+      frames_written_(0),
+      bytes_written_(0) {}
+
+RvlSink::~RvlSink() { StopRecording(); }
+
+void RvlSink::SetFilename(const string &filename) {
+  logger_->info("Setting RVL filename to {}", filename);
+  lock_guard<mutex> lock(mutex_);
+  filename_ = filename;
+}
+
+void RvlSink::SetScale(float depth_scale, float amplitude_scale) {
+  logger_->info("Setting RVL scale to {} m, {}", depth_scale, amplitude_scale);
+  lock_guard<mutex> lock(mutex_);
+  depth_scale_ = depth_scale;
+  amplitude_scale_ = amplitude_scale;
+}
+
+void RvlSink::GetScale(float &depth_scale, float &amplitude_scale) {
+  lock_guard<mutex> lock(mutex_);
+  depth_scale = depth_scale_;
+  amplitude_scale = amplitude_scale_;
+}
+
+void RvlSink::SetAmplitude(bool amplitude) {
+  lock_guard<mutex> lock(mutex_);
+  amplitude_ = amplitude;
+}
+
+void RvlSink::SetFrameRate(float fps) {
+  lock_guard<mutex> lock(mutex_);
+  fps_ = fps;
+}
+
+void RvlSink::SetFrameFormat(const MatShape &shape, int type) {
+  bool changed;
+  {
+    lock_guard<mutex> lock(mutex_);
+    changed = (shape_ != shape) || (type_ != type);
+    shape_ = shape;
+    type_ = type;
+  }
+  if (changed && IsRecording()) {
+    logger_->warn("Frame format changed, stopping recording");
+    StopRecording();
+  }
+}
+
+bool RvlSink::StartRecording() {
+  lock_guard<mutex> lock(mutex_);
+  if (fp_ != nullptr) {
+    logger_->warn("Already recording");
+    return false;
+  }
+
+  int dims = shape_.dims();
+  int planes = (dims == 3) ? shape_[0] : 1;
+  if (type_ != CV_32FC1 || (dims != 2 && dims != 3) || planes > 2) {
+    logger_->error("Only depth and amplitude planes of CV_32FC1 are supported");
+    return false;
+  }
+
+  memset(&header_, 0, sizeof(header_));
+  strncpy(header_.magic, RVL_MAGIC, sizeof(header_.magic));
+  header_.version = RVL_VERSION;
+  header_.height = shape_[dims - 2];
+  header_.width = shape_[dims - 1];
+  header_.planes = amplitude_ ? planes : 1;
+  header_.depth_scale = depth_scale_;
+  header_.amplitude_scale = amplitude_scale_;
+  header_.framerate_num = (uint32_t)roundf(fps_ * 1000);
+  header_.framerate_den = 1000;
+
+  fp_ = fopen(filename_.c_str(), "wb");
+  if (fp_ == nullptr) {
+    logger_->error("Failed to create {}: {}", filename_, strerror(errno));
+    return false;
+  }
+  if (fwrite(&header_, sizeof(header_), 1, fp_) != 1) {
+    logger_->error("Failed to write {}", filename_);
+    fclose(fp_);
+    fp_ = nullptr;
+    return false;
+  }
+
+  size_t count = (size_t)header_.width * header_.height;
+  quantized_.resize(count);
+  encoded_.resize(RvlCodec::GetMaxEncodedSize(count) * header_.planes);
+  sequence_ = 0;
+  frames_written_ = 0;
+  bytes_written_ = sizeof(header_);
+  start_time_ = chrono::steady_clock::now();
+  logger_->info("Recording {}x{}x{} depth frames to {}", header_.planes,
+                header_.height, header_.width, filename_);
+  return true;
+}
+
+void RvlSink::StopRecording() {
+  lock_guard<mutex> lock(mutex_);
+  if (fp_ == nullptr) {
+    return;
+  }
+  fclose(fp_);
+  fp_ = nullptr;
+  logger_->info("Recorded {} frames, {} bytes", frames_written_,
+                bytes_written_);
+}
+
+bool RvlSink::IsRecording() {
+  lock_guard<mutex> lock(mutex_);
+  return fp_ != nullptr;
+}
+
+uint64_t RvlSink::GetFramesWritten() { return frames_written_; }
+
+uint64_t RvlSink::GetBytesWritten() { return bytes_written_; }
+
+void RvlSink::SinkFrame(Mat &frame) {
+  lock_guard<mutex> lock(mutex_);
+  if (fp_ == nullptr) return;
+
+  RvlFrameHeader header;
+  memset(&header, 0, sizeof(header));
+  header.sequence = sequence_++;
+  auto elapsed = chrono::steady_clock::now() - start_time_;
+  header.timestamp_us =
+      chrono::duration_cast<chrono::microseconds>(elapsed).count();
+
+  size_t count = quantized_.size();
+  size_t size = 0;
+  for (int p = 0; p < header_.planes; p++) {
+    const float *plane =
+        (frame.dims == 3) ? frame.ptr<float>(p) : frame.ptr<float>();
+    float scale = (p == 0) ? header_.depth_scale : header_.amplitude_scale;
+    RvlCodec::Quantize(plane, count, scale, quantized_.data());
+    header.plane_sizes[p] =
+        RvlCodec::Encode(quantized_.data(), count, encoded_.data() + size);
+    size += header.plane_sizes[p];
+  }
+
+  if (fwrite(&header, sizeof(header), 1, fp_) != 1 ||
+      fwrite(encoded_.data(), 1, size, fp_) != size) {
+    logger_->error("Failed to write frame {}, stopping recording",
+                   header.sequence);
+    fclose(fp_);
+    fp_ = nullptr;
+    return;
+  }
+  frames_written_++;
+  bytes_written_ += sizeof(header) + size;
+}
@@ -0,0 +1,110 @@
+/* Copyright (C) 2023 Deep In Sight
+ * Author: Le Ngoc Linh <lnlinh93@dinsight.ai>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Suite 500,
+ * Boston, MA 02110-1335, USA.
+ */
+#ifndef __RVL_SINK_H__
+#define __RVL_SINK_H__
+
+#include <sdk/core/base-sink.h>
+#include <sdk/tof/rvl-codec.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <mutex>
+#include <vector>
+
+/**
+ * @brief Records depth frames (DepthCalc, MovingAverage output: depth and
+ * amplitude planes of CV_32FC1) to an RVL depth recording, read back by
+ * RvlSource. Depth is stored in millimetres by default, frames are encoded
+ * on the streaming thread, at several hundred VGA frames per second.
+ *
+ */
+class RvlSink : public BaseSink {
+ public:
+  RvlSink(const string &name = "");
+  ~RvlSink();
+
+  void SetFilename(const string &filename);
+
+  /**
+   * @brief Set the quantization step of the planes, takes effect on next
+   * recording.
+   *
+   * @param depth_scale meters per unit
+   * @param amplitude_scale amplitude per unit
+   */
+  void SetScale(float depth_scale, float amplitude_scale);
+  void GetScale(float &depth_scale, float &amplitude_scale);
+
+  /**
+   * @brief Also record the amplitude plane (default), if the frames have
+   * one.
+   *
+   * @param amplitude
+   */
+  void SetAmplitude(bool amplitude);
+
+  /**
+   * @brief Frame rate written in the file header.
+   *
+   * @param fps
+   */
+  void SetFrameRate(float fps);
+
+  /**
+   * @brief Start recording the next frames, with the current frame format.
+   *
+   * @return true
+   * @return false if the format is not supported or the file cannot be
+   * created
+   */
+  bool StartRecording();
+  void StopRecording();
+  bool IsRecording();
+
+  uint64_t GetFramesWritten();
+  uint64_t GetBytesWritten();
+
+  void SetFrameFormat(const MatShape &shape, int type) override;
+
+ protected:
+  void SinkFrame(Mat &frame) override;
+
+ private:
+  mutex mutex_;
+  string filename_;
+  float depth_scale_;
+  float amplitude_scale_;
+  bool amplitude_;
+  float fps_;
+  MatShape shape_;
+  int type_;
+
+  FILE *fp_;
+  RvlFileHeader header_;
+  vector<uint16_t> quantized_;
+  vector<uint8_t> encoded_;
+  uint32_t sequence_;
+  chrono::steady_clock::time_point start_time_;
+
+  atomic<uint64_t> frames_written_;
+  atomic<uint64_t> bytes_written_;
+};
+
+#endif  // __RVL_SINK_H__
@@ -0,0 +1,139 @@
+#include <sdk/core/pad.h>
+#include <sdk/tof/rvl-src.h>
+#include <spdlog/sinks/stdout_color_sinks.h>
+#include <spdlog/spdlog.h>
+
+#include <cstring>
+
+using namespace spdlog;
+
+static logger *logger_ = stdout_color_mt("RvlSource").get();
+
+RvlSource::RvlSource(const string &name, bool is_async, bool loop)
+    : BaseSource(name, is_async),
+      position_(0),
+      loop_(loop),
+      fps_set_(false),
+      frame_duration_(1.0f / 30.0f) {}
+
+RvlSource::~RvlSource() {
+  if (GetState() != kStreamStateStopped) {
+    Stop();
+  }
+}
+
+void RvlSource::SetFilename(const string &filename) {
+  logger_->info("Setting RVL source filename to {}", filename);
+  filename_ = filename;
+}
+
+void RvlSource::SetFrameRate(float fps) {
+  logger_->info("Setting RVL source fps to {}", fps);
+  fps_set_ = true;
+  frame_duration_ = 1.0 / fps;
+}
+
+void RvlSource::SetLoop(bool loop) {
+  logger_->info("Setting RVL source loop to {}", loop);
+  loop_ = loop;
+}
+
+int RvlSource::GetFrameCount() { return offsets_.size(); }
+
+bool RvlSource::InitializeSource() {
+  logger_->info("Initializing RVL source");
+  if (!file_.Open(filename_)) {
+    logger_->error("Failed to open file {}", filename_);
+    return false;
+  }
+
+  memset(&header_, 0, sizeof(header_));
+  if (!file_.Read(0, &header_, sizeof(header_)) ||
+      strncmp(header_.magic, RVL_MAGIC, sizeof(header_.magic)) != 0 ||
+      header_.version != RVL_VERSION || header_.width == 0 ||
+      header_.height == 0 || header_.planes == 0 || header_.planes > 2) {
+    logger_->error("{} is not an RVL depth recording", filename_);
+    file_.Close();
+    return false;
+  }
+  if (!fps_set_ && header_.framerate_num > 0 && header_.framerate_den > 0) {
+    frame_duration_ = (float)header_.framerate_den / header_.framerate_num;
+  }
+
+  // frames have variable sizes, walk their headers
+  size_t count = (size_t)header_.width * header_.height;
+  size_t maxPlaneSize = RvlCodec::GetMaxEncodedSize(count);
+  size_t offset = sizeof(header_);
+  RvlFrameHeader frameHeader;
+  offsets_.clear();
+  while (file_.Read(offset, &frameHeader, sizeof(frameHeader))) {
+    size_t size = sizeof(frameHeader);
+    bool valid = true;
+    for (int p = 0; p < header_.planes; p++) {
+      valid = valid && frameHeader.plane_sizes[p] > 0 &&
+              frameHeader.plane_sizes[p] <= maxPlaneSize;
+      size += frameHeader.plane_sizes[p];
+    }
+    // the last frame of a recording that was cut short is incomplete
+    if (!valid || offset + size > file_.GetSize()) break;
+    offsets_.push_back(offset);
+    offset += size;
+  }
+  logger_->info("RVL recording: {}x{}x{}, {} frames", header_.planes,
+                header_.height, header_.width, offsets_.size());
+
+  MatShape shape(header_.planes, header_.height, header_.width);
+  quantized_.resize(count);
+  pool_.SetFrameFormat(shape, CV_32FC1);
+  position_ = 0;
+  pacer_.Resync();
+  GetSourcePad()->SetFrameFormat(shape, CV_32FC1);
+  return true;
+}
+
+void RvlSource::CleanupSource() {
+  if (file_.IsOpen()) {
+    logger_->info("Cleaning up RVL source");
+    file_.Close();
+  }
+}
+
+Mat RvlSource::GenerateFrame() {
+  if (position_ >= (int)offsets_.size()) {
+    if (loop_ && !offsets_.empty()) {
+      logger_->info("Reached end of file, looping");
+      position_ = 0;
+    } else {
+      logger_->info("Reached end of file, stopping");
+      return Mat();
+    }
+  }
+
+  pacer_.WaitDeadline(frame_duration_);
+
+  size_t offset = offsets_[position_];
+  RvlFrameHeader header;
+  file_.Read(offset, &header, sizeof(header));
+  size_t size = 0;
+  for (int p = 0; p < header_.planes; p++) size += header.plane_sizes[p];
+
+  Mat encoded = file_.GetFrame(offset + sizeof(header),
+                               MatShape(1, (int)size), CV_8UC1);
+  Mat frame = pool_.Acquire();
+  const uint8_t *data = encoded.data;
+  size_t count = quantized_.size();
+  for (int p = 0; p < header_.planes; p++) {
+    if (encoded.empty() || !RvlCodec::Decode(data, header.plane_sizes[p],
+                                             quantized_.data(), count)) {
+      logger_->error("Failed to decode frame {}", position_);
+      return Mat();
+    }
+    float scale = (p == 0) ? header_.depth_scale : header_.amplitude_scale;
+    RvlCodec::Dequantize(quantized_.data(), count, scale,
+                         frame.ptr<float>(p));
+    data += header.plane_sizes[p];
+  }
+
+  position_++;
+  return frame;
+}
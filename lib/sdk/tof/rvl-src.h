@@ -0,0 +1,79 @@
+/* Copyright (C) 2023 Deep In Sight
+ * Author: Le Ngoc Linh <lnlinh93@dinsight.ai>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Suite 500,
+ * Boston, MA 02110-1335, USA.
+ */
+#ifndef __RVL_SRC_H__
+#define __RVL_SRC_H__
+
+#include <sdk/core/base-src.h>
+#include <sdk/core/frame-pacer.h>
+#include <sdk/core/frame-pool.h>
+#include <sdk/core/mapped-file.h>
+#include <sdk/tof/rvl-codec.h>
+
+#include <vector>
+
+/**
+ * @brief Plays an RVL depth recording written by RvlSink. Frames are
+ * planes x height x width CV_32FC1, depth (and amplitude) planes like the
+ * output of DepthCalc.
+ *
+ */
+class RvlSource : public BaseSource {
+ public:
+  RvlSource(const string &name, bool is_async, bool loop = false);
+  ~RvlSource();
+
+  void SetFilename(const string &filename);
+
+  /**
+   * @brief Set the playback frame rate. Overrides the one from the file.
+   *
+   * @param fps
+   */
+  void SetFrameRate(float fps);
+
+  void SetLoop(bool loop);
+
+  /**
+   * @brief Get number of frames in the file. Only valid after the source is
+   * initialized.
+   *
+   * @return int
+   */
+  int GetFrameCount();
+
+  bool InitializeSource() override;
+  Mat GenerateFrame() override;
+  void CleanupSource() override;
+
+ private:
+  string filename_;
+  MappedFile file_;
+  RvlFileHeader header_;
+  // offsets of the frame headers
+  vector<size_t> offsets_;
+  vector<uint16_t> quantized_;
+  FramePool pool_;
+  int position_;
+  bool loop_;
+  bool fps_set_;
+  float frame_duration_;
+  FramePacer pacer_;
+};
+
+#endif  // __RVL_SRC_H__
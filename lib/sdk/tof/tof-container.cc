@@ -0,0 +1,67 @@
+#include <sdk/core/packed12.h>
+#include <sdk/tof/tof-container.h>
+
+// sanity limits, anything beyond is most likely not a header
+#define TOF_MAX_HEADER_SIZE 65536
+#define TOF_MAX_FRAME_DIM 8192
+#define TOF_MAX_SUBFRAMES 16
+
+size_t ToFStreamHeader::GetPayloadSize() const {
+  return (size_t)frame_width * frame_height * pixel_size;
+}
+
+size_t ToFStreamHeader::GetSubframeSize() const {
+  return subframe_header_size + GetPayloadSize();
+}
+
+size_t ToFStreamHeader::GetFrameSize() const {
+  return num_subframes * GetSubframeSize();
+}
+
+MatShape ToFStreamHeader::GetShape() const {
+  return MatShape(num_subframes, frame_height, frame_width);
+}
+
+int ToFStreamHeader::GetType() const {
+  switch (pixel_size) {
+    case 1:
+      return CV_8UC1;
+    case 2:
+      return CV_16SC1;
+    case 3:
+      return CV_12SP;
+    case 4:
+      return CV_32FC1;
+    default:
+      return -1;
+  }
+}
+
+bool ToFStreamHeader::IsValid(size_t file_size, bool encoded) const {
+  if (container_header_size < sizeof(ToFStreamHeader) ||
+      container_header_size > TOF_MAX_HEADER_SIZE ||
+      subframe_header_size > TOF_MAX_HEADER_SIZE) {
+    return false;
+  }
+  if (frame_width == 0 || frame_width > TOF_MAX_FRAME_DIM ||
+      frame_height == 0 || frame_height > TOF_MAX_FRAME_DIM) {
+    return false;
+  }
+  if (num_subframes == 0 || num_subframes > TOF_MAX_SUBFRAMES ||
+      GetType() < 0) {
+    return false;
+  }
+  if (encoded) {
+    return container_header_size < file_size;
+  }
+  if (container_header_size + GetFrameSize() > file_size) {
+    return false;
+  }
+  // a recording that was cut short is fine, one with frames missing from the
+  // header count is not
+  if (num_frames != 0 &&
+      container_header_size + num_frames * GetFrameSize() < file_size) {
+    return false;
+  }
+  return true;
+}
@@ -0,0 +1,140 @@
+/* Copyright (C) 2023 Deep In Sight
+ * Author: Le Ngoc Linh <lnlinh93@dinsight.ai>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Suite 500,
+ * Boston, MA 02110-1335, USA.
+ */
+#ifndef __TOF_CONTAINER_H__
+#define __TOF_CONTAINER_H__
+
+#include <sdk/core/pad.h>
+
+#include <cstdint>
+#include <vector>
+
+using namespace std;
+using namespace cv;
+
+/**
+ * @brief Recording container, same layout as parsed by the gstreamer
+ * tofparser element:
+ *
+ *  File:     | stream header | frame0 | frame1 | ... | frameN |
+ *  Frame:    | subframe0 | subframe1 | ... | subframeK |
+ *  Subframe: | subframe header | pixel data |
+ *
+ * The stream header is padded to container_header_size bytes and subframe
+ * headers to subframe_header_size bytes, both little endian uint32 fields.
+ *
+ * Recordings of encoded frames carry a ToFCodecHeader right after the stream
+ * header, in its padding. Their frames have variable sizes and are located
+ * by the frame index or by walking the encoded frame headers.
+ *
+ * Packed 12 bits recordings (see Packed12) have a pixel_size of 3, each
+ * "pixel" being a pair of samples, so frame_width is half the sensor width.
+ * Only the SDK reads them back (PlaybackSource then DepthCalc): the
+ * gstreamer tofparser takes 16 bits samples only and rejects pixel_size 3.
+ *
+ */
+struct ToFStreamHeader {
+  uint32_t container_header_size;
+  uint32_t subframe_header_size;
+  uint32_t frame_width;
+  uint32_t frame_height;
+  uint32_t framerate_num;
+  uint32_t framerate_den;
+  uint32_t pixel_size;
+  uint32_t num_subframes;
+  uint32_t num_frames;
+
+  /**
+   * @brief Size in bytes of the pixel data of one subframe.
+   *
+   */
+  size_t GetPayloadSize() const;
+
+  /**
+   * @brief Size in bytes of a subframe, header included.
+   *
+   */
+  size_t GetSubframeSize() const;
+
+  /**
+   * @brief Size in bytes of a frame, all subframes and their headers.
+   *
+   */
+  size_t GetFrameSize() const;
+
+  /**
+   * @brief Shape of a frame once the subframe headers are stripped:
+   * num_subframes x frame_height x frame_width.
+   *
+   */
+  MatShape GetShape() const;
+
+  /**
+   * @brief OpenCV type of a pixel, -1 if pixel_size is not supported.
+   *
+   */
+  int GetType() const;
+
+  /**
+   * @brief Sanity check the header against the size of the file. There is no
+   * magic number in the container, so this is how a headerless raw recording
+   * is told apart.
+   *
+   * @param file_size
+   * @param encoded frames are encoded, so their size is not known
+   * @return true
+   * @return false
+   */
+  bool IsValid(size_t file_size, bool encoded = false) const;
+};
+
+#define TOF_CODEC_MAGIC 0x43454443  // "CDEC"
+
+enum ToFCodec {
+  kToFCodecNone,
+  // lossless phase codec, see PhaseCodec
+  kToFCodecPhase
+};
+
+struct ToFCodecHeader {
+  uint32_t magic;
+  uint32_t codec;
+};
+
+/**
+ * @brief Sensor information at the start of every subframe header, as in
+ * GstMetaTof.
+ *
+ */
+struct ToFSubframeHeader {
+  uint32_t modulation_frequency;
+  uint32_t sensor_temperature;
+  uint32_t rngchk_low;
+  uint32_t rngchk_high;
+};
+
+/**
+ * @brief Metadata of a frame read from a container.
+ *
+ */
+struct ToFFrameMeta {
+  int frame_index;
+  vector<ToFSubframeHeader> subframes;
+};
+
+#endif  // __TOF_CONTAINER_H__
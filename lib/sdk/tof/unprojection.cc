@@ -1,5 +1,7 @@
 #include <sdk/tof/unprojection.h>
 
+#include <limits>
+
 PinholeParams::PinholeParams() {
   fx_ = default_fx;
   fy_ = default_fy;
@@ -53,46 +55,233 @@ const float PinholeParams::default_dy = 10.0f;
 
 Unprojection::Unprojection(const string& name) : BaseTransform(name) {
   params_ = PinholeParams::DefaultParams();
+  index_pad_ = new Pad(kPadSource, "index");
+  AddPad(index_pad_);
+  height_ = 0;
+  width_ = 0;
+  compact_ = false;
+  minDepth_ = 0.0f;
+  maxDepth_ = std::numeric_limits<float>::infinity();
+  minAmplitude_ = 0.0f;
 }
 
-Unprojection::~Unprojection() {}
+Unprojection::~Unprojection() {
+  index_pad_->Unlink();
+  delete index_pad_;
+}
 
-void Unprojection::SetParams(PinholeParams& params) { params_ = params; }
+void Unprojection::SetParams(PinholeParams& params) {
+  lock_guard<mutex> lock(mutex_);
+  params_ = params;
+  PrepareCoefficients();
+}
 
 PinholeParams Unprojection::GetParams() { return params_; }
 
+void Unprojection::SetCompactMode(bool compact) {
+  {
+    lock_guard<mutex> lock(mutex_);
+    if (compact_ == compact) {
+      return;
+    }
+    compact_ = compact;
+  }
+  PushFrameFormat();
+}
+
+bool Unprojection::IsCompactMode() { return compact_; }
+
+void Unprojection::SetDepthRange(float minDepth, float maxDepth) {
+  lock_guard<mutex> lock(mutex_);
+  minDepth_ = minDepth;
+  maxDepth_ = maxDepth;
+}
+
+void Unprojection::GetDepthRange(float& minDepth, float& maxDepth) {
+  minDepth = minDepth_;
+  maxDepth = maxDepth_;
+}
+
+void Unprojection::SetMinAmplitude(float minAmplitude) {
+  lock_guard<mutex> lock(mutex_);
+  minAmplitude_ = minAmplitude;
+}
+
+float Unprojection::GetMinAmplitude() { return minAmplitude_; }
+
+Pad* Unprojection::GetIndexPad() { return index_pad_; }
+
+void Unprojection::PrepareCoefficients() {
+  float fx_pixel = params_.fx_ * 1e-3 / (params_.dx_ * 1e-6);
+  float fy_pixel = params_.fy_ * 1e-3 / (params_.dy_ * 1e-6);
+
+  coeffX_.resize(width_);
+  coeffY_.resize(height_);
+  for (int x = 0; x < width_; x++) {
+    coeffX_[x] = (x - params_.cx_) / fx_pixel;
+  }
+  for (int y = 0; y < height_; y++) {
+    coeffY_[y] = (y - params_.cy_) / fy_pixel;
+  }
+}
+
 void Unprojection::TransformFrame(Mat& frame) {
-  int height, width;
   MatShape shape(frame.size);
-  height = (shape.dims() == 3) ? shape[1] : shape[0];
-  width = (shape.dims() == 3) ? shape[2] : shape[1];
-  Mat cloud({height, width, 3}, CV_32FC1);
+  int height = (shape.dims() == 3) ? shape[1] : shape[0];
+  int width = (shape.dims() == 3) ? shape[2] : shape[1];
+  bool hasAmplitude = (shape.dims() == 3) && (shape[0] >= 2);
+  float* z = (float*)frame.data;
+  Mat cloud, index;
+  bool compact;
+
+  {
+    lock_guard<mutex> lock(mutex_);
+    if (height != height_ || width != width_) {
+      height_ = height;
+      width_ = width;
+      PrepareCoefficients();
+    }
+
+    compact = compact_;
+    if (!compact) {
+      cloud = Mat({height, width, 3}, CV_32FC1);
+      UnprojectOrganized(z, cloud);
+    } else {
+      float* amplitude = hasAmplitude ? z + height * width : nullptr;
+      UnprojectCompact(z, amplitude, cloud, index);
+    }
+  }
 
+  // downstream elements run without our lock
+  if (compact) {
+    index_pad_->PushFrame(index);
+  }
+  GetSourcePad()->PushFrame(cloud);
+}
+
+void Unprojection::UnprojectOrganized(const float* z, Mat& cloud) {
   float* cloudPtr = (float*)cloud.data;
-  float* z = (float*)frame.data;
-  // TODO: cache the xyz coefficients into another Mat to avoid repetitive
-  // calculation also cache the cloud Mat to avoid repetitive allocation
-  float fx_pixel = params_.fx_ * 1e-3 / (params_.dx_ * 1e-6);
-  float fy_pixel = params_.fy_ * 1e-3 / (params_.dy_ * 1e-6);
 
-  for (int y = 0; y < height; y++) {
-    for (int x = 0; x < width; x++, cloudPtr += 3, z++) {
-      cloudPtr[0] = (*z) * (x - params_.cx_) / fx_pixel;
-      cloudPtr[1] = (*z) * (y - params_.cy_) / fy_pixel;
+  for (int y = 0; y < height_; y++) {
+    float cy = coeffY_[y];
+    for (int x = 0; x < width_; x++, cloudPtr += 3, z++) {
+      cloudPtr[0] = (*z) * coeffX_[x];
+      cloudPtr[1] = (*z) * cy;
       cloudPtr[2] = (*z);
     }
   }
+}
 
-  GetSourcePad()->PushFrame(cloud);
+/**
+ * The compaction is a stream compaction in 3 steps, so that every inner loop
+ * is branch-free and can be auto-vectorized:
+ *  1. validity mask and per-row valid count,
+ *  2. exclusive prefix sum of the row counts gives each row's output offset,
+ *  3. each row packs its valid column indices, then gathers the points into
+ *     its own slice of the output.
+ * Rows are independent in step 1 and 3, so these run in parallel.
+ */
+int Unprojection::UnprojectCompact(const float* z, const float* amplitude,
+                                   Mat& cloud, Mat& index) {
+  const int height = height_;
+  const int width = width_;
+  const float minDepth = minDepth_;
+  const float maxDepth = maxDepth_;
+  const float minAmplitude = minAmplitude_;
+
+  validMask_.resize(height * width);
+  rowOffsets_.resize(height + 1);
+  uint8_t* mask = validMask_.data();
+  int* offsets = rowOffsets_.data();
+
+  parallel_for_(Range(0, height), [&](const Range& range) {
+    for (int y = range.start; y < range.end; y++) {
+      const float* zRow = z + y * width;
+      uint8_t* maskRow = mask + y * width;
+      int count = 0;
+      if (amplitude != nullptr) {
+        const float* aRow = amplitude + y * width;
+        for (int x = 0; x < width; x++) {
+          maskRow[x] = (zRow[x] > minDepth) & (zRow[x] <= maxDepth) &
+                       (aRow[x] >= minAmplitude);
+          count += maskRow[x];
+        }
+      } else {
+        for (int x = 0; x < width; x++) {
+          maskRow[x] = (zRow[x] > minDepth) & (zRow[x] <= maxDepth);
+          count += maskRow[x];
+        }
+      }
+      offsets[y + 1] = count;
+    }
+  });
+
+  offsets[0] = 0;
+  for (int y = 0; y < height; y++) {
+    offsets[y + 1] += offsets[y];
+  }
+  const int total = offsets[height];
+
+  cloud = Mat(total, 3, CV_32FC1);
+  index = Mat(total, 1, CV_32SC1);
+  if (total == 0) {
+    return 0;
+  }
+
+  float* cloudData = (float*)cloud.data;
+  int32_t* indexData = (int32_t*)index.data;
+  const float* coeffX = coeffX_.data();
+  const float* coeffY = coeffY_.data();
+
+  parallel_for_(Range(0, height), [&](const Range& range) {
+    std::vector<int> cols(width + 1);
+    for (int y = range.start; y < range.end; y++) {
+      const float* zRow = z + y * width;
+      const uint8_t* maskRow = mask + y * width;
+      int n = 0;
+      // always write, only advance on valid pixels
+      for (int x = 0; x < width; x++) {
+        cols[n] = x;
+        n += maskRow[x];
+      }
+
+      float* dst = cloudData + 3 * offsets[y];
+      int32_t* idx = indexData + offsets[y];
+      float cy = coeffY[y];
+      for (int k = 0; k < n; k++) {
+        int x = cols[k];
+        float d = zRow[x];
+        dst[3 * k + 0] = d * coeffX[x];
+        dst[3 * k + 1] = d * cy;
+        dst[3 * k + 2] = d;
+        idx[k] = y * width + x;
+      }
+    }
+  });
+
+  return total;
 }
 
 void Unprojection::SetFrameFormat(const MatShape& shape, int type) {
-  int height, width;
-  height = (shape.dims() == 3) ? shape[1] : shape[0];
-  width = (shape.dims() == 3) ? shape[2] : shape[1];
+  {
+    lock_guard<mutex> lock(mutex_);
+    height_ = (shape.dims() == 3) ? shape[1] : shape[0];
+    width_ = (shape.dims() == 3) ? shape[2] : shape[1];
+    PrepareCoefficients();
+  }
+  PushFrameFormat();
+}
 
-  MatShape cloudShape(height, width, 3);  // xyz
+void Unprojection::PushFrameFormat() {
   int cloudType = CV_32FC1;
 
-  GetSourcePad()->SetFrameFormat(cloudShape, cloudType);
-}
\ No newline at end of file
+  if (compact_) {
+    MatShape cloudShape(MAT_DIM_DYNAMIC, 3);  // xyz
+    MatShape indexShape(MAT_DIM_DYNAMIC, 1);
+    index_pad_->SetFrameFormat(indexShape, CV_32SC1);
+    GetSourcePad()->SetFrameFormat(cloudShape, cloudType);
+  } else {
+    MatShape cloudShape(height_, width_, 3);  // xyz
+    GetSourcePad()->SetFrameFormat(cloudShape, cloudType);
+  }
+}
@@ -56,10 +56,67 @@ class Unprojection : public BaseTransform {
   void SetParams(PinholeParams &params);
   PinholeParams GetParams();
 
+  /**
+   * @brief Enable/disable compact output. In compact mode, invalid pixels (zero
+   * or out of range depth, low amplitude) are culled and the valid points are
+   * packed into a dense Nx3 cloud. The "index" source pad then carries a Nx1
+   * CV_32SC1 map with the linear pixel index (y * width + x) of each point.
+   * Otherwise the organized HxWx3 cloud is emitted, and nothing is pushed to
+   * the "index" pad.
+   *
+   * @param compact
+   */
+  void SetCompactMode(bool compact);
+  bool IsCompactMode();
+
+  /**
+   * @brief Set the valid depth range (minDepth, maxDepth] used in compact mode.
+   * Default is (0, inf), which culls zero-depth pixels only.
+   *
+   * @param minDepth
+   * @param maxDepth
+   */
+  void SetDepthRange(float minDepth, float maxDepth);
+  void GetDepthRange(float &minDepth, float &maxDepth);
+
+  /**
+   * @brief Set the minimum amplitude of a valid point in compact mode. Ignored
+   * if the input frame has no amplitude plane.
+   *
+   * @param minAmplitude
+   */
+  void SetMinAmplitude(float minAmplitude);
+  float GetMinAmplitude();
+
+  /**
+   * @brief Get the source pad that carries the index map in compact mode.
+   *
+   * @return Pad*
+   */
+  Pad *GetIndexPad();
+
  private:
   void TransformFrame(Mat &frame) override;
   void SetFrameFormat(const MatShape &shape, int type) override;
+  void PushFrameFormat();
+  void PrepareCoefficients();
+  void UnprojectOrganized(const float *z, Mat &cloud);
+  int UnprojectCompact(const float *z, const float *amplitude, Mat &cloud,
+                       Mat &index);
+
   PinholeParams params_;
-  // Mat cloudCache_;
-  // Mat coeffCache_;
+  Pad *index_pad_;
+  int height_;
+  int width_;
+  bool compact_;
+  float minDepth_;
+  float maxDepth_;
+  float minAmplitude_;
+  // per column (x - cx) / fx and per row (y - cy) / fy, in pixel unit
+  std::vector<float> coeffX_;
+  std::vector<float> coeffY_;
+  // compact mode scratch buffers, reused across frames
+  std::vector<uint8_t> validMask_;
+  std::vector<int> rowOffsets_;
+  mutex mutex_;
 };
@@ -1,21 +1,68 @@
-// #include <sdk/calib/fisheye.h>
-
-// class OpenCVSink : public BaseSink {
-//  public:
-//   OpenCVSink(const string& name = "") : BaseSink(name) {}
-//   void SinkFrame(Mat& frame) override {
-//     cv::imshow("OpenCVSink", frame);
-//     cv::waitKey();
-//   }
-// };
-
-// TEST(FisheyeTest, TestTransformFrame) {
-//   Fisheye fisheye;
-//   fisheye.SetParams({390.33216865, 392.37363314,  // fx, fy
-//                      337.7728288, 244.44454662,   // cx, cy
-//                      -0.34335484, 0.14217051,     // k1, k2
-//                      0.00073704, -0.00061519,     // p1, p2
-//                      -0.03051488});               // p3
-//   OpenCVSink sink;
-//   fisheye.GetSourcePad()->Link(sink.GetSinkPad());
-// }
\ No newline at end of file
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include <sdk/calib/fisheye.h>
+#include <sdk/core/base-sink.h>
+
+class FisheyeSink : public BaseSink {
+ public:
+  FisheyeSink(const string& name = "") : BaseSink(name) {}
+  void SinkFrame(Mat& frame) override { frame_ = frame; }
+  Mat frame_;
+};
+
+class FisheyeTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    // no distortion, so the undistorted image is the input itself
+    FisheyeParams params = {16, 16, 8, 8, 0, 0, 0, 0, 0, 1};
+    fisheye_.SetParams(params);
+    fisheye_.GetSourcePad()->Link(sink_.GetSinkPad());
+    fisheye_.GetSinkPad()->SetFrameFormat({2, 16, 16}, CV_32FC1);
+
+    frame_ = Mat({2, 16, 16}, CV_32FC1);
+    for (int i = 0; i < 2 * 16 * 16; i++) {
+      ((float*)frame_.data)[i] = i;
+    }
+  }
+
+  Fisheye fisheye_;
+  FisheyeSink sink_;
+  Mat frame_;
+};
+
+TEST_F(FisheyeTest, TestIdentityRemap) {
+  MatShape shape;
+  int type;
+  sink_.GetSinkPad()->GetFrameFormat(shape, type);
+  EXPECT_EQ(shape[0], 2);
+
+  // nearest neighbour, so the result is exact despite sub-pixel quantization
+  fisheye_.SetInterpolation(kFisheyeInterNearest);
+  fisheye_.GetSinkPad()->PushFrame(frame_);
+  Mat result = sink_.frame_;
+  ASSERT_FALSE(result.empty());
+  EXPECT_EQ(result.size[0], 2);
+  EXPECT_EQ(result.size[1], shape[1]);
+  EXPECT_EQ(result.size[2], shape[2]);
+
+  // the valid roi is the whole frame, or the whole frame minus a border
+  int oy = (16 - shape[1]) / 2;
+  int ox = (16 - shape[2]) / 2;
+  for (int c = 0; c < 2; c++) {
+    for (int y = 0; y < shape[1]; y++) {
+      for (int x = 0; x < shape[2]; x++) {
+        EXPECT_NEAR(result.at<float>(c, y, x),
+                    frame_.at<float>(c, y + oy, x + ox), 1e-6);
+      }
+    }
+  }
+}
+
+TEST_F(FisheyeTest, TestInputUnchanged) {
+  Mat copy = frame_.clone();
+  fisheye_.SetInterpolation(kFisheyeInterDepthAware);
+  fisheye_.GetSinkPad()->PushFrame(frame_);
+  for (int i = 0; i < 2 * 16 * 16; i++) {
+    EXPECT_EQ(((float*)frame_.data)[i], ((float*)copy.data)[i]);
+  }
+}
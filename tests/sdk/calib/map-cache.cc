@@ -0,0 +1,138 @@
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include <sdk/calib/map-cache.h>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstdlib>
+
+class UndistortMapCacheTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    char tmpl[] = "/tmp/tct-map-cache-XXXXXX";
+    directory_ = mkdtemp(tmpl);
+  }
+
+  void TearDown() override {
+    string cmd = "rm -rf " + directory_;
+    system(cmd.c_str());
+  }
+
+  shared_ptr<UndistortMaps> MakeMaps(int width, int height) {
+    auto maps = make_shared<UndistortMaps>();
+    maps->map1 = Mat(height, width, CV_16SC2);
+    maps->map2 = Mat(height, width, CV_16UC1);
+    for (int i = 0; i < width * height; i++) {
+      ((short*)maps->map1.data)[2 * i] = i % width;
+      ((short*)maps->map1.data)[2 * i + 1] = i / width;
+      ((ushort*)maps->map2.data)[i] = i % 1024;
+    }
+    maps->roi = Rect(1, 2, width, height);
+    return maps;
+  }
+
+  // size of the map file, -1 if missing
+  off_t FileSize(const UndistortMapKey& key) {
+    char name[64];
+    snprintf(name, sizeof(name), "/fisheye-%016llx.map",
+             (unsigned long long)key.Hash());
+    struct stat st;
+    return (stat((directory_ + name).c_str(), &st) == 0) ? st.st_size : -1;
+  }
+
+  FisheyeParams params_ = {16, 16, 8, 8, 0, 0, 0, 0, 0, 1};
+  string directory_;
+};
+
+TEST_F(UndistortMapCacheTest, TestGetMissing) {
+  UndistortMapCache cache(directory_);
+  EXPECT_EQ(cache.Get(UndistortMapKey(params_, 16, 16)), nullptr);
+}
+
+TEST_F(UndistortMapCacheTest, TestPutGet) {
+  UndistortMapCache cache(directory_);
+  UndistortMapKey key(params_, 16, 16);
+  auto maps = MakeMaps(12, 10);
+  cache.Put(key, maps);
+  EXPECT_EQ(cache.Get(key), maps);
+
+  FisheyeParams other = params_;
+  other.k1 = 0.1f;
+  EXPECT_EQ(cache.Get(UndistortMapKey(other, 16, 16)), nullptr);
+  EXPECT_EQ(cache.Get(UndistortMapKey(params_, 32, 16)), nullptr);
+}
+
+TEST_F(UndistortMapCacheTest, TestEviction) {
+  UndistortMapCache cache("", 2);
+  UndistortMapKey key1(params_, 16, 16);
+  UndistortMapKey key2(params_, 32, 32);
+  UndistortMapKey key3(params_, 64, 64);
+  cache.Put(key1, MakeMaps(4, 4));
+  cache.Put(key2, MakeMaps(4, 4));
+  // key1 becomes the most recently used, so key2 is evicted
+  EXPECT_NE(cache.Get(key1), nullptr);
+  cache.Put(key3, MakeMaps(4, 4));
+
+  EXPECT_EQ(cache.GetSize(), 2);
+  EXPECT_NE(cache.Get(key1), nullptr);
+  EXPECT_EQ(cache.Get(key2), nullptr);
+  EXPECT_NE(cache.Get(key3), nullptr);
+}
+
+TEST_F(UndistortMapCacheTest, TestPersistence) {
+  UndistortMapKey key(params_, 16, 16);
+  auto maps = MakeMaps(12, 10);
+  {
+    UndistortMapCache cache(directory_);
+    cache.Put(key, maps);
+  }
+
+  UndistortMapCache cache(directory_);
+  auto loaded = cache.Get(key);
+  ASSERT_NE(loaded, nullptr);
+  EXPECT_EQ(loaded->roi, maps->roi);
+  EXPECT_EQ(loaded->map1.type(), CV_16SC2);
+  EXPECT_EQ(loaded->map2.type(), CV_16UC1);
+  EXPECT_EQ(cv::norm(loaded->map1, maps->map1, NORM_INF), 0);
+  EXPECT_EQ(cv::norm(loaded->map2, maps->map2, NORM_INF), 0);
+}
+
+TEST_F(UndistortMapCacheTest, TestWriteOnDestroy) {
+  UndistortMapKey key1(params_, 16, 16);
+  UndistortMapKey key2(params_, 32, 32);
+  {
+    UndistortMapCache cache(directory_);
+    cache.Put(key1, MakeMaps(12, 10));
+    cache.Put(key2, MakeMaps(12, 10));
+    // no Flush(), the destructor drains the queue
+  }
+  EXPECT_GT(FileSize(key1), 0);
+  EXPECT_GT(FileSize(key2), 0);
+}
+
+TEST_F(UndistortMapCacheTest, TestDiskEviction) {
+  UndistortMapKey key1(params_, 16, 16);
+  UndistortMapKey key2(params_, 32, 32);
+  UndistortMapKey key3(params_, 64, 64);
+  UndistortMapCache cache(directory_, 1);
+  cache.Put(key1, MakeMaps(12, 10));
+  cache.Flush();
+  ASSERT_GT(FileSize(key1), 0);
+  // room for 2 files
+  cache.SetDiskCapacity(2 * FileSize(key1));
+
+  usleep(20000);
+  cache.Put(key2, MakeMaps(12, 10));
+  cache.Flush();
+  // key1 is loaded from disk, so it becomes the most recently used
+  usleep(20000);
+  EXPECT_NE(cache.Get(key1), nullptr);
+  usleep(20000);
+  cache.Put(key3, MakeMaps(12, 10));
+  cache.Flush();
+
+  EXPECT_GT(FileSize(key1), 0);
+  EXPECT_EQ(FileSize(key2), -1);
+  EXPECT_GT(FileSize(key3), 0);
+}
@@ -0,0 +1,42 @@
+#include <gtest/gtest.h>
+#include <sdk/core/frame-pacer.h>
+
+#include <thread>
+
+TEST(FramePacer, TestDeadline) {
+  FramePacer pacer;
+  // the first frame is due immediately, then every 20ms
+  auto start = chrono::steady_clock::now();
+  for (int i = 0; i < 6; i++) pacer.WaitDeadline(0.02);
+  auto elapsed = chrono::steady_clock::now() - start;
+  EXPECT_GE(elapsed, chrono::milliseconds(100));
+  EXPECT_LT(elapsed, chrono::milliseconds(150));
+
+  // too late, the schedule restarts instead of catching up
+  this_thread::sleep_for(chrono::milliseconds(150));
+  start = chrono::steady_clock::now();
+  pacer.WaitDeadline(0.02);
+  EXPECT_LT(chrono::steady_clock::now() - start, chrono::milliseconds(10));
+}
+
+TEST(FramePacer, TestTimestamp) {
+  FramePacer pacer;
+  auto start = chrono::steady_clock::now();
+  pacer.WaitTimestamp(1000000, 0.02);
+  pacer.WaitTimestamp(1030000, 0.02);
+  pacer.WaitTimestamp(1080000, 0.02);
+  auto elapsed = chrono::steady_clock::now() - start;
+  EXPECT_GE(elapsed, chrono::milliseconds(80));
+  EXPECT_LT(elapsed, chrono::milliseconds(120));
+
+  // time going backward restarts the schedule
+  start = chrono::steady_clock::now();
+  pacer.WaitTimestamp(0, 0.02);
+  EXPECT_LT(chrono::steady_clock::now() - start, chrono::milliseconds(10));
+
+  // and so does a resync
+  pacer.Resync();
+  start = chrono::steady_clock::now();
+  pacer.WaitTimestamp(500000, 0.02);
+  EXPECT_LT(chrono::steady_clock::now() - start, chrono::milliseconds(10));
+}
@@ -0,0 +1,45 @@
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include <sdk/core/frame-pool.h>
+
+TEST(FramePoolTest, TestReuseReleasedFrame) {
+  FramePool pool(2);
+  pool.SetFrameFormat({2, 4, 4}, CV_32FC1);
+
+  uchar* data;
+  {
+    Mat frame = pool.Acquire();
+    EXPECT_EQ(frame.size[0], 2);
+    EXPECT_EQ(frame.size[1], 4);
+    EXPECT_EQ(frame.size[2], 4);
+    EXPECT_EQ(frame.type(), CV_32FC1);
+    data = frame.data;
+  }
+  // released by the only user, so it is handed out again
+  Mat frame = pool.Acquire();
+  EXPECT_EQ(frame.data, data);
+  EXPECT_EQ(pool.GetPoolSize(), 1);
+}
+
+TEST(FramePoolTest, TestFramesInUse) {
+  FramePool pool(2);
+  pool.SetFrameFormat({1, 4, 4}, CV_32FC1);
+
+  Mat frame1 = pool.Acquire();
+  Mat frame2 = pool.Acquire();
+  Mat frame3 = pool.Acquire();
+  EXPECT_NE(frame1.data, frame2.data);
+  EXPECT_NE(frame2.data, frame3.data);
+  EXPECT_EQ(pool.GetPoolSize(), 2);
+}
+
+TEST(FramePoolTest, TestFormatChanged) {
+  FramePool pool;
+  pool.SetFrameFormat({1, 4, 4}, CV_32FC1);
+  Mat frame = pool.Acquire();
+  pool.SetFrameFormat({1, 8, 8}, CV_16SC1);
+  EXPECT_EQ(pool.GetPoolSize(), 0);
+  frame = pool.Acquire();
+  EXPECT_EQ(frame.size[1], 8);
+  EXPECT_EQ(frame.type(), CV_16SC1);
+}
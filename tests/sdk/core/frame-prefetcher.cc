@@ -0,0 +1,113 @@
+#include <fcntl.h>
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include <sdk/core/frame-prefetcher.h>
+#include <unistd.h>
+
+class FramePrefetcherTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    char tmpl[] = "/tmp/tct-prefetcher-XXXXXX";
+    int fd = mkstemp(tmpl);
+    filename_ = tmpl;
+    // every frame is filled with its index
+    vector<short> data(kNumFrames * kFrameSize);
+    for (int i = 0; i < data.size(); i++) {
+      data[i] = i / kFrameSize;
+    }
+    write(fd, data.data(), data.size() * sizeof(short));
+    close(fd);
+  }
+
+  void TearDown() override { unlink(filename_.c_str()); }
+
+  bool Open(FramePrefetcher &prefetcher) {
+    return prefetcher.Open(filename_, 0, kFrameSize * sizeof(short),
+                           kNumFrames, {2, 32, 32}, CV_16SC1);
+  }
+
+  static const int kNumFrames = 16;
+  static const int kFrameSize = 2 * 32 * 32;
+  string filename_;
+};
+
+TEST_F(FramePrefetcherTest, TestOpen) {
+  FramePrefetcher prefetcher(4);
+  EXPECT_FALSE(prefetcher.Open("/tmp/doesnt_exist.bin", 0, 1, 1, {1}, CV_8UC1));
+  EXPECT_FALSE(prefetcher.IsOpen());
+  EXPECT_TRUE(Open(prefetcher));
+  EXPECT_TRUE(prefetcher.IsOpen());
+  prefetcher.Close();
+  EXPECT_FALSE(prefetcher.IsOpen());
+}
+
+TEST_F(FramePrefetcherTest, TestSequential) {
+  FramePrefetcher prefetcher(4);
+  ASSERT_TRUE(Open(prefetcher));
+  for (int i = 0; i < kNumFrames; i++) {
+    Mat frame = prefetcher.GetFrame(i);
+    ASSERT_FALSE(frame.empty());
+    EXPECT_EQ(((short *)frame.data)[0], i);
+    EXPECT_EQ(((short *)frame.data)[kFrameSize - 1], i);
+  }
+  EXPECT_TRUE(prefetcher.GetFrame(kNumFrames).empty());
+  EXPECT_EQ(prefetcher.GetHits() + prefetcher.GetMisses(), kNumFrames);
+}
+
+TEST_F(FramePrefetcherTest, TestHits) {
+  FramePrefetcher prefetcher(4);
+  ASSERT_TRUE(Open(prefetcher));
+  prefetcher.GetFrame(0);
+  // give the I/O thread time to fill the ring
+  this_thread::sleep_for(chrono::milliseconds(100));
+  prefetcher.ResetStats();
+  for (int i = 1; i <= 4; i++) {
+    prefetcher.GetFrame(i);
+  }
+  EXPECT_EQ(prefetcher.GetHits(), 4);
+  EXPECT_EQ(prefetcher.GetMisses(), 0);
+}
+
+TEST_F(FramePrefetcherTest, TestSeek) {
+  FramePrefetcher prefetcher(4);
+  ASSERT_TRUE(Open(prefetcher));
+  EXPECT_EQ(((short *)prefetcher.GetFrame(0).data)[0], 0);
+  EXPECT_EQ(((short *)prefetcher.GetFrame(10).data)[0], 10);
+  EXPECT_EQ(((short *)prefetcher.GetFrame(3).data)[0], 3);
+  EXPECT_EQ(((short *)prefetcher.GetFrame(4).data)[0], 4);
+}
+
+TEST_F(FramePrefetcherTest, TestSeekNext) {
+  // large frames keep the first batch in flight long enough to seek
+  const int size = 8 << 20;
+  vector<char> data(3 * size);
+  for (int i = 0; i < 3; i++) {
+    data[i * size] = i;
+  }
+  int fd = open(filename_.c_str(), O_WRONLY | O_TRUNC);
+  write(fd, data.data(), data.size());
+  close(fd);
+
+  FramePrefetcher prefetcher(2);
+  for (int i = 0; i < 10; i++) {
+    ASSERT_TRUE(prefetcher.Open(filename_, 0, size, 3, {size}, CV_8UC1));
+    this_thread::sleep_for(chrono::microseconds(i * 100));
+    // frame 2 is read after the first batch, the stale batch must not
+    // fill the ring and stall the I/O thread
+    Mat frame = prefetcher.GetFrame(2);
+    ASSERT_FALSE(frame.empty());
+    EXPECT_EQ(frame.data[0], 2);
+  }
+}
+
+TEST_F(FramePrefetcherTest, TestLoop) {
+  FramePrefetcher prefetcher(4);
+  prefetcher.SetLoop(true);
+  ASSERT_TRUE(Open(prefetcher));
+  prefetcher.GetFrame(kNumFrames - 1);
+  this_thread::sleep_for(chrono::milliseconds(100));
+  prefetcher.ResetStats();
+  Mat frame = prefetcher.GetFrame(0);
+  EXPECT_EQ(((short *)frame.data)[0], 0);
+  EXPECT_EQ(prefetcher.GetHits(), 1);
+}
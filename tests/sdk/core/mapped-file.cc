@@ -0,0 +1,83 @@
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include <sdk/core/mapped-file.h>
+#include <unistd.h>
+
+class MappedFileTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    char tmpl[] = "/tmp/tct-mapped-file-XXXXXX";
+    int fd = mkstemp(tmpl);
+    filename_ = tmpl;
+    data_.resize(kNumFrames * kFrameSize);
+    for (int i = 0; i < data_.size(); i++) {
+      data_[i] = i;
+    }
+    write(fd, data_.data(), data_.size() * sizeof(short));
+    close(fd);
+  }
+
+  void TearDown() override { unlink(filename_.c_str()); }
+
+  static const int kNumFrames = 8;
+  // 2x64x64 CV_16SC1, 16KB per frame
+  static const int kFrameSize = 2 * 64 * 64;
+  string filename_;
+  vector<short> data_;
+};
+
+TEST_F(MappedFileTest, TestOpen) {
+  MappedFile file;
+  EXPECT_FALSE(file.Open("/tmp/doesnt_exist.bin"));
+  EXPECT_TRUE(file.Open(filename_));
+  EXPECT_TRUE(file.IsOpen());
+  EXPECT_EQ(file.GetSize(), kNumFrames * kFrameSize * sizeof(short));
+  file.Close();
+  EXPECT_FALSE(file.IsOpen());
+}
+
+TEST_F(MappedFileTest, TestGetFrame) {
+  // windows smaller than the file force remapping
+  MappedFile file(3 * kFrameSize * sizeof(short));
+  ASSERT_TRUE(file.Open(filename_));
+
+  for (int i = 0; i < kNumFrames; i++) {
+    Mat frame = file.GetFrame(i * kFrameSize * sizeof(short), {2, 64, 64},
+                              CV_16SC1);
+    ASSERT_FALSE(frame.empty());
+    EXPECT_EQ(memcmp(frame.data, &data_[i * kFrameSize],
+                     kFrameSize * sizeof(short)),
+              0);
+  }
+
+  EXPECT_TRUE(
+      file.GetFrame(kNumFrames * kFrameSize * sizeof(short), {2, 64, 64},
+                    CV_16SC1)
+          .empty());
+}
+
+TEST_F(MappedFileTest, TestFrameOutlivesFile) {
+  Mat frame;
+  {
+    MappedFile file(kFrameSize * sizeof(short));
+    ASSERT_TRUE(file.Open(filename_));
+    frame = file.GetFrame(kFrameSize * sizeof(short), {2, 64, 64}, CV_16SC1);
+    // move to another window
+    file.GetFrame(5 * kFrameSize * sizeof(short), {2, 64, 64}, CV_16SC1);
+  }
+
+  ASSERT_FALSE(frame.empty());
+  EXPECT_EQ(
+      memcmp(frame.data, &data_[kFrameSize], kFrameSize * sizeof(short)), 0);
+}
+
+TEST_F(MappedFileTest, TestWriteDoesNotModifyFile) {
+  MappedFile file;
+  ASSERT_TRUE(file.Open(filename_));
+  Mat frame = file.GetFrame(0, {2, 64, 64}, CV_16SC1);
+  ((short *)frame.data)[0] = -1;
+
+  short value;
+  EXPECT_TRUE(file.Read(0, &value, sizeof(value)));
+  EXPECT_EQ(value, 0);
+}
@@ -0,0 +1,70 @@
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include <sdk/core/packed12.h>
+
+#include <vector>
+
+static void PackScalar(const int16_t* in, uint8_t* out, size_t count) {
+  for (size_t i = 0; i < count; i += 2) {
+    uint16_t a = in[i] & 0xfff;
+    uint16_t b = in[i + 1] & 0xfff;
+    out[0] = a & 0xff;
+    out[1] = (a >> 8) | ((b & 0xf) << 4);
+    out[2] = b >> 4;
+    out += 3;
+  }
+}
+
+TEST(Packed12Test, TestLayout) {
+  int16_t in[2] = {0x123, -2};
+  uint8_t out[3];
+  Packed12::Pack(in, out, 2);
+  EXPECT_EQ(out[0], 0x23);
+  EXPECT_EQ(out[1], 0xe1);
+  EXPECT_EQ(out[2], 0xff);
+}
+
+TEST(Packed12Test, TestRoundTrip) {
+  // sizes around the vector widths, to go through the scalar tails
+  for (size_t count : {2, 14, 16, 30, 32, 34, 62, 64, 66, 1000, 4098}) {
+    vector<int16_t> in(count);
+    for (size_t i = 0; i < count; i++) {
+      in[i] = (int16_t)((i * 2654435761u) % 4096) - 2048;
+    }
+    in[0] = -2048;
+    in[1] = 2047;
+    vector<uint8_t> packed(count / 2 * 3), expected(count / 2 * 3);
+    Packed12::Pack(in.data(), packed.data(), count);
+    PackScalar(in.data(), expected.data(), count);
+    EXPECT_EQ(packed, expected) << count;
+
+    vector<int16_t> out(count);
+    Packed12::Unpack(packed.data(), out.data(), count);
+    EXPECT_EQ(out, in) << count;
+  }
+}
+
+TEST(Packed12Test, TestFrame) {
+  Mat frame({4, 6, 10}, CV_16SC1);
+  int16_t* samples = (int16_t*)frame.data;
+  for (int i = 0; i < 4 * 6 * 10; i++) {
+    samples[i] = i % 4096 - 2048;
+  }
+
+  Mat packed;
+  Packed12::Pack(frame, packed);
+  EXPECT_EQ(packed.type(), CV_12SP);
+  EXPECT_EQ(packed.size[0], 4);
+  EXPECT_EQ(packed.size[1], 6);
+  EXPECT_EQ(packed.size[2], 5);
+  EXPECT_TRUE(Packed12::IsPacked(Packed12::GetPackedShape({4, 6, 10}),
+                                 packed.type()));
+  // a color image is not packed
+  EXPECT_FALSE(Packed12::IsPacked({480, 640}, CV_8UC3));
+
+  Mat unpacked;
+  Packed12::Unpack(packed, unpacked);
+  EXPECT_EQ(unpacked.type(), CV_16SC1);
+  EXPECT_EQ(unpacked.size[2], 10);
+  EXPECT_EQ(norm(frame, unpacked, NORM_INF), 0);
+}
@@ -102,6 +102,25 @@ TEST(PadTest, TestPadPushFrame) {
   pad3.PushFrame(frame);
 }
 
+TEST(PadTest, TestPadPushDynamicFrame) {
+  Pad pad1(kPadSource, "src");
+  Pad pad2(kPadSink, "sink");
+  ElementMock elem;
+
+  EXPECT_CALL(elem, PushFrame).Times(2);
+
+  pad1.Link(&pad2);
+  pad2.SetParent(&elem);
+  pad1.SetFrameFormat({MAT_DIM_DYNAMIC, 3}, CV_32FC1);
+
+  cv::Mat frame1(10, 3, CV_32FC1);
+  cv::Mat frame2(20, 3, CV_32FC1);
+  cv::Mat frame3(20, 4, CV_32FC1);
+  pad1.PushFrame(frame1);
+  pad1.PushFrame(frame2);
+  pad1.PushFrame(frame3);
+}
+
 TEST(PadTest, TestPadObservers) {
   Pad pad(kPadSource, "src");
   NiceMock<PadObserverMock> observer1;
@@ -0,0 +1,156 @@
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include <sdk/core/base-sink.h>
+#include <sdk/core/pad.h>
+#include <sdk/core/synchronizer.h>
+
+#include <algorithm>
+#include <thread>
+
+class SyncSinkFake : public BaseSink {
+ public:
+  SyncSinkFake() {}
+  ~SyncSinkFake() {}
+  void SinkFrame(cv::Mat& frame) override { frames.push_back(frame.clone()); }
+  vector<Mat> frames;
+};
+
+// capture time is written in the frame by the test
+static Mat MakeFrame(float timestamp) {
+  return Mat({1, 2, 2}, CV_32FC1, Scalar(timestamp));
+}
+
+static int64_t FrameTimestamp(int input, const Mat& frame) {
+  return (int64_t)frame.at<float>(0, 0, 0);
+}
+
+class SynchronizerTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    sync_.SetTimestampFunction(FrameTimestamp);
+    sync_.SetTolerance(10);
+    sync_.SetGroupCallback([this](SyncGroup& group) {
+      groups_.push_back(group);
+    });
+    src0_.Link(sync_.GetSinkPad(0));
+    src1_.Link(sync_.GetSinkPad(1));
+  }
+
+  void Push(Pad& pad, float timestamp) {
+    Mat frame = MakeFrame(timestamp);
+    pad.PushFrame(frame);
+  }
+
+  // the synchronizer unlinks from the pads, so it goes first
+  Pad src0_{kPadSource, "src0"};
+  Pad src1_{kPadSource, "src1"};
+  Synchronizer sync_{"sync", 2};
+  vector<SyncGroup> groups_;
+};
+
+TEST_F(SynchronizerTest, TestGroupWithinTolerance) {
+  Push(src0_, 100);
+  EXPECT_EQ(groups_.size(), 0);
+  Push(src1_, 105);
+  ASSERT_EQ(groups_.size(), 1);
+  EXPECT_EQ(groups_[0].skew_us, 5);
+  EXPECT_EQ(groups_[0].timestamps_us[0], 100);
+  EXPECT_EQ(groups_[0].timestamps_us[1], 105);
+
+  SyncStats stats = sync_.GetStats();
+  EXPECT_EQ(stats.groups, 1);
+  EXPECT_EQ(stats.dropped, 0);
+  EXPECT_EQ(stats.max_skew_us, 5);
+}
+
+TEST_F(SynchronizerTest, TestDropUnmatched) {
+  // input 0 lost the frame matching 100
+  Push(src1_, 100);
+  Push(src0_, 133);
+  Push(src1_, 135);
+  ASSERT_EQ(groups_.size(), 1);
+  EXPECT_EQ(groups_[0].timestamps_us[1], 135);
+  EXPECT_EQ(sync_.GetStats().dropped, 1);
+
+  // its group is gone
+  Push(src0_, 101);
+  EXPECT_EQ(sync_.GetStats().late, 1);
+  EXPECT_EQ(groups_.size(), 1);
+}
+
+TEST_F(SynchronizerTest, TestEmitPartial) {
+  sync_.SetPolicy(kSyncEmitPartial);
+  Push(src1_, 100);
+  Push(src0_, 133);
+  ASSERT_EQ(groups_.size(), 1);
+  EXPECT_TRUE(groups_[0].frames[0].empty());
+  EXPECT_FALSE(groups_[0].frames[1].empty());
+  EXPECT_EQ(sync_.GetStats().partial_groups, 1);
+}
+
+TEST_F(SynchronizerTest, TestDeadInput) {
+  sync_.SetPolicy(kSyncEmitPartial);
+  sync_.SetDepth(4);
+  for (int i = 0; i < 4; i++) {
+    Push(src0_, i * 33);
+  }
+  // input 0 cannot wait for input 1 any longer
+  ASSERT_EQ(groups_.size(), 1);
+  EXPECT_EQ(groups_[0].timestamps_us[0], 0);
+  EXPECT_TRUE(groups_[0].frames[1].empty());
+}
+
+TEST_F(SynchronizerTest, TestBufferOverflow) {
+  sync_.SetDepth(4);
+  for (int i = 0; i < 6; i++) {
+    Push(src0_, i * 33);
+  }
+  EXPECT_EQ(sync_.GetStats().dropped, 2);
+  // the oldest buffered frame is the third one
+  Push(src1_, 66);
+  ASSERT_EQ(groups_.size(), 1);
+  EXPECT_EQ(groups_[0].timestamps_us[0], 66);
+}
+
+TEST_F(SynchronizerTest, TestStackedOutput) {
+  SyncSinkFake sink;
+  sync_.GetSourcePad()->Link(sink.GetSinkPad());
+  src0_.SetFrameFormat({1, 2, 2}, CV_32FC1);
+  src1_.SetFrameFormat({1, 2, 2}, CV_32FC1);
+
+  MatShape shape;
+  int type;
+  sync_.GetSourcePad()->GetFrameFormat(shape, type);
+  ASSERT_EQ(shape.dims(), 3);
+  EXPECT_EQ(shape[0], 2);
+  EXPECT_EQ(type, CV_32FC1);
+
+  Push(src0_, 200);
+  Push(src1_, 201);
+  ASSERT_EQ(sink.frames.size(), 1);
+  EXPECT_EQ(sink.frames[0].at<float>(0, 1, 1), 200);
+  EXPECT_EQ(sink.frames[0].at<float>(1, 1, 1), 201);
+  sync_.GetSourcePad()->Unlink();
+}
+
+TEST_F(SynchronizerTest, TestCallbackReentry) {
+  // the callback queries the synchronizer while both inputs keep pushing,
+  // partial groups let an input emit while the other one is in the callback
+  sync_.SetPolicy(kSyncEmitPartial);
+  vector<int64_t> timestamps;
+  sync_.SetGroupCallback([this, &timestamps](SyncGroup& group) {
+    timestamps.push_back(group.timestamp_us);
+    // long enough for the other input to match a group meanwhile
+    this_thread::sleep_for(chrono::microseconds(50));
+    sync_.GetStats();
+  });
+  thread other([this] {
+    for (int i = 0; i < 1000; i++) Push(src1_, i * 100);
+  });
+  for (int i = 0; i < 1000; i++) Push(src0_, i * 100);
+  other.join();
+
+  EXPECT_GT(timestamps.size(), 0);
+  EXPECT_EQ(sync_.GetStats().groups, timestamps.size());
+  EXPECT_TRUE(is_sorted(timestamps.begin(), timestamps.end()));
+}
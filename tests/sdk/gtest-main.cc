@@ -2,7 +2,9 @@
 #include <gtest/gtest.h>
 #include <unistd.h>
 
+#include <cstdlib>
 #include <iostream>
+#include <string>
 
 int main(int argc, char** argv) {
   testing::InitGoogleTest(&argc, argv);
@@ -14,5 +16,18 @@ int main(int argc, char** argv) {
   std::cout << "Current working dir: " << cwd << std::endl;
   free(cwd);
 
-  return RUN_ALL_TESTS();
+  // keep the undistortion maps of the tests out of the user cache
+  char cacheHome[] = "/tmp/tct-tests-cache-XXXXXX";
+  bool tmpCache = mkdtemp(cacheHome) != nullptr;
+  if (tmpCache) {
+    setenv("XDG_CACHE_HOME", cacheHome, 1);
+  }
+
+  int result = RUN_ALL_TESTS();
+
+  if (tmpCache) {
+    std::string cmd = std::string("rm -rf ") + cacheHome;
+    system(cmd.c_str());
+  }
+  return result;
 }
\ No newline at end of file
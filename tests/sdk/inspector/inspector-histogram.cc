@@ -74,7 +74,8 @@ TEST_F(InspectorHistogramTest, TestSetBinsUniform) {
   float min = 0;
   float max = 10;
   int num_bins = 5;
-  inspector_histogram_mock_->SetBins(min, max, num_bins);
+  inspector_histogram_mock_->SetRanges(min, max);
+  inspector_histogram_mock_->SetBins(num_bins);
   auto edges = inspector_histogram_mock_->GetEdges();
   EXPECT_EQ(edges.size(), 6);
   EXPECT_EQ(edges[0], 0);
@@ -90,7 +91,9 @@ TEST_F(InspectorHistogramTest, TestGetHistogram) {
   float min = 0, max = 10;
   inspector_histogram_mock_->SetFrameFormat({1, 10, 10}, CV_32FC1);
   inspector_histogram_mock_->SelectChannel(kDepthChannel);
-  inspector_histogram_mock_->SetBins(min, max, bins);
+  inspector_histogram_mock_->SetAutoRange(false);
+  inspector_histogram_mock_->SetRanges(min, max);
+  inspector_histogram_mock_->SetBins(bins);
 
   inspector_histogram_mock_->SetRoi(0, 0, 10, 10);
 
@@ -101,4 +104,27 @@ TEST_F(InspectorHistogramTest, TestGetHistogram) {
   EXPECT_EQ(hist.total(), 2);
   EXPECT_EQ(hist.at<float>(0), 5);
   EXPECT_EQ(hist.at<float>(1), 5);
-}
\ No newline at end of file
+}
+
+TEST_F(InspectorHistogramTest, TestGetHistogramAutoRange) {
+  inspector_histogram_mock_->SetFrameFormat({1, 10, 10}, CV_32FC1);
+  inspector_histogram_mock_->SetAutoRange(true);
+  inspector_histogram_mock_->SetBins(4);
+  // rows 2..3, values 20..39
+  inspector_histogram_mock_->SetRoi(0, 2, 9, 3);
+  data_[25] = std::numeric_limits<float>::quiet_NaN();
+
+  Mat frame({1, 10, 10}, CV_32FC1, data_);
+  const Mat& hist = inspector_histogram_mock_->CalculateHistogram(frame);
+
+  float min, max;
+  inspector_histogram_mock_->GetHistogramRanges(min, max);
+  EXPECT_EQ(min, 20);
+  EXPECT_EQ(max, 39);
+  ASSERT_EQ(hist.total(), 4);
+  // bins of 4.75, 25 is NaN, the max is in the last one
+  EXPECT_EQ(hist.at<float>(0), 5);
+  EXPECT_EQ(hist.at<float>(1), 4);
+  EXPECT_EQ(hist.at<float>(2), 5);
+  EXPECT_EQ(hist.at<float>(3), 5);
+}
@@ -0,0 +1,151 @@
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include <sdk/inspector/inspector-logger.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <fstream>
+#include <sstream>
+#include <thread>
+
+class InspectorLogTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    char tmpl[] = "/tmp/tct-inspector-log-XXXXXX";
+    int fd = mkstemp(tmpl);
+    close(fd);
+    filename_ = tmpl;
+  }
+
+  void TearDown() override { unlink(filename_.c_str()); }
+
+  vector<string> ReadLines() {
+    ifstream file(filename_);
+    vector<string> lines;
+    string line;
+    while (getline(file, line)) {
+      lines.push_back(line);
+    }
+    return lines;
+  }
+
+  string filename_;
+};
+
+TEST_F(InspectorLogTest, TestTrackerCsv) {
+  TrackerLogger logger;
+  logger.SetFrameFormat({2, 4, 4}, CV_32FC1);
+  logger.SetLocation(1, 2);
+  ASSERT_TRUE(logger.Open(filename_, kInspectorLogCsv));
+  for (int k = 0; k < 3; k++) {
+    Mat frame({2, 4, 4}, CV_32FC1, Scalar(0));
+    frame.at<float>(0, 2, 1) = 0.5f + k;
+    logger.OnNewFrame(frame);
+  }
+  logger.Close();
+  EXPECT_FALSE(logger.IsOpen());
+  EXPECT_EQ(logger.GetRecordsWritten(), 3);
+
+  auto lines = ReadLines();
+  ASSERT_EQ(lines.size(), 4);
+  EXPECT_EQ(lines[0], "time,0");
+  double last = 0;
+  for (int k = 0; k < 3; k++) {
+    double time;
+    float value;
+    char comma;
+    istringstream(lines[k + 1]) >> time >> comma >> value;
+    EXPECT_GE(time, last);
+    EXPECT_EQ(value, 0.5f + k);
+    last = time;
+  }
+}
+
+TEST_F(InspectorLogTest, TestColumnarChunks) {
+  InspectorLog log;
+  ASSERT_TRUE(log.Open(filename_, kInspectorLogColumnar));
+  float a[] = {1, 2};
+  float b[] = {3, 4};
+  float c[] = {5, 6, 7};
+  EXPECT_TRUE(log.Write(a, 2));
+  EXPECT_TRUE(log.Write(b, 2));
+  EXPECT_TRUE(log.Write(c, 3));
+  log.Close();
+
+  // a chunk per number of columns
+  FILE* fp = fopen(filename_.c_str(), "rb");
+  ASSERT_NE(fp, nullptr);
+  InspectorLogChunkHeader header;
+  ASSERT_EQ(fread(&header, sizeof(header), 1, fp), 1);
+  EXPECT_EQ(header.magic, INSPECTOR_LOG_MAGIC);
+  EXPECT_EQ(header.rows, 2);
+  EXPECT_EQ(header.columns, 2);
+  double times[2];
+  float values[4];
+  ASSERT_EQ(fread(times, sizeof(double), 2, fp), 2);
+  ASSERT_EQ(fread(values, sizeof(float), 4, fp), 4);
+  EXPECT_LE(times[0], times[1]);
+  EXPECT_EQ(vector<float>(values, values + 4), vector<float>({1, 3, 2, 4}));
+
+  ASSERT_EQ(fread(&header, sizeof(header), 1, fp), 1);
+  EXPECT_EQ(header.rows, 1);
+  EXPECT_EQ(header.columns, 3);
+  ASSERT_EQ(fread(times, sizeof(double), 1, fp), 1);
+  ASSERT_EQ(fread(values, sizeof(float), 3, fp), 3);
+  EXPECT_EQ(values[2], 7);
+  EXPECT_EQ(fread(&header, sizeof(header), 1, fp), 0);
+  fclose(fp);
+}
+
+TEST_F(InspectorLogTest, TestDropped) {
+  InspectorLog log;
+  float values[16] = {};
+  // closed
+  EXPECT_FALSE(log.Write(values, 1));
+
+  log.SetBufferSize(64);
+  ASSERT_TRUE(log.Open(filename_, kInspectorLogCsv));
+  // larger than the ring, never fits
+  EXPECT_FALSE(log.Write(values, 16));
+  EXPECT_TRUE(log.Write(values, 2));
+  log.Close();
+  EXPECT_EQ(log.GetRecordsDropped(), 1);
+  EXPECT_EQ(log.GetRecordsWritten(), 1);
+  EXPECT_EQ(ReadLines().size(), 2);
+}
+
+TEST_F(InspectorLogTest, TestCloseWhileStreaming) {
+  InspectorLog log;
+  log.SetBufferSize(1024);
+  ASSERT_TRUE(log.Open(filename_, kInspectorLogCsv));
+  atomic<bool> streaming(true);
+  thread producer([&log, &streaming] {
+    float values[] = {1, 2, 3};
+    while (streaming) {
+      log.Write(values, 3);
+    }
+  });
+
+  // reopen with another ring size while records keep coming
+  for (int i = 0; i < 20; i++) {
+    this_thread::sleep_for(chrono::milliseconds(2));
+    log.Close();
+    log.SetBufferSize(i % 2 ? 1024 : 4096);
+    ASSERT_TRUE(log.Open(filename_, kInspectorLogCsv));
+  }
+  this_thread::sleep_for(chrono::milliseconds(2));
+  log.Close();
+  uint64_t written = log.GetRecordsWritten();
+  this_thread::sleep_for(chrono::milliseconds(2));
+  streaming = false;
+  producer.join();
+
+  // nothing is written past Close(), and no record is torn
+  EXPECT_EQ(log.GetRecordsWritten(), written);
+  auto lines = ReadLines();
+  ASSERT_EQ(lines.size(), written + 1);
+  EXPECT_EQ(lines[0], "time,0,1,2");
+  for (int k = 1; k < (int)lines.size(); k++) {
+    EXPECT_EQ(lines[k].substr(lines[k].find(',')), ",1,2,3");
+  }
+}
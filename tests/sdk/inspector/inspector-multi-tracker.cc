@@ -0,0 +1,138 @@
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include <sdk/inspector/inspector-multi-tracker.h>
+
+#include <cmath>
+#include <limits>
+
+using testing::_;
+using testing::NiceMock;
+using testing::SaveArg;
+
+class MultiPointTrackerMock : public MultiPointTracker {
+ public:
+  virtual ~MultiPointTrackerMock(){};
+  MOCK_METHOD(void, RenderPoints, (double t, const vector<float>& values),
+              (override));
+  MOCK_METHOD(void, OnFrameFormatChanged, (const MatShape& shape, int type),
+              (override));
+  const vector<float>& SamplePoints(Mat& frame) {
+    return MultiPointTracker::SamplePoints(frame);
+  }
+};
+
+class MultiPointTrackerTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    tracker_.SetFrameFormat({2, 10, 10}, CV_32FC1);
+    frame_ = Mat({2, 10, 10}, CV_32FC1);
+    for (int i = 0; i < 200; i++) {
+      ((float*)frame_.data)[i] = i;
+    }
+  }
+
+  NiceMock<MultiPointTrackerMock> tracker_;
+  Mat frame_;
+};
+
+TEST_F(MultiPointTrackerTest, TestSamplePoints) {
+  EXPECT_EQ(tracker_.AddPoint(1, 2), 0);
+  // mean of the 3x3 neighbourhood
+  EXPECT_EQ(tracker_.AddPoint(5, 5, 1), 1);
+  // clamped to the frame, 2x2 pixels left
+  EXPECT_EQ(tracker_.AddPoint(12, 12, 1), 2);
+
+  auto& values = tracker_.SamplePoints(frame_);
+  ASSERT_EQ(values.size(), 3);
+  EXPECT_EQ(values[0], 21);
+  EXPECT_FLOAT_EQ(values[1], 55);
+  EXPECT_FLOAT_EQ(values[2], (88 + 89 + 98 + 99) / 4.0f);
+
+  // invalid pixels are left out
+  frame_.at<float>(0, 4, 4) = std::numeric_limits<float>::quiet_NaN();
+  frame_.at<float>(0, 6, 6) = std::numeric_limits<float>::quiet_NaN();
+  EXPECT_FLOAT_EQ(tracker_.SamplePoints(frame_)[1], 55);
+
+  tracker_.SelectChannel(kAmplitudeChannel);
+  EXPECT_EQ(tracker_.SamplePoints(frame_)[0], 121);
+}
+
+TEST_F(MultiPointTrackerTest, TestOneCallPerFrame) {
+  tracker_.AddPoint(0, 0);
+  tracker_.AddPoint(9, 9);
+  vector<float> values;
+  EXPECT_CALL(tracker_, RenderPoints(_, _))
+      .Times(2)
+      .WillRepeatedly(SaveArg<1>(&values));
+  tracker_.OnNewFrame(frame_);
+  tracker_.OnNewFrame(frame_);
+  ASSERT_EQ(values.size(), 2);
+  EXPECT_EQ(values[1], 99);
+
+  vector<TimeSeriesPoint> history;
+  tracker_.QueryHistory(1, 0, 1e9, 100, history);
+  ASSERT_EQ(history.size(), 2);
+  EXPECT_EQ(history[0].mean, 99);
+
+  tracker_.RemovePoint(0);
+  EXPECT_EQ(tracker_.GetPointCount(), 1);
+  tracker_.QueryHistory(0, 0, 1e9, 100, history);
+  EXPECT_EQ(history.size(), 2);
+}
+
+TEST(TimeSeriesTest, TestRecentSamples) {
+  TimeSeries series(64, 4, 3);
+  for (int i = 0; i < 10; i++) {
+    series.Add(i, i);
+  }
+  vector<TimeSeriesPoint> points;
+  series.Query(2, 5, 100, points);
+  ASSERT_EQ(points.size(), 4);
+  EXPECT_EQ(points[0].t, 2);
+  EXPECT_EQ(points[3].mean, 5);
+}
+
+TEST(TimeSeriesTest, TestLongHistory) {
+  // the last level spans 64 * 4^5 samples
+  TimeSeries series(64, 4, 6);
+  int n = 20000;
+  for (int i = 0; i < n; i++) {
+    series.Add(i, (i == 5000) ? 1000 : i % 100);
+  }
+  EXPECT_EQ(series.GetTotal(), n);
+
+  vector<TimeSeriesPoint> points;
+  series.Query(0, n, 50, points);
+  ASSERT_LE(points.size(), 50);
+  ASSERT_GE(points.size(), 3);
+  EXPECT_EQ(points.front().t, 0);
+  // the last samples are there, even if not summarized yet
+  EXPECT_GE(points.back().t, n - 64);
+  float max = 0;
+  for (size_t i = 0; i < points.size(); i++) {
+    if (i > 0) {
+      EXPECT_GT(points[i].t, points[i - 1].t);
+    }
+    max = std::max(max, points[i].max);
+  }
+  // the spike is kept by the min/max levels
+  EXPECT_EQ(max, 1000);
+}
+
+TEST(TimeSeriesTest, TestLttb) {
+  TimeSeries series(4096, 16, 2);
+  for (int i = 0; i < 1000; i++) {
+    series.Add(i, (i == 500) ? 50 : 0);
+  }
+  vector<TimeSeriesPoint> points;
+  series.Query(0, 1000, 20, points);
+  ASSERT_EQ(points.size(), 20);
+  EXPECT_EQ(points.front().t, 0);
+  EXPECT_EQ(points.back().t, 999);
+  // the peak makes the largest triangle of its bucket
+  bool peak = false;
+  for (auto& p : points) {
+    peak = peak || (p.t == 500 && p.mean == 50);
+  }
+  EXPECT_TRUE(peak);
+}
@@ -0,0 +1,121 @@
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include <sdk/inspector/inspector-noise.h>
+
+#include <cmath>
+#include <limits>
+
+using testing::_;
+using testing::NiceMock;
+using testing::SaveArg;
+
+class InspectorNoiseMock : public InspectorNoise {
+ public:
+  virtual ~InspectorNoiseMock(){};
+  MOCK_METHOD(void, RenderNoise, (const NoiseReport& report), (override));
+  MOCK_METHOD(void, OnFrameFormatChanged, (const MatShape& shape, int type),
+              (override));
+  void Accumulate(Mat& frame) { InspectorNoise::Accumulate(frame); }
+  void BuildReport(NoiseReport& report) { InspectorNoise::BuildReport(report); }
+};
+
+class InspectorNoiseTest : public ::testing::Test {
+ protected:
+  void SetUp() override { inspector_.SetFrameFormat({2, 4, 4}, CV_32FC1); }
+
+  // pixel i alternates around 1 + 0.1 * i, by +-0.01 * (i + 1)
+  Mat MakeFrame(int k) {
+    Mat frame({2, 4, 4}, CV_32FC1);
+    for (int i = 0; i < 16; i++) {
+      float s = 0.01f * (i + 1);
+      frame.at<float>(0, i / 4, i % 4) = 1 + 0.1f * i + ((k % 2) ? s : -s);
+      frame.at<float>(1, i / 4, i % 4) = 100 + i;
+    }
+    return frame;
+  }
+
+  NiceMock<InspectorNoiseMock> inspector_;
+};
+
+TEST_F(InspectorNoiseTest, TestRunningStats) {
+  for (int k = 0; k < 100; k++) {
+    Mat frame = MakeFrame(k);
+    inspector_.Accumulate(frame);
+  }
+  NoiseReport report;
+  inspector_.BuildReport(report);
+  EXPECT_EQ(report.frames, 100);
+  for (int i = 0; i < 16; i++) {
+    EXPECT_NEAR(report.depth_mean.at<float>(i / 4, i % 4), 1 + 0.1f * i, 1e-5);
+    EXPECT_NEAR(report.depth_std.at<float>(i / 4, i % 4), 0.01f * (i + 1),
+                1e-5);
+    EXPECT_NEAR(report.amplitude_mean.at<float>(i / 4, i % 4), 100 + i, 1e-3);
+    EXPECT_NEAR(report.amplitude_std.at<float>(i / 4, i % 4), 0, 1e-3);
+  }
+  // the upper of the two middle values
+  EXPECT_NEAR(report.median_depth_std, 0.09f, 1e-5);
+
+  // noise grows with distance, and with amplitude here
+  ASSERT_GE(report.noise_vs_distance.size(), 2);
+  EXPECT_LT(report.noise_vs_distance.front().noise,
+            report.noise_vs_distance.back().noise);
+  ASSERT_GE(report.noise_vs_amplitude.size(), 2);
+  int pixels = 0;
+  for (auto& p : report.noise_vs_amplitude) {
+    pixels += p.pixels;
+  }
+  EXPECT_EQ(pixels, 16);
+}
+
+TEST_F(InspectorNoiseTest, TestInvalidSamples) {
+  for (int k = 0; k < 10; k++) {
+    Mat frame = MakeFrame(k);
+    // pixel 0 is valid once, pixel 1 never
+    if (k > 0) frame.at<float>(0, 0, 0) = 0;
+    frame.at<float>(0, 0, 1) = std::numeric_limits<float>::quiet_NaN();
+    inspector_.Accumulate(frame);
+  }
+  NoiseReport report;
+  inspector_.BuildReport(report);
+  EXPECT_NEAR(report.depth_mean.at<float>(0, 0), 0.99f, 1e-5);
+  EXPECT_TRUE(std::isnan(report.depth_std.at<float>(0, 0)));
+  EXPECT_TRUE(std::isnan(report.depth_mean.at<float>(0, 1)));
+  EXPECT_NEAR(report.depth_std.at<float>(0, 2), 0.03f, 1e-5);
+}
+
+TEST_F(InspectorNoiseTest, TestWindow) {
+  inspector_.SetWindow(10);
+  Mat frame = MakeFrame(0);
+  for (int k = 0; k < 100; k++) {
+    inspector_.Accumulate(frame);
+  }
+  // a step, older frames fade out
+  for (int i = 0; i < 32; i++) {
+    ((float*)frame.data)[i] += 1;
+  }
+  for (int k = 0; k < 100; k++) {
+    inspector_.Accumulate(frame);
+  }
+  NoiseReport report;
+  inspector_.BuildReport(report);
+  EXPECT_NEAR(report.depth_mean.at<float>(0, 0), frame.at<float>(0, 0, 0),
+              1e-3);
+  EXPECT_NEAR(report.depth_std.at<float>(0, 0), 0, 1e-3);
+}
+
+TEST_F(InspectorNoiseTest, TestPublish) {
+  inspector_.SetPublishInterval(0);
+  EXPECT_CALL(inspector_, RenderNoise(_)).Times(3);
+  for (int k = 0; k < 3; k++) {
+    Mat frame = MakeFrame(k);
+    inspector_.OnNewFrame(frame);
+  }
+  EXPECT_EQ(inspector_.GetFrameCount(), 3);
+
+  inspector_.Reset();
+  inspector_.SetPublishInterval(60000);
+  EXPECT_CALL(inspector_, RenderNoise(_)).Times(0);
+  Mat frame = MakeFrame(0);
+  inspector_.OnNewFrame(frame);
+  EXPECT_EQ(inspector_.GetFrameCount(), 1);
+}
@@ -0,0 +1,134 @@
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include <sdk/inspector/inspector-plane-fit.h>
+
+#include <cmath>
+#include <limits>
+
+using testing::_;
+using testing::NiceMock;
+using testing::SaveArg;
+
+class InspectorPlaneFitMock : public InspectorPlaneFit {
+ public:
+  virtual ~InspectorPlaneFitMock(){};
+  MOCK_METHOD(void, RenderPlaneFit, (const PlaneFitReport& report),
+              (override));
+  MOCK_METHOD(void, OnFrameFormatChanged, (const MatShape& shape, int type),
+              (override));
+  void Fit(Mat& frame, PlaneFitReport& report) {
+    InspectorPlaneFit::Fit(frame, report);
+  }
+};
+
+class InspectorPlaneFitTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    inspector_.SetFrameFormat({2, 60, 80}, CV_32FC1);
+    PinholeParams params(1.0f, 1.0f, 40, 30, 10.0f, 10.0f);
+    inspector_.SetParams(params);
+    // 100 pixels focal length
+    focal_ = 100;
+    // a wall at 2, tilted around the y axis
+    float norm = sqrt(0.2f * 0.2f + 1);
+    normal_[0] = 0.2f / norm;
+    normal_[1] = 0;
+    normal_[2] = 1 / norm;
+    frame_ = Mat({2, 60, 80}, CV_32FC1);
+    for (int y = 0; y < 60; y++) {
+      for (int x = 0; x < 80; x++) {
+        float u = (x - 40) / focal_;
+        frame_.at<float>(0, y, x) = 2 / (normal_[0] * u + normal_[2]);
+        frame_.at<float>(1, y, x) = 100;
+      }
+    }
+  }
+
+  NiceMock<InspectorPlaneFitMock> inspector_;
+  Mat frame_;
+  float focal_;
+  float normal_[3];
+};
+
+TEST_F(InspectorPlaneFitTest, TestFitWall) {
+  inspector_.SetRoi(10, 5, 69, 54);
+  // some invalid pixels
+  frame_.at<float>(0, 10, 10) = 0;
+  frame_.at<float>(0, 20, 30) = std::numeric_limits<float>::quiet_NaN();
+
+  PlaneFitReport report;
+  EXPECT_CALL(inspector_, RenderPlaneFit(_)).WillOnce(SaveArg<0>(&report));
+  inspector_.OnNewFrame(frame_);
+  ASSERT_TRUE(report.ok);
+  EXPECT_EQ(report.valid, 60 * 50 - 2);
+  EXPECT_EQ(report.inliers, report.valid);
+  for (int i = 0; i < 3; i++) {
+    EXPECT_NEAR(report.normal[i], normal_[i], 1e-4);
+  }
+  EXPECT_NEAR(report.distance, 2, 1e-4);
+  EXPECT_NEAR(report.rms, 0, 1e-4);
+  EXPECT_TRUE(std::isnan(report.bias));
+
+  ASSERT_EQ(report.residual.rows, 50);
+  ASSERT_EQ(report.residual.cols, 60);
+  EXPECT_TRUE(std::isnan(report.residual.at<float>(5, 0)));
+  EXPECT_NEAR(report.residual.at<float>(0, 0), 0, 1e-4);
+}
+
+TEST_F(InspectorPlaneFitTest, TestReference) {
+  inspector_.SetRoi(0, 0, 79, 59);
+  inspector_.SetReference(1.9f, normal_[0], normal_[1], normal_[2]);
+  PlaneFitReport report;
+  inspector_.Fit(frame_, report);
+  ASSERT_TRUE(report.ok);
+  EXPECT_NEAR(report.bias, 0.1f, 1e-4);
+  EXPECT_NEAR(report.tilt, 0, 0.1);
+
+  // a fronto-parallel reference
+  inspector_.SetReference(2);
+  inspector_.Fit(frame_, report);
+  EXPECT_NEAR(report.tilt, atan(0.2f) * 180 / M_PI, 0.01);
+}
+
+TEST_F(InspectorPlaneFitTest, TestOutliers) {
+  // a box in front of a third of the wall
+  for (int y = 0; y < 60; y++) {
+    for (int x = 0; x < 25; x++) {
+      frame_.at<float>(0, y, x) -= 0.5f;
+    }
+  }
+  inspector_.SetRoi(0, 0, 79, 59);
+  PlaneFitReport report;
+  inspector_.Fit(frame_, report);
+  ASSERT_TRUE(report.ok);
+  EXPECT_EQ(report.inliers, 55 * 60);
+  EXPECT_NEAR(report.normal[0], normal_[0], 1e-4);
+  EXPECT_NEAR(report.distance, 2, 1e-4);
+  EXPECT_LT(report.residual.at<float>(0, 0), -0.4f);
+
+  // without outlier rejection, the box tilts the plane
+  inspector_.SetThreshold(0);
+  inspector_.Fit(frame_, report);
+  EXPECT_EQ(report.inliers, 80 * 60);
+  EXPECT_GT(fabs(report.normal[0] - normal_[0]), 0.01f);
+}
+
+TEST_F(InspectorPlaneFitTest, TestNotEnoughPixels) {
+  inspector_.SetRoi(0, 0, 9, 9);
+  for (int y = 0; y < 10; y++) {
+    for (int x = 0; x < 10; x++) {
+      frame_.at<float>(0, y, x) = 0;
+    }
+  }
+  frame_.at<float>(0, 3, 3) = 2;
+  PlaneFitReport report;
+  inspector_.Fit(frame_, report);
+  EXPECT_FALSE(report.ok);
+  EXPECT_EQ(report.valid, 1);
+  EXPECT_TRUE(std::isnan(report.residual.at<float>(3, 3)));
+
+  // no ROI, no report
+  NiceMock<InspectorPlaneFitMock> empty;
+  EXPECT_CALL(empty, RenderPlaneFit(_)).Times(0);
+  empty.OnNewFrame(frame_);
+}
@@ -0,0 +1,132 @@
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include <sdk/inspector/inspector-roi-stats.h>
+
+#include <cmath>
+#include <limits>
+
+using testing::_;
+using testing::NiceMock;
+using testing::SaveArg;
+
+class InspectorRoiStatsMock : public InspectorRoiStats {
+ public:
+  virtual ~InspectorRoiStatsMock(){};
+  MOCK_METHOD(void, RenderStats, (const vector<RoiStats>& stats), (override));
+  MOCK_METHOD(void, OnFrameFormatChanged, (const MatShape& shape, int type),
+              (override));
+};
+
+class InspectorRoiStatsTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    inspector_.SetFrameFormat({2, 10, 12}, CV_32FC1);
+    frame_ = Mat({2, 10, 12}, CV_32FC1);
+    for (int y = 0; y < 10; y++) {
+      for (int x = 0; x < 12; x++) {
+        frame_.at<float>(0, y, x) = 1 + 0.1f * x + y;
+        frame_.at<float>(1, y, x) = 100 + x * y;
+      }
+    }
+    // invalid depth
+    frame_.at<float>(0, 2, 3) = 0;
+    frame_.at<float>(0, 4, 5) = std::numeric_limits<float>::quiet_NaN();
+  }
+
+  // stats of the valid pixels, walking them
+  RoiStats Expected(const Rect& roi) {
+    RoiStats stats = {};
+    double sum[2] = {0, 0};
+    double sqsum[2] = {0, 0};
+    float mins[2] = {1e30f, 1e30f};
+    float maxs[2] = {-1e30f, -1e30f};
+    for (int y = roi.y; y < roi.y + roi.height; y++) {
+      for (int x = roi.x; x < roi.x + roi.width; x++) {
+        float depth = frame_.at<float>(0, y, x);
+        if (!(depth > 0)) continue;
+        stats.valid++;
+        for (int p = 0; p < 2; p++) {
+          float v = frame_.at<float>(p, y, x);
+          sum[p] += v;
+          sqsum[p] += (double)v * v;
+          mins[p] = std::min(mins[p], v);
+          maxs[p] = std::max(maxs[p], v);
+        }
+      }
+    }
+    RoiChannelStats* channels[] = {&stats.depth, &stats.amplitude};
+    for (int p = 0; p < 2; p++) {
+      channels[p]->mean = sum[p] / stats.valid;
+      channels[p]->stddev = std::sqrt(sqsum[p] / stats.valid -
+                                      channels[p]->mean * channels[p]->mean);
+      channels[p]->min = mins[p];
+      channels[p]->max = maxs[p];
+    }
+    return stats;
+  }
+
+  NiceMock<InspectorRoiStatsMock> inspector_;
+  Mat frame_;
+};
+
+TEST_F(InspectorRoiStatsTest, TestRoiClamped) {
+  int x, y, x2, y2;
+  int index = inspector_.AddRoi(8, -2, 20, 3);
+  EXPECT_EQ(index, 0);
+  inspector_.GetRoi(index, x, y, x2, y2);
+  EXPECT_EQ(x, 8);
+  EXPECT_EQ(y, 0);
+  EXPECT_EQ(x2, 11);
+  EXPECT_EQ(y2, 3);
+  EXPECT_EQ(inspector_.GetRoiCount(), 1);
+  inspector_.RemoveRoi(index);
+  EXPECT_EQ(inspector_.GetRoiCount(), 0);
+}
+
+TEST_F(InspectorRoiStatsTest, TestStatsMatchPixelWalk) {
+  inspector_.AddRoi(0, 0, 11, 9);
+  inspector_.AddRoi(2, 1, 6, 5);
+  inspector_.AddRoi(3, 2, 3, 2);
+  inspector_.AddRoi(11, 9, 11, 9);
+
+  vector<RoiStats> stats;
+  // one call per frame, for all the ROIs
+  EXPECT_CALL(inspector_, RenderStats(_))
+      .Times(1)
+      .WillOnce(SaveArg<0>(&stats));
+  inspector_.OnNewFrame(frame_);
+  ASSERT_EQ(stats.size(), 4);
+
+  for (int i : {0, 1, 3}) {
+    RoiStats expected = Expected(stats[i].roi);
+    EXPECT_EQ(stats[i].valid, expected.valid);
+    EXPECT_NEAR(stats[i].depth.mean, expected.depth.mean, 1e-6);
+    EXPECT_NEAR(stats[i].depth.stddev, expected.depth.stddev, 1e-4);
+    EXPECT_NEAR(stats[i].amplitude.mean, expected.amplitude.mean, 1e-6);
+    EXPECT_NEAR(stats[i].amplitude.stddev, expected.amplitude.stddev, 1e-4);
+    EXPECT_EQ(stats[i].depth.min, expected.depth.min);
+    EXPECT_EQ(stats[i].depth.max, expected.depth.max);
+    EXPECT_EQ(stats[i].amplitude.min, expected.amplitude.min);
+    EXPECT_EQ(stats[i].amplitude.max, expected.amplitude.max);
+  }
+  EXPECT_EQ(stats[0].valid, 118);
+  // the only pixel is invalid
+  EXPECT_EQ(stats[2].valid, 0);
+  EXPECT_EQ(stats[2].depth.mean, 0);
+}
+
+TEST_F(InspectorRoiStatsTest, TestDepthOnly) {
+  inspector_.SetFrameFormat({1, 10, 12}, CV_32FC1);
+  Mat depth({1, 10, 12}, CV_32FC1, Scalar(2));
+  inspector_.AddRoi(0, 0, 3, 3);
+  inspector_.SetMinMax(false);
+
+  vector<RoiStats> stats;
+  EXPECT_CALL(inspector_, RenderStats(_)).WillOnce(SaveArg<0>(&stats));
+  inspector_.OnNewFrame(depth);
+  ASSERT_EQ(stats.size(), 1);
+  EXPECT_EQ(stats[0].valid, 16);
+  EXPECT_DOUBLE_EQ(stats[0].depth.mean, 2);
+  EXPECT_NEAR(stats[0].depth.stddev, 0, 1e-6);
+  EXPECT_EQ(stats[0].amplitude.mean, 0);
+}
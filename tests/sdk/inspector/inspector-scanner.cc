@@ -5,142 +5,132 @@
 #include <iostream>
 
 using testing::NiceMock;
-class InspectorHScannerMock : public InspectorHScanner {
+class InspectorScannerMock : public InspectorScanner {
  public:
   MOCK_METHOD(void, RenderRange, (const std::vector<float>& vec), (override));
   MOCK_METHOD(void, OnFrameFormatChanged, (const MatShape& shape, int type),
               (override));
   const vector<float>& CollectRange(Mat& frame) {
-    return InspectorHScanner::CollectRange(frame);
-  }
-};
-
-class InspectorVScannerMock : public InspectorVScanner {
- public:
-  MOCK_METHOD(void, RenderRange, (const std::vector<float>& vec), (override));
-  MOCK_METHOD(void, OnFrameFormatChanged, (const MatShape& shape, int type),
-              (override));
-  const vector<float>& CollectRange(Mat& frame) {
-    return InspectorVScanner::CollectRange(frame);
+    return InspectorScanner::CollectRange(frame);
   }
 };
 
 class InspectorScannerTest : public ::testing::Test {
  public:
   InspectorScannerTest() {
-    hscanner_ = new NiceMock<InspectorHScannerMock>();
-    vscanner_ = new NiceMock<InspectorVScannerMock>();
+    scanner_ = new NiceMock<InspectorScannerMock>();
+    scanner_->SetFrameFormat({2, 10, 10}, CV_32FC1);
     data_ = new float[200];
     for (int i = 0; i < 200; i++) {
       data_[i] = i;
     }
   }
   ~InspectorScannerTest() {
-    delete hscanner_;
-    delete vscanner_;
-    delete data_;
+    delete scanner_;
+    delete[] data_;
   }
   int test_width_ = 10;
   int test_height_ = 10;
   float* data_;
-  NiceMock<InspectorHScannerMock>* hscanner_;
-  NiceMock<InspectorVScannerMock>* vscanner_;
+  NiceMock<InspectorScannerMock>* scanner_;
 };
 
-TEST_F(InspectorScannerTest, TestSetHRange) {
-  int x1, y1, xy2;
-  hscanner_->SetFrameFormat({2, 10, 10}, CV_32FC1);
+TEST_F(InspectorScannerTest, TestSetRange) {
+  int x1, y1, x2, y2;
   // in-bound range
-  hscanner_->SetRoi(1, 2, 3);
-  hscanner_->GetRoi(x1, y1, xy2);
+  scanner_->SetRoi(1, 2, 3, 4);
+  scanner_->GetRoi(x1, y1, x2, y2);
   EXPECT_EQ(x1, 1);
   EXPECT_EQ(y1, 2);
-  EXPECT_EQ(xy2, 3);
+  EXPECT_EQ(x2, 3);
+  EXPECT_EQ(y2, 4);
 
-  // out-bound range
-  hscanner_->SetRoi(-1, 2, 15);
-  hscanner_->GetRoi(x1, y1, xy2);
+  // out-bound range is clipped
+  scanner_->SetRoi(-1, 2, 15, 2);
+  scanner_->GetRoi(x1, y1, x2, y2);
   EXPECT_EQ(x1, 0);
   EXPECT_EQ(y1, 2);
-  EXPECT_EQ(xy2, 9);
+  EXPECT_EQ(x2, 9);
+  EXPECT_EQ(y2, 2);
 
-  // reverse selection
-  hscanner_->SetRoi(3, 2, 1);
-  hscanner_->GetRoi(x1, y1, xy2);
-  EXPECT_EQ(x1, 1);
-  EXPECT_EQ(y1, 2);
-  EXPECT_EQ(xy2, 3);
-}
-
-TEST_F(InspectorScannerTest, TestSetVRange) {
-  int x1, y1, xy2;
-  vscanner_->SetFrameFormat({2, 10, 10}, CV_32FC1);
-  // in-bound range
-  vscanner_->SetRoi(1, 2, 3);
-  vscanner_->GetRoi(x1, y1, xy2);
-  EXPECT_EQ(x1, 1);
-  EXPECT_EQ(y1, 2);
-  EXPECT_EQ(xy2, 3);
-
-  // out-bound range
-  vscanner_->SetRoi(1, -2, 15);
-  vscanner_->GetRoi(x1, y1, xy2);
-  EXPECT_EQ(x1, 1);
-  EXPECT_EQ(y1, 0);
-  EXPECT_EQ(xy2, 9);
-
-  // reverse selection
-  vscanner_->SetRoi(1, 3, 2);
-  vscanner_->GetRoi(x1, y1, xy2);
-  EXPECT_EQ(x1, 1);
-  EXPECT_EQ(y1, 2);
-  EXPECT_EQ(xy2, 3);
+  // still one line
+  EXPECT_EQ(scanner_->GetLineCount(), 1);
 }
 
-TEST_F(InspectorScannerTest, TestCollectRangeOneChannel) {
-  Mat frame({1, 10, 10}, CV_32FC1, data_);
-
-  hscanner_->SelectChannel(kDepthChannel);
-  hscanner_->SetRoi(1, 2, 3);
-  auto& hvec = hscanner_->CollectRange(frame);
+TEST_F(InspectorScannerTest, TestCollectRange) {
+  Mat frame({2, 10, 10}, CV_32FC1, data_);
 
-  EXPECT_EQ(hvec.size(), 3);
+  scanner_->SelectChannel(kDepthChannel);
+  scanner_->SetRoi(1, 2, 3, 2);
+  auto& hvec = scanner_->CollectRange(frame);
+  ASSERT_EQ(hvec.size(), 3);
   EXPECT_EQ(hvec[0], 21);
   EXPECT_EQ(hvec[1], 22);
   EXPECT_EQ(hvec[2], 23);
 
-  // vertical scan
-  vscanner_->SelectChannel(kDepthChannel);
-  vscanner_->SetRoi(1, 2, 3);
-  auto& vvec = vscanner_->CollectRange(frame);
-  EXPECT_EQ(vvec.size(), 2);
-  EXPECT_EQ(vvec[0], 21);
-  EXPECT_EQ(vvec[1], 31);
-
-  EXPECT_ANY_THROW({
-    hscanner_->SetFrameFormat({1, 10, 10}, CV_32FC1);
-    hscanner_->SelectChannel(kAmplitudeChannel);
-  });
+  scanner_->SelectChannel(kAmplitudeChannel);
+  scanner_->SetRoi(1, 2, 1, 3);
+  auto& vvec = scanner_->CollectRange(frame);
+  ASSERT_EQ(vvec.size(), 2);
+  EXPECT_EQ(vvec[0], 121);
+  EXPECT_EQ(vvec[1], 131);
 }
 
-TEST_F(InspectorScannerTest, TestCollectRangeAmplitude) {
+TEST_F(InspectorScannerTest, TestPolylines) {
   Mat frame({2, 10, 10}, CV_32FC1, data_);
-  hscanner_->SetFrameFormat({2, 10, 10}, CV_32FC1);
 
-  hscanner_->SelectChannel(kDepthChannel);
-  hscanner_->SetRoi(1, 2, 3);
-  auto& hvec = hscanner_->CollectRange(frame);
+  // shared vertices are sampled once
+  EXPECT_EQ(scanner_->AddLine({Point(0, 0), Point(2, 0), Point(2, 2)}), 0);
+  EXPECT_EQ(scanner_->AddLine({Point(5, 5)}), 1);
+  // clamped to the frame
+  EXPECT_EQ(scanner_->AddLine({Point(8, 9), Point(12, 9)}), 2);
+  EXPECT_EQ(scanner_->AddLine({}), -1);
+
+  auto& vec = scanner_->CollectRange(frame);
+  vector<float> expected = {0, 1, 2, 12, 22, 55, 98, 99};
+  EXPECT_EQ(vec, expected);
+  vector<int> starts = {0, 5, 6, 8};
+  EXPECT_EQ(scanner_->GetLineStarts(), starts);
+
+  scanner_->SetLine(1, {Point(0, 9), Point(0, 8)});
+  auto& vec2 = scanner_->CollectRange(frame);
+  ASSERT_EQ(vec2.size(), 9);
+  EXPECT_EQ(vec2[5], 90);
+  EXPECT_EQ(vec2[6], 80);
+}
 
-  EXPECT_EQ(hvec.size(), 3);
-  EXPECT_EQ(hvec[0], 21);
-  EXPECT_EQ(hvec[1], 22);
-  EXPECT_EQ(hvec[2], 23);
+TEST_F(InspectorScannerTest, TestBilinear) {
+  // linear in x and y, so the interpolation is exact
+  Mat frame({1, 10, 10}, CV_32FC1);
+  for (int y = 0; y < 10; y++) {
+    for (int x = 0; x < 10; x++) {
+      frame.at<float>(0, y, x) = x + 10 * y;
+    }
+  }
+  scanner_->SetInterpolation(kScannerBilinear);
+  scanner_->AddLine({Point(0, 0), Point(3, 4)});
+  auto& vec = scanner_->CollectRange(frame);
+  // one sample per pixel of length
+  ASSERT_EQ(vec.size(), 6);
+  for (int i = 0; i <= 5; i++) {
+    EXPECT_NEAR(vec[i], 0.6f * i + 8.0f * i, 1e-4);
+  }
 
-  vscanner_->SetFrameFormat({2, 10, 10}, CV_32FC1);
-  vscanner_->SelectChannel(kAmplitudeChannel);
-  vscanner_->SetRoi(1, 2, 3);
-  auto& vvec = vscanner_->CollectRange(frame);
-  EXPECT_EQ(vvec.size(), 2);
-  EXPECT_EQ(vvec[0], 121);
-  EXPECT_EQ(vvec[1], 131);
-}
\ No newline at end of file
+  // last row and column
+  scanner_->SetLine(0, {Point(9, 0), Point(9, 9)});
+  auto& edge = scanner_->CollectRange(frame);
+  ASSERT_EQ(edge.size(), 10);
+  EXPECT_NEAR(edge[9], 99, 1e-4);
+}
+
+TEST_F(InspectorScannerTest, TestFrameSizeChanged) {
+  scanner_->AddLine({Point(0, 0), Point(9, 0)});
+  Mat frame({2, 10, 10}, CV_32FC1, data_);
+  EXPECT_EQ(scanner_->CollectRange(frame).size(), 10);
+
+  // the samples are computed again, clamped to the new size
+  Mat small({1, 5, 5}, CV_32FC1, data_);
+  auto& vec = scanner_->CollectRange(small);
+  ASSERT_EQ(vec.size(), 5);
+  EXPECT_EQ(vec[4], 4);
+}
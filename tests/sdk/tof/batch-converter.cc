@@ -0,0 +1,112 @@
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include <sdk/tof/batch-converter.h>
+#include <sdk/tof/depth-calc.h>
+#include <sdk/tof/moving-average.h>
+#include <sdk/tof/playback-src.h>
+#include <unistd.h>
+
+class BatchConverterTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    char tmpl[] = "/tmp/tct-batch-XXXXXX";
+    ASSERT_NE(mkdtemp(tmpl), nullptr);
+    dir_ = tmpl;
+    input_ = dir_ + "/input.bin";
+
+    // 40 frames of 4 phases 8x16, no subframe header
+    ToFStreamHeader header = {64, 0, 16, 8, 30, 1, 2, 4, 40};
+    vector<uint8_t> data(64 + 40 * header.GetFrameSize(), 0);
+    memcpy(data.data(), &header, sizeof(header));
+    int16_t* samples = (int16_t*)(data.data() + 64);
+    for (size_t i = 0; i < 40 * 4 * 8 * 16; i++) {
+      samples[i] = (int16_t)((i * 7919) % 2000) - 1000;
+    }
+    FILE* fp = fopen(input_.c_str(), "wb");
+    ASSERT_NE(fp, nullptr);
+    fwrite(data.data(), 1, data.size(), fp);
+    fclose(fp);
+  }
+
+  void TearDown() override {
+    unlink(input_.c_str());
+    unlink(FrameIndex::GetFilename(input_).c_str());
+    unlink((dir_ + "/serial.bin").c_str());
+    unlink((dir_ + "/parallel.bin").c_str());
+    rmdir(dir_.c_str());
+  }
+
+  bool Convert(const string& output, int workers, int chunkSize) {
+    BatchConverter converter;
+    converter.SetInput(input_);
+    converter.SetOutput(output);
+    converter.SetWorkers(workers);
+    converter.SetChunkSize(chunkSize);
+    // depth, averaged over 3 frames
+    converter.SetOverlap(2);
+    converter.SetPipeline(
+        [](Pad* src, vector<shared_ptr<Element>>& elements) -> Pad* {
+          auto depth = make_shared<DepthCalc>("depth");
+          auto average = make_shared<MovingAverage>("average");
+          depth->SetConfig(37e6, 0);
+          average->SetWindowSize(3);
+          src->Link(depth->GetSinkPad());
+          depth->GetSourcePad()->Link(average->GetSinkPad());
+          elements.push_back(depth);
+          elements.push_back(average);
+          return average->GetSourcePad();
+        });
+    bool ok = converter.Run();
+    frames_ = converter.GetFramesWritten();
+    return ok;
+  }
+
+  vector<Mat> ReadResult(const string& filename) {
+    vector<Mat> frames;
+    PlaybackSource source("result", false, false);
+    source.SetFilename(filename);
+    source.SetContainer(kPlaybackContainerToF);
+    source.SetPacing(kPlaybackPacingUnthrottled);
+    if (!source.InitializeSource()) return frames;
+    for (Mat frame = source.GenerateFrame(); !frame.empty();
+         frame = source.GenerateFrame()) {
+      frames.push_back(frame.clone());
+    }
+    source.CleanupSource();
+    return frames;
+  }
+
+  string dir_;
+  string input_;
+  int frames_;
+};
+
+TEST_F(BatchConverterTest, TestChunksMatchSequential) {
+  string serial = dir_ + "/serial.bin";
+  string parallel = dir_ + "/parallel.bin";
+  ASSERT_TRUE(Convert(serial, 1, 0));
+  // moving average outputs from the 3rd frame on
+  EXPECT_EQ(frames_, 38);
+  ASSERT_TRUE(Convert(parallel, 4, 7));
+  EXPECT_EQ(frames_, 38);
+  // no chunk result left behind
+  EXPECT_NE(access((parallel + BATCH_PART_SUFFIX "0000").c_str(), F_OK), 0);
+
+  vector<Mat> expected = ReadResult(serial);
+  vector<Mat> actual = ReadResult(parallel);
+  ASSERT_EQ(expected.size(), 38);
+  ASSERT_EQ(actual.size(), expected.size());
+  for (size_t i = 0; i < actual.size(); i++) {
+    EXPECT_EQ(actual[i].size[0], 2);
+    EXPECT_EQ(actual[i].type(), CV_32FC1);
+    // running sums of the moving average start over at each chunk
+    EXPECT_LT(norm(actual[i], expected[i], NORM_INF), 1e-3) << i;
+  }
+}
+
+TEST_F(BatchConverterTest, TestMissingInput) {
+  BatchConverter converter;
+  converter.SetInput(dir_ + "/doesnt_exist.bin");
+  converter.SetOutput(dir_ + "/parallel.bin");
+  EXPECT_FALSE(converter.Run());
+}
@@ -2,6 +2,8 @@
 #include <gtest/gtest.h>
 #include <sdk/tof/camera-src.h>
 
+#include "fake-camera.h"
+
 class ToFCameraTest : public ::testing::Test {
  protected:
   void SetUp() override {
@@ -24,3 +26,44 @@ TEST_F(ToFCameraTest, TestGenerateFrame) {
   EXPECT_EQ(m.size[2], 640);
   EXPECT_EQ(m.type(), CV_16SC1);
 }
+
+TEST(IPCameraTest, TestReadEOF) {
+  FakeCamera camera(0);
+  camera.Start();
+  IPCamera ip;
+  ASSERT_TRUE(ip.Open("127.0.0.1", camera.port_));
+  ip.Write("getFrame", 8);
+  vector<char> buffer(4 * 480 * 640 * 2);
+  // used to spin forever
+  EXPECT_EQ(ip.Read(buffer.data(), buffer.size()), -1);
+}
+
+TEST(IPCameraTest, TestReadTimeout) {
+  FakeCamera camera;
+  camera.silent_ = true;
+  camera.Start();
+  IPCamera ip;
+  ip.SetTimeout(100);
+  ASSERT_TRUE(ip.Open("127.0.0.1", camera.port_));
+  char buffer[16];
+  auto start = chrono::steady_clock::now();
+  EXPECT_EQ(ip.Read(buffer, sizeof(buffer)), -1);
+  EXPECT_LT(chrono::steady_clock::now() - start, chrono::seconds(1));
+  ip.Write("x", 1);
+}
+
+TEST(IPCameraTest, TestPipelinedFrames) {
+  FakeCamera camera(5);
+  camera.Start();
+  ToFCameraSrc source("127.0.0.1:" + to_string(camera.port_));
+  source.SetOutstandingRequests(3);
+  ASSERT_TRUE(source.InitializeSource());
+  for (int i = 0; i < 5; i++) {
+    Mat frame = source.GenerateFrame();
+    ASSERT_FALSE(frame.empty());
+    EXPECT_EQ(frame.at<int16_t>(0, 0, 0), i);
+  }
+  // the camera hangs up in the middle of the next frame
+  EXPECT_TRUE(source.GenerateFrame().empty());
+  source.CleanupSource();
+}
@@ -1,6 +1,8 @@
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 #include <sdk/core/base-sink.h>
+#include <sdk/core/packed12.h>
+#include <sdk/core/pad.h>
 #include <sdk/tof/depth-calc.h>
 #include <sdk/tof/playback-src.h>
 
@@ -89,4 +91,42 @@ TEST_F(DepthCalcTest, DepthTest) {
                   1e-3);
     }
   }
-}
\ No newline at end of file
+}
+TEST_F(DepthCalcTest, PackedDepthTest) {
+  // same phases packed to 12 bits give the same output
+  Mat phases({4, 8, 16}, CV_16SC1);
+  int16_t* samples = (int16_t*)phases.data;
+  for (int i = 0; i < 4 * 8 * 16; i++) {
+    samples[i] = (i * 37) % 4096 - 2048;
+  }
+  Mat packed;
+  Packed12::Pack(phases, packed);
+
+  Pad pad(kPadSource, "src");
+  pad.Link(depth_calc_->GetSinkPad());
+  pad.SetFrameFormat({4, 8, 16}, CV_16SC1);
+  pad.PushFrame(phases);
+  Mat expected = sink_->frame_.clone();
+  ASSERT_FALSE(expected.empty());
+
+  pad.SetFrameFormat(Packed12::GetPackedShape({4, 8, 16}), CV_12SP);
+  MatShape shape;
+  int type;
+  depth_calc_->GetSourcePad()->GetFrameFormat(shape, type);
+  EXPECT_EQ(shape[0], 2);
+  EXPECT_EQ(shape[1], 8);
+  EXPECT_EQ(shape[2], 16);
+  EXPECT_EQ(type, CV_32FC1);
+  pad.PushFrame(packed);
+
+  Mat actual = sink_->frame_;
+  EXPECT_EQ(norm(actual, expected, NORM_INF), 0);
+}
+
+TEST_F(DepthCalcTest, TestUnsupportedFormat) {
+  Pad pad(kPadSource, "src");
+  pad.Link(depth_calc_->GetSinkPad());
+  EXPECT_THROW(pad.SetFrameFormat({2, 8, 8}, CV_16SC1), std::invalid_argument);
+  EXPECT_THROW(pad.SetFrameFormat({8, 8}, CV_16SC1), std::invalid_argument);
+  EXPECT_THROW(pad.SetFrameFormat({4, 8, 8}, CV_32FC1), std::invalid_argument);
+}
@@ -0,0 +1,94 @@
+#ifndef __FAKE_CAMERA_H__
+#define __FAKE_CAMERA_H__
+
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+/**
+ * @brief Camera on the loopback interface, answers the sensor setup commands
+ * with an ack and getFrame requests with a frame numbered in its first
+ * sample.
+ *
+ */
+class FakeCamera {
+ public:
+  FakeCamera(int framesToSend = -1)
+      : framesToSend_(framesToSend), silent_(false) {
+    listenFd_ = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = 0;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    bind(listenFd_, (struct sockaddr *)&addr, sizeof(addr));
+    socklen_t len = sizeof(addr);
+    getsockname(listenFd_, (struct sockaddr *)&addr, &len);
+    port_ = ntohs(addr.sin_port);
+    listen(listenFd_, 1);
+  }
+
+  ~FakeCamera() {
+    if (thread_.joinable()) thread_.join();
+    close(listenFd_);
+  }
+
+  void Start() { thread_ = thread(&FakeCamera::Serve, this); }
+
+  int port_;
+  int framesToSend_;
+  // accept, then never answer
+  bool silent_;
+
+ private:
+  void Serve() {
+    int fd = accept(listenFd_, nullptr, nullptr);
+    if (fd < 0) return;
+    if (silent_) {
+      char c;
+      recv(fd, &c, 1, 0);
+      close(fd);
+      return;
+    }
+
+    vector<int16_t> frame(4 * 480 * 640, 0);
+    string pending;
+    int sent = 0;
+    char buffer[256];
+    while (framesToSend_ < 0 || sent < framesToSend_) {
+      int n = recv(fd, buffer, sizeof(buffer), 0);
+      if (n <= 0) break;
+      pending.append(buffer, n);
+      while (pending.compare(0, 8, "getFrame") == 0 &&
+             (framesToSend_ < 0 || sent < framesToSend_)) {
+        pending.erase(0, (pending.size() > 8 && pending[8] == '\0') ? 9 : 8);
+        frame[0] = sent++;
+        send(fd, frame.data(), frame.size() * sizeof(int16_t), MSG_NOSIGNAL);
+      }
+      if (!pending.empty() && pending.compare(0, 8, "getFrame") != 0) {
+        int16_t ack = 0;
+        send(fd, &ack, sizeof(ack), MSG_NOSIGNAL);
+        pending.clear();
+      }
+    }
+    // half a frame, then hang up. Gracefully, so that the frames sent and
+    // the requests still coming are not lost to a reset.
+    send(fd, frame.data(), frame.size(), MSG_NOSIGNAL);
+    shutdown(fd, SHUT_WR);
+    while (recv(fd, buffer, sizeof(buffer), 0) > 0) {
+    }
+    close(fd);
+  }
+
+  int listenFd_;
+  thread thread_;
+};
+
+#endif  // __FAKE_CAMERA_H__
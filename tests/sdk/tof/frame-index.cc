@@ -0,0 +1,91 @@
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include <sdk/tof/frame-index.h>
+#include <unistd.h>
+
+#include <cstring>
+
+class FrameIndexTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    char tmpl[] = "/tmp/tct-index-XXXXXX";
+    close(mkstemp(tmpl));
+    filename_ = tmpl;
+
+    FrameIndexWriter writer;
+    ASSERT_TRUE(writer.Open(filename_));
+    for (int i = 0; i < 10; i++) {
+      FrameIndexEntry entry;
+      memset(&entry, 0, sizeof(entry));
+      entry.offset = 64 + i * 1000;
+      // 100ms apart, with a gap after frame 4
+      entry.timestamp_us = i * 100000 + (i > 4 ? 1000000 : 0);
+      entry.sequence = i;
+      EXPECT_TRUE(writer.Append(entry));
+    }
+    EXPECT_TRUE(writer.Close(64 + 10 * 1000));
+  }
+
+  void TearDown() override { unlink(filename_.c_str()); }
+
+  string filename_;
+};
+
+TEST_F(FrameIndexTest, TestOpen) {
+  FrameIndex index;
+  EXPECT_FALSE(index.Open("/tmp/doesnt_exist.idx", 0));
+  EXPECT_TRUE(index.Open(filename_, 64 + 10 * 1000));
+  EXPECT_TRUE(index.IsOpen());
+  EXPECT_EQ(index.GetSize(), 10);
+  EXPECT_EQ(index.GetEntry(3).offset, 3064);
+  EXPECT_EQ(index.GetEntry(3).sequence, 3);
+  index.Close();
+  EXPECT_FALSE(index.IsOpen());
+}
+
+TEST_F(FrameIndexTest, TestStale) {
+  FrameIndex index;
+  // the recording is smaller than what was indexed
+  EXPECT_FALSE(index.Open(filename_, 64 + 5 * 1000));
+  // a longer recording was written over the indexed one
+  EXPECT_FALSE(index.Open(filename_, 64 + 20 * 1000));
+}
+
+TEST_F(FrameIndexTest, TestFindFrame) {
+  FrameIndex index;
+  ASSERT_TRUE(index.Open(filename_, 64 + 10 * 1000));
+  EXPECT_EQ(index.FindFrame(-1), 0);
+  EXPECT_EQ(index.FindFrame(0), 0);
+  EXPECT_EQ(index.FindFrame(150000), 1);
+  EXPECT_EQ(index.FindFrame(400000), 4);
+  // in the gap
+  EXPECT_EQ(index.FindFrame(1000000), 4);
+  EXPECT_EQ(index.FindFrame(1500000), 5);
+  EXPECT_EQ(index.FindFrame(100000000), 9);
+}
+
+TEST_F(FrameIndexTest, TestFlush) {
+  string filename = filename_ + "-rolling";
+  FrameIndexWriter writer;
+  ASSERT_TRUE(writer.Open(filename));
+  FrameIndexEntry entry;
+  memset(&entry, 0, sizeof(entry));
+  writer.Append(entry);
+  writer.Append(entry);
+  EXPECT_TRUE(writer.Flush(2000));
+  writer.Append(entry);
+
+  // only flushed entries are visible
+  FrameIndex index;
+  ASSERT_TRUE(index.Open(filename, 2000));
+  EXPECT_EQ(index.GetSize(), 2);
+  // the recording grew after the last flush
+  ASSERT_TRUE(index.Open(filename, 2500));
+  EXPECT_EQ(index.GetSize(), 2);
+
+  writer.Close(3000);
+  EXPECT_FALSE(index.Open(filename, 2500));
+  EXPECT_TRUE(index.Open(filename, 3000));
+  EXPECT_EQ(index.GetSize(), 3);
+  unlink(filename.c_str());
+}
@@ -0,0 +1,110 @@
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include <sdk/core/base-sink.h>
+#include <sdk/tof/multi-camera-src.h>
+
+#include <mutex>
+
+#include "fake-camera.h"
+
+class SequenceSink : public BaseSink {
+ public:
+  SequenceSink(const string& name) : BaseSink(name) {}
+  ~SequenceSink() {}
+
+  void SinkFrame(Mat& frame) override {
+    lock_guard<mutex> lock(mutex_);
+    sequences_.push_back(frame.at<int16_t>(0, 0, 0));
+  }
+
+  size_t GetCount() {
+    lock_guard<mutex> lock(mutex_);
+    return sequences_.size();
+  }
+
+  mutex mutex_;
+  vector<int> sequences_;
+};
+
+static bool WaitFor(const function<bool()>& condition) {
+  auto deadline = chrono::steady_clock::now() + chrono::seconds(5);
+  while (!condition()) {
+    if (chrono::steady_clock::now() > deadline) return false;
+    this_thread::sleep_for(chrono::milliseconds(10));
+  }
+  return true;
+}
+
+TEST(MultiCameraSourceTest, TestAddCamera) {
+  MultiCameraSource source("cameras");
+  EXPECT_EQ(source.AddCamera("127.0.0.1:50660"), 0);
+  EXPECT_EQ(source.AddCamera("127.0.0.1:50661"), 1);
+  EXPECT_EQ(source.AddCamera("nowhere"), -1);
+  EXPECT_EQ(source.AddCamera("not.an.ip:50660"), -1);
+  EXPECT_EQ(source.GetCameraCount(), 2);
+  EXPECT_EQ(source.GetSourcePad(1), source.GetPad("cam1"));
+  EXPECT_EQ(source.GetSourcePad(2), nullptr);
+}
+
+TEST(MultiCameraSourceTest, TestFramesInOrder) {
+  const int count = 3;
+  vector<unique_ptr<FakeCamera>> cameras;
+  vector<unique_ptr<SequenceSink>> sinks;
+  MultiCameraSource source("cameras");
+  source.SetOutstandingRequests(2);
+  source.SetDispatchThreads(2);
+  for (int i = 0; i < count; i++) {
+    cameras.emplace_back(new FakeCamera());
+    cameras.back()->Start();
+    int index =
+        source.AddCamera("127.0.0.1:" + to_string(cameras.back()->port_));
+    ASSERT_EQ(index, i);
+    sinks.emplace_back(new SequenceSink("sink" + to_string(i)));
+    source.GetSourcePad(i)->Link(sinks.back()->GetSinkPad());
+  }
+
+  ASSERT_TRUE(source.Start());
+  bool received = WaitFor([&] {
+    for (auto& sink : sinks) {
+      if (sink->GetCount() < 10) return false;
+    }
+    return true;
+  });
+  source.Stop();
+  ASSERT_TRUE(received);
+
+  for (int i = 0; i < count; i++) {
+    EXPECT_EQ(source.GetConnectionState(i), kCameraDisconnected);
+    auto& sequences = sinks[i]->sequences_;
+    // dropped frames leave gaps, but never reorder
+    for (size_t f = 1; f < sequences.size(); f++) {
+      EXPECT_GT(sequences[f], sequences[f - 1]);
+    }
+    // frames still waiting for their pipeline are dropped on stop
+    EXPECT_LE(sequences.size() + source.GetFramesDropped(i),
+              source.GetFramesReceived(i));
+  }
+}
+
+TEST(MultiCameraSourceTest, TestCameraHangsUp) {
+  FakeCamera good;
+  FakeCamera bad(2);
+  good.Start();
+  bad.Start();
+  MultiCameraSource source("cameras");
+  source.AddCamera("127.0.0.1:" + to_string(good.port_));
+  source.AddCamera("127.0.0.1:" + to_string(bad.port_));
+  SequenceSink goodSink("good");
+  SequenceSink badSink("bad");
+  source.GetSourcePad(0)->Link(goodSink.GetSinkPad());
+  source.GetSourcePad(1)->Link(badSink.GetSinkPad());
+
+  ASSERT_TRUE(source.Start());
+  // the other camera keeps streaming
+  EXPECT_TRUE(WaitFor([&] {
+    return source.GetConnectionState(1) == kCameraDisconnected &&
+           goodSink.GetCount() >= 10;
+  }));
+  source.Stop();
+  EXPECT_EQ(source.GetFramesReceived(1), 2);
+}
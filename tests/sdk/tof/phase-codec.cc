@@ -0,0 +1,110 @@
+#include <gtest/gtest.h>
+#include <sdk/tof/phase-codec.h>
+
+#include <random>
+
+class PhaseCodecTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    // smooth phase planes with sensor noise, 100 rows to cover a partial
+    // chunk and 70 columns a partial block
+    frame_ = Mat({4, 100, 70}, CV_16SC1);
+    mt19937 rng(42);
+    normal_distribution<float> noise(0, 4);
+    for (int p = 0; p < 4; p++) {
+      for (int r = 0; r < 100; r++) {
+        for (int c = 0; c < 70; c++) {
+          frame_.at<int16_t>(p, r, c) =
+              1000 * (p - 2) + 10 * r - 5 * c + (int)noise(rng);
+        }
+      }
+    }
+    encoded_.resize(PhaseCodec::GetMaxEncodedSize(MatShape(4, 100, 70)));
+  }
+
+  void ExpectEqual(const Mat &a, const Mat &b) {
+    EXPECT_EQ(norm(a, b, NORM_INF), 0);
+  }
+
+  Mat frame_;
+  vector<uint8_t> encoded_;
+};
+
+TEST_F(PhaseCodecTest, TestRoundTrip) {
+  size_t size = PhaseCodec::Encode(frame_, encoded_.data(), encoded_.size());
+  ASSERT_GT(size, 0);
+  EXPECT_LT(size, frame_.total() * frame_.elemSize() / 2);
+  EXPECT_EQ(PhaseCodec::GetEncodedSize(encoded_.data(), size), size);
+
+  Mat decoded({4, 100, 70}, CV_16SC1);
+  ASSERT_TRUE(PhaseCodec::Decode(encoded_.data(), size, decoded));
+  ExpectEqual(frame_, decoded);
+}
+
+TEST_F(PhaseCodecTest, TestExtremeValues) {
+  // full range noise is incompressible but still lossless
+  mt19937 rng(7);
+  for (size_t i = 0; i < frame_.total(); i++) {
+    ((uint16_t *)frame_.data)[i] = rng();
+  }
+  frame_.at<int16_t>(0, 0, 0) = INT16_MIN;
+  frame_.at<int16_t>(0, 0, 1) = INT16_MAX;
+
+  size_t size = PhaseCodec::Encode(frame_, encoded_.data(), encoded_.size());
+  ASSERT_GT(size, 0);
+  EXPECT_LE(size, encoded_.size());
+  Mat decoded({4, 100, 70}, CV_16SC1);
+  ASSERT_TRUE(PhaseCodec::Decode(encoded_.data(), size, decoded));
+  ExpectEqual(frame_, decoded);
+
+  Mat unsignedFrame({4, 100, 70}, CV_16UC1, frame_.data);
+  size = PhaseCodec::Encode(unsignedFrame, encoded_.data(), encoded_.size());
+  Mat unsignedDecoded({4, 100, 70}, CV_16UC1);
+  ASSERT_TRUE(PhaseCodec::Decode(encoded_.data(), size, unsignedDecoded));
+  ExpectEqual(unsignedFrame, unsignedDecoded);
+}
+
+TEST_F(PhaseCodecTest, TestWorstCaseFits) {
+  // incompressible planes whose rows are not a multiple of the chunk rows,
+  // coded into exactly GetMaxEncodedSize() bytes followed by a guard
+  MatShape shape(3, 45, 37);
+  Mat frame({3, 45, 37}, CV_16UC1);
+  mt19937 rng(11);
+  for (size_t i = 0; i < frame.total(); i++) {
+    ((uint16_t *)frame.data)[i] = rng();
+  }
+  size_t maxSize = PhaseCodec::GetMaxEncodedSize(shape);
+  vector<uint8_t> buffer(maxSize + 4096, 0xa5);
+
+  size_t size = PhaseCodec::Encode(frame, buffer.data(), maxSize);
+  ASSERT_GT(size, 0);
+  EXPECT_LE(size, maxSize);
+  for (size_t i = maxSize; i < buffer.size(); i++) {
+    ASSERT_EQ(buffer[i], 0xa5) << "written past the end at " << i;
+  }
+  Mat decoded({3, 45, 37}, CV_16UC1);
+  ASSERT_TRUE(PhaseCodec::Decode(buffer.data(), size, decoded));
+  ExpectEqual(frame, decoded);
+}
+
+TEST_F(PhaseCodecTest, TestInvalid) {
+  Mat floats({4, 100, 70}, CV_32FC1);
+  EXPECT_FALSE(PhaseCodec::IsSupported(CV_32FC1));
+  EXPECT_EQ(PhaseCodec::Encode(floats, encoded_.data(), encoded_.size()), 0);
+  // not enough room for the worst case
+  EXPECT_EQ(PhaseCodec::Encode(frame_, encoded_.data(), 100), 0);
+
+  size_t size = PhaseCodec::Encode(frame_, encoded_.data(), encoded_.size());
+  Mat decoded({4, 100, 70}, CV_16SC1);
+  // truncated
+  EXPECT_FALSE(PhaseCodec::Decode(encoded_.data(), size - 1, decoded));
+  // wrong shape
+  Mat other({4, 100, 80}, CV_16SC1);
+  EXPECT_FALSE(PhaseCodec::Decode(encoded_.data(), size, other));
+  // corrupted chunk size table
+  encoded_[sizeof(PhaseFrameHeader)] ^= 1;
+  EXPECT_FALSE(PhaseCodec::Decode(encoded_.data(), size, decoded));
+  // not an encoded frame
+  memset(encoded_.data(), 0, sizeof(PhaseFrameHeader));
+  EXPECT_EQ(PhaseCodec::GetEncodedSize(encoded_.data(), size), 0);
+}
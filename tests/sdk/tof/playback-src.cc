@@ -2,6 +2,7 @@
 #include <gtest/gtest.h>
 #include <sdk/core/base-sink.h>
 #include <sdk/tof/playback-src.h>
+#include <unistd.h>
 
 class SinkMock : public BaseSink {
  public:
@@ -39,4 +40,199 @@ TEST(PlaybackSource, GenerateFrame) {
   source.Start();
   this_thread::sleep_for(chrono::milliseconds(100));
   source.Stop();
-}
\ No newline at end of file
+}
+class PlaybackContainerTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    char tmpl[] = "/tmp/tct-container-XXXXXX";
+    int fd = mkstemp(tmpl);
+    filename_ = tmpl;
+
+    // 3 frames of 4 subframes 4x4, with 64B stream header and 32B subframe
+    // headers
+    ToFStreamHeader header = {64, 32, 4, 4, 10, 1, 2, 4, 3};
+    vector<uint8_t> data(64 + 3 * header.GetFrameSize(), 0);
+    memcpy(data.data(), &header, sizeof(header));
+    for (int f = 0; f < 3; f++) {
+      for (int s = 0; s < 4; s++) {
+        uint8_t *subframe = data.data() + 64 + f * header.GetFrameSize() +
+                            s * header.GetSubframeSize();
+        ToFSubframeHeader meta = {37500000, (uint32_t)(40 + f), 0, 0};
+        memcpy(subframe, &meta, sizeof(meta));
+        int16_t *pixels = (int16_t *)(subframe + 32);
+        for (int p = 0; p < 16; p++) {
+          pixels[p] = f * 100 + s * 10 + p;
+        }
+      }
+    }
+    write(fd, data.data(), data.size());
+    close(fd);
+  }
+
+  void TearDown() override { unlink(filename_.c_str()); }
+
+  void CheckFrame(Mat &frame, int f) {
+    ASSERT_FALSE(frame.empty());
+    for (int s = 0; s < 4; s++) {
+      for (int p = 0; p < 16; p++) {
+        EXPECT_EQ(frame.at<int16_t>(s, p / 4, p % 4), f * 100 + s * 10 + p);
+      }
+    }
+  }
+
+  string filename_;
+};
+
+TEST_F(PlaybackContainerTest, TestNegotiateFormat) {
+  SinkMock sink("sink");
+  PlaybackSource source("playback", false, false);
+  source.GetSourcePad()->Link(sink.GetSinkPad());
+  source.SetFilename(filename_);
+  // ignored, the container has its own format
+  source.SetFormat({4, 480, 640}, CV_16UC1);
+  ASSERT_TRUE(source.InitializeSource());
+  EXPECT_EQ(source.GetFrameCount(), 3);
+
+  MatShape shape;
+  int type;
+  sink.GetSinkPad()->GetFrameFormat(shape, type);
+  EXPECT_EQ(shape.dims(), 3);
+  EXPECT_EQ(shape[0], 4);
+  EXPECT_EQ(shape[1], 4);
+  EXPECT_EQ(shape[2], 4);
+  EXPECT_EQ(type, CV_16SC1);
+  source.CleanupSource();
+}
+
+TEST_F(PlaybackContainerTest, TestForceContainer) {
+  PlaybackSource source("playback", false, false);
+  source.SetContainer(kPlaybackContainerToF);
+  source.SetFilename(filename_);
+  EXPECT_TRUE(source.InitializeSource());
+  source.CleanupSource();
+
+  // a raw file is not a container
+  source.SetFilename("data/input/raw2depth.dat");
+  EXPECT_FALSE(source.InitializeSource());
+}
+
+TEST_F(PlaybackContainerTest, TestRange) {
+  PlaybackSource source("playback", false, false);
+  source.SetFilename(filename_);
+  source.SetPacing(kPlaybackPacingUnthrottled);
+  source.SetRange(1, 1);
+  ASSERT_TRUE(source.InitializeSource());
+
+  Mat frame = source.GenerateFrame();
+  CheckFrame(frame, 1);
+  EXPECT_TRUE(source.GenerateFrame().empty());
+  source.CleanupSource();
+
+  // up to the end of the file
+  source.SetRange(1);
+  ASSERT_TRUE(source.InitializeSource());
+  frame = source.GenerateFrame();
+  CheckFrame(frame, 1);
+  frame = source.GenerateFrame();
+  CheckFrame(frame, 2);
+  EXPECT_TRUE(source.GenerateFrame().empty());
+  source.CleanupSource();
+}
+
+TEST_F(PlaybackContainerTest, TestFramesAndMeta) {
+  PlaybackSource source("playback", false, false);
+  source.SetFilename(filename_);
+  source.SetFrameRate(1000);
+  ASSERT_TRUE(source.InitializeSource());
+
+  ToFFrameMeta meta;
+  EXPECT_FALSE(source.GetFrameMeta(meta));
+  for (int f = 0; f < 3; f++) {
+    Mat frame = source.GenerateFrame();
+    CheckFrame(frame, f);
+    ASSERT_TRUE(source.GetFrameMeta(meta));
+    EXPECT_EQ(meta.frame_index, f);
+    ASSERT_EQ(meta.subframes.size(), 4);
+    EXPECT_EQ(meta.subframes[3].modulation_frequency, 37500000);
+    EXPECT_EQ(meta.subframes[3].sensor_temperature, 40 + f);
+  }
+  EXPECT_TRUE(source.GenerateFrame().empty());
+  source.CleanupSource();
+}
+
+TEST_F(PlaybackContainerTest, TestPrefetchFrames) {
+  PlaybackSource source("playback", false, false);
+  source.SetFilename(filename_);
+  source.SetFrameRate(1000);
+  source.SetPrefetchDepth(2);
+  ASSERT_TRUE(source.InitializeSource());
+
+  for (int f = 0; f < 3; f++) {
+    Mat frame = source.GenerateFrame();
+    CheckFrame(frame, f);
+  }
+  source.CleanupSource();
+}
+
+TEST_F(PlaybackContainerTest, TestIndexSeek) {
+  PlaybackSource source("playback", false, false);
+  source.SetFilename(filename_);
+  ASSERT_TRUE(source.BuildIndex(true));
+
+  FrameIndex index;
+  ASSERT_TRUE(index.Open(FrameIndex::GetFilename(filename_), 64 + 3 * 4 * 64));
+  ASSERT_EQ(index.GetSize(), 3);
+  // 10 fps from the header
+  EXPECT_EQ(index.GetEntry(2).timestamp_us, 200000);
+  EXPECT_FALSE(index.GetEntry(2).flags & FRAME_INDEX_HAS_TIMESTAMP);
+  EXPECT_TRUE(index.GetEntry(1).flags & FRAME_INDEX_HAS_STATS);
+  EXPECT_EQ(index.GetEntry(1).min, 100);
+  EXPECT_EQ(index.GetEntry(1).max, 115);
+  index.Close();
+
+  source.SetFrameRate(1000);
+  ASSERT_TRUE(source.InitializeSource());
+  EXPECT_TRUE(source.SeekTime(0.25));
+  Mat frame = source.GenerateFrame();
+  CheckFrame(frame, 2);
+  EXPECT_EQ(source.GetPosition(), 2);
+
+  EXPECT_TRUE(source.Seek(0));
+  frame = source.GenerateFrame();
+  CheckFrame(frame, 0);
+  // back to a cached frame
+  EXPECT_TRUE(source.Seek(2));
+  frame = source.GenerateFrame();
+  CheckFrame(frame, 2);
+  EXPECT_FALSE(source.Seek(3));
+  source.CleanupSource();
+
+  unlink(FrameIndex::GetFilename(filename_).c_str());
+}
+
+TEST_F(PlaybackContainerTest, TestPacing) {
+  PlaybackSource source("playback", false, true);
+  source.SetFilename(filename_);
+  source.SetFrameRate(20);
+  ASSERT_TRUE(source.InitializeSource());
+
+  // deadline: the first frame is due immediately, then every 50ms
+  auto start = chrono::steady_clock::now();
+  for (int i = 0; i < 5; i++) source.GenerateFrame();
+  auto elapsed = chrono::steady_clock::now() - start;
+  EXPECT_GE(elapsed, chrono::milliseconds(200));
+  EXPECT_LT(elapsed, chrono::milliseconds(300));
+
+  source.SetPacing(kPlaybackPacingUnthrottled);
+  start = chrono::steady_clock::now();
+  for (int i = 0; i < 5; i++) source.GenerateFrame();
+  EXPECT_LT(chrono::steady_clock::now() - start, chrono::milliseconds(50));
+
+  // no index, falls back to the 20 fps frame rate
+  source.SetPacing(kPlaybackPacingRecorded);
+  source.Seek(0);
+  start = chrono::steady_clock::now();
+  for (int i = 0; i < 3; i++) source.GenerateFrame();
+  EXPECT_GE(chrono::steady_clock::now() - start, chrono::milliseconds(100));
+  source.CleanupSource();
+}
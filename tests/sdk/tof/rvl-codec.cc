@@ -0,0 +1,81 @@
+#include <gtest/gtest.h>
+#include <sdk/tof/rvl-codec.h>
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+using namespace std;
+
+TEST(RvlCodec, TestRoundTrip) {
+  // runs of invalid pixels, small deltas, and the extremes
+  vector<uint16_t> values(1000);
+  mt19937 rng(3);
+  for (size_t i = 0; i < values.size(); i++) {
+    values[i] = (i % 100 < 20) ? 0 : 1500 + i % 7;
+  }
+  values[50] = 65535;
+  values[51] = 1;
+  values[999] = 0;
+  for (size_t i = 700; i < 800; i++) values[i] = rng();
+
+  vector<uint8_t> encoded(RvlCodec::GetMaxEncodedSize(values.size()));
+  size_t size = RvlCodec::Encode(values.data(), values.size(), encoded.data());
+  EXPECT_EQ(size % 4, 0);
+  EXPECT_LE(size, encoded.size());
+  EXPECT_LT(size, values.size() * sizeof(uint16_t));
+
+  vector<uint16_t> decoded(values.size());
+  ASSERT_TRUE(
+      RvlCodec::Decode(encoded.data(), size, decoded.data(), decoded.size()));
+  EXPECT_EQ(decoded, values);
+}
+
+TEST(RvlCodec, TestWorstCase) {
+  // alternating invalid pixels and large jumps
+  vector<uint16_t> values(1001);
+  for (size_t i = 0; i < values.size(); i++) {
+    values[i] = (i % 2) ? 0 : ((i % 4) ? 65535 : 1);
+  }
+  vector<uint8_t> encoded(RvlCodec::GetMaxEncodedSize(values.size()));
+  size_t size = RvlCodec::Encode(values.data(), values.size(), encoded.data());
+  EXPECT_LE(size, encoded.size());
+
+  vector<uint16_t> decoded(values.size());
+  ASSERT_TRUE(
+      RvlCodec::Decode(encoded.data(), size, decoded.data(), decoded.size()));
+  EXPECT_EQ(decoded, values);
+}
+
+TEST(RvlCodec, TestCorrupted) {
+  vector<uint16_t> values(100, 1234);
+  vector<uint8_t> encoded(RvlCodec::GetMaxEncodedSize(values.size()));
+  size_t size = RvlCodec::Encode(values.data(), values.size(), encoded.data());
+
+  vector<uint16_t> decoded(values.size());
+  // truncated
+  EXPECT_FALSE(RvlCodec::Decode(encoded.data(), size - 4, decoded.data(),
+                                decoded.size()));
+  // trailing data
+  EXPECT_FALSE(RvlCodec::Decode(encoded.data(), size + 4, decoded.data(),
+                                decoded.size()));
+  // run longer than the frame
+  EXPECT_FALSE(RvlCodec::Decode(encoded.data(), size, decoded.data(), 50));
+}
+
+TEST(RvlCodec, TestQuantize) {
+  float values[] = {-1.0f, NAN, 0.0004f, 0.0006f, 1.2344f, 100.0f};
+  uint16_t quantized[6];
+  RvlCodec::Quantize(values, 6, 0.001f, quantized);
+  EXPECT_EQ(quantized[0], 0);
+  EXPECT_EQ(quantized[1], 0);
+  EXPECT_EQ(quantized[2], 0);
+  EXPECT_EQ(quantized[3], 1);
+  EXPECT_EQ(quantized[4], 1234);
+  EXPECT_EQ(quantized[5], 65535);
+
+  float dequantized[6];
+  RvlCodec::Dequantize(quantized, 6, 0.001f, dequantized);
+  EXPECT_FLOAT_EQ(dequantized[4], 1.234f);
+  EXPECT_FLOAT_EQ(dequantized[0], 0.0f);
+}
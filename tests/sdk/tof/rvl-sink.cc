@@ -0,0 +1,94 @@
+#include <gtest/gtest.h>
+#include <sdk/core/pad.h>
+#include <sdk/tof/rvl-sink.h>
+#include <sdk/tof/rvl-src.h>
+#include <unistd.h>
+
+class RvlSinkTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    char tmpl[] = "/tmp/tct-rvl-XXXXXX";
+    int fd = mkstemp(tmpl);
+    close(fd);
+    filename_ = tmpl;
+  }
+
+  void TearDown() override { unlink(filename_.c_str()); }
+
+  Mat MakeFrame(int f) {
+    Mat frame({2, 8, 10}, CV_32FC1);
+    for (int r = 0; r < 8; r++) {
+      for (int c = 0; c < 10; c++) {
+        // a column of invalid depth
+        frame.at<float>(0, r, c) = (c == 0) ? 0.0f : 1.0f + 0.01f * (f + r + c);
+        frame.at<float>(1, r, c) = 100.0f * f + r * 10 + c;
+      }
+    }
+    return frame;
+  }
+
+  string filename_;
+};
+
+TEST_F(RvlSinkTest, TestRecordAndPlay) {
+  RvlSink sink("rvl");
+  Pad pad(kPadSource, "src");
+  pad.Link(sink.GetSinkPad());
+  pad.SetFrameFormat({2, 8, 10}, CV_32FC1);
+  sink.SetFilename(filename_);
+  ASSERT_TRUE(sink.StartRecording());
+  for (int f = 0; f < 3; f++) {
+    Mat frame = MakeFrame(f);
+    pad.PushFrame(frame);
+  }
+  sink.StopRecording();
+  EXPECT_EQ(sink.GetFramesWritten(), 3);
+
+  RvlSource source("rvl", false, false);
+  source.SetFilename(filename_);
+  source.SetFrameRate(1000);
+  ASSERT_TRUE(source.InitializeSource());
+  ASSERT_EQ(source.GetFrameCount(), 3);
+  for (int f = 0; f < 3; f++) {
+    Mat frame = source.GenerateFrame();
+    ASSERT_FALSE(frame.empty());
+    Mat expected = MakeFrame(f);
+    // lossless up to the quantization step
+    EXPECT_LE(norm(frame, expected, NORM_INF), 0.0005 + 1e-6);
+    EXPECT_EQ(frame.at<float>(0, 3, 0), 0.0f);
+  }
+  EXPECT_TRUE(source.GenerateFrame().empty());
+  source.CleanupSource();
+}
+
+TEST_F(RvlSinkTest, TestDepthOnly) {
+  RvlSink sink("rvl");
+  Pad pad(kPadSource, "src");
+  pad.Link(sink.GetSinkPad());
+  pad.SetFrameFormat({2, 8, 10}, CV_32FC1);
+  sink.SetFilename(filename_);
+  sink.SetAmplitude(false);
+  ASSERT_TRUE(sink.StartRecording());
+  Mat frame = MakeFrame(0);
+  pad.PushFrame(frame);
+  sink.StopRecording();
+
+  RvlSource source("rvl", false, false);
+  source.SetFilename(filename_);
+  ASSERT_TRUE(source.InitializeSource());
+  MatShape shape;
+  int type;
+  source.GetSourcePad()->GetFrameFormat(shape, type);
+  EXPECT_EQ(shape[0], 1);
+  EXPECT_EQ(type, CV_32FC1);
+  source.CleanupSource();
+}
+
+TEST_F(RvlSinkTest, TestUnsupportedFormat) {
+  RvlSink sink("rvl");
+  Pad pad(kPadSource, "src");
+  pad.Link(sink.GetSinkPad());
+  pad.SetFrameFormat({4, 8, 10}, CV_16SC1);
+  sink.SetFilename(filename_);
+  EXPECT_FALSE(sink.StartRecording());
+}
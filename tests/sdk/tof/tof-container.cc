@@ -0,0 +1,75 @@
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include <sdk/core/packed12.h>
+#include <sdk/tof/tof-container.h>
+
+class ToFStreamHeaderTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    header_ = {64, 32, 640, 480, 30, 1, 2, 4, 10};
+    fileSize_ = 64 + 10 * header_.GetFrameSize();
+  }
+
+  ToFStreamHeader header_;
+  size_t fileSize_;
+};
+
+TEST_F(ToFStreamHeaderTest, TestSizes) {
+  EXPECT_EQ(header_.GetPayloadSize(), 640 * 480 * 2);
+  EXPECT_EQ(header_.GetSubframeSize(), 32 + 640 * 480 * 2);
+  EXPECT_EQ(header_.GetFrameSize(), 4 * (32 + 640 * 480 * 2));
+  MatShape shape = header_.GetShape();
+  EXPECT_EQ(shape.dims(), 3);
+  EXPECT_EQ(shape[0], 4);
+  EXPECT_EQ(shape[1], 480);
+  EXPECT_EQ(shape[2], 640);
+  EXPECT_EQ(header_.GetType(), CV_16SC1);
+}
+
+TEST_F(ToFStreamHeaderTest, TestPacked) {
+  // pairs of 12 bits samples
+  ToFStreamHeader header = header_;
+  header.pixel_size = 3;
+  header.frame_width = 320;
+  EXPECT_EQ(header.GetType(), CV_12SP);
+  EXPECT_EQ(header.GetPayloadSize(), 640 * 480 * 3 / 2);
+  EXPECT_TRUE(header.IsValid(64 + 10 * header.GetFrameSize()));
+}
+
+TEST_F(ToFStreamHeaderTest, TestValid) {
+  EXPECT_TRUE(header_.IsValid(fileSize_));
+  // cut short recording
+  EXPECT_TRUE(header_.IsValid(fileSize_ - 100));
+  header_.num_frames = 0;
+  EXPECT_TRUE(header_.IsValid(fileSize_ + header_.GetFrameSize()));
+}
+
+TEST_F(ToFStreamHeaderTest, TestInvalid) {
+  // more data than the header says
+  EXPECT_FALSE(header_.IsValid(fileSize_ + header_.GetFrameSize()));
+  // not even one frame
+  EXPECT_FALSE(header_.IsValid(64 + header_.GetFrameSize() - 1));
+
+  ToFStreamHeader header = header_;
+  header.container_header_size = 8;
+  EXPECT_FALSE(header.IsValid(fileSize_));
+  header = header_;
+  header.pixel_size = 5;
+  EXPECT_FALSE(header.IsValid(fileSize_));
+  header = header_;
+  header.num_subframes = 0;
+  EXPECT_FALSE(header.IsValid(fileSize_));
+  header = header_;
+  header.frame_width = 100000;
+  EXPECT_FALSE(header.IsValid(fileSize_));
+}
+
+TEST_F(ToFStreamHeaderTest, TestValidEncoded) {
+  // encoded frames are smaller than raw ones, any size past the header goes
+  EXPECT_TRUE(header_.IsValid(64 + 100, true));
+  EXPECT_FALSE(header_.IsValid(64, true));
+
+  ToFStreamHeader header = header_;
+  header.pixel_size = 5;
+  EXPECT_FALSE(header.IsValid(fileSize_, true));
+}
@@ -0,0 +1,87 @@
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include <sdk/core/base-sink.h>
+#include <sdk/tof/unprojection.h>
+
+class CloudSink : public BaseSink {
+ public:
+  CloudSink(const string& name) : BaseSink(name) {}
+  ~CloudSink() {}
+
+  void SinkFrame(Mat& frame) override { frame_ = frame; }
+  Mat frame_;
+};
+
+class UnprojectionTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    unprojection_ = new Unprojection("unprojection");
+    cloudSink_ = new CloudSink("cloud");
+    indexSink_ = new CloudSink("index");
+    unprojection_->GetSourcePad()->Link(cloudSink_->GetSinkPad());
+    unprojection_->GetIndexPad()->Link(indexSink_->GetSinkPad());
+    // cx = cy = 0, fx_pixel = fy_pixel = 1
+    PinholeParams params(1.0f, 1.0f, 0, 0, 1000.0f, 1000.0f);
+    unprojection_->SetParams(params);
+    unprojection_->GetSinkPad()->SetFrameFormat({2, 2, 3}, CV_32FC1);
+
+    // depth plane then amplitude plane
+    float data[] = {0.0f, 1.0f, 2.0f, 3.0f,  4.0f,  5.0f,
+                    9.0f, 9.0f, 9.0f, 0.1f, 9.0f, 9.0f};
+    frame_ = Mat({2, 2, 3}, CV_32FC1, data).clone();
+  }
+
+  void TearDown() override {
+    delete cloudSink_;
+    delete indexSink_;
+    delete unprojection_;
+  }
+
+  Unprojection* unprojection_;
+  CloudSink* cloudSink_;
+  CloudSink* indexSink_;
+  Mat frame_;
+};
+
+TEST_F(UnprojectionTest, TestOrganizedCloud) {
+  unprojection_->GetSinkPad()->PushFrame(frame_);
+  Mat cloud = cloudSink_->frame_;
+  ASSERT_EQ(cloud.size.dims(), 3);
+  EXPECT_EQ(cloud.size[0], 2);
+  EXPECT_EQ(cloud.size[1], 3);
+  EXPECT_EQ(cloud.size[2], 3);
+  // pixel (x=2, y=1), depth 5
+  EXPECT_FLOAT_EQ(cloud.at<float>(1, 2, 0), 10.0f);
+  EXPECT_FLOAT_EQ(cloud.at<float>(1, 2, 1), 5.0f);
+  EXPECT_FLOAT_EQ(cloud.at<float>(1, 2, 2), 5.0f);
+  EXPECT_TRUE(indexSink_->frame_.empty());
+}
+
+TEST_F(UnprojectionTest, TestCompactCloud) {
+  unprojection_->SetCompactMode(true);
+  unprojection_->SetDepthRange(0.0f, 4.5f);
+  unprojection_->SetMinAmplitude(1.0f);
+
+  MatShape shape;
+  int type;
+  cloudSink_->GetSinkPad()->GetFrameFormat(shape, type);
+  EXPECT_EQ(shape[0], MAT_DIM_DYNAMIC);
+  EXPECT_EQ(shape[1], 3);
+  indexSink_->GetSinkPad()->GetFrameFormat(shape, type);
+  EXPECT_EQ(type, CV_32SC1);
+
+  unprojection_->GetSinkPad()->PushFrame(frame_);
+
+  // pixel 0: zero depth, pixel 3: low amplitude, pixel 5: out of range
+  Mat cloud = cloudSink_->frame_;
+  Mat index = indexSink_->frame_;
+  ASSERT_EQ(cloud.rows, 3);
+  ASSERT_EQ(index.rows, 3);
+  EXPECT_EQ(index.at<int32_t>(0), 1);
+  EXPECT_EQ(index.at<int32_t>(1), 2);
+  EXPECT_EQ(index.at<int32_t>(2), 4);
+  // pixel 4 is (x=1, y=1), depth 4
+  EXPECT_FLOAT_EQ(cloud.at<float>(2, 0), 4.0f);
+  EXPECT_FLOAT_EQ(cloud.at<float>(2, 1), 4.0f);
+  EXPECT_FLOAT_EQ(cloud.at<float>(2, 2), 4.0f);
+}